@@ -6,30 +6,220 @@
 #include <SDL.h>
 #include <SDL_vulkan.h>
 
+#include "allocator.h"
 #include "base.h"
+#include "config.h"
+#include "cpuCulling.h"
+#include "debugLog.h"
+#include "drawSort.h"
+#include "framePacer.h"
+#include "gpuCulling.h"
+#include "gpuProfiler.h"
+#include "instancing.h"
+#include "math3d.h"
+#include "mesh.h"
+#include "pipelineBuilder.h"
+#include "samplerCache.h"
+#include "shaderCache.h"
+#include "stagingRing.h"
+#include "texture.h"
+#include "threadPool.h"
+#include "virtualTexture.h"
+
+#define STARTUP_ARENA_BLOCK_SIZE    (64 * 1024)
+#define MAX_STARTUP_STEPS           32
+
+// Time spent in one step of createApplication, printed with --timing
+typedef struct StartupStep
+{
+    const char*    pName;
+    uint64_t       ticks;
+} StartupStep;
+
+typedef struct Frame
+{
+    VkCommandBuffer    commandBuffer;
+    VkSemaphore        imageAvailableSemaphore;
+    VkFence            inFlightFence;
+} Frame;
+
+typedef enum MeshState
+{
+    MESH_STATE_LOADING,
+    MESH_STATE_UPLOADED,
+    MESH_STATE_FAILED
+} MeshState;
+
+typedef struct PushConstants
+{
+    Mat4    modelViewProjection;
+    Mat4    model;
+} PushConstants;
+
+// Push constants of shaders/culled.vert, which reads the rest of the transform from the object buffer
+typedef struct CulledPushConstants
+{
+    Mat4    viewProjection;
+    Mat4    rotation;
+} CulledPushConstants;
+
+// Push constants of shaders/instanced.vert, the model matrices come from the instance binding
+typedef struct InstancedPushConstants
+{
+    Mat4    viewProjection;
+} InstancedPushConstants;
+
+// Per-frame state of the mesh draws, written by the main thread before the recording jobs start and only read by them.
+// Draw i shows grid object pObjectIndices[i], or object i when pObjectIndices is NULL.
+typedef struct DrawList
+{
+    VkPipeline         pipeline;
+    Mat4               rotation;
+    Mat4               viewProjection;
+    uint32_t           gridSize;
+    float              cellSize;
+    uint32_t           drawCount;
+    const uint32_t*    pObjectIndices;
+} DrawList;
+
+// Records a range of the draws into a secondary command buffer. Every job has a command pool per frame in flight,
+// which is only ever used by the thread running the job and is reset as a whole once its frame has finished.
+typedef struct RecordJob
+{
+    struct Application*    pApplication;
+    VkCommandPool          pCommandPools[MAX_FRAMES_IN_FLIGHT];
+    VkCommandBuffer        pCommandBuffers[MAX_FRAMES_IN_FLIGHT];
+    uint32_t               imageIndex;
+    uint32_t               firstDraw;
+    uint32_t               drawCount;
+    Result                 result;
+} RecordJob;
 
 typedef struct Application
 {
+    Config                      config;
     SDL_Window*                 pWindow;
     VkInstance                  instance;
+    ValidationLevel             validationLevel;
+#ifdef VIEWER_VALIDATION
+    DebugLog                    debugLog;
     VkDebugUtilsMessengerEXT    debugUtilsMessenger;
+#endif
     VkPhysicalDevice            physicalDevice;
     VkDevice                    device;
+    uint32_t                    graphicsQueueFamily;
+    uint32_t                    transferQueueFamily;
     VkQueue                     queue;
+    VkQueue                     transferQueue;
+    Allocator                   allocator;
+    StagingRing                 stagingRing;
     VkSurfaceKHR                surface;
     VkSwapchainKHR              swapchain;
+    SDL_bool                    swapchainOutdated;
+    VkPresentModeKHR            presentMode;
     VkFormat                    swapchainImageFormat;
     VkExtent2D                  swapchainExtent;
     uint32_t                    swapchainImageCount;
     VkImage*                    pSwapchainImages;
     VkImageView*                pSwapchainImageViews;
+    Allocation*                 pHeadlessImageAllocations;
+    VkFormat                    depthFormat;
+    VkImage                     depthImage;
+    Allocation                  depthImageAllocation;
+    VkImageView                 depthImageView;
+    VkFramebuffer*              pFramebuffers;
+    VkSemaphore*                pRenderFinishedSemaphores;
+    VkFence*                    pImageFences;
+    VkPipelineCache             pipelineCache;
+    char*                       pPipelineCachePath;
+    VkDescriptorSetLayout       objectSetLayout;
+    VkDescriptorSetLayout       materialSetLayout;
+    VkDescriptorSetLayout       virtualTextureSetLayout;
     VkPipelineLayout            pipelineLayout;
     VkRenderPass                renderPass;
-    VkPipeline                  pipeline;
+    ShaderCache                 shaderCache;
+    VkShaderModule              vertShaderModule;
+    VkShaderModule              fragShaderModule;
+    VkShaderModule              culledVertShaderModule;
+    VkShaderModule              instancedVertShaderModule;
+    PipelineBuilder             pipelineBuilder;
+    uint32_t                    meshPipeline;
+    uint32_t                    culledPipeline;
+    uint32_t                    instancedPipeline;
+    SDL_bool                    drawIndirectCountSupported;
+    SDL_bool                    sparseResidencySupported;
+    SDL_bool                    gpuCullingEnabled;
+    GpuCulling                  gpuCulling;
+    SDL_bool                    cpuCullingEnabled;
+    ObjectBounds                objectBounds;
+    ThreadPool                  cullingThreadPool;
+    CpuCulling                  cpuCulling;
+    SDL_bool                    instancingEnabled;
+    DrawItem*                   pDrawItems;
+    DrawBatch*                  pDrawBatches;
+    SDL_bool                    drawSortEnabled;
+    DrawSorter                  drawSorter;
+    VkBuffer                    pInstanceBuffers[MAX_FRAMES_IN_FLIGHT];
+    Allocation                  pInstanceAllocations[MAX_FRAMES_IN_FLIGHT];
+    Mesh                        mesh;
+    SDL_Thread*                 pMeshLoaderThread;
+    SDL_atomic_t                meshState;
+    uint64_t                    meshTimelineValue;
+    SDL_bool                    meshReady;
+    Mat4                        meshTransform;
+    float                       meshRadius;
+    TextureLoader               textureLoader;
+    SamplerCache                samplerCache;
+    Texture                     texture;
+    VkDescriptorPool            materialDescriptorPool;
+    VkDescriptorSet             materialDescriptorSet;
+    SDL_bool                    virtualTextureEnabled;
+    VirtualTexture              virtualTexture;
+    VkCommandPool               commandPool;
+    DrawList                    drawList;
+    ThreadPool                  recordThreadPool;
+    uint32_t                    recordJobCount;
+    RecordJob*                  pRecordJobs;
+    uint32_t                    frameCount;
+    Frame*                      pFrames;
+    uint32_t                    currentFrame;
+    uint64_t                    frameNumber;
+    GpuProfiler                 gpuProfiler;
+    uint64_t                    waitTicks;
+    uint64_t                    recordTicks;
+    uint64_t                    cullTicks;
+    uint64_t                    sortTicks;
+    uint64_t                    sortedDrawSum;
+    uint64_t                    reorderedDrawSum;
+    uint64_t                    drawCallSum;
+    uint64_t                    drawnObjectSum;
+    uint64_t                    inputTicks;
+    LatencyHistory              inputLatency;
+    uint64_t                    startTicks;
+    StartupStep                 pStartupSteps[MAX_STARTUP_STEPS];
+    uint32_t                    startupStepCount;
+    uint64_t                    startupStepTicks;
+    SDL_bool                    pipelinesReady;
 } Application;
 
-Result createApplication(Application* pApplication);
+Result createApplication(Application* pApplication, const Config* pConfig);
 
 void destroyApplication(Application* pApplication);
 
+// Latency is measured from inputTicks, the time of the oldest input the frame reacts to, up to the return of
+// vkQueuePresentKHR. It is reset once the frame is presented, zero means the frame has no input to measure.
+Result drawFrame(Application* pApplication);
+
+// Fragment shader invocations per pixel of the frame, from the pipeline statistics of the GPU profiler. Hidden
+// fragments rejected by the early depth test are not invoked, so this is the overdraw that costs shading.
+Result getOverdraw(const Application* pApplication, double* pOverdraw);
+
+// The state the mesh pipeline is built from, also used to build variants of it
+void getMeshPipelineState(const Application* pApplication, GraphicsPipelineState* pState);
+
+const char* getPresentModeName(VkPresentModeKHR presentMode);
+
+// Time of every step of createApplication and their share of the total
+void printStartupTiming(const Application* pApplication);
+
 #endif // APPLICATION_H
@@ -0,0 +1,92 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+#include "blockAllocator.h"
+
+#define DEFAULT_MEMORY_BLOCK_SIZE    (64ull * 1024 * 1024)
+#define MIN_BUDDY_BLOCK_SIZE         256ull
+
+typedef struct AllocationInfo
+{
+    VkMemoryPropertyFlags    requiredFlags;
+    VkMemoryPropertyFlags    preferredFlags;
+    AllocationStrategy       strategy;
+    SDL_bool                 optimalImage;
+} AllocationInfo;
+
+typedef struct MemoryBlock
+{
+    VkDeviceMemory        memory;
+    uint32_t              memoryTypeIndex;
+    SDL_bool              optimalImage;
+    SDL_bool              dedicated;
+    void*                 pMapped;
+    BlockAllocator        allocator;
+} MemoryBlock;
+
+typedef struct Allocation
+{
+    VkDeviceMemory    memory;
+    VkDeviceSize      offset;
+    VkDeviceSize      size;
+    void*             pMapped;
+    MemoryBlock*      pBlock;
+} Allocation;
+
+typedef struct AllocatorStats
+{
+    uint32_t        blockCount;
+    uint32_t        dedicatedBlockCount;
+    uint32_t        allocationCount;
+    VkDeviceSize    blockBytes;
+    VkDeviceSize    usedBytes;
+    VkDeviceSize    requestedBytes;
+    VkDeviceSize    freeBytes;
+    VkDeviceSize    largestFreeRegion;
+    float           fragmentation;
+} AllocatorStats;
+
+// Sub-allocates buffers and images from a few large VkDeviceMemory blocks per memory type instead of
+// calling vkAllocateMemory for every resource. Allocations of at least half a block get a block of their own.
+typedef struct Allocator
+{
+    VkPhysicalDevice                    physicalDevice;
+    VkDevice                            device;
+    VkPhysicalDeviceMemoryProperties    memoryProperties;
+    VkDeviceSize                        blockSize;
+    uint32_t                            blockCount;
+    uint32_t                            blockCapacity;
+    MemoryBlock**                       ppBlocks;
+    SDL_mutex*                          pMutex;
+} Allocator;
+
+Result findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties* pMemoryProperties, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags, uint32_t* pMemoryTypeIndex);
+
+Result createAllocator(Allocator* pAllocator, VkPhysicalDevice physicalDevice, VkDevice device);
+
+void destroyAllocator(Allocator* pAllocator);
+
+Result allocateMemory(Allocator* pAllocator, const VkMemoryRequirements* pRequirements, const AllocationInfo* pInfo, Allocation* pAllocation);
+
+void freeMemory(Allocator* pAllocator, Allocation* pAllocation);
+
+Result createBuffer(Allocator* pAllocator, VkDeviceSize size, VkBufferUsageFlags usage, const AllocationInfo* pInfo, VkBuffer* pBuffer, Allocation* pAllocation);
+
+void destroyBuffer(Allocator* pAllocator, VkBuffer buffer, Allocation* pAllocation);
+
+Result createImage(Allocator* pAllocator, const VkImageCreateInfo* pCreateInfo, const AllocationInfo* pInfo, VkImage* pImage, Allocation* pAllocation);
+
+void destroyImage(Allocator* pAllocator, VkImage image, Allocation* pAllocation);
+
+void getAllocatorStats(Allocator* pAllocator, AllocatorStats* pStats);
+
+void printAllocatorStats(Allocator* pAllocator);
+
+#endif // ALLOCATOR_H
@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#include "base.h"
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator for data that is thrown away all at once, such as the results of enumerations. Allocations come
+// out of blocks of blockSize bytes, a request that does not fit into the current block starts a new one.
+typedef struct Arena
+{
+    size_t         blockSize;
+    ArenaBlock*    pBlocks;
+} Arena;
+
+// No memory is allocated until the first allocation
+void createArena(Arena* pArena, size_t blockSize);
+
+// Frees every allocation at once
+void destroyArena(Arena* pArena);
+
+// Aligned to ARENA_ALIGNMENT, NULL when out of memory
+void* arenaAllocate(Arena* pArena, size_t size);
+
+#endif // ARENA_H
@@ -1,6 +1,17 @@
 #ifndef BASE_H
 #define BASE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASH_SEED 14695981039346656037ull
+
+typedef struct MappedFile
+{
+    void*     pData;
+    size_t    size;
+} MappedFile;
+
 typedef enum Result
 {
     SUCCESS,
@@ -9,4 +20,29 @@ typedef enum Result
 
 void printError(const char* pFormat, ...);
 
+uint64_t hashBytes(const void* pData, size_t size, uint64_t seed);
+
+// Sorts ascending, used for timing statistics
+void sortFloats(float* pValues, uint32_t count);
+
+// Nearest-rank percentile of sorted values, e.g. 99 for p99. count must not be 0.
+float getSortedPercentile(const float* pSorted, uint32_t count, uint32_t percentile);
+
+// Reads a whole file and null terminates it, free the data with free()
+Result readFile(const char* pPath, char** ppData, size_t* pSize);
+
+// Maps a whole file read-only, pages are only read from disk when they are touched
+Result mapFile(const char* pPath, MappedFile* pFile);
+
+void unmapFile(MappedFile* pFile);
+
+// Moves a file over another one, replacing it. rename() fails on Windows when the target exists.
+Result replaceFile(const char* pSourcePath, const char* pPath);
+
+// Size and modification time, used to tell whether a file derived from another one is out of date
+Result getFileStamp(const char* pPath, uint64_t* pSize, int64_t* pModifiedTime);
+
+// Path of a file in the user preferences directory of the viewer, free it with free(). NULL when there is none.
+char* getPreferencePath(const char* pFileName);
+
 #endif // BASE_H
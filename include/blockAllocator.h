@@ -0,0 +1,49 @@
+#ifndef BLOCK_ALLOCATOR_H
+#define BLOCK_ALLOCATOR_H
+
+#include <stdint.h>
+
+#include "base.h"
+
+typedef enum AllocationStrategy
+{
+    ALLOCATION_STRATEGY_LINEAR,
+    ALLOCATION_STRATEGY_BUDDY
+} AllocationStrategy;
+
+typedef struct BlockAllocatorStats
+{
+    uint64_t    size;
+    uint64_t    usedSize;
+    uint64_t    requestedSize;
+    uint64_t    largestFreeRegion;
+    uint32_t    allocationCount;
+} BlockAllocatorStats;
+
+// Hands out offsets inside one range and knows nothing about Vulkan, so it can be exercised without a GPU.
+// Linear is a bump allocator that rewinds once every allocation is freed, meant for staging and per-frame
+// data. Buddy splits the range into power of two blocks and coalesces them again on free.
+typedef struct BlockAllocator
+{
+    AllocationStrategy    strategy;
+    uint64_t              size;
+    uint64_t              usedSize;
+    uint64_t              requestedSize;
+    uint32_t              allocationCount;
+    uint64_t              linearOffset;
+    uint64_t              minBlockSize;
+    uint32_t              maxOrder;
+    uint8_t*              pLongestFree;
+} BlockAllocator;
+
+Result createBlockAllocator(BlockAllocator* pAllocator, AllocationStrategy strategy, uint64_t size, uint64_t minBlockSize);
+
+void destroyBlockAllocator(BlockAllocator* pAllocator);
+
+Result blockAllocate(BlockAllocator* pAllocator, uint64_t size, uint64_t alignment, uint64_t* pOffset);
+
+void blockFree(BlockAllocator* pAllocator, uint64_t offset, uint64_t size);
+
+void getBlockAllocatorStats(const BlockAllocator* pAllocator, BlockAllocatorStats* pStats);
+
+#endif // BLOCK_ALLOCATOR_H
@@ -0,0 +1,51 @@
+#ifndef CAPABILITY_CACHE_H
+#define CAPABILITY_CACHE_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define CAPABILITY_CACHE_FILE_NAME              "capabilities.bin"
+
+#define DEVICE_CAPABILITY_SWAPCHAIN             (1u << 0)
+#define DEVICE_CAPABILITY_TIMELINE_SEMAPHORE    (1u << 1)
+#define DEVICE_CAPABILITY_DRAW_INDIRECT_COUNT   (1u << 2)
+
+// What device selection needs to know of a device beyond its properties. A driver update can change it, so it is
+// keyed by the driver version as well as the device.
+typedef struct DeviceCapabilities
+{
+    uint32_t    vendorID;
+    uint32_t    deviceID;
+    uint32_t    driverVersion;
+    uint32_t    apiVersion;
+    uint32_t    flags;
+} DeviceCapabilities;
+
+// Saves enumerating the extensions and features of every device on every launch
+typedef struct CapabilityCache
+{
+    char*                  pPath;
+    uint32_t               recordCount;
+    DeviceCapabilities*    pRecords;
+    SDL_bool               dirty;
+    uint32_t               hitCount;
+    uint32_t               missCount;
+} CapabilityCache;
+
+// A missing, stale or damaged file gives an empty cache. pPath may be NULL for a cache that is never saved.
+Result loadCapabilityCache(CapabilityCache* pCache, const char* pPath);
+
+// Only writes the file when devices were added
+Result saveCapabilityCache(CapabilityCache* pCache);
+
+void destroyCapabilityCache(CapabilityCache* pCache);
+
+// Queries the device on a miss and remembers the result
+Result getDeviceCapabilities(CapabilityCache* pCache, VkPhysicalDevice physicalDevice, const VkPhysicalDeviceProperties* pProperties, DeviceCapabilities* pCapabilities);
+
+#endif // CAPABILITY_CACHE_H
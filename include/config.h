@@ -0,0 +1,92 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define DEFAULT_FRAMES_IN_FLIGHT    2
+#define MAX_FRAMES_IN_FLIGHT        8
+#define MAX_RECORD_THREADS          64
+#define DEFAULT_WIDTH               1600
+#define DEFAULT_HEIGHT              900
+#define DEFAULT_VIRTUAL_TEXTURE_MB  64
+
+typedef enum PresentModeOption
+{
+    PRESENT_MODE_OPTION_DEFAULT,
+    PRESENT_MODE_OPTION_FIFO,
+    PRESENT_MODE_OPTION_FIFO_RELAXED,
+    PRESENT_MODE_OPTION_MAILBOX,
+    PRESENT_MODE_OPTION_IMMEDIATE
+} PresentModeOption;
+
+typedef enum CpuCullingOption
+{
+    CPU_CULLING_OPTION_OFF,
+    CPU_CULLING_OPTION_AUTO,
+    CPU_CULLING_OPTION_SCALAR,
+    CPU_CULLING_OPTION_SSE,
+    CPU_CULLING_OPTION_AVX
+} CpuCullingOption;
+
+// Each level adds to the one before. gpu also enables best practices, everything the viewer used to enable always.
+typedef enum ValidationLevel
+{
+    VALIDATION_LEVEL_OFF,
+    VALIDATION_LEVEL_STANDARD,
+    VALIDATION_LEVEL_SYNC,
+    VALIDATION_LEVEL_GPU
+} ValidationLevel;
+
+// Only used when VIEWER_VALIDATION is defined, CMake sets it from VIEWER_VALIDATION_LEVEL
+#ifndef VIEWER_DEFAULT_VALIDATION
+#define VIEWER_DEFAULT_VALIDATION   VALIDATION_LEVEL_STANDARD
+#endif
+
+typedef struct Config
+{
+    SDL_bool             showHelp;
+    SDL_bool             verbose;
+    SDL_bool             timing;
+    ValidationLevel      validation;
+    SDL_bool             headless;
+    uint32_t             width;
+    uint32_t             height;
+    uint32_t             framesInFlight;
+    PresentModeOption    presentMode;
+    uint32_t             swapchainImageCount;
+    uint32_t             targetFps;
+    uint32_t             frameLimit;
+    const char*          pPipelineCachePath;
+    uint32_t             pipelineThreadCount;
+    uint32_t             recordThreadCount;
+    const char*          pMeshPath;
+    SDL_bool             verifyMeshCache;
+    const char*          pTexturePath;
+    const char*          pVirtualTexturePath;
+    uint32_t             virtualTextureBudgetMb;
+    uint32_t             gridTriangleCount;
+    uint32_t             drawCount;
+    SDL_bool             gpuCulling;
+    CpuCullingOption     cpuCulling;
+    SDL_bool             instancing;
+    SDL_bool             sortDraws;
+    uint32_t             timeStepMs;
+    const char*          pConvertPath;
+    const char*          pProfilePath;
+    const char*          pCpuTracePath;
+    const char*          pDevice;
+} Config;
+
+void setDefaultConfig(Config* pConfig);
+
+Result parseCommandLine(int argc, char* argv[], Config* pConfig);
+
+void printUsage(const char* pProgramName);
+
+const char* getValidationLevelName(ValidationLevel level);
+
+#endif // CONFIG_H
@@ -0,0 +1,74 @@
+#ifndef CPU_CULLING_H
+#define CPU_CULLING_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+#include "threadPool.h"
+
+// Objects per job, 64 KiB of bounds
+#define CPU_CULLING_CHUNK_SIZE  4096
+
+typedef enum CullingInstructionSet
+{
+    CULLING_INSTRUCTION_SET_SCALAR,
+    CULLING_INSTRUCTION_SET_SSE,
+    CULLING_INSTRUCTION_SET_AVX
+} CullingInstructionSet;
+
+// Bounding spheres as structure of arrays, so one vector load brings in the same component of 4 or 8 objects
+typedef struct ObjectBounds
+{
+    uint32_t    objectCount;
+    float*      pCenterX;
+    float*      pCenterY;
+    float*      pCenterZ;
+    float*      pRadii;
+} ObjectBounds;
+
+typedef struct CullingChunk
+{
+    struct CpuCulling*    pCulling;
+    uint32_t              firstObject;
+    uint32_t              objectCount;
+    uint32_t              visibleCount;
+} CullingChunk;
+
+// Tests the bounds against the frustum in chunks spread over a thread pool. Every chunk writes the indices of its
+// visible objects to its own range of pVisibleObjects, which are packed to the front once all chunks are done.
+typedef struct CpuCulling
+{
+    const ObjectBounds*      pBounds;
+    ThreadPool*              pThreadPool;
+    CullingInstructionSet    instructionSet;
+    uint32_t                 chunkCount;
+    CullingChunk*            pChunks;
+    uint32_t*                pVisibleObjects;
+    float                    pPlanes[6][4];
+    float                    radiusScale;
+} CpuCulling;
+
+// The arrays are 32 byte aligned and zeroed
+Result createObjectBounds(ObjectBounds* pBounds, uint32_t objectCount);
+
+void destroyObjectBounds(ObjectBounds* pBounds);
+
+// The widest instruction set the CPU running the viewer supports
+CullingInstructionSet getBestCullingInstructionSet(void);
+
+SDL_bool isCullingInstructionSetSupported(CullingInstructionSet instructionSet);
+
+const char* getCullingInstructionSetName(CullingInstructionSet instructionSet);
+
+// pThreadPool may be NULL to cull on the calling thread only. The bounds must outlive the culling.
+Result createCpuCulling(CpuCulling* pCulling, const ObjectBounds* pBounds, ThreadPool* pThreadPool, CullingInstructionSet instructionSet);
+
+void destroyCpuCulling(CpuCulling* pCulling);
+
+// Planes as returned by getFrustumPlanes, every radius is multiplied by radiusScale. Returns the number of visible
+// objects, their indices are at the start of pCulling->pVisibleObjects in ascending order until the next call.
+uint32_t cullObjects(CpuCulling* pCulling, const float pPlanes[6][4], float radiusScale);
+
+#endif // CPU_CULLING_H
@@ -0,0 +1,41 @@
+#ifndef CPU_TRACE_H
+#define CPU_TRACE_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define CPU_TRACE_EVENT_COUNT       65536
+#define CPU_TRACE_THREAD_NAME_SIZE  32
+
+// Process wide, so any thread can trace without the Application at hand. Every thread records into a ring buffer
+// of its own, which keeps the last CPU_TRACE_EVENT_COUNT events and needs no locking on the hot path.
+//
+//     uint64_t traceStart = beginCpuTrace();
+//     ...
+//     endCpuTrace("record", traceStart);
+//
+// While tracing is off beginCpuTrace is a single atomic load and endCpuTrace returns right away.
+
+// Starts tracing when pOutputPath is not NULL, the trace is written there as Chrome trace JSON by destroyCpuTrace
+Result createCpuTrace(const char* pOutputPath);
+
+// Every traced thread must have finished
+void destroyCpuTrace(void);
+
+// Pauses or resumes recording, does nothing without an output path
+void setCpuTraceEnabled(SDL_bool enabled);
+
+SDL_bool isCpuTraceEnabled(void);
+
+// Shows the calling thread under this name instead of its ID
+void nameCpuTraceThread(const char* pName);
+
+uint64_t beginCpuTrace(void);
+
+// pName must be a string literal or otherwise outlive the trace
+void endCpuTrace(const char* pName, uint64_t startTicks);
+
+#endif // CPU_TRACE_H
@@ -0,0 +1,78 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+// Must be a power of two
+#define DEBUG_LOG_QUEUE_SIZE        1024
+#define DEBUG_LOG_MESSAGE_SIZE      1024
+#define DEBUG_LOG_ID_NAME_SIZE      64
+#define DEBUG_LOG_COUNTER_COUNT     512
+// Every message ID is printed this many times in full, then at most once per interval
+#define DEBUG_LOG_BURST             4
+#define DEBUG_LOG_INTERVAL_MS       1000
+#define DEBUG_LOG_FLUSH_MS          20
+
+typedef struct DebugLogEntry
+{
+    SDL_atomic_t                              sequence;
+    VkDebugUtilsMessageSeverityFlagBitsEXT    severity;
+    VkDebugUtilsMessageTypeFlagsEXT           types;
+    int32_t                                   messageIdNumber;
+    uint64_t                                  ticks;
+    char                                      pMessageIdName[DEBUG_LOG_ID_NAME_SIZE];
+    char                                      pMessage[DEBUG_LOG_MESSAGE_SIZE];
+} DebugLogEntry;
+
+// Only touched by the logger thread
+typedef struct DebugLogCounter
+{
+    SDL_bool                                  used;
+    int32_t                                   messageIdNumber;
+    VkDebugUtilsMessageSeverityFlagBitsEXT    severity;
+    char                                      pMessageIdName[DEBUG_LOG_ID_NAME_SIZE];
+    uint64_t                                  count;
+    uint64_t                                  printedCount;
+    uint64_t                                  suppressedCount;
+    uint64_t                                  lastPrintTicks;
+} DebugLogCounter;
+
+// Validation messages arrive on whatever thread made the Vulkan call, often many per frame. The messenger callback
+// only copies a message into a bounded lock free queue and returns, and a logger thread formats and writes it.
+//
+// The logger counts messages by messageIdNumber, prints the first DEBUG_LOG_BURST of every ID and after that one
+// per DEBUG_LOG_INTERVAL_MS together with how many were suppressed since. Every line is a list of key=value pairs:
+//
+//     vulkan time=1.250 severity=error type=validation id=0x5c0ec5d6 name="VUID-vkCmdDraw-None-02699" count=1 message="..."
+//
+// ID 0 is shared by unrelated messages, the loader's among them, so those are never limited. Messages
+// are dropped rather than blocking the caller when the queue is full, and destroyDebugLog prints how many, together
+// with the total count of every ID that was rate limited.
+typedef struct DebugLog
+{
+    DebugLogEntry*      pEntries;
+    SDL_atomic_t        enqueuePosition;
+    uint32_t            dequeuePosition;
+    SDL_atomic_t        droppedCount;
+    SDL_atomic_t        quit;
+    SDL_sem*            pWakeSemaphore;
+    SDL_Thread*         pThread;
+    DebugLogCounter*    pCounters;
+    uint64_t            startTicks;
+} DebugLog;
+
+Result createDebugLog(DebugLog* pLog);
+
+// Writes out every queued message first, nothing may push while it runs
+void destroyDebugLog(DebugLog* pLog);
+
+// Safe to call from any thread at any time, never blocks
+void pushDebugLogMessage(DebugLog* pLog, VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData);
+
+#endif // DEBUG_LOG_H
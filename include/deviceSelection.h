@@ -0,0 +1,39 @@
+#ifndef DEVICE_SELECTION_H
+#define DEVICE_SELECTION_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+#include "capabilityCache.h"
+
+// Environment variable naming the device when --device is not given
+#define DEVICE_ENVIRONMENT_VARIABLE "VULKAN_VIEWER_DEVICE"
+
+typedef struct DeviceCandidate
+{
+    VkPhysicalDevice              physicalDevice;
+    VkPhysicalDeviceProperties    properties;
+    uint8_t                       pUuid[VK_UUID_SIZE];
+    SDL_bool                      uuidValid;
+    VkDeviceSize                  localMemorySize;
+    SDL_bool                      dedicatedTransferQueue;
+    SDL_bool                      drawIndirectCount;
+    const char*                   pUnsuitableReason;
+    uint64_t                      score;
+} DeviceCandidate;
+
+// Picks the device the viewer runs on. Devices without Vulkan 1.2, timeline semaphores, a graphics queue family
+// that can present to the surface or, with a surface, the swapchain extension are never picked. Of the rest the
+// highest score wins: discrete before integrated before virtual before CPU devices, then more device local memory,
+// then a dedicated transfer queue family and indirect count draws.
+//
+// pSelection overrides the score and is the index of the device, its UUID or a case insensitive part of its name.
+// The surface may be NULL when rendering headless. Extensions and features come from the capability cache, and
+// every device is listed when verbose.
+Result selectPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, CapabilityCache* pCache, const char* pSelection, SDL_bool verbose, VkPhysicalDevice* pPhysicalDevice);
+
+#endif // DEVICE_SELECTION_H
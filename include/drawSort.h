@@ -0,0 +1,30 @@
+#ifndef DRAW_SORT_H
+#define DRAW_SORT_H
+
+#include <stdint.h>
+
+#include "base.h"
+
+// Sort keys of opaque draws: pipeline in the top 8 bits, material in the next 24 and the view depth in the low 32,
+// so draws are grouped by state first and go front to back within a group
+typedef struct DrawSorter
+{
+    uint32_t     capacity;
+    uint64_t*    pKeys;
+    uint32_t*    pValues;
+    uint64_t*    pScratchKeys;
+    uint32_t*    pScratchValues;
+} DrawSorter;
+
+Result createDrawSorter(DrawSorter* pSorter, uint32_t capacity);
+
+void destroyDrawSorter(DrawSorter* pSorter);
+
+// Depth is the distance along the view direction, draws behind the camera sort as depth 0
+uint64_t makeDrawSortKey(uint32_t pipeline, uint32_t material, float depth);
+
+// Sorts the first count keys of pKeys together with pValues, keeping the submission order of equal keys.
+// Either array may be swapped with its scratch array, so the pointers have to be read again afterwards.
+void sortDraws(DrawSorter* pSorter, uint32_t count);
+
+#endif // DRAW_SORT_H
@@ -8,22 +8,24 @@
 #include <SDL.h>
 #include <SDL_vulkan.h>
 
+#include "arena.h"
 #include "base.h"
 
-Result getAvailableInstanceExtensions(uint32_t* pExtensionCount, char*** pppExtensions);
+// Enumerations are allocated from the arena and live as long as it does, extension names are not copied
 
-void printAvailableInstanceExtensions(uint32_t extensionCount, char** ppExtensions);
+Result getAvailableInstanceExtensions(Arena* pArena, uint32_t* pExtensionCount, VkExtensionProperties** ppExtensions);
 
-Result getRequiredInstanceExtensions(SDL_Window* pWindow, unsigned int* pExtensionCount, const char*** pppExtensions);
+void printAvailableInstanceExtensions(uint32_t extensionCount, const VkExtensionProperties* pExtensions);
 
-void printRequiredInstanceExtensions(unsigned int extensionCount, const char** ppExtensions);
+// The debug utils and validation features extensions are only added for validation, and never without VIEWER_VALIDATION
+Result getRequiredInstanceExtensions(Arena* pArena, SDL_Window* pWindow, SDL_bool validation, unsigned int* pExtensionCount, const char*** pppExtensions);
 
-void freeInstanceExtensions(uint32_t* pAvailableExtensionCount, char*** pppAvailableExtensions, unsigned int* pRequiredExtensionCount, const char*** pppRequiredExtensions);
+void printRequiredInstanceExtensions(unsigned int extensionCount, const char** ppExtensions);
 
-Result getAvailableDeviceExtensions(VkPhysicalDevice physicalDevice, uint32_t* pExtensionCount, char*** pppExtensions);
+Result getAvailableDeviceExtensions(Arena* pArena, VkPhysicalDevice physicalDevice, uint32_t* pExtensionCount, VkExtensionProperties** ppExtensions);
 
-void printAvailableDeviceExtensions(uint32_t extensionCount, char** ppExtensions);
+void printAvailableDeviceExtensions(uint32_t extensionCount, const VkExtensionProperties* pExtensions);
 
-void freeDeviceExtensions(uint32_t* pAvailableExtensionCount, char*** pppAvailableExtensions);
+SDL_bool hasExtension(uint32_t extensionCount, const VkExtensionProperties* pExtensions, const char* pExtensionName);
 
 #endif // EXTENSIONS_H
@@ -0,0 +1,36 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#define LATENCY_HISTORY_SIZE    1024
+
+typedef struct FramePacer
+{
+    uint64_t    frameTicks;
+    uint64_t    spinTicks;
+    uint64_t    nextFrameTicks;
+} FramePacer;
+
+// Latencies of the last LATENCY_HISTORY_SIZE samples in milliseconds
+typedef struct LatencyHistory
+{
+    uint64_t    sampleCount;
+    float       pSamples[LATENCY_HISTORY_SIZE];
+} LatencyHistory;
+
+// A target of zero leaves the frame rate uncapped
+void createFramePacer(FramePacer* pPacer, uint32_t targetFps);
+
+// Sleeps until the next frame is due. SDL_Delay only has millisecond accuracy, so the last
+// spinTicks are spent spinning. A frame that is late starts the schedule over instead of rushing the next ones.
+void waitForNextFrame(FramePacer* pPacer);
+
+void addLatencySample(LatencyHistory* pHistory, uint64_t startTicks, uint64_t endTicks);
+
+// Prints nothing without samples
+void printLatencyHistory(const LatencyHistory* pHistory, const char* pName);
+
+#endif // FRAME_PACER_H
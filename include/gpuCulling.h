@@ -0,0 +1,73 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "allocator.h"
+#include "base.h"
+#include "math3d.h"
+
+#define CULLING_GROUP_SIZE  64
+
+// Must match the push constants of shaders/cull.comp
+typedef struct CullingPushConstants
+{
+    float       pFrustumPlanes[6][4];
+    uint32_t    objectCount;
+    uint32_t    indexCount;
+    float       objectRadius;
+    uint32_t    compact;
+} CullingPushConstants;
+
+// The draws and their count written by the culling shader for one frame in flight
+typedef struct CullingFrame
+{
+    VkBuffer           drawBuffer;
+    Allocation         drawAllocation;
+    VkBuffer           countBuffer;
+    Allocation         countAllocation;
+    VkDescriptorSet    descriptorSet;
+} CullingFrame;
+
+// Tests the bounding sphere of every object against the frustum on the GPU and writes a
+// VkDrawIndexedIndirectCommand for each visible one, so the CPU records the same few commands for any object count.
+// Objects are a world position and a uniform scale, their index reaches the vertex shader as gl_InstanceIndex.
+typedef struct GpuCulling
+{
+    VkDevice            device;
+    Allocator*          pAllocator;
+    SDL_bool            drawCountSupported;
+    SDL_bool            multiDrawSupported;
+    uint32_t            maxDrawCount;
+    uint32_t            objectCount;
+    VkBuffer            objectBuffer;
+    Allocation          objectAllocation;
+    uint32_t            frameCount;
+    CullingFrame*       pFrames;
+    VkDescriptorPool    descriptorPool;
+    VkPipelineLayout    pipelineLayout;
+    VkPipeline          pipeline;
+} GpuCulling;
+
+// Set 0 of shaders/cull.comp and shaders/culled.vert: objects, draws and draw count
+Result createCullingSetLayout(VkDevice device, VkDescriptorSetLayout* pSetLayout);
+
+// pPositionScales holds four floats per object. Without drawCountSupported every object gets a draw, culled ones
+// with an instance count of zero, and the draws are issued with vkCmdDrawIndexedIndirect instead.
+Result createGpuCulling(GpuCulling* pCulling, VkPhysicalDevice physicalDevice, VkDevice device, Allocator* pAllocator, VkDescriptorSetLayout setLayout,
+    VkShaderModule shaderModule, VkPipelineCache pipelineCache, uint32_t frameCount, uint32_t objectCount, const float* pPositionScales, SDL_bool drawCountSupported);
+
+// The device must be idle
+void destroyGpuCulling(GpuCulling* pCulling);
+
+// Outside of a render pass, before the draws of the same frame. objectRadius is the bounding sphere radius at scale 1.
+void recordCulling(GpuCulling* pCulling, VkCommandBuffer commandBuffer, uint32_t frameIndex, const Mat4* pViewProjection, float objectRadius, uint32_t indexCount);
+
+// The graphics pipeline, its push constants and the mesh buffers must be bound
+void drawCulledObjects(GpuCulling* pCulling, VkCommandBuffer commandBuffer, uint32_t frameIndex, VkPipelineLayout pipelineLayout);
+
+#endif // GPU_CULLING_H
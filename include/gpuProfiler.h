@@ -0,0 +1,125 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define MAX_PROFILER_SCOPES             32
+#define MAX_PROFILER_FRAME_SCOPES       64
+#define MAX_PROFILER_FRAME_STATISTICS   16
+#define MAX_PROFILER_DEPTH              8
+#define PROFILER_HISTORY_SIZE           512
+#define PROFILER_STATISTIC_COUNT        5
+
+// Index of the statistic among the enabled ones, which are in bit order
+#define PROFILER_STATISTIC_FRAGMENT_INVOCATIONS     4
+
+#define PROFILER_STATISTIC_FLAGS (VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT \
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT                        \
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT)
+
+typedef enum ProfilerOutput
+{
+    PROFILER_OUTPUT_NONE,
+    PROFILER_OUTPUT_CSV,
+    PROFILER_OUTPUT_CHROME_TRACE
+} ProfilerOutput;
+
+// Durations of one named scope over the last PROFILER_HISTORY_SIZE frames it was recorded in
+typedef struct ProfilerScope
+{
+    const char*    pName;
+    uint32_t       depth;
+    uint64_t       sampleCount;
+    float          pHistory[PROFILER_HISTORY_SIZE];
+    SDL_bool       hasStatistics;
+    uint64_t       pStatisticSums[PROFILER_STATISTIC_COUNT];
+    uint64_t       statisticSampleCount;
+} ProfilerScope;
+
+// Queries of one frame in flight, read back when the frame slot is reused so the results are never waited on
+typedef struct ProfilerFrame
+{
+    VkQueryPool    timestampPool;
+    VkQueryPool    statisticsPool;
+    SDL_bool       recorded;
+    uint64_t       frameNumber;
+    uint32_t       scopeCount;
+    uint32_t       pScopeIndices[MAX_PROFILER_FRAME_SCOPES];
+    uint32_t       pScopeDepths[MAX_PROFILER_FRAME_SCOPES];
+    uint32_t       pStatisticsSlots[MAX_PROFILER_FRAME_SCOPES];
+    uint32_t       statisticsCount;
+} ProfilerFrame;
+
+typedef struct ProfilerScopeStats
+{
+    uint32_t    sampleCount;
+    float       minMs;
+    float       averageMs;
+    float       p99Ms;
+} ProfilerScopeStats;
+
+typedef struct GpuProfiler
+{
+    VkDevice          device;
+    SDL_bool          enabled;
+    SDL_bool          statisticsSupported;
+    SDL_bool          inheritedQueriesSupported;
+    double            timestampPeriod;
+    uint64_t          timestampMask;
+    uint32_t          frameCount;
+    ProfilerFrame*    pFrames;
+    ProfilerFrame*    pCurrentFrame;
+    uint64_t          recordedFrameCount;
+    uint64_t          resolvedFrameCount;
+    uint64_t          droppedFrameCount;
+    uint32_t          scopeCount;
+    ProfilerScope     pScopes[MAX_PROFILER_SCOPES];
+    uint32_t          openScopeCount;
+    uint32_t          pOpenScopes[MAX_PROFILER_DEPTH];
+    uint32_t          overflowScopeCount;
+    SDL_bool          statisticsOpen;
+    ProfilerOutput    output;
+    FILE*             pOutputFile;
+    SDL_bool          firstTraceEvent;
+    SDL_bool          hasTimeOrigin;
+    uint64_t          timeOrigin;
+} GpuProfiler;
+
+// Results are written to pOutputPath as a Chrome trace when it ends in .json and as CSV otherwise, NULL only keeps the console summary
+Result createGpuProfiler(GpuProfiler* pProfiler, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, const char* pOutputPath);
+
+// The device must be idle, the results of the frames still in flight are collected before the pools are destroyed
+void destroyGpuProfiler(GpuProfiler* pProfiler);
+
+// Call first in the command buffer of frame slot frameIndex, outside of a render pass
+void beginProfilerFrame(GpuProfiler* pProfiler, VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+// pName must outlive the profiler, scopes are told apart by name. Pipeline statistics cannot nest, so they are
+// only collected for the outermost scope asking for them, which must end within the same subpass it began in.
+void beginProfilerScope(GpuProfiler* pProfiler, VkCommandBuffer commandBuffer, const char* pName, SDL_bool collectStatistics);
+
+void endProfilerScope(GpuProfiler* pProfiler, VkCommandBuffer commandBuffer);
+
+// Secondary command buffers executed inside a scope collecting statistics must inherit these. 0 when the device
+// lacks inheritedQueries, such a scope must then not collect statistics at all.
+VkQueryPipelineStatisticFlags getProfilerStatisticFlags(const GpuProfiler* pProfiler);
+
+// Forgets the samples collected so far, for example after a warm-up. Frames still in flight are counted afterwards.
+void resetGpuProfilerStats(GpuProfiler* pProfiler);
+
+// Fails when no frame recorded a scope of that name yet
+Result getProfilerScopeStats(const GpuProfiler* pProfiler, const char* pName, ProfilerScopeStats* pStats);
+
+// Average per frame of one of the PROFILER_STATISTIC_COUNT statistics, fails when the scope never collected any
+Result getProfilerScopeStatistic(const GpuProfiler* pProfiler, const char* pName, uint32_t statistic, double* pAverage);
+
+void printGpuProfilerStats(const GpuProfiler* pProfiler);
+
+#endif // GPU_PROFILER_H
@@ -0,0 +1,45 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "base.h"
+#include "math3d.h"
+
+// The model matrix takes the locations following the vertex attributes of the mesh, one per column
+#define INSTANCE_BINDING            1
+#define INSTANCE_FIRST_LOCATION     3
+
+// Per-instance vertex input of shaders/instanced.vert
+typedef struct InstanceData
+{
+    Mat4    model;
+} InstanceData;
+
+// One object to draw, objects sharing a mesh and a material can be drawn with a single instanced draw
+typedef struct DrawItem
+{
+    uint32_t    mesh;
+    uint32_t    material;
+    uint32_t    object;
+} DrawItem;
+
+// Instances firstInstance to firstInstance + instanceCount - 1 of the sorted items
+typedef struct DrawBatch
+{
+    uint32_t    mesh;
+    uint32_t    material;
+    uint32_t    firstInstance;
+    uint32_t    instanceCount;
+} DrawBatch;
+
+// Appends the per-instance binding and its attributes to the vertex input of the mesh
+void addInstanceInputState(uint32_t* pBindingCount, VkVertexInputBindingDescription* pBindings, uint32_t* pAttributeCount, VkVertexInputAttributeDescription* pAttributes);
+
+// Sorts the items by mesh, material and object and writes a batch for every mesh and material pair.
+// pBatches needs room for itemCount batches. Returns the number of batches.
+uint32_t batchDrawItems(DrawItem* pItems, uint32_t itemCount, DrawBatch* pBatches);
+
+#endif // INSTANCING_H
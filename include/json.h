@@ -0,0 +1,59 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define JSON_NONE UINT32_MAX
+
+typedef enum JsonType
+{
+    JSON_TYPE_NULL,
+    JSON_TYPE_BOOLEAN,
+    JSON_TYPE_NUMBER,
+    JSON_TYPE_STRING,
+    JSON_TYPE_ARRAY,
+    JSON_TYPE_OBJECT
+} JsonType;
+
+// Values are stored in one array and linked by index. Strings and keys point into the source text
+// and are not unescaped, which is enough for the ASCII keys of formats like glTF.
+typedef struct JsonValue
+{
+    JsonType       type;
+    double         number;
+    const char*    pString;
+    uint32_t       stringLength;
+    const char*    pKey;
+    uint32_t       keyLength;
+    uint32_t       childCount;
+    uint32_t       firstChild;
+    uint32_t       lastChild;
+    uint32_t       nextSibling;
+} JsonValue;
+
+typedef struct JsonDocument
+{
+    uint32_t      valueCount;
+    uint32_t      valueCapacity;
+    JsonValue*    pValues;
+} JsonDocument;
+
+// The source text must outlive the document, the root value has index 0
+Result parseJson(const char* pText, size_t length, JsonDocument* pDocument);
+
+void destroyJson(JsonDocument* pDocument);
+
+uint32_t getJsonMember(const JsonDocument* pDocument, uint32_t object, const char* pKey);
+
+uint32_t getJsonElement(const JsonDocument* pDocument, uint32_t array, uint32_t index);
+
+double getJsonNumber(const JsonDocument* pDocument, uint32_t object, const char* pKey, double defaultValue);
+
+SDL_bool isJsonString(const JsonDocument* pDocument, uint32_t value, const char* pString);
+
+#endif // JSON_H
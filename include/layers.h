@@ -3,14 +3,19 @@
 
 #include <stdint.h>
 
+#include <vulkan/vulkan.h>
+
+#include "arena.h"
 #include "base.h"
 
-Result getAvailableInstanceLayers(uint32_t* pLayerCount, char*** pppLayers);
+#define VALIDATION_LAYER_NAME "VK_LAYER_KHRONOS_validation"
 
-Result printAvailableInstanceLayers(uint32_t layerCount, char** ppLayers);
+// The properties are allocated from the arena and live as long as it does
+Result getAvailableInstanceLayers(Arena* pArena, uint32_t* pLayerCount, VkLayerProperties** ppLayers);
 
-Result checkAvailabilityOfRequiredInstanceLayers(uint32_t availableLayerCount, char** ppAvailableLayers, uint32_t requiredLayerCount, const char** ppRequiredLayers);
+// Also lists the extensions of every layer, which asks the loader once per layer
+Result printAvailableInstanceLayers(Arena* pArena, uint32_t layerCount, const VkLayerProperties* pLayers);
 
-void freeInstanceLayers(uint32_t* pAvailableLayerCount, char*** pppAvailableLayers);
+Result checkAvailabilityOfRequiredInstanceLayers(uint32_t availableLayerCount, const VkLayerProperties* pAvailableLayers, uint32_t requiredLayerCount, const char** ppRequiredLayers);
 
 #endif // LAYERS_H
@@ -0,0 +1,35 @@
+#ifndef MATH3D_H
+#define MATH3D_H
+
+// Column-major like GLSL, so matrices can be pushed to shaders as they are
+typedef struct Mat4
+{
+    float m[16];
+} Mat4;
+
+Mat4 identityMat4(void);
+
+Mat4 multiplyMat4(Mat4 a, Mat4 b);
+
+Mat4 translationMat4(float x, float y, float z);
+
+Mat4 scaleMat4(float x, float y, float z);
+
+Mat4 rotationXMat4(float angle);
+
+Mat4 rotationYMat4(float angle);
+
+Mat4 quaternionMat4(float x, float y, float z, float w);
+
+// Right-handed, depth in [0, 1] and Y pointing up on screen
+Mat4 perspectiveMat4(float fovY, float aspect, float zNear, float zFar);
+
+void transformPoint(const Mat4* pMatrix, const float* pPoint, float* pResult);
+
+void transformDirection(const Mat4* pMatrix, const float* pDirection, float* pResult);
+
+// Left, right, bottom, top, near and far planes as (normal, distance) with normalized normals pointing inwards,
+// so a sphere is outside when dot(normal, center) + distance < -radius for any plane
+void getFrustumPlanes(const Mat4* pViewProjection, float pPlanes[6][4]);
+
+#endif // MATH3D_H
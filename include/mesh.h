@@ -0,0 +1,35 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.h"
+#include "base.h"
+#include "meshLoader.h"
+#include "stagingRing.h"
+
+typedef struct Mesh
+{
+    VkBuffer       vertexBuffer;
+    Allocation     vertexAllocation;
+    VkBuffer       indexBuffer;
+    Allocation     indexAllocation;
+    uint32_t       vertexCount;
+    uint32_t       indexCount;
+    VkIndexType    indexType;
+} Mesh;
+
+// Uploads the mesh into device local buffers, 16-bit indices are used whenever the vertex count allows it.
+// The copies are only recorded, flush the staging ring before drawing.
+Result createMesh(Allocator* pAllocator, StagingRing* pRing, const MeshData* pMeshData, Mesh* pMesh);
+
+// Uploads vertices and indices that are already in their final layout, e.g. straight from a mapped mesh cache
+Result createMeshBuffers(Allocator* pAllocator, StagingRing* pRing, uint32_t vertexCount, const Vertex* pVertices, uint32_t indexCount, VkIndexType indexType, const void* pIndices, Mesh* pMesh);
+
+void destroyMesh(Allocator* pAllocator, Mesh* pMesh);
+
+void getVertexInputState(uint32_t* pBindingCount, VkVertexInputBindingDescription* pBindings, uint32_t* pAttributeCount, VkVertexInputAttributeDescription* pAttributes);
+
+#endif // MESH_H
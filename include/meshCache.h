@@ -0,0 +1,63 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+#include "meshLoader.h"
+
+#define MESH_CACHE_MAGIC        0x4D535656 // "VVSM"
+#define MESH_CACHE_VERSION      3
+#define MESH_CACHE_ALIGNMENT    4096
+#define MESH_CACHE_EXTENSION    ".vvmesh"
+
+// Vertices and indices follow at page aligned offsets in exactly the layout the GPU buffers use, so a mapped cache
+// is copied into staging memory as is. The cache is trusted when the size and modification time of the source model
+// match, so a reload reads neither file in full. sourceHash decides when only the time changed, as it does on
+// checkouts. dataHash covers the vertices and indices as written and is only checked on request. Bump
+// MESH_CACHE_VERSION whenever the loader or the vertex layout changes.
+typedef struct MeshCacheHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    vertexStride;
+    uint32_t    indexSize;
+    uint32_t    vertexCount;
+    uint32_t    indexCount;
+    float       pMin[3];
+    float       pMax[3];
+    uint64_t    sourceSize;
+    int64_t     sourceModifiedTime;
+    uint64_t    sourceHash;
+    uint64_t    vertexOffset;
+    uint64_t    indexOffset;
+    uint64_t    dataHash;
+    uint64_t    headerHash;
+} MeshCacheHeader;
+
+typedef struct MeshCache
+{
+    MappedFile         file;
+    MeshCacheHeader    header;
+    const Vertex*      pVertices;
+    const void*        pIndices;
+} MeshCache;
+
+SDL_bool isMeshCachePath(const char* pPath);
+
+// Returns the cache path next to the source model, free it with free()
+char* getMeshCachePath(const char* pSourcePath);
+
+// Pass the source model to reject caches built from another version of it, or NULL to skip the check. verify reads
+// the whole cache, and the source model when given, to check their hashes and the index range.
+Result openMeshCache(const char* pPath, const char* pSourcePath, SDL_bool verify, MeshCache* pCache);
+
+void closeMeshCache(MeshCache* pCache);
+
+Result writeMeshCache(const char* pPath, const char* pSourcePath, const MeshData* pMeshData);
+
+Result convertMesh(const char* pSourcePath);
+
+#endif // MESH_CACHE_H
@@ -0,0 +1,39 @@
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <stdint.h>
+
+#include "base.h"
+
+// Interleaved so a vertex is fetched with a single 32 byte read
+typedef struct Vertex
+{
+    float    position[3];
+    float    normal[3];
+    float    texCoord[2];
+} Vertex;
+
+typedef struct MeshData
+{
+    uint32_t     vertexCount;
+    uint32_t     vertexCapacity;
+    Vertex*      pVertices;
+    uint32_t     indexCount;
+    uint32_t     indexCapacity;
+    uint32_t*    pIndices;
+    float        pMin[3];
+    float        pMax[3];
+} MeshData;
+
+// Loads Wavefront OBJ (.obj) and binary glTF 2.0 (.glb) files. Missing normals are generated
+// and vertices are reordered by first use, so the vertex fetch walks memory mostly linearly.
+Result loadMeshData(const char* pPath, MeshData* pMeshData);
+
+Result createTriangleMeshData(MeshData* pMeshData);
+
+// A flat grid of square cells in the XY plane with exactly triangleCount triangles, for scaling tests
+Result createGridMeshData(uint32_t triangleCount, MeshData* pMeshData);
+
+void destroyMeshData(MeshData* pMeshData);
+
+#endif // MESH_LOADER_H
@@ -0,0 +1,76 @@
+#ifndef PIPELINE_BUILDER_H
+#define PIPELINE_BUILDER_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+#include "threadPool.h"
+
+#define MAX_SHADER_STAGES           2
+#define MAX_VERTEX_BINDINGS         4
+#define MAX_VERTEX_ATTRIBUTES       16
+#define MAX_DYNAMIC_STATES          4
+
+typedef enum PipelineStatus
+{
+    PIPELINE_STATUS_PENDING,
+    PIPELINE_STATUS_READY,
+    PIPELINE_STATUS_FAILED
+} PipelineStatus;
+
+// Owns every state struct a VkGraphicsPipelineCreateInfo points to, so a pipeline description can be
+// copied into a build job and outlive the function that filled it. Pointers are fixed up on submission.
+typedef struct GraphicsPipelineState
+{
+    uint32_t                                  stageCount;
+    VkPipelineShaderStageCreateInfo           pStages[MAX_SHADER_STAGES];
+    uint32_t                                  vertexBindingCount;
+    VkVertexInputBindingDescription           pVertexBindings[MAX_VERTEX_BINDINGS];
+    uint32_t                                  vertexAttributeCount;
+    VkVertexInputAttributeDescription         pVertexAttributes[MAX_VERTEX_ATTRIBUTES];
+    VkPipelineVertexInputStateCreateInfo      vertexInputState;
+    VkPipelineInputAssemblyStateCreateInfo    inputAssemblyState;
+    VkPipelineViewportStateCreateInfo         viewportState;
+    VkPipelineRasterizationStateCreateInfo    rasterizationState;
+    VkPipelineMultisampleStateCreateInfo      multisampleState;
+    VkPipelineDepthStencilStateCreateInfo     depthStencilState;
+    SDL_bool                                  depthStencilEnable;
+    VkPipelineColorBlendAttachmentState       colorBlendAttachment;
+    VkPipelineColorBlendStateCreateInfo       colorBlendState;
+    uint32_t                                  dynamicStateCount;
+    VkDynamicState                            pDynamicStates[MAX_DYNAMIC_STATES];
+    VkPipelineDynamicStateCreateInfo          dynamicState;
+    VkGraphicsPipelineCreateInfo              createInfo;
+} GraphicsPipelineState;
+
+typedef struct PipelineBuildJob PipelineBuildJob;
+
+typedef struct PipelineBuilder
+{
+    VkDevice               device;
+    VkPipelineCache        pipelineCache;
+    ThreadPool             threadPool;
+    uint32_t               jobCount;
+    uint32_t               jobCapacity;
+    PipelineBuildJob**     ppJobs;
+} PipelineBuilder;
+
+void setDefaultGraphicsPipelineState(GraphicsPipelineState* pState);
+
+Result createPipelineBuilder(PipelineBuilder* pBuilder, VkDevice device, VkPipelineCache pipelineCache, uint32_t threadCount);
+
+void destroyPipelineBuilder(PipelineBuilder* pBuilder);
+
+Result submitGraphicsPipelines(PipelineBuilder* pBuilder, uint32_t stateCount, const GraphicsPipelineState* pStates, uint32_t* pFirstPipelineId);
+
+PipelineStatus getPipelineStatus(PipelineBuilder* pBuilder, uint32_t pipelineId);
+
+VkPipeline getPipeline(PipelineBuilder* pBuilder, uint32_t pipelineId);
+
+Result waitForPipelines(PipelineBuilder* pBuilder);
+
+#endif // PIPELINE_BUILDER_H
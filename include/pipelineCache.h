@@ -0,0 +1,14 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include "base.h"
+
+char* getDefaultPipelineCachePath(void);
+
+Result loadPipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const char* pPath, VkPipelineCache* pPipelineCache);
+
+Result savePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache, const char* pPath);
+
+#endif // PIPELINE_CACHE_H
@@ -0,0 +1,45 @@
+#ifndef SAMPLER_CACHE_H
+#define SAMPLER_CACHE_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define MAX_CACHED_SAMPLERS     32
+
+// Everything a sampler is created from, compared as raw bytes, so it has no padding
+typedef struct SamplerKey
+{
+    VkFilter                filter;
+    VkSamplerMipmapMode     mipmapMode;
+    VkSamplerAddressMode    addressMode;
+    float                   maxAnisotropy;
+} SamplerKey;
+
+// Drivers limit the number of samplers and textures tend to use the same few, so they are created once per key
+// and shared. Samplers live as long as the cache.
+typedef struct SamplerCache
+{
+    VkDevice      device;
+    float         maxSupportedAnisotropy;
+    uint32_t      samplerCount;
+    SamplerKey    pKeys[MAX_CACHED_SAMPLERS];
+    VkSampler     pSamplers[MAX_CACHED_SAMPLERS];
+    SDL_mutex*    pMutex;
+} SamplerCache;
+
+Result createSamplerCache(SamplerCache* pCache, VkPhysicalDevice physicalDevice, VkDevice device);
+
+void destroySamplerCache(SamplerCache* pCache);
+
+// Trilinear, repeating and with the most anisotropy the device supports
+void setDefaultSamplerKey(const SamplerCache* pCache, SamplerKey* pKey);
+
+// Thread safe, the anisotropy is clamped to what the device supports
+Result getSampler(SamplerCache* pCache, const SamplerKey* pKey, VkSampler* pSampler);
+
+#endif // SAMPLER_CACHE_H
@@ -0,0 +1,39 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define MAX_CACHED_SHADERS      16
+
+// Shader modules are created once per SPIR-V content and shared by every pipeline using them, they live as long
+// as the cache.
+//
+// With VIEWER_EMBED_SHADERS the SPIR-V is compiled into the executable and nothing is read at runtime. Otherwise
+// it is mapped from shaders/ next to the executable, or from shaders/ one directory above it, which is where
+// multi-config generators and shaders compiled by hand into the source tree leave it. The working directory
+// does not matter either way.
+typedef struct ShaderCache
+{
+    VkDevice          device;
+    char*             pBasePath;
+    uint32_t          shaderCount;
+    uint64_t          pHashes[MAX_CACHED_SHADERS];
+    size_t            pCodeSizes[MAX_CACHED_SHADERS];
+    VkShaderModule    pModules[MAX_CACHED_SHADERS];
+    SDL_mutex*        pMutex;
+} ShaderCache;
+
+Result createShaderCache(ShaderCache* pCache, VkDevice device);
+
+void destroyShaderCache(ShaderCache* pCache);
+
+// Thread safe, pName is the file name of the SPIR-V, e.g. "cull_comp.spv"
+Result getShaderModule(ShaderCache* pCache, const char* pName, VkShaderModule* pModule);
+
+#endif // SHADER_CACHE_H
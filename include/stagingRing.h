@@ -0,0 +1,67 @@
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "allocator.h"
+#include "base.h"
+
+#define DEFAULT_STAGING_RING_SIZE     (16ull * 1024 * 1024)
+#define STAGING_SEGMENT_COUNT         4
+
+// A quarter of the ring, filled and submitted as one batch of copies while the other quarters are in flight
+typedef struct StagingSegment
+{
+    VkCommandBuffer    commandBuffer;
+    VkDeviceSize       usedSize;
+    SDL_bool           recording;
+    uint64_t           timelineValue;
+} StagingSegment;
+
+// Records copies on the transfer queue and signals a timeline semaphore per submitted segment. When the
+// transfer queue belongs to another family than the graphics queue, staged buffers are released to the
+// graphics family and the consumer has to record the matching acquire with acquireStagedBuffer.
+typedef struct StagingRing
+{
+    VkDevice          device;
+    VkQueue           queue;
+    uint32_t          queueFamilyIndex;
+    uint32_t          dstQueueFamilyIndex;
+    Allocator*        pAllocator;
+    VkBuffer          buffer;
+    Allocation        allocation;
+    VkDeviceSize      segmentSize;
+    VkCommandPool     commandPool;
+    VkSemaphore       timelineSemaphore;
+    uint64_t          lastTimelineValue;
+    StagingSegment    pSegments[STAGING_SEGMENT_COUNT];
+    uint32_t          currentSegment;
+    uint64_t          stagedBytes;
+} StagingRing;
+
+Result createStagingRing(StagingRing* pRing, Allocator* pAllocator, VkQueue queue, uint32_t queueFamilyIndex, uint32_t dstQueueFamilyIndex, VkDeviceSize size);
+
+void destroyStagingRing(StagingRing* pRing);
+
+// Copies data into the ring and records a copy into the destination buffer, large data is split across segments
+Result stageBuffer(StagingRing* pRing, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+
+// Call once every copy into the buffer is staged, hands the buffer over to the graphics queue family
+Result releaseStagedBuffer(StagingRing* pRing, VkBuffer buffer);
+
+// Records the acquire half of the ownership transfer on the graphics queue, does nothing within one family
+void acquireStagedBuffer(const StagingRing* pRing, VkCommandBuffer commandBuffer, VkBuffer buffer, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+
+// Submits the pending copies without waiting, the timeline semaphore reaches *pTimelineValue once they completed
+Result submitStagingRing(StagingRing* pRing, uint64_t* pTimelineValue);
+
+// Submits the pending copies and waits until every staged copy has completed
+Result flushStagingRing(StagingRing* pRing);
+
+SDL_bool isTimelineValueReached(const StagingRing* pRing, uint64_t timelineValue);
+
+#endif // STAGING_RING_H
@@ -0,0 +1,68 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "allocator.h"
+#include "base.h"
+#include "threadPool.h"
+
+#define MAX_TEXTURE_LEVELS      16
+#define KTX2_EXTENSION          ".ktx2"
+
+typedef struct Texture
+{
+    VkImage        image;
+    Allocation     allocation;
+    VkImageView    imageView;
+    VkFormat       format;
+    uint32_t       width;
+    uint32_t       height;
+    uint32_t       levelCount;
+    SDL_bool       compressed;
+} Texture;
+
+// uncompressedBytes is what the same textures take as RGBA8 with a full mip chain
+typedef struct TextureLoadStats
+{
+    uint32_t        textureCount;
+    uint32_t        compressedCount;
+    double          decodeMs;
+    double          uploadMs;
+    VkDeviceSize    memoryBytes;
+    VkDeviceSize    uncompressedBytes;
+} TextureLoadStats;
+
+// Decodes images on worker threads and uploads them on the graphics queue, which vkCmdBlitImage needs for the mips
+typedef struct TextureLoader
+{
+    VkPhysicalDevice    physicalDevice;
+    VkDevice            device;
+    Allocator*          pAllocator;
+    VkQueue             queue;
+    VkCommandPool       commandPool;
+    VkFence             fence;
+    ThreadPool          threadPool;
+} TextureLoader;
+
+Result createTextureLoader(TextureLoader* pLoader, VkPhysicalDevice physicalDevice, VkDevice device, Allocator* pAllocator, VkQueue queue, uint32_t queueFamilyIndex,
+    uint32_t threadCount);
+
+void destroyTextureLoader(TextureLoader* pLoader);
+
+// Loads PNG, JPEG and KTX2 files as sRGB color textures. A PNG or JPEG is replaced by a KTX2 file of the same name next
+// to it when that holds BC1, BC3 or BC7 blocks the device can sample. KTX2 files bring their own mips, the mips of
+// decoded images are generated on the GPU. Every texture is uploaded with a single submission, which is waited for.
+// pStats may be NULL.
+Result loadTextures(TextureLoader* pLoader, uint32_t textureCount, const char* const* ppPaths, Texture* pTextures, TextureLoadStats* pStats);
+
+// A single sRGB texel, e.g. to give untextured meshes a white texture to sample
+Result createSolidTexture(TextureLoader* pLoader, const uint8_t pColor[4], Texture* pTexture);
+
+void destroyTexture(TextureLoader* pLoader, Texture* pTexture);
+
+#endif // TEXTURE_H
@@ -0,0 +1,43 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+typedef void (*JobFunction)(void* pUserData);
+
+typedef struct Job
+{
+    JobFunction    function;
+    void*          pUserData;
+} Job;
+
+typedef struct ThreadPool
+{
+    uint32_t        threadCount;
+    SDL_Thread**    ppThreads;
+    SDL_mutex*      pMutex;
+    SDL_cond*       pJobAvailableCondition;
+    SDL_cond*       pIdleCondition;
+    Job*            pJobs;
+    uint32_t        jobCapacity;
+    uint32_t        firstJob;
+    uint32_t        queuedJobCount;
+    uint32_t        runningJobCount;
+    SDL_bool        quit;
+} ThreadPool;
+
+uint32_t getDefaultThreadCount(void);
+
+Result createThreadPool(ThreadPool* pThreadPool, uint32_t threadCount);
+
+void destroyThreadPool(ThreadPool* pThreadPool);
+
+Result submitJob(ThreadPool* pThreadPool, JobFunction function, void* pUserData);
+
+void waitForJobs(ThreadPool* pThreadPool);
+
+#endif // THREAD_POOL_H
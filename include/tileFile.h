@@ -0,0 +1,70 @@
+#ifndef TILE_FILE_H
+#define TILE_FILE_H
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "base.h"
+
+#define TILE_FILE_MAGIC         0x4C545656 // "VVTL"
+#define TILE_FILE_VERSION       1
+#define TILE_FILE_ALIGNMENT     4096
+#define TILE_FILE_EXTENSION     ".vvtiles"
+#define TILE_SIZE               128
+#define TILE_BORDER             4
+#define TILE_SLOT_SIZE          (TILE_SIZE + 2 * TILE_BORDER)
+#define TILE_SLOT_BYTES         (TILE_SLOT_SIZE * TILE_SLOT_SIZE * 4)
+#define MAX_TILE_LEVELS         16
+
+// Tiles of every mip level of an sRGB RGBA8 image, in level order and row-major within a level, starting at
+// TILE_FILE_ALIGNMENT. Each tile is TILE_SIZE texels square with a border of TILE_BORDER texels taken from its
+// neighbours, wrapping around at the edges, so bilinear filtering inside a tile never needs another tile.
+// Levels narrower than a tile sit in the top left corner of their single tile.
+typedef struct TileFileHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    levelCount;
+    uint32_t    tileSize;
+    uint32_t    border;
+    uint32_t    pageCount;
+    uint64_t    sourceSize;
+    int64_t     sourceModifiedTime;
+    uint64_t    headerHash;
+} TileFileHeader;
+
+// Page i of the whole file is tile (i - firstPage) of its level
+typedef struct TileLevel
+{
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    pagesX;
+    uint32_t    pagesY;
+    uint32_t    firstPage;
+} TileLevel;
+
+typedef struct TileFile
+{
+    MappedFile        file;
+    TileFileHeader    header;
+    TileLevel         pLevels[MAX_TILE_LEVELS];
+} TileFile;
+
+// Returns the tile file path next to the source image, free it with free()
+char* getTileFilePath(const char* pSourcePath);
+
+// Pass the source image to reject tile files built from an older version of it, or NULL to skip the check
+Result openTileFile(const char* pPath, const char* pSourcePath, TileFile* pFile);
+
+void closeTileFile(TileFile* pFile);
+
+// Decodes the whole source image once, which is the only time it has to fit into memory
+Result writeTileFile(const char* pPath, const char* pSourcePath);
+
+// TILE_SLOT_BYTES of mapped memory, only read from disk when touched
+const void* getTile(const TileFile* pFile, uint32_t page);
+
+#endif // TILE_FILE_H
@@ -0,0 +1,159 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <SDL.h>
+
+#include "allocator.h"
+#include "base.h"
+#include "samplerCache.h"
+#include "tileFile.h"
+
+#define VIRTUAL_TEXTURE_UPLOADS_PER_FRAME   16
+#define MAX_VIRTUAL_TEXTURE_REQUESTS        4096
+#define VIRTUAL_TEXTURE_QUEUE_SIZE          1024
+
+// Must match the page table of shaders/virtual.frag, the page entries follow it
+typedef struct PageTableHeader
+{
+    uint32_t    frameStamp;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    levelCount;
+    uint32_t    cacheSize;
+    uint32_t    slotsPerRow;
+    uint32_t    sparse;
+    uint32_t    maxRequests;
+    uint32_t    pLevels[MAX_TILE_LEVELS][4];
+} PageTableHeader;
+
+typedef enum PageState
+{
+    PAGE_STATE_NONE,
+    PAGE_STATE_QUEUED,
+    PAGE_STATE_RESIDENT
+} PageState;
+
+typedef enum TileUploadState
+{
+    TILE_UPLOAD_STATE_FREE,
+    TILE_UPLOAD_STATE_LOADING,
+    TILE_UPLOAD_STATE_READY,
+    TILE_UPLOAD_STATE_IN_FLIGHT
+} TileUploadState;
+
+// A tile in staging memory, written by the loader thread and copied into the cache by a frame
+typedef struct TileUpload
+{
+    TileUploadState    state;
+    uint32_t           page;
+    uint64_t           frameNumber;
+} TileUpload;
+
+// The page table the frame samples with and the feedback it writes, which is read once the frame has finished.
+// Sparse binds of the frame signal its bind semaphore, which the submission of the frame waits on.
+typedef struct VirtualTextureFrame
+{
+    VkBuffer           pageTableBuffer;
+    Allocation         pageTableAllocation;
+    VkBuffer           feedbackBuffer;
+    Allocation         feedbackAllocation;
+    VkDescriptorSet    descriptorSet;
+    uint64_t           pageTableVersion;
+    VkSemaphore        bindSemaphore;
+    SDL_bool           bindPending;
+} VirtualTextureFrame;
+
+// Streams the tiles of a texture of any size into a cache of fixed size. The fragment shader records the pages it
+// wants in the feedback buffer and falls back to the nearest coarser resident page meanwhile. A loader thread
+// copies requested tiles out of the mapped tile file into staging memory, frames copy them into the cache and
+// evict the least recently requested pages when it is full. The coarsest levels are pinned.
+//
+// The cache is an atlas of bordered tiles, or a sparse image of the full size when the device supports sparse
+// residency with tiles of TILE_SIZE, whose pages get memory from a fixed pool as they become resident.
+// Either way device memory stays within the budget, only the page table grows with the texture.
+typedef struct VirtualTexture
+{
+    VkDevice                    device;
+    Allocator*                  pAllocator;
+    VkQueue                     queue;
+    VkFence                     bindFence;
+    uint32_t                    frameCount;
+    TileFile                    tileFile;
+    uint32_t                    pageCount;
+    SDL_bool                    sparse;
+    uint32_t                    pinnedFirstLevel;
+    uint32_t                    mipTailFirstLevel;
+    VkImage                     cacheImage;
+    Allocation                  cacheAllocation;
+    Allocation                  mipTailAllocation;
+    VkDeviceSize                sparsePageSize;
+    VkImageView                 cacheImageView;
+    VkSampler                   sampler;
+    SDL_bool                    cacheInitialized;
+    uint32_t                    slotsPerRow;
+    uint32_t                    slotCount;
+    uint32_t*                   pPageTable;
+    uint8_t*                    pPageStates;
+    uint64_t                    pageTableVersion;
+    uint32_t*                   pSlotPages;
+    uint64_t*                   pSlotLastUsed;
+    uint32_t*                   pSlotPrevious;
+    uint32_t*                   pSlotNext;
+    uint32_t                    lruHead;
+    uint32_t                    lruTail;
+    uint32_t*                   pFreeSlots;
+    uint32_t                    freeSlotCount;
+    uint32_t*                   pReleasedSlots;
+    uint64_t*                   pReleaseFrames;
+    uint32_t                    releasedFirst;
+    uint32_t                    releasedCount;
+    uint32_t                    uploadCount;
+    TileUpload*                 pUploads;
+    VkBuffer                    stagingBuffer;
+    Allocation                  stagingAllocation;
+    VkBufferImageCopy*          pCopies;
+    VkSparseImageMemoryBind*    pSparseBinds;
+    uint32_t                    pRequests[VIRTUAL_TEXTURE_QUEUE_SIZE];
+    uint32_t                    requestFirst;
+    uint32_t                    requestCount;
+    SDL_Thread*                 pLoaderThread;
+    SDL_mutex*                  pMutex;
+    SDL_cond*                   pCondition;
+    SDL_bool                    quit;
+    VkDescriptorPool            descriptorPool;
+    VirtualTextureFrame*        pFrames;
+    uint64_t                    uploadedTileCount;
+    uint64_t                    evictedTileCount;
+    uint32_t                    residentPageCount;
+} VirtualTexture;
+
+// Set 2 of shaders/virtual.frag: page cache, page table and feedback
+Result createVirtualTextureSetLayout(VkDevice device, VkDescriptorSetLayout* pSetLayout);
+
+// pPath is a tile file or an image, which is converted into a tile file next to it on first use. The queue is used
+// to bind sparse memory and must be the one the frames are submitted to. budget is in bytes of device memory.
+Result createVirtualTexture(VirtualTexture* pTexture, VkPhysicalDevice physicalDevice, VkDevice device, Allocator* pAllocator, SamplerCache* pSamplerCache,
+    VkQueue queue, uint32_t queueFamilyIndex, VkDescriptorSetLayout setLayout, uint32_t frameCount, const char* pPath, VkDeviceSize budget, SDL_bool sparseSupported);
+
+// The device must be idle
+void destroyVirtualTexture(VirtualTexture* pTexture);
+
+// Outside of a render pass, once the fence of the frame has been waited for. Queues the pages requested the last
+// time the frame ran, records the copies of loaded tiles and publishes the page table the frame samples with.
+Result updateVirtualTexture(VirtualTexture* pTexture, VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber);
+
+// Signaled by the sparse binds of the last update of the frame, which its submission must wait on before copying
+// into or sampling the cache. VK_NULL_HANDLE when nothing was bound.
+VkSemaphore getVirtualTextureBindSemaphore(const VirtualTexture* pTexture, uint32_t frameIndex);
+
+// After the render pass, makes the feedback written by the fragment shader visible to the CPU
+void finishVirtualTextureFrame(VkCommandBuffer commandBuffer);
+
+// Device memory of the cache and the staging tiles, which is what the budget bounds
+VkDeviceSize getVirtualTextureMemory(const VirtualTexture* pTexture);
+
+#endif // VIRTUAL_TEXTURE_H
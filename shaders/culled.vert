@@ -0,0 +1,30 @@
+#version 450
+
+// The draws written by cull.comp put the object index into firstInstance
+layout(set = 0, binding = 0) readonly buffer Objects
+{
+    vec4 positionScales[];
+} objects;
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+    mat4 rotation;
+} pushConstants;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outTexCoord;
+
+void main()
+{
+    vec4 positionScale = objects.positionScales[gl_InstanceIndex];
+    vec3 worldPosition = positionScale.xyz + positionScale.w * (pushConstants.rotation * vec4(inPosition, 1.0)).xyz;
+
+    gl_Position = pushConstants.viewProjection * vec4(worldPosition, 1.0);
+    outNormal = mat3(pushConstants.rotation) * inNormal;
+    outTexCoord = inTexCoord;
+}
@@ -0,0 +1,23 @@
+#version 450
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+} pushConstants;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+// Per-instance binding, one column per location
+layout(location = 3) in mat4 inModel;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outTexCoord;
+
+void main()
+{
+    gl_Position = pushConstants.viewProjection * inModel * vec4(inPosition, 1.0);
+    outNormal = mat3(inModel) * inNormal;
+    outTexCoord = inTexCoord;
+}
@@ -0,0 +1,16 @@
+#version 450
+
+layout(set = 1, binding = 0) uniform sampler2D baseColor;
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec2 inTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    vec3 lightDirection = normalize(vec3(0.4, 0.8, 0.6));
+    float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0);
+    vec4 color = texture(baseColor, inTexCoord);
+    outColor = vec4(color.rgb * (0.15 + 0.85 * diffuse), color.a);
+}
@@ -0,0 +1,21 @@
+#version 450
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 modelViewProjection;
+    mat4 model;
+} pushConstants;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outTexCoord;
+
+void main()
+{
+    gl_Position = pushConstants.modelViewProjection * vec4(inPosition, 1.0);
+    outNormal = mat3(pushConstants.model) * inNormal;
+    outTexCoord = inTexCoord;
+}
@@ -0,0 +1,116 @@
+#version 450
+
+// Must match TILE_SIZE and TILE_BORDER of include/tileFile.h
+const uint TILE_SIZE = 128;
+const uint TILE_BORDER = 4;
+const uint TILE_SLOT_SIZE = TILE_SIZE + 2 * TILE_BORDER;
+
+// Stores would otherwise move the depth test after the shader, which would also request pages of hidden surfaces
+layout(early_fragment_tests) in;
+
+layout(set = 2, binding = 0) uniform sampler2D pageCache;
+
+// Must match PageTableHeader of include/virtualTexture.h. A page entry is its cache slot + 1, or 0 while not resident.
+// levels holds the first page, pages per row, width and height of each level.
+layout(std430, set = 2, binding = 1) readonly buffer PageTable
+{
+    uint frameStamp;
+    uint width;
+    uint height;
+    uint levelCount;
+    uint cacheSize;
+    uint slotsPerRow;
+    uint sparse;
+    uint maxRequests;
+    uvec4 levels[16];
+    uint pages[];
+} pageTable;
+
+// The first maxRequests entries list the requested pages, then each page holds the frame stamp of its last request
+layout(std430, set = 2, binding = 2) buffer Feedback
+{
+    uint requestCount;
+    uint requests[];
+} feedback;
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec2 inTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+uvec2 getPageCoordinates(vec2 uv, uint level)
+{
+    uvec4 levelInfo = pageTable.levels[level];
+    uvec2 texel = min(uvec2(uv * vec2(levelInfo.zw)), levelInfo.zw - 1);
+    return texel / TILE_SIZE;
+}
+
+uint getPage(uvec2 pageCoordinates, uint level)
+{
+    uvec4 levelInfo = pageTable.levels[level];
+    return levelInfo.x + pageCoordinates.y * levelInfo.y + pageCoordinates.x;
+}
+
+void requestPage(uint page)
+{
+    // Only the first fragment to want the page this frame appends it
+    uint stampIndex = pageTable.maxRequests + page;
+    if (feedback.requests[stampIndex] == pageTable.frameStamp)
+    {
+        return;
+    }
+
+    if (atomicExchange(feedback.requests[stampIndex], pageTable.frameStamp) != pageTable.frameStamp)
+    {
+        uint index = atomicAdd(feedback.requestCount, 1);
+        if (index < pageTable.maxRequests)
+        {
+            feedback.requests[index] = page;
+        }
+    }
+}
+
+vec4 sampleVirtualTexture(vec2 texCoord)
+{
+    vec2 uv = fract(texCoord);
+
+    vec2 texel = texCoord * vec2(pageTable.width, pageTable.height);
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    uint wantedLevel = uint(clamp(floor(lod), 0.0, float(pageTable.levelCount - 1)));
+
+    requestPage(getPage(getPageCoordinates(uv, wantedLevel), wantedLevel));
+
+    // The nearest coarser resident page stands in until the wanted one arrives
+    for (uint level = wantedLevel; level < pageTable.levelCount; ++level)
+    {
+        uvec2 pageCoordinates = getPageCoordinates(uv, level);
+        uint entry = pageTable.pages[getPage(pageCoordinates, level)];
+        if (entry == 0)
+        {
+            continue;
+        }
+
+        if (pageTable.sparse != 0)
+        {
+            return textureLod(pageCache, uv, float(level));
+        }
+
+        uint slot = entry - 1;
+        vec2 slotOrigin = vec2(slot % pageTable.slotsPerRow, slot / pageTable.slotsPerRow) * float(TILE_SLOT_SIZE) + float(TILE_BORDER);
+        vec2 insideTile = uv * vec2(pageTable.levels[level].zw) - vec2(pageCoordinates * TILE_SIZE);
+        return textureLod(pageCache, (slotOrigin + insideTile) / float(pageTable.cacheSize), 0.0);
+    }
+
+    // Nothing is resident before the first tiles have been copied
+    return vec4(0.5, 0.5, 0.5, 1.0);
+}
+
+void main()
+{
+    vec3 lightDirection = normalize(vec3(0.4, 0.8, 0.6));
+    float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0);
+    vec4 color = sampleVirtualTexture(inTexCoord);
+    outColor = vec4(color.rgb * (0.15 + 0.85 * diffuse), color.a);
+}
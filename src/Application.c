@@ -1,13 +1,25 @@
 #include "Application.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
+#include "capabilityCache.h"
+#include "cpuTrace.h"
+#include "deviceSelection.h"
 #include "extensions.h"
+#include "math3d.h"
 #include "layers.h"
+#include "mesh.h"
+#include "meshCache.h"
+#include "meshLoader.h"
+#include "pipelineBuilder.h"
+#include "pipelineCache.h"
 
 static Result createWindow(Application* pApplication);
 
+#ifdef VIEWER_VALIDATION
 static VKAPI_ATTR VkBool32 debugUtilsMessengerCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT         messageSeverity,
     VkDebugUtilsMessageTypeFlagsEXT                messageTypes,
@@ -15,11 +27,14 @@ static VKAPI_ATTR VkBool32 debugUtilsMessengerCallback(
     void*                                          pUserData);
 
 static Result createDebugUtilsMessenger(Application* pApplication, VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo);
+#endif
 
 static Result createInstance(Application* pApplication);
 
 static Result getPhysicalDevice(Application* pApplication);
 
+static Result findQueueFamilies(Application* pApplication, uint32_t* pTransferQueueIndex);
+
 static Result createDevice(Application* pApplication);
 
 static Result createSurface(Application* pApplication);
@@ -30,7 +45,15 @@ static Result getSwapchainImages(Application* pApplication);
 
 static Result createSwapchainImageViews(Application* pApplication);
 
-static Result createShaderModule(Application* pApplication, const char* pShaderPath, VkShaderModule* pModule);
+static void destroySwapchainResources(Application* pApplication);
+
+static Result recreateSwapchain(Application* pApplication);
+
+static Result createHeadlessImages(Application* pApplication);
+
+static Result createPipelineCache(Application* pApplication);
+
+static Result startPipelineBuilder(Application* pApplication);
 
 static Result createPipelineLayout(Application* pApplication);
 
@@ -38,40 +61,198 @@ static Result createRenderPass(Application* pApplication);
 
 static Result createGraphicsPipeline(Application* pApplication);
 
-Result createApplication(Application* pApplication)
+static Result loadMesh(Application* pApplication);
+
+static int loadMeshThread(void* pData);
+
+static Result createTextures(Application* pApplication);
+
+static Result createVirtualTexturing(Application* pApplication);
+
+static VkFormat getDepthFormat(Application* pApplication);
+
+static Result createDepthImage(Application* pApplication);
+
+static Result createFramebuffers(Application* pApplication);
+
+static Result createCommandPool(Application* pApplication);
+
+static Result createFrames(Application* pApplication);
+
+static Result createRecordJobs(Application* pApplication);
+
+static Result createCulling(Application* pApplication);
+
+static Result createCpuObjectCulling(Application* pApplication);
+
+static Result createInstancing(Application* pApplication);
+
+static Result createDrawSorting(Application* pApplication);
+
+static Result createSyncObjects(Application* pApplication);
+
+static Result recordCommandBuffer(Application* pApplication, VkCommandBuffer commandBuffer, uint32_t imageIndex, SDL_bool acquireMesh);
+
+static uint32_t getMeshPipelineId(const Application* pApplication);
+
+static void getGridLayout(uint32_t objectCount, uint32_t* pGridSize, float* pCellSize);
+
+static void getGridObject(uint32_t index, uint32_t gridSize, float cellSize, float* pPositionScale);
+
+static Mat4 getObjectModel(const DrawList* pDrawList, uint32_t objectIndex);
+
+static void markStartupStep(Application* pApplication, const char* pName);
+
+static void bindMesh(const Application* pApplication, VkCommandBuffer commandBuffer, VkPipeline pipeline);
+
+static void sortDrawList(Application* pApplication, uint32_t pipelineId);
+
+static void recordDraws(const Application* pApplication, VkCommandBuffer commandBuffer, uint32_t firstDraw, uint32_t drawCount);
+
+static void recordCulledDraws(Application* pApplication, VkCommandBuffer commandBuffer);
+
+static uint32_t recordInstancedDraws(Application* pApplication, VkCommandBuffer commandBuffer);
+
+static Result recordSecondaryCommandBuffers(Application* pApplication, VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+static void recordJob(void* pUserData);
+
+Result createApplication(Application* pApplication, const Config* pConfig)
 {
+    pApplication->config = *pConfig;
     pApplication->pWindow = NULL;
     pApplication->instance = NULL;
+    pApplication->validationLevel = VALIDATION_LEVEL_OFF;
+#ifdef VIEWER_VALIDATION
+    memset(&pApplication->debugLog, 0, sizeof(pApplication->debugLog));
     pApplication->debugUtilsMessenger = NULL;
+#endif
     pApplication->physicalDevice = NULL;
     pApplication->device = NULL;
+    pApplication->queue = NULL;
+    pApplication->transferQueue = NULL;
+    memset(&pApplication->allocator, 0, sizeof(pApplication->allocator));
+    memset(&pApplication->stagingRing, 0, sizeof(pApplication->stagingRing));
     pApplication->surface = NULL;
     pApplication->swapchain = NULL;
+    pApplication->swapchainOutdated = SDL_FALSE;
+    pApplication->presentMode = VK_PRESENT_MODE_FIFO_KHR;
     pApplication->pSwapchainImages = NULL;
     pApplication->pSwapchainImageViews = NULL;
+    pApplication->pHeadlessImageAllocations = NULL;
+    pApplication->depthFormat = VK_FORMAT_UNDEFINED;
+    pApplication->depthImage = NULL;
+    memset(&pApplication->depthImageAllocation, 0, sizeof(pApplication->depthImageAllocation));
+    pApplication->depthImageView = NULL;
+    pApplication->pFramebuffers = NULL;
+    pApplication->pRenderFinishedSemaphores = NULL;
+    pApplication->pImageFences = NULL;
+    pApplication->pipelineCache = NULL;
+    pApplication->pPipelineCachePath = NULL;
+    pApplication->objectSetLayout = NULL;
+    pApplication->materialSetLayout = NULL;
+    pApplication->virtualTextureSetLayout = NULL;
     pApplication->pipelineLayout = NULL;
     pApplication->renderPass = NULL;
-    pApplication->pipeline = NULL;
-
-    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    memset(&pApplication->shaderCache, 0, sizeof(pApplication->shaderCache));
+    pApplication->vertShaderModule = NULL;
+    pApplication->fragShaderModule = NULL;
+    pApplication->culledVertShaderModule = NULL;
+    pApplication->instancedVertShaderModule = NULL;
+    memset(&pApplication->pipelineBuilder, 0, sizeof(pApplication->pipelineBuilder));
+    pApplication->meshPipeline = UINT32_MAX;
+    pApplication->culledPipeline = UINT32_MAX;
+    pApplication->instancedPipeline = UINT32_MAX;
+    pApplication->drawIndirectCountSupported = SDL_FALSE;
+    pApplication->sparseResidencySupported = SDL_FALSE;
+    pApplication->gpuCullingEnabled = SDL_FALSE;
+    memset(&pApplication->gpuCulling, 0, sizeof(pApplication->gpuCulling));
+    pApplication->cpuCullingEnabled = SDL_FALSE;
+    memset(&pApplication->objectBounds, 0, sizeof(pApplication->objectBounds));
+    memset(&pApplication->cullingThreadPool, 0, sizeof(pApplication->cullingThreadPool));
+    memset(&pApplication->cpuCulling, 0, sizeof(pApplication->cpuCulling));
+    pApplication->instancingEnabled = SDL_FALSE;
+    pApplication->pDrawItems = NULL;
+    pApplication->pDrawBatches = NULL;
+    pApplication->drawSortEnabled = SDL_FALSE;
+    memset(&pApplication->drawSorter, 0, sizeof(pApplication->drawSorter));
+    memset(pApplication->pInstanceBuffers, 0, sizeof(pApplication->pInstanceBuffers));
+    memset(pApplication->pInstanceAllocations, 0, sizeof(pApplication->pInstanceAllocations));
+    memset(&pApplication->mesh, 0, sizeof(pApplication->mesh));
+    pApplication->pMeshLoaderThread = NULL;
+    SDL_AtomicSet(&pApplication->meshState, MESH_STATE_LOADING);
+    pApplication->meshTimelineValue = 0;
+    pApplication->meshReady = SDL_FALSE;
+    pApplication->meshRadius = 1.0f;
+    memset(&pApplication->textureLoader, 0, sizeof(pApplication->textureLoader));
+    memset(&pApplication->samplerCache, 0, sizeof(pApplication->samplerCache));
+    memset(&pApplication->texture, 0, sizeof(pApplication->texture));
+    pApplication->materialDescriptorPool = NULL;
+    pApplication->materialDescriptorSet = NULL;
+    pApplication->virtualTextureEnabled = SDL_FALSE;
+    memset(&pApplication->virtualTexture, 0, sizeof(pApplication->virtualTexture));
+    pApplication->startTicks = SDL_GetPerformanceCounter();
+    pApplication->startupStepCount = 0;
+    pApplication->startupStepTicks = pApplication->startTicks;
+    pApplication->pipelinesReady = SDL_FALSE;
+    pApplication->commandPool = NULL;
+    memset(&pApplication->drawList, 0, sizeof(pApplication->drawList));
+    memset(&pApplication->recordThreadPool, 0, sizeof(pApplication->recordThreadPool));
+    pApplication->recordJobCount = 0;
+    pApplication->pRecordJobs = NULL;
+    pApplication->frameCount = pConfig->framesInFlight;
+    pApplication->pFrames = NULL;
+    pApplication->currentFrame = 0;
+    pApplication->frameNumber = 0;
+    memset(&pApplication->gpuProfiler, 0, sizeof(pApplication->gpuProfiler));
+    pApplication->waitTicks = 0;
+    pApplication->recordTicks = 0;
+    pApplication->cullTicks = 0;
+    pApplication->sortTicks = 0;
+    pApplication->sortedDrawSum = 0;
+    pApplication->reorderedDrawSum = 0;
+    pApplication->drawnObjectSum = 0;
+    pApplication->drawCallSum = 0;
+    pApplication->inputTicks = 0;
+    memset(&pApplication->inputLatency, 0, sizeof(pApplication->inputLatency));
+
+    // Render farm nodes have no display, so headless mode must not touch the video subsystem
+    SDL_bool headless = pConfig->headless;
+    if (SDL_Init((headless == SDL_TRUE) ? SDL_INIT_EVENTS : SDL_INIT_VIDEO) < 0)
     {
         printError("Failed to initialize SDL library!");
         return FAIL;
     }
 
-    if (createWindow(pApplication) != SUCCESS)
+    markStartupStep(pApplication, "SDL");
+
+    if ((headless != SDL_TRUE) && (createWindow(pApplication) != SUCCESS))
     {
         printError("Failed to create window!");
         destroyApplication(pApplication);
         return FAIL;
     }
 
+    markStartupStep(pApplication, "window");
+
     if (createInstance(pApplication) != SUCCESS)
     {
         destroyApplication(pApplication);
         return FAIL;
     }
 
+    markStartupStep(pApplication, "instance");
+
+    // The queue family selection needs the surface to check for presentation support
+    if ((headless != SDL_TRUE) && (createSurface(pApplication) != SUCCESS))
+    {
+        printError("Failed to create surface!");
+        destroyApplication(pApplication);
+        return FAIL;
+    }
+
+    markStartupStep(pApplication, "surface");
+
     if (getPhysicalDevice(pApplication) != SUCCESS)
     {
         printError("Failed to get physical device!");
@@ -79,6 +260,8 @@ Result createApplication(Application* pApplication)
         return FAIL;
     }
 
+    markStartupStep(pApplication, "device selection");
+
     if (createDevice(pApplication) != SUCCESS)
     {
         printError("Failed to create device!");
@@ -86,27 +269,48 @@ Result createApplication(Application* pApplication)
         return FAIL;
     }
 
-    vkGetDeviceQueue(pApplication->device, 0, 0, &pApplication->queue);
+    markStartupStep(pApplication, "device");
 
-    if (createSurface(pApplication) != SUCCESS)
+    if (createAllocator(&pApplication->allocator, pApplication->physicalDevice, pApplication->device) != SUCCESS)
     {
-        printError("Failed to create surface!");
+        printError("Failed to create allocator!");
         destroyApplication(pApplication);
         return FAIL;
     }
 
-    if (createSwapchain(pApplication) != SUCCESS)
+    if (createStagingRing(&pApplication->stagingRing, &pApplication->allocator, pApplication->transferQueue, pApplication->transferQueueFamily, pApplication->graphicsQueueFamily, DEFAULT_STAGING_RING_SIZE) != SUCCESS)
     {
-        printError("Failed to create swapchain!");
+        printError("Failed to create staging ring!");
         destroyApplication(pApplication);
         return FAIL;
     }
 
-    if (getSwapchainImages(pApplication) != SUCCESS)
+    markStartupStep(pApplication, "allocators");
+
+    if (headless == SDL_TRUE)
     {
-        printError("Failed to get swapchain images!");
-        destroyApplication(pApplication);
-        return FAIL;
+        if (createHeadlessImages(pApplication) != SUCCESS)
+        {
+            printError("Failed to create headless images!");
+            destroyApplication(pApplication);
+            return FAIL;
+        }
+    }
+    else
+    {
+        if (createSwapchain(pApplication) != SUCCESS)
+        {
+            printError("Failed to create swapchain!");
+            destroyApplication(pApplication);
+            return FAIL;
+        }
+
+        if (getSwapchainImages(pApplication) != SUCCESS)
+        {
+            printError("Failed to get swapchain images!");
+            destroyApplication(pApplication);
+            return FAIL;
+        }
     }
 
     if (createSwapchainImageViews(pApplication) != SUCCESS)
@@ -116,6 +320,24 @@ Result createApplication(Application* pApplication)
         return FAIL;
     }
 
+    markStartupStep(pApplication, "swapchain");
+
+    if (createPipelineCache(pApplication) != SUCCESS)
+    {
+        printError("Failed to create pipeline cache!");
+        destroyApplication(pApplication);
+        return FAIL;
+    }
+
+    markStartupStep(pApplication, "pipeline cache");
+
+    if (startPipelineBuilder(pApplication) != SUCCESS)
+    {
+        printError("Failed to create pipeline builder!");
+        destroyApplication(pApplication);
+        return FAIL;
+    }
+
     if (createPipelineLayout(pApplication) != SUCCESS)
     {
         printError("Failed to create pipeline layout!");
@@ -130,6 +352,13 @@ Result createApplication(Application* pApplication)
         return FAIL;
     }
 
+    if (createShaderCache(&pApplication->shaderCache, pApplication->device) != SUCCESS)
+    {
+        printError("Failed to create shader cache!");
+        destroyApplication(pApplication);
+        return FAIL;
+    }
+
     if (createGraphicsPipeline(pApplication) != SUCCESS)
     {
         printError("Failed to create graphics pipeline!");
@@ -137,721 +366,2802 @@ Result createApplication(Application* pApplication)
         return FAIL;
     }
 
-    return SUCCESS;
-}
-
-void destroyApplication(Application* pApplication)
-{
-    vkDestroyPipeline(pApplication->device, pApplication->pipeline, NULL);
-
-    vkDestroyRenderPass(pApplication->device, pApplication->renderPass, NULL);
-
-    vkDestroyPipelineLayout(pApplication->device, pApplication->pipelineLayout, NULL);
+    markStartupStep(pApplication, "pipeline requests");
 
-    if (pApplication->pSwapchainImageViews != NULL)
+    // With a queue of its own the mesh streams in while frames are presented, otherwise it is loaded up front.
+    // Either way the builder threads compile the pipeline meanwhile.
+    if (pApplication->transferQueue != pApplication->queue)
     {
-        for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+        pApplication->pMeshLoaderThread = SDL_CreateThread(loadMeshThread, "mesh loader", pApplication);
+        if (pApplication->pMeshLoaderThread == NULL)
         {
-            vkDestroyImageView(pApplication->device, pApplication->pSwapchainImageViews[i], NULL);
+            printError("Failed to create mesh loader thread!");
+            destroyApplication(pApplication);
+            return FAIL;
         }
     }
-
-    free(pApplication->pSwapchainImageViews);
-
-    free(pApplication->pSwapchainImages);
-
-    vkDestroySwapchainKHR(pApplication->device, pApplication->swapchain, NULL);
-
-    vkDestroySurfaceKHR(pApplication->instance, pApplication->surface, NULL);
-
-    vkDestroyDevice(pApplication->device, NULL);
-
-    PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessengerEXT = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(pApplication->instance, "vkDestroyDebugUtilsMessengerEXT");
-    vkDestroyDebugUtilsMessengerEXT(pApplication->instance, pApplication->debugUtilsMessenger, NULL);
-
-    vkDestroyInstance(pApplication->instance, NULL);
-
-    if (pApplication->pWindow != NULL)
+    else
     {
-        SDL_DestroyWindow(pApplication->pWindow);
+        loadMeshThread(pApplication);
+        if (SDL_AtomicGet(&pApplication->meshState) == MESH_STATE_FAILED)
+        {
+            printError("Failed to load mesh!");
+            destroyApplication(pApplication);
+            return FAIL;
+        }
     }
 
-    SDL_Quit();
-}
-
-Result createWindow(Application* pApplication)
-{
-    pApplication->pWindow = SDL_CreateWindow("Viewer", 100, 100, 1600, 900, SDL_WINDOW_VULKAN);
-    return (pApplication->pWindow == NULL) ? FAIL : SUCCESS;
-}
+    markStartupStep(pApplication, "mesh");
 
-VKAPI_ATTR VkBool32 debugUtilsMessengerCallback(
-    VkDebugUtilsMessageSeverityFlagBitsEXT         messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT                messageTypes,
-    const VkDebugUtilsMessengerCallbackDataEXT*    pCallbackData,
-    void*                                          pUserData)
-{
-    if (messageSeverity < VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
-    {
-        printf("%s\n", pCallbackData->pMessage);
-        printf("\n");
-    }
-    else
+    if (createTextures(pApplication) != SUCCESS)
     {
-        fprintf(stderr, "%s\n", pCallbackData->pMessage);
-        fprintf(stderr, "\n");
+        printError("Failed to create textures!");
+        destroyApplication(pApplication);
+        return FAIL;
     }
 
-    return VK_FALSE;
-}
-
-Result createDebugUtilsMessenger(Application* pApplication, VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo)
-{
-    PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessengerEXT = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(pApplication->instance, "vkCreateDebugUtilsMessengerEXT");
-    int result = vkCreateDebugUtilsMessengerEXT(pApplication->instance, pCreateInfo, NULL, &pApplication->debugUtilsMessenger);
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
-}
-
-Result createInstance(Application* pApplication)
-{
-    uint32_t apiVersion;
-    vkEnumerateInstanceVersion(&apiVersion);
-
-    VkApplicationInfo applicationInfo;
-    applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-    applicationInfo.pNext = NULL;
-    applicationInfo.pApplicationName = "Vulkan viewer";
-    applicationInfo.applicationVersion = 1;
-    applicationInfo.pEngineName = NULL;
-    applicationInfo.engineVersion = 0;
-    applicationInfo.apiVersion = apiVersion;
-
-    VkDebugUtilsMessengerCreateInfoEXT debugUtilsMessengerCreateInfo;
-    debugUtilsMessengerCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-    debugUtilsMessengerCreateInfo.pNext = NULL;
-    debugUtilsMessengerCreateInfo.flags = 0;
-    debugUtilsMessengerCreateInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT
-                                                    // | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT
-                                                    | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT
-                                                    | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-    debugUtilsMessengerCreateInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT
-                                                | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
-                                                | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT
-                                                | VK_DEBUG_UTILS_MESSAGE_TYPE_DEVICE_ADDRESS_BINDING_BIT_EXT;
-    debugUtilsMessengerCreateInfo.pfnUserCallback = debugUtilsMessengerCallback;
-    debugUtilsMessengerCreateInfo.pUserData = NULL;
-
-    VkValidationFeatureEnableEXT pEnabledValidationFeatures[4] = {VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT,
-                                                                  VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT,
-                                                                  VK_VALIDATION_FEATURE_ENABLE_BEST_PRACTICES_EXT,
-                                                                  VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT};
+    markStartupStep(pApplication, "textures");
 
-    VkValidationFeaturesEXT validationFeatures;
-    validationFeatures.sType = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
-    validationFeatures.pNext = &debugUtilsMessengerCreateInfo;
-    validationFeatures.enabledValidationFeatureCount = 4;
-    validationFeatures.pEnabledValidationFeatures = pEnabledValidationFeatures;
-    validationFeatures.disabledValidationFeatureCount = 0;
-    validationFeatures.pDisabledValidationFeatures = NULL;
+    if (createVirtualTexturing(pApplication) != SUCCESS)
+    {
+        printError("Failed to create virtual texturing!");
+        destroyApplication(pApplication);
+        return FAIL;
+    }
 
-    uint32_t        availableLayerCount = 0;
-    char**          ppAvailableLayers = NULL;
-    uint32_t        availableExtensionCount = 0;
-    char**          ppAvailableExtensions = NULL;
-    uint32_t        requiredLayerCount = 1;
-    const char*     ppRequiredLayers[1] = {"VK_LAYER_KHRONOS_validation"};
-    unsigned int    requiredExtensionCount = 0;
-    const char**    ppRequiredExtensions = NULL;
+    markStartupStep(pApplication, "virtual texture");
 
-    if (getAvailableInstanceLayers(&availableLayerCount, &ppAvailableLayers) != SUCCESS)
+    if (createFramebuffers(pApplication) != SUCCESS)
     {
-        printError("Failed to get available instance layers!");
-        freeInstanceLayers(&availableLayerCount, &ppAvailableLayers);
+        printError("Failed to create framebuffers!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    if (printAvailableInstanceLayers(availableLayerCount, ppAvailableLayers) != SUCCESS)
+    if (createCommandPool(pApplication) != SUCCESS)
     {
-        printError("Failed to print available instance layers!");
-        freeInstanceLayers(&availableLayerCount, &ppAvailableLayers);
+        printError("Failed to create command pool!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    if (checkAvailabilityOfRequiredInstanceLayers(availableLayerCount, ppAvailableLayers, requiredLayerCount, ppRequiredLayers) != SUCCESS)
+    if (createFrames(pApplication) != SUCCESS)
     {
-        printError("Some of required layers are not available!");
-        freeInstanceLayers(&availableLayerCount, &ppAvailableLayers);
+        printError("Failed to create frames!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    if (getAvailableInstanceExtensions(&availableExtensionCount, &ppAvailableExtensions) != SUCCESS)
+    if (createRecordJobs(pApplication) != SUCCESS)
     {
-        printError("Failed to get available instance extensions!");
-        freeInstanceExtensions(&availableExtensionCount, &ppAvailableExtensions, &requiredExtensionCount, &ppRequiredExtensions);
-        freeInstanceLayers(&availableLayerCount, &ppAvailableLayers);
+        printError("Failed to create record jobs!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    printAvailableInstanceExtensions(availableExtensionCount, ppAvailableExtensions);
+    markStartupStep(pApplication, "frames");
 
-    if (getRequiredInstanceExtensions(pApplication->pWindow, &requiredExtensionCount, &ppRequiredExtensions) != SUCCESS)
+    if (createCulling(pApplication) != SUCCESS)
     {
-        printError("Failed to get required extensions!");
-        freeInstanceExtensions(&availableExtensionCount, &ppAvailableExtensions, &requiredExtensionCount, &ppRequiredExtensions);
-        freeInstanceLayers(&availableLayerCount, &ppAvailableLayers);
+        printError("Failed to create culling!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    printRequiredInstanceExtensions(requiredExtensionCount, ppRequiredExtensions);
-
-    VkInstanceCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    createInfo.pNext = &validationFeatures;
-    createInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
-    createInfo.pApplicationInfo = &applicationInfo;
-    createInfo.enabledLayerCount = requiredLayerCount;
-    createInfo.ppEnabledLayerNames = ppRequiredLayers;
-    createInfo.enabledExtensionCount = requiredExtensionCount;
-    createInfo.ppEnabledExtensionNames = ppRequiredExtensions;
-
-    int result = vkCreateInstance(&createInfo, NULL, &pApplication->instance);
-
-    freeInstanceExtensions(&availableExtensionCount, &ppAvailableExtensions, &requiredExtensionCount, &ppRequiredExtensions);
-    freeInstanceLayers(&availableLayerCount, &ppAvailableLayers);
-
-    if (result != VK_SUCCESS)
+    if (createInstancing(pApplication) != SUCCESS)
     {
-        printError("Failed to create instance!");
+        printError("Failed to create instancing!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    if (createDebugUtilsMessenger(pApplication, &debugUtilsMessengerCreateInfo) != SUCCESS)
+    if (createDrawSorting(pApplication) != SUCCESS)
     {
-        printError("Failed to create debug utils messenger!");
+        printError("Failed to create draw sorting!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    return SUCCESS;
-}
-
-Result getPhysicalDevice(Application* pApplication)
-{
-    uint32_t physicalDeviceCount;
-    vkEnumeratePhysicalDevices(pApplication->instance, &physicalDeviceCount, NULL);
+    markStartupStep(pApplication, "draw processing");
 
-    if (physicalDeviceCount < 1)
+    if (createGpuProfiler(&pApplication->gpuProfiler, pApplication->physicalDevice, pApplication->device, pApplication->graphicsQueueFamily, pApplication->frameCount, pConfig->pProfilePath) != SUCCESS)
     {
-        printError("There are no physical devices!");
+        printError("Failed to create GPU profiler!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    VkPhysicalDevice* pPhysicalDevices = malloc(physicalDeviceCount * sizeof(VkPhysicalDevice));
-    if (pPhysicalDevices == NULL)
+    if (createSyncObjects(pApplication) != SUCCESS)
     {
-        printError("Failed to allocate %lu bytes of memory for physical devices!", physicalDeviceCount * sizeof(VkPhysicalDevice));
+        printError("Failed to create synchronization objects!");
+        destroyApplication(pApplication);
         return FAIL;
     }
 
-    vkEnumeratePhysicalDevices(pApplication->instance, &physicalDeviceCount, pPhysicalDevices);
-
-    // TODO: change later
-    pApplication->physicalDevice = pPhysicalDevices[0];
-
-    free(pPhysicalDevices);
+    markStartupStep(pApplication, "profiler and synchronization");
 
     return SUCCESS;
 }
 
-Result createDevice(Application* pApplication)
+void destroyApplication(Application* pApplication)
 {
-    float priority = 1.0f;
+    // The loader submits to the transfer queue, so it has to finish before the device can be idled
+    if (pApplication->pMeshLoaderThread != NULL)
+    {
+        SDL_WaitThread(pApplication->pMeshLoaderThread, NULL);
+        pApplication->pMeshLoaderThread = NULL;
+    }
 
-    // TODO: change later
-    VkDeviceQueueCreateInfo queueCreateInfo;
-    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfo.pNext = NULL;
-    queueCreateInfo.flags = 0;
-    queueCreateInfo.queueFamilyIndex = 0;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = &priority;
+    if (pApplication->device != NULL)
+    {
+        vkDeviceWaitIdle(pApplication->device);
+    }
 
-    uint32_t       availableExtensionCount;
-    char**         ppAvailableExtensions;
-    uint32_t       requiredExtensionCount = 1;
-    const char*    ppRequiredExtensions[1] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    destroySwapchainResources(pApplication);
 
-    if (getAvailableDeviceExtensions(pApplication->physicalDevice, &availableExtensionCount, &ppAvailableExtensions) != SUCCESS)
+    if (pApplication->pFrames != NULL)
     {
-        printError("Failed to get available device extensions!");
-        freeDeviceExtensions(&availableExtensionCount, &ppAvailableExtensions);
-        return FAIL;
+        for (uint32_t i = 0; i < pApplication->frameCount; ++i)
+        {
+            vkDestroyFence(pApplication->device, pApplication->pFrames[i].inFlightFence, NULL);
+            vkDestroySemaphore(pApplication->device, pApplication->pFrames[i].imageAvailableSemaphore, NULL);
+        }
     }
 
-    // printAvailableDeviceExtensions(availableExtensionCount, ppAvailableExtensions);
+    free(pApplication->pFrames);
 
-    VkPhysicalDeviceFeatures features;
-    vkGetPhysicalDeviceFeatures(pApplication->physicalDevice, &features);
+    destroyGpuProfiler(&pApplication->gpuProfiler);
 
-    VkDeviceCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.queueCreateInfoCount = 1;
-    createInfo.pQueueCreateInfos = &queueCreateInfo;
-    createInfo.enabledLayerCount = 0;
-    createInfo.ppEnabledLayerNames = NULL;
-    createInfo.enabledExtensionCount = requiredExtensionCount;
-    createInfo.ppEnabledExtensionNames = ppRequiredExtensions;
-    createInfo.pEnabledFeatures = &features;
+    if (pApplication->gpuCullingEnabled == SDL_TRUE)
+    {
+        destroyGpuCulling(&pApplication->gpuCulling);
+    }
 
-    int result = vkCreateDevice(pApplication->physicalDevice, &createInfo, NULL, &pApplication->device);
+    destroyThreadPool(&pApplication->cullingThreadPool);
+    destroyCpuCulling(&pApplication->cpuCulling);
+    destroyObjectBounds(&pApplication->objectBounds);
 
-    freeDeviceExtensions(&availableExtensionCount, &ppAvailableExtensions);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    {
+        if (pApplication->pInstanceBuffers[i] != VK_NULL_HANDLE)
+        {
+            destroyBuffer(&pApplication->allocator, pApplication->pInstanceBuffers[i], &pApplication->pInstanceAllocations[i]);
+        }
+    }
 
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
-}
+    destroyDrawSorter(&pApplication->drawSorter);
 
-Result createSurface(Application* pApplication)
-{
-    SDL_bool result = SDL_Vulkan_CreateSurface(pApplication->pWindow, pApplication->instance, &pApplication->surface);
-    return (result == SDL_TRUE) ? SUCCESS : FAIL;
-}
+    free(pApplication->pDrawBatches);
+    free(pApplication->pDrawItems);
 
-Result createSwapchain(Application* pApplication)
-{
-    VkSurfaceCapabilitiesKHR surfaceCapabilities;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(pApplication->physicalDevice, pApplication->surface, &surfaceCapabilities);
+    // Workers are idle between frames, joining them first keeps their pools from being destroyed under them
+    destroyThreadPool(&pApplication->recordThreadPool);
 
-    uint32_t imageCount = surfaceCapabilities.minImageCount + 1;
-    if ((surfaceCapabilities.maxImageCount > 0) && (imageCount > surfaceCapabilities.maxImageCount))
+    if (pApplication->pRecordJobs != NULL)
     {
-        imageCount = surfaceCapabilities.maxImageCount;
+        for (uint32_t i = 0; i < pApplication->recordJobCount; ++i)
+        {
+            for (uint32_t j = 0; j < pApplication->frameCount; ++j)
+            {
+                vkDestroyCommandPool(pApplication->device, pApplication->pRecordJobs[i].pCommandPools[j], NULL);
+            }
+        }
     }
 
-    uint32_t surfaceFormatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(pApplication->physicalDevice, pApplication->surface, &surfaceFormatCount, NULL);
+    free(pApplication->pRecordJobs);
 
-    VkSurfaceFormatKHR* pSurfaceFormats = malloc(surfaceFormatCount * sizeof(VkSurfaceFormatKHR));
+    vkDestroyCommandPool(pApplication->device, pApplication->commandPool, NULL);
+
+    // Waits for builds still in flight, so the shader modules are no longer referenced afterwards
+    destroyPipelineBuilder(&pApplication->pipelineBuilder);
+
+    destroyShaderCache(&pApplication->shaderCache);
+
+    vkDestroyRenderPass(pApplication->device, pApplication->renderPass, NULL);
+
+    vkDestroyPipelineLayout(pApplication->device, pApplication->pipelineLayout, NULL);
+
+    vkDestroyDescriptorSetLayout(pApplication->device, pApplication->virtualTextureSetLayout, NULL);
+
+    vkDestroyDescriptorSetLayout(pApplication->device, pApplication->materialSetLayout, NULL);
+
+    vkDestroyDescriptorSetLayout(pApplication->device, pApplication->objectSetLayout, NULL);
+
+    if ((pApplication->pipelineCache != NULL) && (pApplication->pPipelineCachePath != NULL))
+    {
+        savePipelineCache(pApplication->physicalDevice, pApplication->device, pApplication->pipelineCache, pApplication->pPipelineCachePath);
+    }
+
+    vkDestroyPipelineCache(pApplication->device, pApplication->pipelineCache, NULL);
+
+    free(pApplication->pPipelineCachePath);
+
+    if (pApplication->pHeadlessImageAllocations != NULL)
+    {
+        for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+        {
+            destroyImage(&pApplication->allocator, pApplication->pSwapchainImages[i], &pApplication->pHeadlessImageAllocations[i]);
+        }
+    }
+
+    free(pApplication->pHeadlessImageAllocations);
+
+    free(pApplication->pSwapchainImages);
+
+    vkDestroySwapchainKHR(pApplication->device, pApplication->swapchain, NULL);
+
+    vkDestroySurfaceKHR(pApplication->instance, pApplication->surface, NULL);
+
+    destroyMesh(&pApplication->allocator, &pApplication->mesh);
+
+    if (pApplication->virtualTextureEnabled == SDL_TRUE)
+    {
+        destroyVirtualTexture(&pApplication->virtualTexture);
+    }
+
+    vkDestroyDescriptorPool(pApplication->device, pApplication->materialDescriptorPool, NULL);
+
+    if (pApplication->textureLoader.device != NULL)
+    {
+        destroyTexture(&pApplication->textureLoader, &pApplication->texture);
+        destroyTextureLoader(&pApplication->textureLoader);
+    }
+
+    destroySamplerCache(&pApplication->samplerCache);
+
+    destroyStagingRing(&pApplication->stagingRing);
+
+    destroyAllocator(&pApplication->allocator);
+
+    vkDestroyDevice(pApplication->device, NULL);
+
+#ifdef VIEWER_VALIDATION
+    if (pApplication->debugUtilsMessenger != NULL)
+    {
+        PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessengerEXT = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(pApplication->instance, "vkDestroyDebugUtilsMessengerEXT");
+        vkDestroyDebugUtilsMessengerEXT(pApplication->instance, pApplication->debugUtilsMessenger, NULL);
+    }
+#endif
+
+    vkDestroyInstance(pApplication->instance, NULL);
+
+#ifdef VIEWER_VALIDATION
+    // After the instance, which reports its own destruction through the messenger create info it was created with
+    destroyDebugLog(&pApplication->debugLog);
+#endif
+
+    if (pApplication->pWindow != NULL)
+    {
+        SDL_DestroyWindow(pApplication->pWindow);
+    }
+
+    SDL_Quit();
+}
+
+Result drawFrame(Application* pApplication)
+{
+    VkDevice    device = pApplication->device;
+    Frame*      pFrame = &pApplication->pFrames[pApplication->currentFrame];
+
+    if (pApplication->swapchainOutdated == SDL_TRUE)
+    {
+        if (recreateSwapchain(pApplication) != SUCCESS)
+        {
+            printError("Failed to recreate swapchain!");
+            return FAIL;
+        }
+
+        // Still outdated while the window is minimized, there is nothing to render to
+        if (pApplication->swapchainOutdated == SDL_TRUE)
+        {
+            return SUCCESS;
+        }
+    }
+
+    // Blocking here instead of spinning is what lets the CPU run at most frameCount frames ahead
+    uint64_t waitStart = SDL_GetPerformanceCounter();
+    uint64_t traceStart = beginCpuTrace();
+    vkWaitForFences(device, 1, &pFrame->inFlightFence, VK_TRUE, UINT64_MAX);
+    endCpuTrace("wait for frame", traceStart);
+
+    SDL_bool    headless = pApplication->config.headless;
+    uint32_t    imageIndex = pApplication->currentFrame % pApplication->swapchainImageCount;
+    VkResult    result = VK_SUCCESS;
+
+    if (headless != SDL_TRUE)
+    {
+        traceStart = beginCpuTrace();
+        result = vkAcquireNextImageKHR(device, pApplication->swapchain, UINT64_MAX, pFrame->imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+        endCpuTrace("acquire", traceStart);
+
+        // The frame is skipped and the next one recreates the swapchain. A suboptimal image is still
+        // rendered and presented, its semaphore is already signaled.
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            pApplication->swapchainOutdated = SDL_TRUE;
+            pApplication->waitTicks += SDL_GetPerformanceCounter() - waitStart;
+            return SUCCESS;
+        }
+
+        if (result == VK_SUBOPTIMAL_KHR)
+        {
+            pApplication->swapchainOutdated = SDL_TRUE;
+        }
+        else if (result != VK_SUCCESS)
+        {
+            printError("Failed to acquire swapchain image!");
+            return FAIL;
+        }
+    }
+
+    // With more frames in flight than swapchain images an image can come back while an older frame still renders to it
+    if (pApplication->pImageFences[imageIndex] != VK_NULL_HANDLE)
+    {
+        vkWaitForFences(device, 1, &pApplication->pImageFences[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+    pApplication->pImageFences[imageIndex] = pFrame->inFlightFence;
+    pApplication->waitTicks += SDL_GetPerformanceCounter() - waitStart;
+
+    vkResetFences(device, 1, &pFrame->inFlightFence);
+
+    // Polled instead of waited on, so frames keep coming while the transfer queue is busy
+    SDL_bool acquireMesh = SDL_FALSE;
+    if (pApplication->meshReady != SDL_TRUE)
+    {
+        int meshState = SDL_AtomicGet(&pApplication->meshState);
+        SDL_MemoryBarrierAcquire();
+
+        if (meshState == MESH_STATE_FAILED)
+        {
+            printError("Failed to load mesh!");
+            return FAIL;
+        }
+
+        if ((meshState == MESH_STATE_UPLOADED) && (isTimelineValueReached(&pApplication->stagingRing, pApplication->meshTimelineValue) == SDL_TRUE))
+        {
+            acquireMesh = SDL_TRUE;
+            pApplication->meshReady = SDL_TRUE;
+            printf("Mesh resident %.3f ms after startup\n\n", (SDL_GetPerformanceCounter() - pApplication->startTicks) * 1000.0 / SDL_GetPerformanceFrequency());
+        }
+    }
+
+    // A pipeline that failed to build never becomes ready, the mesh would silently never be drawn
+    uint32_t pipelineId = getMeshPipelineId(pApplication);
+    if ((pipelineId < pApplication->pipelineBuilder.jobCount) && (getPipelineStatus(&pApplication->pipelineBuilder, pipelineId) == PIPELINE_STATUS_FAILED))
+    {
+        printError("Failed to build mesh pipeline!");
+        return FAIL;
+    }
+
+    uint64_t recordStart = SDL_GetPerformanceCounter();
+    traceStart = beginCpuTrace();
+    vkResetCommandBuffer(pFrame->commandBuffer, 0);
+    if (recordCommandBuffer(pApplication, pFrame->commandBuffer, imageIndex, acquireMesh) != SUCCESS)
+    {
+        printError("Failed to record command buffer!");
+        return FAIL;
+    }
+    endCpuTrace("record", traceStart);
+    pApplication->recordTicks += SDL_GetPerformanceCounter() - recordStart;
+
+    // The wait on the upload timeline is already satisfied, it only orders the copies before the first draw
+    uint32_t                waitSemaphoreCount = 0;
+    VkSemaphore             pWaitSemaphores[3];
+    VkPipelineStageFlags    pWaitStages[3];
+    uint64_t                pWaitValues[3];
+
+    if (headless != SDL_TRUE)
+    {
+        pWaitSemaphores[waitSemaphoreCount] = pFrame->imageAvailableSemaphore;
+        pWaitStages[waitSemaphoreCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        pWaitValues[waitSemaphoreCount] = 0;
+        ++waitSemaphoreCount;
+    }
+
+    if (acquireMesh == SDL_TRUE)
+    {
+        pWaitSemaphores[waitSemaphoreCount] = pApplication->stagingRing.timelineSemaphore;
+        pWaitStages[waitSemaphoreCount] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        pWaitValues[waitSemaphoreCount] = pApplication->meshTimelineValue;
+        ++waitSemaphoreCount;
+    }
+
+    VkSemaphore bindSemaphore = (pApplication->virtualTextureEnabled == SDL_TRUE) ? getVirtualTextureBindSemaphore(&pApplication->virtualTexture, pApplication->currentFrame) : VK_NULL_HANDLE;
+    if (bindSemaphore != VK_NULL_HANDLE)
+    {
+        pWaitSemaphores[waitSemaphoreCount] = bindSemaphore;
+        pWaitStages[waitSemaphoreCount] = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        pWaitValues[waitSemaphoreCount] = 0;
+        ++waitSemaphoreCount;
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo;
+    timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineSubmitInfo.pNext = NULL;
+    timelineSubmitInfo.waitSemaphoreValueCount = waitSemaphoreCount;
+    timelineSubmitInfo.pWaitSemaphoreValues = pWaitValues;
+    timelineSubmitInfo.signalSemaphoreValueCount = 0;
+    timelineSubmitInfo.pSignalSemaphoreValues = NULL;
+
+    VkSubmitInfo submitInfo;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineSubmitInfo;
+    submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+    submitInfo.pWaitSemaphores = pWaitSemaphores;
+    submitInfo.pWaitDstStageMask = pWaitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &pFrame->commandBuffer;
+    submitInfo.signalSemaphoreCount = (headless == SDL_TRUE) ? 0 : 1;
+    submitInfo.pSignalSemaphores = &pApplication->pRenderFinishedSemaphores[imageIndex];
+
+    traceStart = beginCpuTrace();
+    if (vkQueueSubmit(pApplication->queue, 1, &submitInfo, pFrame->inFlightFence) != VK_SUCCESS)
+    {
+        printError("Failed to submit command buffer!");
+        return FAIL;
+    }
+    endCpuTrace("submit", traceStart);
+
+    // Offscreen images are only recycled by the fences, so headless frames finish at submission
+    if (headless == SDL_TRUE)
+    {
+        pApplication->currentFrame = (pApplication->currentFrame + 1) % pApplication->frameCount;
+        ++pApplication->frameNumber;
+        return SUCCESS;
+    }
+
+    VkPresentInfoKHR presentInfo;
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.pNext = NULL;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &pApplication->pRenderFinishedSemaphores[imageIndex];
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &pApplication->swapchain;
+    presentInfo.pImageIndices = &imageIndex;
+    presentInfo.pResults = NULL;
+
+    traceStart = beginCpuTrace();
+    result = vkQueuePresentKHR(pApplication->queue, &presentInfo);
+    endCpuTrace("present", traceStart);
+    if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+    {
+        pApplication->swapchainOutdated = SDL_TRUE;
+    }
+    else if (result != VK_SUCCESS)
+    {
+        printError("Failed to present swapchain image!");
+        return FAIL;
+    }
+
+    if (pApplication->inputTicks != 0)
+    {
+        addLatencySample(&pApplication->inputLatency, pApplication->inputTicks, SDL_GetPerformanceCounter());
+        pApplication->inputTicks = 0;
+    }
+
+    pApplication->currentFrame = (pApplication->currentFrame + 1) % pApplication->frameCount;
+    ++pApplication->frameNumber;
+
+    return SUCCESS;
+}
+
+const char* getPresentModeName(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+        default: return "unknown";
+    }
+}
+
+Result getOverdraw(const Application* pApplication, double* pOverdraw)
+{
+    // Statistics are collected by the mesh scope, or by the render pass scope when secondaries record the draws
+    double fragmentInvocations;
+    if ((getProfilerScopeStatistic(&pApplication->gpuProfiler, "mesh", PROFILER_STATISTIC_FRAGMENT_INVOCATIONS, &fragmentInvocations) != SUCCESS)
+        && (getProfilerScopeStatistic(&pApplication->gpuProfiler, "render pass", PROFILER_STATISTIC_FRAGMENT_INVOCATIONS, &fragmentInvocations) != SUCCESS))
+    {
+        return FAIL;
+    }
+
+    *pOverdraw = fragmentInvocations / ((double)pApplication->swapchainExtent.width * pApplication->swapchainExtent.height);
+
+    return SUCCESS;
+}
+
+void printStartupTiming(const Application* pApplication)
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    uint64_t totalTicks = pApplication->startupStepTicks - pApplication->startTicks;
+
+    printf("Startup took %.3f ms:\n", totalTicks * 1000.0 / frequency);
+    for (uint32_t i = 0; i < pApplication->startupStepCount; ++i)
+    {
+        const StartupStep* pStep = &pApplication->pStartupSteps[i];
+        printf("    %-30s %9.3f ms %5.1f%%\n", pStep->pName, pStep->ticks * 1000.0 / frequency, (totalTicks > 0) ? pStep->ticks * 100.0 / totalTicks : 0.0);
+    }
+    printf("\n");
+}
+
+void markStartupStep(Application* pApplication, const char* pName)
+{
+    uint64_t ticks = SDL_GetPerformanceCounter();
+
+    if (pApplication->startupStepCount < MAX_STARTUP_STEPS)
+    {
+        StartupStep* pStep = &pApplication->pStartupSteps[pApplication->startupStepCount++];
+        pStep->pName = pName;
+        pStep->ticks = ticks - pApplication->startupStepTicks;
+    }
+
+    pApplication->startupStepTicks = ticks;
+}
+
+void getMeshPipelineState(const Application* pApplication, GraphicsPipelineState* pState)
+{
+    setDefaultGraphicsPipelineState(pState);
+
+    pState->stageCount = 2;
+    pState->pStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    pState->pStages[0].module = pApplication->vertShaderModule;
+    pState->pStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pState->pStages[1].module = pApplication->fragShaderModule;
+
+    getVertexInputState(&pState->vertexBindingCount, pState->pVertexBindings, &pState->vertexAttributeCount, pState->pVertexAttributes);
+
+    // The projection flips Y for Vulkan, so meshes keep their counter-clockwise front faces
+    pState->rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    // Opaque meshes only, so fragments behind what was drawn before fail the test ahead of shading
+    pState->depthStencilEnable = SDL_TRUE;
+    pState->depthStencilState.depthTestEnable = VK_TRUE;
+    pState->depthStencilState.depthWriteEnable = VK_TRUE;
+    pState->depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    pState->createInfo.layout = pApplication->pipelineLayout;
+    pState->createInfo.renderPass = pApplication->renderPass;
+}
+
+Result createWindow(Application* pApplication)
+{
+    pApplication->pWindow = SDL_CreateWindow("Viewer", 100, 100, pApplication->config.width, pApplication->config.height, SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+    return (pApplication->pWindow == NULL) ? FAIL : SUCCESS;
+}
+
+#ifdef VIEWER_VALIDATION
+VKAPI_ATTR VkBool32 debugUtilsMessengerCallback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT         messageSeverity,
+    VkDebugUtilsMessageTypeFlagsEXT                messageTypes,
+    const VkDebugUtilsMessengerCallbackDataEXT*    pCallbackData,
+    void*                                          pUserData)
+{
+    // Runs on whichever thread made the call, so formatting and writing are left to the debug log thread
+    pushDebugLogMessage(pUserData, messageSeverity, messageTypes, pCallbackData);
+    return VK_FALSE;
+}
+
+Result createDebugUtilsMessenger(Application* pApplication, VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo)
+{
+    PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessengerEXT = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(pApplication->instance, "vkCreateDebugUtilsMessengerEXT");
+    int result = vkCreateDebugUtilsMessengerEXT(pApplication->instance, pCreateInfo, NULL, &pApplication->debugUtilsMessenger);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+#endif
+
+Result createInstance(Application* pApplication)
+{
+    uint32_t apiVersion;
+    vkEnumerateInstanceVersion(&apiVersion);
+
+    VkApplicationInfo applicationInfo;
+    applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    applicationInfo.pNext = NULL;
+    applicationInfo.pApplicationName = "Vulkan viewer";
+    applicationInfo.applicationVersion = 1;
+    applicationInfo.pEngineName = NULL;
+    applicationInfo.engineVersion = 0;
+    applicationInfo.apiVersion = apiVersion;
+
+    // Every enumeration lands in one arena, which is freed as a whole once the instance exists
+    Arena arena;
+    createArena(&arena, STARTUP_ARENA_BLOCK_SIZE);
+
+    SDL_bool                  verbose = pApplication->config.verbose;
+    ValidationLevel           validationLevel = pApplication->config.validation;
+    uint32_t                  availableLayerCount = 0;
+    VkLayerProperties*        pAvailableLayers = NULL;
+    uint32_t                  requiredLayerCount = 0;
+    const char*               ppRequiredLayers[1] = {VALIDATION_LAYER_NAME};
+    unsigned int              requiredExtensionCount = 0;
+    const char**              ppRequiredExtensions = NULL;
+    const void*               pNext = NULL;
+
+    // Without validation nothing needs the layers, so they are not even enumerated
+    if ((validationLevel != VALIDATION_LEVEL_OFF) || (verbose == SDL_TRUE))
+    {
+        if (getAvailableInstanceLayers(&arena, &availableLayerCount, &pAvailableLayers) != SUCCESS)
+        {
+            printError("Failed to get available instance layers!");
+            destroyArena(&arena);
+            return FAIL;
+        }
+
+        if ((verbose == SDL_TRUE) && (printAvailableInstanceLayers(&arena, availableLayerCount, pAvailableLayers) != SUCCESS))
+        {
+            printError("Failed to print available instance layers!");
+            destroyArena(&arena);
+            return FAIL;
+        }
+    }
+
+#ifdef VIEWER_VALIDATION
+    VkDebugUtilsMessengerCreateInfoEXT debugUtilsMessengerCreateInfo;
+    debugUtilsMessengerCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    debugUtilsMessengerCreateInfo.pNext = NULL;
+    debugUtilsMessengerCreateInfo.flags = 0;
+    debugUtilsMessengerCreateInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    debugUtilsMessengerCreateInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT
+                                                | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
+                                                | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT
+                                                | VK_DEBUG_UTILS_MESSAGE_TYPE_DEVICE_ADDRESS_BINDING_BIT_EXT;
+    debugUtilsMessengerCreateInfo.pfnUserCallback = debugUtilsMessengerCallback;
+    debugUtilsMessengerCreateInfo.pUserData = &pApplication->debugLog;
+
+    // Verbose messages arrive for nearly every call, so they are only asked for together with --verbose
+    if (verbose == SDL_TRUE)
+    {
+        debugUtilsMessengerCreateInfo.messageSeverity |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+    }
+
+    VkValidationFeatureEnableEXT    pEnabledValidationFeatures[4];
+    uint32_t                        enabledValidationFeatureCount = 0;
+
+    if (validationLevel >= VALIDATION_LEVEL_SYNC)
+    {
+        pEnabledValidationFeatures[enabledValidationFeatureCount++] = VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT;
+    }
+
+    if (validationLevel >= VALIDATION_LEVEL_GPU)
+    {
+        pEnabledValidationFeatures[enabledValidationFeatureCount++] = VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT;
+        pEnabledValidationFeatures[enabledValidationFeatureCount++] = VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT;
+        pEnabledValidationFeatures[enabledValidationFeatureCount++] = VK_VALIDATION_FEATURE_ENABLE_BEST_PRACTICES_EXT;
+    }
+
+    VkValidationFeaturesEXT validationFeatures;
+    validationFeatures.sType = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
+    validationFeatures.pNext = &debugUtilsMessengerCreateInfo;
+    validationFeatures.enabledValidationFeatureCount = enabledValidationFeatureCount;
+    validationFeatures.pEnabledValidationFeatures = pEnabledValidationFeatures;
+    validationFeatures.disabledValidationFeatureCount = 0;
+    validationFeatures.pDisabledValidationFeatures = NULL;
+
+    // A missing layer is no reason not to run, the viewer just runs unvalidated then
+    if (validationLevel != VALIDATION_LEVEL_OFF)
+    {
+        if (checkAvailabilityOfRequiredInstanceLayers(availableLayerCount, pAvailableLayers, 1, ppRequiredLayers) == SUCCESS)
+        {
+            if (createDebugLog(&pApplication->debugLog) != SUCCESS)
+            {
+                printError("Failed to create debug log!");
+                destroyArena(&arena);
+                return FAIL;
+            }
+
+            requiredLayerCount = 1;
+            pNext = &validationFeatures;
+        }
+        else
+        {
+            printf("Running without validation\n\n");
+            validationLevel = VALIDATION_LEVEL_OFF;
+        }
+    }
+#endif
+
+    pApplication->validationLevel = validationLevel;
+
+    // Only listed, vkCreateInstance reports missing extensions by itself
+    if (verbose == SDL_TRUE)
+    {
+        uint32_t                  availableExtensionCount = 0;
+        VkExtensionProperties*    pAvailableExtensions = NULL;
+
+        if (getAvailableInstanceExtensions(&arena, &availableExtensionCount, &pAvailableExtensions) != SUCCESS)
+        {
+            printError("Failed to get available instance extensions!");
+            destroyArena(&arena);
+            return FAIL;
+        }
+
+        printAvailableInstanceExtensions(availableExtensionCount, pAvailableExtensions);
+    }
+
+    SDL_bool validation = (validationLevel != VALIDATION_LEVEL_OFF) ? SDL_TRUE : SDL_FALSE;
+    if (getRequiredInstanceExtensions(&arena, pApplication->pWindow, validation, &requiredExtensionCount, &ppRequiredExtensions) != SUCCESS)
+    {
+        printError("Failed to get required extensions!");
+        destroyArena(&arena);
+        return FAIL;
+    }
+
+    if (verbose == SDL_TRUE)
+    {
+        printRequiredInstanceExtensions(requiredExtensionCount, ppRequiredExtensions);
+    }
+
+    VkInstanceCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pNext = pNext;
+    createInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+    createInfo.pApplicationInfo = &applicationInfo;
+    createInfo.enabledLayerCount = requiredLayerCount;
+    createInfo.ppEnabledLayerNames = ppRequiredLayers;
+    createInfo.enabledExtensionCount = requiredExtensionCount;
+    createInfo.ppEnabledExtensionNames = ppRequiredExtensions;
+
+    int result = vkCreateInstance(&createInfo, NULL, &pApplication->instance);
+
+    destroyArena(&arena);
+
+    if (result != VK_SUCCESS)
+    {
+        printError("Failed to create instance!");
+        return FAIL;
+    }
+
+#ifdef VIEWER_VALIDATION
+    if ((validation == SDL_TRUE) && (createDebugUtilsMessenger(pApplication, &debugUtilsMessengerCreateInfo) != SUCCESS))
+    {
+        printError("Failed to create debug utils messenger!");
+        return FAIL;
+    }
+#endif
+
+    return SUCCESS;
+}
+
+Result getPhysicalDevice(Application* pApplication)
+{
+    char* pCachePath = getPreferencePath(CAPABILITY_CACHE_FILE_NAME);
+
+    CapabilityCache cache;
+    Result result = loadCapabilityCache(&cache, pCachePath);
+
+    free(pCachePath);
+
+    if (result != SUCCESS)
+    {
+        printError("Failed to load capability cache!");
+        return FAIL;
+    }
+
+    result = selectPhysicalDevice(pApplication->instance, pApplication->surface, &cache, pApplication->config.pDevice, pApplication->config.verbose, &pApplication->physicalDevice);
+
+    if (pApplication->config.verbose == SDL_TRUE)
+    {
+        printf("Capability cache: %u devices cached, %u queried\n\n", cache.hitCount, cache.missCount);
+    }
+
+    // Only a convenience for the next launch, so failing to write it is not fatal
+    saveCapabilityCache(&cache);
+    destroyCapabilityCache(&cache);
+
+    return result;
+}
+
+Result findQueueFamilies(Application* pApplication, uint32_t* pTransferQueueIndex)
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(pApplication->physicalDevice, &familyCount, NULL);
+
+    VkQueueFamilyProperties* pFamilies = malloc(familyCount * sizeof(VkQueueFamilyProperties));
+    if (pFamilies == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for queue families!", familyCount * sizeof(VkQueueFamilyProperties));
+        return FAIL;
+    }
+
+    vkGetPhysicalDeviceQueueFamilyProperties(pApplication->physicalDevice, &familyCount, pFamilies);
+
+    pApplication->graphicsQueueFamily = UINT32_MAX;
+    pApplication->transferQueueFamily = UINT32_MAX;
+
+    for (uint32_t i = 0; (i < familyCount) && (pApplication->graphicsQueueFamily == UINT32_MAX); ++i)
+    {
+        VkBool32 presentSupported = VK_TRUE;
+        if (pApplication->surface != NULL)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(pApplication->physicalDevice, i, pApplication->surface, &presentSupported);
+        }
+
+        if (((pFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) && (presentSupported == VK_TRUE))
+        {
+            pApplication->graphicsQueueFamily = i;
+        }
+    }
+
+    // Transfer-only families map to the copy engines, async compute families are the next best thing
+    for (uint32_t i = 0; (i < familyCount) && (pApplication->transferQueueFamily == UINT32_MAX); ++i)
+    {
+        if (((pFamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) && ((pFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) != 0))
+        {
+            pApplication->transferQueueFamily = i;
+        }
+    }
+
+    for (uint32_t i = 0; (i < familyCount) && (pApplication->transferQueueFamily == UINT32_MAX); ++i)
+    {
+        if (((pFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0) && ((pFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0))
+        {
+            pApplication->transferQueueFamily = i;
+        }
+    }
+
+    // Without a separate family take a second queue of the graphics family if there is one
+    *pTransferQueueIndex = 0;
+    if ((pApplication->transferQueueFamily == UINT32_MAX) && (pApplication->graphicsQueueFamily != UINT32_MAX))
+    {
+        pApplication->transferQueueFamily = pApplication->graphicsQueueFamily;
+        *pTransferQueueIndex = (pFamilies[pApplication->graphicsQueueFamily].queueCount > 1) ? 1 : 0;
+    }
+
+    free(pFamilies);
+
+    if (pApplication->graphicsQueueFamily == UINT32_MAX)
+    {
+        printError("There is no queue family with graphics and presentation support!");
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+Result createDevice(Application* pApplication)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(pApplication->physicalDevice, &properties);
+
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        printError("Device supports Vulkan %u.%u, but timeline semaphores need Vulkan 1.2!", VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion));
+        return FAIL;
+    }
+
+    uint32_t transferQueueIndex;
+    if (findQueueFamilies(pApplication, &transferQueueIndex) != SUCCESS)
+    {
+        printError("Failed to find queue families!");
+        return FAIL;
+    }
+
+    // Streaming uploads must never hold back frames, so the transfer queue gets the lower priority
+    float pPriorities[2] = {1.0f, 0.5f};
+
+    VkDeviceQueueCreateInfo pQueueCreateInfos[2];
+    pQueueCreateInfos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    pQueueCreateInfos[0].pNext = NULL;
+    pQueueCreateInfos[0].flags = 0;
+    pQueueCreateInfos[0].queueFamilyIndex = pApplication->graphicsQueueFamily;
+    pQueueCreateInfos[0].queueCount = transferQueueIndex + 1;
+    pQueueCreateInfos[0].pQueuePriorities = pPriorities;
+
+    pQueueCreateInfos[1] = pQueueCreateInfos[0];
+    pQueueCreateInfos[1].queueFamilyIndex = pApplication->transferQueueFamily;
+    pQueueCreateInfos[1].queueCount = 1;
+    pQueueCreateInfos[1].pQueuePriorities = &pPriorities[1];
+
+    uint32_t       queueCreateInfoCount = (pApplication->transferQueueFamily != pApplication->graphicsQueueFamily) ? 2 : 1;
+    uint32_t       requiredExtensionCount = (pApplication->config.headless == SDL_TRUE) ? 0 : 1;
+    const char*    ppRequiredExtensions[1] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+    // Device selection already made sure the required extensions are there
+    if (pApplication->config.verbose == SDL_TRUE)
+    {
+        Arena arena;
+        createArena(&arena, STARTUP_ARENA_BLOCK_SIZE);
+
+        uint32_t                  availableExtensionCount;
+        VkExtensionProperties*    pAvailableExtensions;
+
+        if (getAvailableDeviceExtensions(&arena, pApplication->physicalDevice, &availableExtensionCount, &pAvailableExtensions) == SUCCESS)
+        {
+            printAvailableDeviceExtensions(availableExtensionCount, pAvailableExtensions);
+        }
+
+        destroyArena(&arena);
+    }
+
+    VkPhysicalDeviceVulkan12Features supportedFeatures12;
+    memset(&supportedFeatures12, 0, sizeof(supportedFeatures12));
+    supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures;
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedFeatures12;
+
+    vkGetPhysicalDeviceFeatures2(pApplication->physicalDevice, &supportedFeatures);
+
+    if (supportedFeatures12.timelineSemaphore != VK_TRUE)
+    {
+        printError("Device does not support timeline semaphores!");
+        return FAIL;
+    }
+
+    // Every core feature stays enabled as before, inheritedQueries for the profiler among them, Vulkan 1.2 features only
+    // when they are used
+    VkPhysicalDeviceVulkan12Features features12;
+    memset(&features12, 0, sizeof(features12));
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+    features12.timelineSemaphore = VK_TRUE;
+    features12.drawIndirectCount = supportedFeatures12.drawIndirectCount;
+
+    pApplication->drawIndirectCountSupported = (supportedFeatures12.drawIndirectCount == VK_TRUE) ? SDL_TRUE : SDL_FALSE;
+
+    // Enabled with the other core features, virtual textures use a sparse image instead of an atlas then
+    VkPhysicalDeviceFeatures* pSupportedFeatures = &supportedFeatures.features;
+    pApplication->sparseResidencySupported = ((pSupportedFeatures->sparseBinding == VK_TRUE) && (pSupportedFeatures->sparseResidencyImage2D == VK_TRUE)) ? SDL_TRUE : SDL_FALSE;
+
+    VkPhysicalDeviceFeatures2 features;
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+    features.features = supportedFeatures.features;
+
+    VkDeviceCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &features;
+    createInfo.flags = 0;
+    createInfo.queueCreateInfoCount = queueCreateInfoCount;
+    createInfo.pQueueCreateInfos = pQueueCreateInfos;
+    createInfo.enabledLayerCount = 0;
+    createInfo.ppEnabledLayerNames = NULL;
+    createInfo.enabledExtensionCount = requiredExtensionCount;
+    createInfo.ppEnabledExtensionNames = ppRequiredExtensions;
+    createInfo.pEnabledFeatures = NULL;
+
+    int result = vkCreateDevice(pApplication->physicalDevice, &createInfo, NULL, &pApplication->device);
+
+    if (result != VK_SUCCESS)
+    {
+        return FAIL;
+    }
+
+    vkGetDeviceQueue(pApplication->device, pApplication->graphicsQueueFamily, 0, &pApplication->queue);
+    vkGetDeviceQueue(pApplication->device, pApplication->transferQueueFamily, transferQueueIndex, &pApplication->transferQueue);
+
+    printf("Graphics queue family %u, transfer queue family %u (%s)\n\n", pApplication->graphicsQueueFamily, pApplication->transferQueueFamily,
+        (pApplication->transferQueue != pApplication->queue) ? "streaming uploads" : "shared with graphics, uploads block");
+
+    return SUCCESS;
+}
+
+Result createSurface(Application* pApplication)
+{
+    SDL_bool result = SDL_Vulkan_CreateSurface(pApplication->pWindow, pApplication->instance, &pApplication->surface);
+    return (result == SDL_TRUE) ? SUCCESS : FAIL;
+}
+
+Result createSwapchain(Application* pApplication)
+{
+    VkSurfaceCapabilitiesKHR surfaceCapabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(pApplication->physicalDevice, pApplication->surface, &surfaceCapabilities);
+
+    // The swapchain may still create more images than asked for, getSwapchainImages reads back the real count
+    uint32_t imageCount = (pApplication->config.swapchainImageCount > 0) ? pApplication->config.swapchainImageCount : surfaceCapabilities.minImageCount + 1;
+    if (imageCount < surfaceCapabilities.minImageCount)
+    {
+        imageCount = surfaceCapabilities.minImageCount;
+    }
+    else if ((surfaceCapabilities.maxImageCount > 0) && (imageCount > surfaceCapabilities.maxImageCount))
+    {
+        imageCount = surfaceCapabilities.maxImageCount;
+    }
+
+    uint32_t surfaceFormatCount;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(pApplication->physicalDevice, pApplication->surface, &surfaceFormatCount, NULL);
+
+    VkSurfaceFormatKHR* pSurfaceFormats = malloc(surfaceFormatCount * sizeof(VkSurfaceFormatKHR));
     if (pSurfaceFormats == NULL)
     {
-        printError("Failed to allocate %lu bytes of memory for surface formats!", surfaceFormatCount * sizeof(VkSurfaceFormatKHR));
+        printError("Failed to allocate %lu bytes of memory for surface formats!", surfaceFormatCount * sizeof(VkSurfaceFormatKHR));
+        return FAIL;
+    }
+
+    vkGetPhysicalDeviceSurfaceFormatsKHR(pApplication->physicalDevice, pApplication->surface, &surfaceFormatCount, pSurfaceFormats);
+
+    VkSurfaceFormatKHR surfaceFormat = pSurfaceFormats[0];
+    for (uint32_t i = 0; i < surfaceFormatCount; ++i)
+    {
+        if ((pSurfaceFormats[i].format == VK_FORMAT_B8G8R8A8_SRGB) && (pSurfaceFormats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR))
+        {
+            surfaceFormat = pSurfaceFormats[i];
+            break;
+        }
+    }
+
+    free(pSurfaceFormats);
+
+    VkExtent2D extent;
+    if (surfaceCapabilities.currentExtent.width != UINT32_MAX)
+    {
+        extent = surfaceCapabilities.currentExtent;
+    }
+    else
+    {
+        int width, height;
+        SDL_Vulkan_GetDrawableSize(pApplication->pWindow, &width, &height);
+
+        extent.width = width;
+        extent.height = height;
+
+        if (width < surfaceCapabilities.minImageExtent.width)
+        {
+            extent.width = surfaceCapabilities.minImageExtent.width;
+        }
+        else if (width > surfaceCapabilities.maxImageExtent.width)
+        {
+            extent.width = surfaceCapabilities.maxImageExtent.width;
+        }
+
+        if (height < surfaceCapabilities.minImageExtent.height)
+        {
+            extent.height = surfaceCapabilities.minImageExtent.height;
+        }
+        else if (height > surfaceCapabilities.maxImageExtent.height)
+        {
+            extent.height = surfaceCapabilities.maxImageExtent.height;
+        }
+    }
+
+    uint32_t presentModeCount;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(pApplication->physicalDevice, pApplication->surface, &presentModeCount, NULL);
+
+    VkPresentModeKHR* pPresentModes = malloc(presentModeCount * sizeof(VkPresentModeKHR));
+    if (pPresentModes == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for present modes!");
+        return FAIL;
+    }
+
+    vkGetPhysicalDeviceSurfacePresentModesKHR(pApplication->physicalDevice, pApplication->surface, &presentModeCount, pPresentModes);
+
+    VkPresentModeKHR requestedMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    switch (pApplication->config.presentMode)
+    {
+        case PRESENT_MODE_OPTION_FIFO: requestedMode = VK_PRESENT_MODE_FIFO_KHR; break;
+        case PRESENT_MODE_OPTION_FIFO_RELAXED: requestedMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR; break;
+        case PRESENT_MODE_OPTION_MAILBOX: requestedMode = VK_PRESENT_MODE_MAILBOX_KHR; break;
+        case PRESENT_MODE_OPTION_IMMEDIATE: requestedMode = VK_PRESENT_MODE_IMMEDIATE_KHR; break;
+        default: break;
+    }
+
+    // FIFO is the only mode every surface supports
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    for (uint32_t i = 0; i < presentModeCount; ++i)
+    {
+        if (pPresentModes[i] == requestedMode)
+        {
+            presentMode = requestedMode;
+            break;
+        }
+    }
+
+    free(pPresentModes);
+
+    // Only reported once, recreating the swapchain asks for the same mode again
+    if ((presentMode != requestedMode) && (pApplication->config.presentMode != PRESENT_MODE_OPTION_DEFAULT) && (pApplication->swapchain == VK_NULL_HANDLE))
+    {
+        printf("Present mode %s is not supported, falling back to fifo\n\n", getPresentModeName(requestedMode));
+    }
+
+    VkSwapchainCreateInfoKHR createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.surface = pApplication->surface;
+    createInfo.minImageCount = imageCount;
+    createInfo.imageFormat = surfaceFormat.format;
+    createInfo.imageColorSpace = surfaceFormat.colorSpace;
+    createInfo.imageExtent = extent;
+    createInfo.imageArrayLayers = 1;
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 1;
+    createInfo.pQueueFamilyIndices = &pApplication->graphicsQueueFamily;
+    createInfo.preTransform = surfaceCapabilities.currentTransform;
+    createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    createInfo.presentMode = presentMode;
+    createInfo.clipped = VK_TRUE;
+    createInfo.oldSwapchain = pApplication->swapchain;
+
+    // Passing the old swapchain lets the driver hand its resources over, it is retired even if creation fails
+    VkSwapchainKHR oldSwapchain = pApplication->swapchain;
+    pApplication->swapchain = VK_NULL_HANDLE;
+
+    int result = vkCreateSwapchainKHR(pApplication->device, &createInfo, NULL, &pApplication->swapchain);
+
+    vkDestroySwapchainKHR(pApplication->device, oldSwapchain, NULL);
+
+    pApplication->swapchainImageFormat = surfaceFormat.format;
+    pApplication->swapchainExtent = extent;
+    pApplication->presentMode = presentMode;
+
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result getSwapchainImages(Application* pApplication)
+{
+    vkGetSwapchainImagesKHR(pApplication->device, pApplication->swapchain, &pApplication->swapchainImageCount, NULL);
+
+    pApplication->pSwapchainImages = malloc(pApplication->swapchainImageCount * sizeof(VkImage));
+    if (pApplication->pSwapchainImages == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for swapchain images!", pApplication->swapchainImageCount * sizeof(VkImage));
+        return FAIL;
+    }
+
+    vkGetSwapchainImagesKHR(pApplication->device, pApplication->swapchain, &pApplication->swapchainImageCount, pApplication->pSwapchainImages);
+
+    return SUCCESS;
+}
+
+Result createSwapchainImageViews(Application* pApplication)
+{
+    pApplication->pSwapchainImageViews = calloc(pApplication->swapchainImageCount, sizeof(VkImageView));
+    if (pApplication->pSwapchainImageViews == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for swapchain image views!", pApplication->swapchainImageCount * sizeof(VkImageView));
+        return FAIL;
+    }
+
+    VkImage*        pImages = pApplication->pSwapchainImages;
+    VkImageView*    pImageViews = pApplication->pSwapchainImageViews;
+
+    for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+    {
+        VkImageViewCreateInfo createInfo;
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.pNext = NULL;
+        createInfo.flags = 0;
+        createInfo.image = pImages[i];
+        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        createInfo.format = pApplication->swapchainImageFormat;
+        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.levelCount = 1;
+        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(pApplication->device, &createInfo, NULL, &pImageViews[i]) != VK_SUCCESS)
+        {
+            printError("Failed to create swapchain image view %u!", i);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+void destroySwapchainResources(Application* pApplication)
+{
+    if (pApplication->pRenderFinishedSemaphores != NULL)
+    {
+        for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+        {
+            vkDestroySemaphore(pApplication->device, pApplication->pRenderFinishedSemaphores[i], NULL);
+        }
+    }
+
+    free(pApplication->pRenderFinishedSemaphores);
+    pApplication->pRenderFinishedSemaphores = NULL;
+
+    free(pApplication->pImageFences);
+    pApplication->pImageFences = NULL;
+
+    if (pApplication->pFramebuffers != NULL)
+    {
+        for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+        {
+            vkDestroyFramebuffer(pApplication->device, pApplication->pFramebuffers[i], NULL);
+        }
+    }
+
+    free(pApplication->pFramebuffers);
+    pApplication->pFramebuffers = NULL;
+
+    vkDestroyImageView(pApplication->device, pApplication->depthImageView, NULL);
+    pApplication->depthImageView = NULL;
+
+    if (pApplication->depthImage != NULL)
+    {
+        destroyImage(&pApplication->allocator, pApplication->depthImage, &pApplication->depthImageAllocation);
+        pApplication->depthImage = NULL;
+    }
+
+    if (pApplication->pSwapchainImageViews != NULL)
+    {
+        for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+        {
+            vkDestroyImageView(pApplication->device, pApplication->pSwapchainImageViews[i], NULL);
+        }
+    }
+
+    free(pApplication->pSwapchainImageViews);
+    pApplication->pSwapchainImageViews = NULL;
+}
+
+Result recreateSwapchain(Application* pApplication)
+{
+    int width, height;
+    SDL_Vulkan_GetDrawableSize(pApplication->pWindow, &width, &height);
+
+    if ((width == 0) || (height == 0) || ((SDL_GetWindowFlags(pApplication->pWindow) & SDL_WINDOW_MINIMIZED) != 0))
+    {
+        return SUCCESS;
+    }
+
+    // The in flight fences do not cover presentation, which can still wait on a render finished semaphore, so the
+    // graphics and present queue is idled. The transfer queue keeps streaming meanwhile.
+    uint64_t waitStart = SDL_GetPerformanceCounter();
+    vkQueueWaitIdle(pApplication->queue);
+    pApplication->waitTicks += SDL_GetPerformanceCounter() - waitStart;
+
+    destroySwapchainResources(pApplication);
+
+    free(pApplication->pSwapchainImages);
+    pApplication->pSwapchainImages = NULL;
+
+    VkFormat imageFormat = pApplication->swapchainImageFormat;
+
+    if (createSwapchain(pApplication) != SUCCESS)
+    {
+        printError("Failed to create swapchain!");
+        return FAIL;
+    }
+
+    // The render pass and with it every pipeline is built for the old format
+    if (pApplication->swapchainImageFormat != imageFormat)
+    {
+        printError("Swapchain format changed from %d to %d!", imageFormat, pApplication->swapchainImageFormat);
+        return FAIL;
+    }
+
+    if (getSwapchainImages(pApplication) != SUCCESS)
+    {
+        printError("Failed to get swapchain images!");
+        return FAIL;
+    }
+
+    if (createSwapchainImageViews(pApplication) != SUCCESS)
+    {
+        printError("Failed to create swapchain image views!");
+        return FAIL;
+    }
+
+    if (createFramebuffers(pApplication) != SUCCESS)
+    {
+        printError("Failed to create framebuffers!");
+        return FAIL;
+    }
+
+    if (createSyncObjects(pApplication) != SUCCESS)
+    {
+        printError("Failed to create synchronization objects!");
+        return FAIL;
+    }
+
+    pApplication->swapchainOutdated = SDL_FALSE;
+
+    return SUCCESS;
+}
+
+Result createHeadlessImages(Application* pApplication)
+{
+    // One render target per frame in flight, so a frame never has to wait for another frame's image
+    pApplication->swapchainImageCount = pApplication->frameCount;
+    pApplication->swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    pApplication->swapchainExtent.width = pApplication->config.width;
+    pApplication->swapchainExtent.height = pApplication->config.height;
+
+    pApplication->pSwapchainImages = calloc(pApplication->swapchainImageCount, sizeof(VkImage));
+    if (pApplication->pSwapchainImages == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for headless images!", pApplication->swapchainImageCount * sizeof(VkImage));
+        return FAIL;
+    }
+
+    pApplication->pHeadlessImageAllocations = calloc(pApplication->swapchainImageCount, sizeof(Allocation));
+    if (pApplication->pHeadlessImageAllocations == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for headless image allocations!", pApplication->swapchainImageCount * sizeof(Allocation));
+        return FAIL;
+    }
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_TRUE;
+
+    for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+    {
+        VkImageCreateInfo createInfo;
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        createInfo.pNext = NULL;
+        createInfo.flags = 0;
+        createInfo.imageType = VK_IMAGE_TYPE_2D;
+        createInfo.format = pApplication->swapchainImageFormat;
+        createInfo.extent.width = pApplication->swapchainExtent.width;
+        createInfo.extent.height = pApplication->swapchainExtent.height;
+        createInfo.extent.depth = 1;
+        createInfo.mipLevels = 1;
+        createInfo.arrayLayers = 1;
+        createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        createInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        createInfo.queueFamilyIndexCount = 0;
+        createInfo.pQueueFamilyIndices = NULL;
+        createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (createImage(&pApplication->allocator, &createInfo, &allocationInfo, &pApplication->pSwapchainImages[i], &pApplication->pHeadlessImageAllocations[i]) != SUCCESS)
+        {
+            printError("Failed to create headless image %u!", i);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result createPipelineCache(Application* pApplication)
+{
+    if (pApplication->config.pPipelineCachePath != NULL)
+    {
+        pApplication->pPipelineCachePath = strdup(pApplication->config.pPipelineCachePath);
+    }
+    else
+    {
+        pApplication->pPipelineCachePath = getDefaultPipelineCachePath();
+    }
+
+    // Without a path the cache still deduplicates work within this run, it just is not persisted
+    if (pApplication->pPipelineCachePath == NULL)
+    {
+        printError("Failed to get pipeline cache path, pipeline cache will not be saved!");
+    }
+
+    return loadPipelineCache(pApplication->physicalDevice, pApplication->device, pApplication->pPipelineCachePath, &pApplication->pipelineCache);
+}
+
+Result startPipelineBuilder(Application* pApplication)
+{
+    uint32_t threadCount = pApplication->config.pipelineThreadCount;
+    if (threadCount == 0)
+    {
+        threadCount = getDefaultThreadCount();
+    }
+
+    return createPipelineBuilder(&pApplication->pipelineBuilder, pApplication->device, pApplication->pipelineCache, threadCount);
+}
+
+Result createPipelineLayout(Application* pApplication)
+{
+    // Only culled.vert reads the objects, the other mesh pipelines share the layout and ignore the set
+    if (createCullingSetLayout(pApplication->device, &pApplication->objectSetLayout) != SUCCESS)
+    {
+        printError("Failed to create object descriptor set layout!");
+        return FAIL;
+    }
+
+    VkDescriptorSetLayoutBinding textureBinding;
+    textureBinding.binding = 0;
+    textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    textureBinding.descriptorCount = 1;
+    textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    textureBinding.pImmutableSamplers = NULL;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo;
+    setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutCreateInfo.pNext = NULL;
+    setLayoutCreateInfo.flags = 0;
+    setLayoutCreateInfo.bindingCount = 1;
+    setLayoutCreateInfo.pBindings = &textureBinding;
+
+    if (vkCreateDescriptorSetLayout(pApplication->device, &setLayoutCreateInfo, NULL, &pApplication->materialSetLayout) != VK_SUCCESS)
+    {
+        printError("Failed to create material descriptor set layout!");
+        return FAIL;
+    }
+
+    // Only virtual.frag reads set 2, it is part of the layout either way so that the pipelines stay compatible
+    if (createVirtualTextureSetLayout(pApplication->device, &pApplication->virtualTextureSetLayout) != SUCCESS)
+    {
+        printError("Failed to create virtual texture descriptor set layout!");
+        return FAIL;
+    }
+
+    VkDescriptorSetLayout pSetLayouts[3] = {pApplication->objectSetLayout, pApplication->materialSetLayout, pApplication->virtualTextureSetLayout};
+
+    VkPushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.setLayoutCount = 3;
+    createInfo.pSetLayouts = pSetLayouts;
+    createInfo.pushConstantRangeCount = 1;
+    createInfo.pPushConstantRanges = &pushConstantRange;
+
+    int result = vkCreatePipelineLayout(pApplication->device, &createInfo, NULL, &pApplication->pipelineLayout);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result createRenderPass(Application* pApplication)
+{
+    pApplication->depthFormat = getDepthFormat(pApplication);
+    if (pApplication->depthFormat == VK_FORMAT_UNDEFINED)
+    {
+        printError("Device supports no depth attachment format!");
+        return FAIL;
+    }
+
+    VkAttachmentDescription pAttachments[2];
+    pAttachments[0].flags = 0;
+    pAttachments[0].format = pApplication->swapchainImageFormat;
+    pAttachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    pAttachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    pAttachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    pAttachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    pAttachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    pAttachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    pAttachments[0].finalLayout = (pApplication->config.headless == SDL_TRUE) ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // Depth is cleared at the start and never stored, so tilers can keep it on chip
+    pAttachments[1].flags = 0;
+    pAttachments[1].format = pApplication->depthFormat;
+    pAttachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    pAttachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    pAttachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    pAttachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    pAttachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    pAttachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    pAttachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference attachmentRef;
+    attachmentRef.attachment = 0;
+    attachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthAttachmentRef;
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass;
+    subpass.flags = 0;
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = NULL;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &attachmentRef;
+    subpass.pResolveAttachments = NULL;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = NULL;
+
+    // The acquire semaphore is waited at the color attachment output stage, so the layout transition
+    // out of UNDEFINED has to wait for that stage as well. The frames in flight share the depth image,
+    // so its clear also waits for the depth writes of the previous frame.
+    VkSubpassDependency dependency;
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dependencyFlags = 0;
+
+    VkRenderPassCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.attachmentCount = 2;
+    createInfo.pAttachments = pAttachments;
+    createInfo.subpassCount = 1;
+    createInfo.pSubpasses = &subpass;
+    createInfo.dependencyCount = 1;
+    createInfo.pDependencies = &dependency;
+
+    int result = vkCreateRenderPass(pApplication->device, &createInfo, NULL, &pApplication->renderPass);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result createGraphicsPipeline(Application* pApplication)
+{
+    if (getShaderModule(&pApplication->shaderCache, "shader_vert.spv", &pApplication->vertShaderModule) != SUCCESS)
+    {
+        printError("Failed to create vertex shader module!");
+        return FAIL;
+    }
+
+    const char* pFragShaderName = (pApplication->config.pVirtualTexturePath != NULL) ? "virtual_frag.spv" : "shader_frag.spv";
+    if (getShaderModule(&pApplication->shaderCache, pFragShaderName, &pApplication->fragShaderModule) != SUCCESS)
+    {
+        printError("Failed to create fragment shader module!");
+        return FAIL;
+    }
+
+    GraphicsPipelineState state;
+    getMeshPipelineState(pApplication, &state);
+
+    // Compiled on the builder threads; frames skip the draw until the pipeline is ready
+    if (submitGraphicsPipelines(&pApplication->pipelineBuilder, 1, &state, &pApplication->meshPipeline) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    if (pApplication->config.instancing == SDL_TRUE)
+    {
+        if (getShaderModule(&pApplication->shaderCache, "instanced_vert.spv", &pApplication->instancedVertShaderModule) != SUCCESS)
+        {
+            printError("Failed to create instanced vertex shader module!");
+            return FAIL;
+        }
+
+        GraphicsPipelineState instancedState = state;
+        instancedState.pStages[0].module = pApplication->instancedVertShaderModule;
+        addInstanceInputState(&instancedState.vertexBindingCount, instancedState.pVertexBindings, &instancedState.vertexAttributeCount, instancedState.pVertexAttributes);
+
+        if (submitGraphicsPipelines(&pApplication->pipelineBuilder, 1, &instancedState, &pApplication->instancedPipeline) != SUCCESS)
+        {
+            return FAIL;
+        }
+    }
+
+    if (pApplication->config.gpuCulling != SDL_TRUE)
+    {
+        return SUCCESS;
+    }
+
+    if (getShaderModule(&pApplication->shaderCache, "culled_vert.spv", &pApplication->culledVertShaderModule) != SUCCESS)
+    {
+        printError("Failed to create culled vertex shader module!");
+        return FAIL;
+    }
+
+    state.pStages[0].module = pApplication->culledVertShaderModule;
+
+    return submitGraphicsPipelines(&pApplication->pipelineBuilder, 1, &state, &pApplication->culledPipeline);
+}
+
+Result loadMesh(Application* pApplication)
+{
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    const char* pMeshPath = pApplication->config.pMeshPath;
+
+    MeshData meshData;
+    memset(&meshData, 0, sizeof(meshData));
+
+    MeshCache cache;
+    memset(&cache, 0, sizeof(cache));
+
+    Result result = SUCCESS;
+
+    if (pApplication->config.gridTriangleCount > 0)
+    {
+        result = createGridMeshData(pApplication->config.gridTriangleCount, &meshData);
+    }
+    else if (pMeshPath == NULL)
+    {
+        result = createTriangleMeshData(&meshData);
+    }
+    else if (isMeshCachePath(pMeshPath) == SDL_TRUE)
+    {
+        result = openMeshCache(pMeshPath, NULL, pApplication->config.verifyMeshCache, &cache);
+        if (result != SUCCESS)
+        {
+            printError("Failed to open mesh cache \"%s\"!", pMeshPath);
+        }
+    }
+    else
+    {
+        // The model is only parsed when its cache is missing or stale, the cache is then rebuilt for the next run
+        char* pCachePath = getMeshCachePath(pMeshPath);
+        if (pCachePath == NULL)
+        {
+            return FAIL;
+        }
+
+        if (openMeshCache(pCachePath, pMeshPath, pApplication->config.verifyMeshCache, &cache) != SUCCESS)
+        {
+            result = loadMeshData(pMeshPath, &meshData);
+            if ((result == SUCCESS) && (writeMeshCache(pCachePath, pMeshPath, &meshData) != SUCCESS))
+            {
+                printError("Failed to write mesh cache, \"%s\" will be parsed again on the next run!", pMeshPath);
+            }
+        }
+
+        free(pCachePath);
+    }
+
+    if (result != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    uint64_t parsedTicks = SDL_GetPerformanceCounter();
+
+    const float* pMin = meshData.pMin;
+    const float* pMax = meshData.pMax;
+
+    if (cache.pVertices != NULL)
+    {
+        // Mapped pages go straight into the staging ring, the cache already has the final index type
+        VkIndexType indexType = (cache.header.indexSize == sizeof(uint16_t)) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        result = createMeshBuffers(&pApplication->allocator, &pApplication->stagingRing, cache.header.vertexCount, cache.pVertices, cache.header.indexCount, indexType, cache.pIndices, &pApplication->mesh);
+
+        pMin = cache.header.pMin;
+        pMax = cache.header.pMax;
+    }
+    else
+    {
+        result = createMesh(&pApplication->allocator, &pApplication->stagingRing, &meshData, &pApplication->mesh);
+    }
+
+    // Hand the buffers over to the graphics queue, the render thread acquires them once the copies completed
+    if (result == SUCCESS)
+    {
+        if ((releaseStagedBuffer(&pApplication->stagingRing, pApplication->mesh.vertexBuffer) != SUCCESS)
+            || (releaseStagedBuffer(&pApplication->stagingRing, pApplication->mesh.indexBuffer) != SUCCESS)
+            || (submitStagingRing(&pApplication->stagingRing, &pApplication->meshTimelineValue) != SUCCESS))
+        {
+            result = FAIL;
+        }
+    }
+
+    // Center the mesh and scale its largest extent to 2 units, so any model fits in front of the camera
+    float extent = 0.0f;
+    float pCenter[3];
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        pCenter[axis] = (pMin[axis] + pMax[axis]) * 0.5f;
+        extent = (pMax[axis] - pMin[axis] > extent) ? pMax[axis] - pMin[axis] : extent;
+    }
+
+    float scale = (extent > 0.0f) ? 2.0f / extent : 1.0f;
+    pApplication->meshTransform = multiplyMat4(scaleMat4(scale, scale, scale), translationMat4(-pCenter[0], -pCenter[1], -pCenter[2]));
+
+    // Half the diagonal of the bounds, the sphere around the center holds the mesh however it is rotated
+    float diagonalSquared = 0.0f;
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        diagonalSquared += (pMax[axis] - pMin[axis]) * (pMax[axis] - pMin[axis]);
+    }
+
+    pApplication->meshRadius = scale * 0.5f * sqrtf(diagonalSquared);
+
+    SDL_bool fromCache = (cache.pVertices != NULL) ? SDL_TRUE : SDL_FALSE;
+
+    closeMeshCache(&cache);
+    destroyMeshData(&meshData);
+
+    if (result != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double triangleMillions = pApplication->mesh.indexCount / 3 / 1000000.0;
+    double residentBytes = (double)(pApplication->mesh.vertexAllocation.size + pApplication->mesh.indexAllocation.size);
+
+    const char* pMeshName = (pApplication->config.gridTriangleCount > 0) ? "generated grid" : ((pMeshPath != NULL) ? pMeshPath : "builtin triangle");
+    printf("Mesh \"%s\": %u vertices, %u triangles, %s indices\n", pMeshName,
+        pApplication->mesh.vertexCount, pApplication->mesh.indexCount / 3, (pApplication->mesh.indexType == VK_INDEX_TYPE_UINT16) ? "16-bit" : "32-bit");
+    printf("%s in %.3f ms, upload submitted in %.3f ms\n", (fromCache == SDL_TRUE) ? "Mapped from cache" : "Loaded", (parsedTicks - startTicks) * 1000.0 / frequency, (SDL_GetPerformanceCounter() - parsedTicks) * 1000.0 / frequency);
+    printf("Resident: %.3f MiB (%.3f MiB per million triangles)\n", residentBytes / 1048576.0, residentBytes / 1048576.0 / triangleMillions);
+    printf("\n");
+
+    return SUCCESS;
+}
+
+int loadMeshThread(void* pData)
+{
+    Application* pApplication = pData;
+
+    // Also runs on the main thread when there is no separate transfer queue
+    if (pApplication->transferQueue != pApplication->queue)
+    {
+        nameCpuTraceThread("mesh loader");
+    }
+
+    uint64_t traceStart = beginCpuTrace();
+    Result result = loadMesh(pApplication);
+    endCpuTrace("load mesh", traceStart);
+
+    // Publishes the mesh, its transform and the timeline value to the render thread
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&pApplication->meshState, (result == SUCCESS) ? MESH_STATE_UPLOADED : MESH_STATE_FAILED);
+
+    return 0;
+}
+
+Result createTextures(Application* pApplication)
+{
+    if (createSamplerCache(&pApplication->samplerCache, pApplication->physicalDevice, pApplication->device) != SUCCESS)
+    {
+        printError("Failed to create sampler cache!");
+        return FAIL;
+    }
+
+    // Decoding runs on the loader threads while the pipeline builder compiles, uploads use the graphics queue
+    if (createTextureLoader(&pApplication->textureLoader, pApplication->physicalDevice, pApplication->device, &pApplication->allocator, pApplication->queue,
+        pApplication->graphicsQueueFamily, getDefaultThreadCount()) != SUCCESS)
+    {
+        printError("Failed to create texture loader!");
+        return FAIL;
+    }
+
+    const char* pTexturePath = pApplication->config.pTexturePath;
+    if (pTexturePath != NULL)
+    {
+        TextureLoadStats stats;
+        if (loadTextures(&pApplication->textureLoader, 1, &pTexturePath, &pApplication->texture, &stats) != SUCCESS)
+        {
+            printError("Failed to load texture \"%s\"!", pTexturePath);
+            return FAIL;
+        }
+
+        const Texture* pTexture = &pApplication->texture;
+        printf("Texture: %ux%u, %u levels, %s\n", pTexture->width, pTexture->height, pTexture->levelCount, (pTexture->compressed == SDL_TRUE) ? "block compressed" : "RGBA8");
+        printf("Decoded in %.3f ms, uploaded in %.3f ms\n", stats.decodeMs, stats.uploadMs);
+        printf("Resident: %.3f MiB (%.3f MiB as RGBA8)\n", stats.memoryBytes / 1048576.0, stats.uncompressedBytes / 1048576.0);
+        printf("\n");
+    }
+    else
+    {
+        // Untextured meshes sample white, so the lighting shows unchanged
+        const uint8_t pWhite[4] = {255, 255, 255, 255};
+        if (createSolidTexture(&pApplication->textureLoader, pWhite, &pApplication->texture) != SUCCESS)
+        {
+            printError("Failed to create default texture!");
+            return FAIL;
+        }
+    }
+
+    SamplerKey samplerKey;
+    setDefaultSamplerKey(&pApplication->samplerCache, &samplerKey);
+
+    VkSampler sampler;
+    if (getSampler(&pApplication->samplerCache, &samplerKey, &sampler) != SUCCESS)
+    {
+        printError("Failed to get texture sampler!");
+        return FAIL;
+    }
+
+    VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = 0;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = 1;
+    poolCreateInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(pApplication->device, &poolCreateInfo, NULL, &pApplication->materialDescriptorPool) != VK_SUCCESS)
+    {
+        printError("Failed to create material descriptor pool!");
+        return FAIL;
+    }
+
+    VkDescriptorSetAllocateInfo allocateInfo;
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext = NULL;
+    allocateInfo.descriptorPool = pApplication->materialDescriptorPool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &pApplication->materialSetLayout;
+
+    if (vkAllocateDescriptorSets(pApplication->device, &allocateInfo, &pApplication->materialDescriptorSet) != VK_SUCCESS)
+    {
+        printError("Failed to allocate material descriptor set!");
+        return FAIL;
+    }
+
+    VkDescriptorImageInfo imageInfo;
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = pApplication->texture.imageView;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write;
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = pApplication->materialDescriptorSet;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    write.pBufferInfo = NULL;
+    write.pTexelBufferView = NULL;
+
+    vkUpdateDescriptorSets(pApplication->device, 1, &write, 0, NULL);
+
+    return SUCCESS;
+}
+
+Result createVirtualTexturing(Application* pApplication)
+{
+    const Config* pConfig = &pApplication->config;
+    if (pConfig->pVirtualTexturePath == NULL)
+    {
+        return SUCCESS;
+    }
+
+    // The sparse backend binds pages on the graphics queue, which falls back to the atlas when its family cannot
+    VkDeviceSize budget = (VkDeviceSize)pConfig->virtualTextureBudgetMb * 1024 * 1024;
+    if (createVirtualTexture(&pApplication->virtualTexture, pApplication->physicalDevice, pApplication->device, &pApplication->allocator, &pApplication->samplerCache,
+        pApplication->queue, pApplication->graphicsQueueFamily, pApplication->virtualTextureSetLayout, pApplication->frameCount, pConfig->pVirtualTexturePath, budget,
+        pApplication->sparseResidencySupported) != SUCCESS)
+    {
+        printError("Failed to create virtual texture \"%s\"!", pConfig->pVirtualTexturePath);
+        return FAIL;
+    }
+
+    pApplication->virtualTextureEnabled = SDL_TRUE;
+
+    return SUCCESS;
+}
+
+VkFormat getDepthFormat(Application* pApplication)
+{
+    // Most precise first, no stencil is used
+    const VkFormat pCandidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM };
+
+    for (uint32_t i = 0; i < sizeof(pCandidates) / sizeof(pCandidates[0]); ++i)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(pApplication->physicalDevice, pCandidates[i], &properties);
+
+        if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0)
+        {
+            return pCandidates[i];
+        }
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+Result createDepthImage(Application* pApplication)
+{
+    VkImageCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = pApplication->depthFormat;
+    createInfo.extent.width = pApplication->swapchainExtent.width;
+    createInfo.extent.height = pApplication->swapchainExtent.height;
+    createInfo.extent.depth = 1;
+    createInfo.mipLevels = 1;
+    createInfo.arrayLayers = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = NULL;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_TRUE;
+
+    if (createImage(&pApplication->allocator, &createInfo, &allocationInfo, &pApplication->depthImage, &pApplication->depthImageAllocation) != SUCCESS)
+    {
+        pApplication->depthImage = NULL;
+        return FAIL;
+    }
+
+    VkImageViewCreateInfo viewCreateInfo;
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = NULL;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = pApplication->depthImage;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = pApplication->depthFormat;
+    viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    viewCreateInfo.subresourceRange.baseMipLevel = 0;
+    viewCreateInfo.subresourceRange.levelCount = 1;
+    viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    viewCreateInfo.subresourceRange.layerCount = 1;
+
+    int result = vkCreateImageView(pApplication->device, &viewCreateInfo, NULL, &pApplication->depthImageView);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result createFramebuffers(Application* pApplication)
+{
+    // Sized like the swapchain, so it is recreated with the framebuffers
+    if (createDepthImage(pApplication) != SUCCESS)
+    {
+        printError("Failed to create depth image!");
+        return FAIL;
+    }
+
+    pApplication->pFramebuffers = calloc(pApplication->swapchainImageCount, sizeof(VkFramebuffer));
+    if (pApplication->pFramebuffers == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for framebuffers!", pApplication->swapchainImageCount * sizeof(VkFramebuffer));
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+    {
+        VkImageView pAttachments[2] = {pApplication->pSwapchainImageViews[i], pApplication->depthImageView};
+
+        VkFramebufferCreateInfo createInfo;
+        createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        createInfo.pNext = NULL;
+        createInfo.flags = 0;
+        createInfo.renderPass = pApplication->renderPass;
+        createInfo.attachmentCount = 2;
+        createInfo.pAttachments = pAttachments;
+        createInfo.width = pApplication->swapchainExtent.width;
+        createInfo.height = pApplication->swapchainExtent.height;
+        createInfo.layers = 1;
+
+        if (vkCreateFramebuffer(pApplication->device, &createInfo, NULL, &pApplication->pFramebuffers[i]) != VK_SUCCESS)
+        {
+            printError("Failed to create framebuffer %u!", i);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result createCommandPool(Application* pApplication)
+{
+    VkCommandPoolCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    createInfo.queueFamilyIndex = pApplication->graphicsQueueFamily;
+
+    int result = vkCreateCommandPool(pApplication->device, &createInfo, NULL, &pApplication->commandPool);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result createFrames(Application* pApplication)
+{
+    pApplication->pFrames = calloc(pApplication->frameCount, sizeof(Frame));
+    if (pApplication->pFrames == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for frames!", pApplication->frameCount * sizeof(Frame));
+        return FAIL;
+    }
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo;
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = NULL;
+    semaphoreCreateInfo.flags = 0;
+
+    // Fences start signaled so that the first wait on every frame returns immediately
+    VkFenceCreateInfo fenceCreateInfo;
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = NULL;
+    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < pApplication->frameCount; ++i)
+    {
+        Frame* pFrame = &pApplication->pFrames[i];
+
+        VkCommandBufferAllocateInfo allocateInfo;
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.pNext = NULL;
+        allocateInfo.commandPool = pApplication->commandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(pApplication->device, &allocateInfo, &pFrame->commandBuffer) != VK_SUCCESS)
+        {
+            printError("Failed to allocate command buffer for frame %u!", i);
+            return FAIL;
+        }
+
+        if (vkCreateSemaphore(pApplication->device, &semaphoreCreateInfo, NULL, &pFrame->imageAvailableSemaphore) != VK_SUCCESS)
+        {
+            printError("Failed to create image available semaphore for frame %u!", i);
+            return FAIL;
+        }
+
+        if (vkCreateFence(pApplication->device, &fenceCreateInfo, NULL, &pFrame->inFlightFence) != VK_SUCCESS)
+        {
+            printError("Failed to create in flight fence for frame %u!", i);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result createRecordJobs(Application* pApplication)
+{
+    uint32_t threadCount = pApplication->config.recordThreadCount;
+    if (threadCount == 0)
+    {
+        return SUCCESS;
+    }
+
+    if (createThreadPool(&pApplication->recordThreadPool, threadCount) != SUCCESS)
+    {
+        printError("Failed to create record thread pool!");
+        return FAIL;
+    }
+
+    pApplication->pRecordJobs = calloc(threadCount, sizeof(RecordJob));
+    if (pApplication->pRecordJobs == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for record jobs!", threadCount * sizeof(RecordJob));
+        return FAIL;
+    }
+
+    pApplication->recordJobCount = threadCount;
+
+    // Pools are reset every frame instead of their command buffers one by one
+    VkCommandPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolCreateInfo.queueFamilyIndex = pApplication->graphicsQueueFamily;
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        RecordJob* pJob = &pApplication->pRecordJobs[i];
+        pJob->pApplication = pApplication;
+
+        for (uint32_t j = 0; j < pApplication->frameCount; ++j)
+        {
+            if (vkCreateCommandPool(pApplication->device, &poolCreateInfo, NULL, &pJob->pCommandPools[j]) != VK_SUCCESS)
+            {
+                printError("Failed to create command pool %u of record job %u!", j, i);
+                return FAIL;
+            }
+
+            VkCommandBufferAllocateInfo allocateInfo;
+            allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateInfo.pNext = NULL;
+            allocateInfo.commandPool = pJob->pCommandPools[j];
+            allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocateInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(pApplication->device, &allocateInfo, &pJob->pCommandBuffers[j]) != VK_SUCCESS)
+            {
+                printError("Failed to allocate command buffer %u of record job %u!", j, i);
+                return FAIL;
+            }
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result createCulling(Application* pApplication)
+{
+    if (pApplication->config.gpuCulling != SDL_TRUE)
+    {
+        return createCpuObjectCulling(pApplication);
+    }
+
+    // The draws carry the object index in firstInstance, which is optional for indirect draws
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(pApplication->physicalDevice, &features);
+    if (features.drawIndirectFirstInstance != VK_TRUE)
+    {
+        printf("Device does not support drawIndirectFirstInstance, culling on the CPU instead\n\n");
+        if (pApplication->config.cpuCulling == CPU_CULLING_OPTION_OFF)
+        {
+            pApplication->config.cpuCulling = CPU_CULLING_OPTION_AUTO;
+        }
+
+        return createCpuObjectCulling(pApplication);
+    }
+
+    uint32_t objectCount = pApplication->config.drawCount;
+    uint32_t gridSize;
+    float cellSize;
+    getGridLayout(objectCount, &gridSize, &cellSize);
+
+    float* pPositionScales = malloc(objectCount * 4 * sizeof(float));
+    if (pPositionScales == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for culling objects!", objectCount * 4 * sizeof(float));
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        getGridObject(i, gridSize, cellSize, &pPositionScales[i * 4]);
+    }
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    if (getShaderModule(&pApplication->shaderCache, "cull_comp.spv", &shaderModule) != SUCCESS)
+    {
+        printError("Failed to create culling shader module!");
+        free(pPositionScales);
+        return FAIL;
+    }
+
+    Result result = createGpuCulling(&pApplication->gpuCulling, pApplication->physicalDevice, pApplication->device, &pApplication->allocator, pApplication->objectSetLayout,
+        shaderModule, pApplication->pipelineCache, pApplication->frameCount, objectCount, pPositionScales, pApplication->drawIndirectCountSupported);
+
+    free(pPositionScales);
+
+    if (result != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    pApplication->gpuCullingEnabled = SDL_TRUE;
+
+    return SUCCESS;
+}
+
+Result createCpuObjectCulling(Application* pApplication)
+{
+    CullingInstructionSet instructionSet;
+    switch (pApplication->config.cpuCulling)
+    {
+        case CPU_CULLING_OPTION_AUTO:
+            instructionSet = getBestCullingInstructionSet();
+            break;
+        case CPU_CULLING_OPTION_SCALAR:
+            instructionSet = CULLING_INSTRUCTION_SET_SCALAR;
+            break;
+        case CPU_CULLING_OPTION_SSE:
+            instructionSet = CULLING_INSTRUCTION_SET_SSE;
+            break;
+        case CPU_CULLING_OPTION_AVX:
+            instructionSet = CULLING_INSTRUCTION_SET_AVX;
+            break;
+        default:
+            return SUCCESS;
+    }
+
+    uint32_t objectCount = pApplication->config.drawCount;
+    uint32_t gridSize;
+    float cellSize;
+    getGridLayout(objectCount, &gridSize, &cellSize);
+
+    if (createObjectBounds(&pApplication->objectBounds, objectCount) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    // Radii are relative to the mesh, which may still be loading, and are scaled by its radius when culling
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        float pPositionScale[4];
+        getGridObject(i, gridSize, cellSize, pPositionScale);
+
+        pApplication->objectBounds.pCenterX[i] = pPositionScale[0];
+        pApplication->objectBounds.pCenterY[i] = pPositionScale[1];
+        pApplication->objectBounds.pCenterZ[i] = pPositionScale[2];
+        pApplication->objectBounds.pRadii[i] = pPositionScale[3];
+    }
+
+    // The main thread culls a chunk of its own, so one worker less than there are cores
+    uint32_t threadCount = getDefaultThreadCount() - 1;
+    ThreadPool* pThreadPool = NULL;
+    if ((threadCount > 0) && (objectCount > CPU_CULLING_CHUNK_SIZE))
+    {
+        if (createThreadPool(&pApplication->cullingThreadPool, threadCount) != SUCCESS)
+        {
+            printError("Failed to create culling thread pool!");
+            return FAIL;
+        }
+
+        pThreadPool = &pApplication->cullingThreadPool;
+    }
+
+    if (createCpuCulling(&pApplication->cpuCulling, &pApplication->objectBounds, pThreadPool, instructionSet) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    pApplication->cpuCullingEnabled = SDL_TRUE;
+    printf("Culling %u objects on the CPU with %s on %u threads\n\n", objectCount, getCullingInstructionSetName(instructionSet), (pThreadPool != NULL) ? threadCount + 1 : 1);
+
+    return SUCCESS;
+}
+
+Result createInstancing(Application* pApplication)
+{
+    if (pApplication->config.instancing != SDL_TRUE)
+    {
+        return SUCCESS;
+    }
+
+    if (pApplication->gpuCullingEnabled == SDL_TRUE)
+    {
+        printf("GPU culling draws indirectly, instancing is not used\n\n");
+        return SUCCESS;
+    }
+
+    uint32_t objectCount = pApplication->config.drawCount;
+
+    pApplication->pDrawItems = malloc(objectCount * sizeof(DrawItem));
+    if (pApplication->pDrawItems == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for draw items!", objectCount * sizeof(DrawItem));
+        return FAIL;
+    }
+
+    pApplication->pDrawBatches = malloc(objectCount * sizeof(DrawBatch));
+    if (pApplication->pDrawBatches == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for draw batches!", objectCount * sizeof(DrawBatch));
+        return FAIL;
+    }
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    // Transforms change every frame and are written straight into the buffer of the frame being recorded
+    for (uint32_t i = 0; i < pApplication->frameCount; ++i)
+    {
+        if (createBuffer(&pApplication->allocator, (VkDeviceSize)objectCount * sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &allocationInfo,
+                &pApplication->pInstanceBuffers[i], &pApplication->pInstanceAllocations[i]) != SUCCESS)
+        {
+            printError("Failed to create instance buffer for frame %u!", i);
+            return FAIL;
+        }
+    }
+
+    pApplication->instancingEnabled = SDL_TRUE;
+
+    return SUCCESS;
+}
+
+Result createDrawSorting(Application* pApplication)
+{
+    if (pApplication->config.sortDraws != SDL_TRUE)
+    {
+        return SUCCESS;
+    }
+
+    if (createDrawSorter(&pApplication->drawSorter, pApplication->config.drawCount) != SUCCESS)
+    {
+        printError("Failed to create draw sorter!");
+        return FAIL;
+    }
+
+    pApplication->drawSortEnabled = SDL_TRUE;
+
+    return SUCCESS;
+}
+
+Result createSyncObjects(Application* pApplication)
+{
+    // Release semaphores are owned by swapchain images rather than by frames: the presentation engine
+    // only gives the semaphore back once the same image has been acquired again.
+    pApplication->pRenderFinishedSemaphores = calloc(pApplication->swapchainImageCount, sizeof(VkSemaphore));
+    if (pApplication->pRenderFinishedSemaphores == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for render finished semaphores!", pApplication->swapchainImageCount * sizeof(VkSemaphore));
+        return FAIL;
+    }
+
+    pApplication->pImageFences = calloc(pApplication->swapchainImageCount, sizeof(VkFence));
+    if (pApplication->pImageFences == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for image fences!", pApplication->swapchainImageCount * sizeof(VkFence));
+        return FAIL;
+    }
+
+    if (pApplication->config.headless == SDL_TRUE)
+    {
+        return SUCCESS;
+    }
+
+    VkSemaphoreCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+
+    for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+    {
+        if (vkCreateSemaphore(pApplication->device, &createInfo, NULL, &pApplication->pRenderFinishedSemaphores[i]) != VK_SUCCESS)
+        {
+            printError("Failed to create render finished semaphore %u!", i);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result recordCommandBuffer(Application* pApplication, VkCommandBuffer commandBuffer, uint32_t imageIndex, SDL_bool acquireMesh)
+{
+    VkCommandBufferBeginInfo beginInfo;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = NULL;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = NULL;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
         return FAIL;
     }
 
-    vkGetPhysicalDeviceSurfaceFormatsKHR(pApplication->physicalDevice, pApplication->surface, &surfaceFormatCount, pSurfaceFormats);
+    beginProfilerFrame(&pApplication->gpuProfiler, commandBuffer, pApplication->currentFrame);
+    beginProfilerScope(&pApplication->gpuProfiler, commandBuffer, "frame", SDL_FALSE);
 
-    VkSurfaceFormatKHR surfaceFormat = pSurfaceFormats[0];
-    for (uint32_t i = 0; i < surfaceFormatCount; ++i)
+    if (acquireMesh == SDL_TRUE)
     {
-        if ((pSurfaceFormats[i].format == VK_FORMAT_B8G8R8A8_SRGB) && (pSurfaceFormats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR))
+        acquireStagedBuffer(&pApplication->stagingRing, commandBuffer, pApplication->mesh.vertexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        acquireStagedBuffer(&pApplication->stagingRing, commandBuffer, pApplication->mesh.indexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+    }
+
+    VkClearValue pClearValues[2];
+    pClearValues[0].color.float32[0] = 0.0f;
+    pClearValues[0].color.float32[1] = 0.0f;
+    pClearValues[0].color.float32[2] = 0.0f;
+    pClearValues[0].color.float32[3] = 1.0f;
+    pClearValues[1].depthStencil.depth = 1.0f;
+    pClearValues[1].depthStencil.stencil = 0;
+
+    VkRenderPassBeginInfo renderPassBeginInfo;
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = NULL;
+    renderPassBeginInfo.renderPass = pApplication->renderPass;
+    renderPassBeginInfo.framebuffer = pApplication->pFramebuffers[imageIndex];
+    renderPassBeginInfo.renderArea.offset.x = 0;
+    renderPassBeginInfo.renderArea.offset.y = 0;
+    renderPassBeginInfo.renderArea.extent = pApplication->swapchainExtent;
+    renderPassBeginInfo.clearValueCount = 2;
+    renderPassBeginInfo.pClearValues = pClearValues;
+
+    SDL_bool cull = pApplication->gpuCullingEnabled;
+    SDL_bool instance = pApplication->instancingEnabled;
+    uint32_t pipelineId = getMeshPipelineId(pApplication);
+    VkPipeline pipeline = getPipeline(&pApplication->pipelineBuilder, pipelineId);
+    SDL_bool drawMesh = ((pipeline != VK_NULL_HANDLE) && (pApplication->meshReady == SDL_TRUE)) ? SDL_TRUE : SDL_FALSE;
+
+    if (drawMesh == SDL_TRUE)
+    {
+        if (pApplication->pipelinesReady != SDL_TRUE)
         {
-            surfaceFormat = pSurfaceFormats[i];
-            break;
+            pApplication->pipelinesReady = SDL_TRUE;
+            printf("Pipelines ready %.3f ms after startup\n\n", (SDL_GetPerformanceCounter() - pApplication->startTicks) * 1000.0 / SDL_GetPerformanceFrequency());
         }
-    }
 
-    free(pSurfaceFormats);
+        // A fixed step makes the animation a function of the frame number, so benchmark runs render the same images
+        uint32_t timeStepMs = pApplication->config.timeStepMs;
+        float seconds = (timeStepMs > 0) ? (float)(pApplication->frameNumber * timeStepMs / 1000.0)
+                                         : (float)((double)(SDL_GetPerformanceCounter() - pApplication->startTicks) / SDL_GetPerformanceFrequency());
+        float aspect = (float)pApplication->swapchainExtent.width / (float)pApplication->swapchainExtent.height;
 
-    VkExtent2D extent;
-    if (surfaceCapabilities.currentExtent.width != UINT32_MAX)
-    {
-        extent = surfaceCapabilities.currentExtent;
-    }
-    else
-    {
-        int width, height;
-        SDL_Vulkan_GetDrawableSize(pApplication->pWindow, &width, &height);
+        DrawList* pDrawList = &pApplication->drawList;
+        pDrawList->pipeline = pipeline;
+        pDrawList->rotation = multiplyMat4(rotationYMat4(seconds * 0.5f), pApplication->meshTransform);
+        pDrawList->viewProjection = multiplyMat4(perspectiveMat4(1.0f, aspect, 0.1f, 100.0f), translationMat4(0.0f, 0.0f, -2.5f));
 
-        extent.width = width;
-        extent.height = height;
+        pDrawList->drawCount = pApplication->config.drawCount;
+        pDrawList->pObjectIndices = NULL;
 
-        if (width < surfaceCapabilities.minImageExtent.width)
+        getGridLayout(pApplication->config.drawCount, &pDrawList->gridSize, &pDrawList->cellSize);
+
+        if (pApplication->cpuCullingEnabled == SDL_TRUE)
         {
-            extent.width = surfaceCapabilities.minImageExtent.width;
+            uint64_t cullStart = SDL_GetPerformanceCounter();
+            uint64_t traceStart = beginCpuTrace();
+
+            float pPlanes[6][4];
+            getFrustumPlanes(&pDrawList->viewProjection, pPlanes);
+
+            pDrawList->drawCount = cullObjects(&pApplication->cpuCulling, pPlanes, pApplication->meshRadius);
+            pDrawList->pObjectIndices = pApplication->cpuCulling.pVisibleObjects;
+
+            endCpuTrace("cull", traceStart);
+            pApplication->cullTicks += SDL_GetPerformanceCounter() - cullStart;
         }
-        else if (width > surfaceCapabilities.maxImageExtent.width)
+
+        // GPU culling compacts the draws in its own order and instancing batches them itself
+        if ((pApplication->drawSortEnabled == SDL_TRUE) && (cull != SDL_TRUE) && (instance != SDL_TRUE))
         {
-            extent.width = surfaceCapabilities.maxImageExtent.width;
+            uint64_t sortStart = SDL_GetPerformanceCounter();
+            uint64_t traceStart = beginCpuTrace();
+
+            sortDrawList(pApplication, pipelineId);
+
+            endCpuTrace("sort", traceStart);
+            pApplication->sortTicks += SDL_GetPerformanceCounter() - sortStart;
+            pApplication->sortedDrawSum += pDrawList->drawCount;
         }
 
-        if (height < surfaceCapabilities.minImageExtent.height)
+        if (cull == SDL_TRUE)
         {
-            extent.height = surfaceCapabilities.minImageExtent.height;
+            beginProfilerScope(&pApplication->gpuProfiler, commandBuffer, "cull", SDL_FALSE);
+            recordCulling(&pApplication->gpuCulling, commandBuffer, pApplication->currentFrame, &pDrawList->viewProjection, pApplication->meshRadius, pApplication->mesh.indexCount);
+            endProfilerScope(&pApplication->gpuProfiler, commandBuffer);
         }
-        else if (height > surfaceCapabilities.maxImageExtent.height)
+    }
+
+    // Timestamps cannot be written inside a subpass executing secondary command buffers. The mesh scope is folded into
+    // the render pass scope then, which begins outside of the render pass and collects the statistics instead.
+    if (pApplication->virtualTextureEnabled == SDL_TRUE)
+    {
+        uint64_t traceStart = beginCpuTrace();
+        Result result = updateVirtualTexture(&pApplication->virtualTexture, commandBuffer, pApplication->currentFrame, pApplication->frameNumber);
+        endCpuTrace("virtual texture", traceStart);
+
+        if (result != SUCCESS)
         {
-            extent.height = surfaceCapabilities.maxImageExtent.height;
+            return FAIL;
         }
     }
 
-    uint32_t queueFamilyIndex = 0;
+    SDL_bool useSecondaries = ((drawMesh == SDL_TRUE) && (cull != SDL_TRUE) && (instance != SDL_TRUE) && (pApplication->recordJobCount > 0)) ? SDL_TRUE : SDL_FALSE;
 
-    uint32_t presentModeCount;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(pApplication->physicalDevice, pApplication->surface, &presentModeCount, NULL);
+    // Statistics may only stay active across vkCmdExecuteCommands when the secondaries can inherit the query
+    SDL_bool secondaryStatistics = ((useSecondaries == SDL_TRUE) && (getProfilerStatisticFlags(&pApplication->gpuProfiler) != 0)) ? SDL_TRUE : SDL_FALSE;
 
-    VkPresentModeKHR* pPresentModes = malloc(presentModeCount * sizeof(VkPresentModeKHR));
-    if (pPresentModes == NULL)
-    {
-        printError("Failed to allocate %lu bytes of memory for present modes!");
-        return FAIL;
-    }
+    beginProfilerScope(&pApplication->gpuProfiler, commandBuffer, "render pass", secondaryStatistics);
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, (useSecondaries == SDL_TRUE) ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
-    vkGetPhysicalDeviceSurfacePresentModesKHR(pApplication->physicalDevice, pApplication->surface, &presentModeCount, pPresentModes);
+    if (useSecondaries == SDL_TRUE)
+    {
+        if (recordSecondaryCommandBuffers(pApplication, commandBuffer, imageIndex) != SUCCESS)
+        {
+            return FAIL;
+        }
 
-    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    for (uint32_t i = 0; i < presentModeCount; ++i)
+        pApplication->drawCallSum += pApplication->drawList.drawCount;
+        pApplication->drawnObjectSum += pApplication->drawList.drawCount;
+    }
+    else if (drawMesh == SDL_TRUE)
     {
-        if (pPresentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)
+        beginProfilerScope(&pApplication->gpuProfiler, commandBuffer, "mesh", SDL_TRUE);
+        if (cull == SDL_TRUE)
         {
-            presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
-            break;
+            recordCulledDraws(pApplication, commandBuffer);
+        }
+        else if (instance == SDL_TRUE)
+        {
+            pApplication->drawCallSum += recordInstancedDraws(pApplication, commandBuffer);
+            pApplication->drawnObjectSum += pApplication->drawList.drawCount;
+        }
+        else
+        {
+            recordDraws(pApplication, commandBuffer, 0, pApplication->drawList.drawCount);
+            pApplication->drawCallSum += pApplication->drawList.drawCount;
+            pApplication->drawnObjectSum += pApplication->drawList.drawCount;
         }
+        endProfilerScope(&pApplication->gpuProfiler, commandBuffer);
     }
 
-    free(pPresentModes);
-
-    VkSwapchainCreateInfoKHR createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.surface = pApplication->surface;
-    createInfo.minImageCount = imageCount;
-    createInfo.imageFormat = surfaceFormat.format;
-    createInfo.imageColorSpace = surfaceFormat.colorSpace;
-    createInfo.imageExtent = extent;
-    createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    createInfo.queueFamilyIndexCount = 1;
-    createInfo.pQueueFamilyIndices = &queueFamilyIndex;
-    createInfo.preTransform = surfaceCapabilities.currentTransform;
-    createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    createInfo.presentMode = presentMode;
-    createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    vkCmdEndRenderPass(commandBuffer);
+    endProfilerScope(&pApplication->gpuProfiler, commandBuffer);
 
-    int result = vkCreateSwapchainKHR(pApplication->device, &createInfo, NULL, &pApplication->swapchain);
+    if (pApplication->virtualTextureEnabled == SDL_TRUE)
+    {
+        finishVirtualTextureFrame(commandBuffer);
+    }
 
-    pApplication->swapchainImageFormat = surfaceFormat.format;
-    pApplication->swapchainExtent = extent;
+    endProfilerScope(&pApplication->gpuProfiler, commandBuffer);
 
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+    return (vkEndCommandBuffer(commandBuffer) == VK_SUCCESS) ? SUCCESS : FAIL;
 }
 
-Result getSwapchainImages(Application* pApplication)
+uint32_t getMeshPipelineId(const Application* pApplication)
 {
-    vkGetSwapchainImagesKHR(pApplication->device, pApplication->swapchain, &pApplication->swapchainImageCount, NULL);
+    if (pApplication->gpuCullingEnabled == SDL_TRUE)
+    {
+        return pApplication->culledPipeline;
+    }
 
-    pApplication->pSwapchainImages = malloc(pApplication->swapchainImageCount * sizeof(VkImage));
-    if (pApplication->pSwapchainImages == NULL)
+    return (pApplication->instancingEnabled == SDL_TRUE) ? pApplication->instancedPipeline : pApplication->meshPipeline;
+}
+
+void getGridLayout(uint32_t objectCount, uint32_t* pGridSize, float* pCellSize)
+{
+    // Copies share the space of a single mesh, laid out on the smallest square grid that holds them
+    uint32_t gridSize = 1;
+    while (gridSize * gridSize < objectCount)
     {
-        printError("Failed to allocate %lu bytes of memory for swapchain images!", pApplication->swapchainImageCount * sizeof(VkImage));
-        return FAIL;
+        ++gridSize;
     }
 
-    vkGetSwapchainImagesKHR(pApplication->device, pApplication->swapchain, &pApplication->swapchainImageCount, pApplication->pSwapchainImages);
+    *pGridSize = gridSize;
+    *pCellSize = 2.0f / gridSize;
+}
 
-    return SUCCESS;
+void getGridObject(uint32_t index, uint32_t gridSize, float cellSize, float* pPositionScale)
+{
+    pPositionScale[0] = -1.0f + ((index % gridSize) + 0.5f) * cellSize;
+    pPositionScale[1] = 1.0f - ((index / gridSize) + 0.5f) * cellSize;
+    // Later copies sit nearer the camera and cover part of their neighbours, so grid order draws back to front and
+    // a depth sort changes both the order and the overdraw. A single copy stays at the origin.
+    pPositionScale[2] = (float)index / (gridSize * gridSize);
+    pPositionScale[3] = cellSize * 0.5f;
 }
 
-Result createSwapchainImageViews(Application* pApplication)
+Mat4 getObjectModel(const DrawList* pDrawList, uint32_t objectIndex)
 {
-    pApplication->pSwapchainImageViews = malloc(pApplication->swapchainImageCount * sizeof(VkImageView));
-    if (pApplication->pSwapchainImageViews == NULL)
+    float pPositionScale[4];
+    getGridObject(objectIndex, pDrawList->gridSize, pDrawList->cellSize, pPositionScale);
+
+    float scale = pPositionScale[3];
+    return multiplyMat4(translationMat4(pPositionScale[0], pPositionScale[1], pPositionScale[2]), multiplyMat4(scaleMat4(scale, scale, scale), pDrawList->rotation));
+}
+
+void bindMesh(const Application* pApplication, VkCommandBuffer commandBuffer, VkPipeline pipeline)
+{
+    // Dynamic state is not inherited by secondary command buffers, so every range sets it again
+    VkViewport viewport;
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = pApplication->swapchainExtent.width;
+    viewport.height = pApplication->swapchainExtent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor;
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent = pApplication->swapchainExtent;
+
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    VkDeviceSize vertexOffset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &pApplication->mesh.vertexBuffer, &vertexOffset);
+    vkCmdBindIndexBuffer(commandBuffer, pApplication->mesh.indexBuffer, 0, pApplication->mesh.indexType);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pApplication->pipelineLayout, 1, 1, &pApplication->materialDescriptorSet, 0, NULL);
+
+    if (pApplication->virtualTextureEnabled == SDL_TRUE)
     {
-        printError("Failed to allocate %lu bytes of memory for swapchain image views!", pApplication->swapchainImageCount * sizeof(VkImageView));
-        return FAIL;
+        const VirtualTextureFrame* pFrame = &pApplication->virtualTexture.pFrames[pApplication->currentFrame];
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pApplication->pipelineLayout, 2, 1, &pFrame->descriptorSet, 0, NULL);
     }
+}
 
-    VkImage*        pImages = pApplication->pSwapchainImages;
-    VkImageView*    pImageViews = pApplication->pSwapchainImageViews;
+void sortDrawList(Application* pApplication, uint32_t pipelineId)
+{
+    DrawList* pDrawList = &pApplication->drawList;
+    DrawSorter* pSorter = &pApplication->drawSorter;
+    const float* m = pDrawList->viewProjection.m;
 
-    for (uint32_t i = 0; i < pApplication->swapchainImageCount; ++i)
+    // Clip space w is the depth along the view direction, taken at the center of each object
+    for (uint32_t i = 0; i < pDrawList->drawCount; ++i)
     {
-        VkImageViewCreateInfo createInfo;
-        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        createInfo.pNext = NULL;
-        createInfo.flags = 0;
-        createInfo.image = pImages[i];
-        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        createInfo.format = pApplication->swapchainImageFormat;
-        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        createInfo.subresourceRange.baseMipLevel = 0;
-        createInfo.subresourceRange.levelCount = 1;
-        createInfo.subresourceRange.baseArrayLayer = 0;
-        createInfo.subresourceRange.layerCount = 1;
+        uint32_t objectIndex = (pDrawList->pObjectIndices != NULL) ? pDrawList->pObjectIndices[i] : i;
 
-        if (vkCreateImageView(pApplication->device, &createInfo, NULL, &pImageViews[i]) != VK_SUCCESS)
+        float pPositionScale[4];
+        getGridObject(objectIndex, pDrawList->gridSize, pDrawList->cellSize, pPositionScale);
+
+        float depth = m[3] * pPositionScale[0] + m[7] * pPositionScale[1] + m[11] * pPositionScale[2] + m[15];
+
+        // Every draw uses the one material of the mesh
+        pSorter->pKeys[i] = makeDrawSortKey(pipelineId, 0, depth);
+        pSorter->pValues[i] = objectIndex;
+    }
+
+    sortDraws(pSorter, pDrawList->drawCount);
+
+    for (uint32_t i = 0; i < pDrawList->drawCount; ++i)
+    {
+        uint32_t objectIndex = (pDrawList->pObjectIndices != NULL) ? pDrawList->pObjectIndices[i] : i;
+        if (pSorter->pValues[i] != objectIndex)
         {
-            printError("Failed to create swapchain image view %u!", i);
-            return FAIL;
+            ++pApplication->reorderedDrawSum;
         }
     }
 
-    return SUCCESS;
+    pDrawList->pObjectIndices = pSorter->pValues;
 }
 
-Result createShaderModule(Application* pApplication, const char* pShaderPath, VkShaderModule* pModule)
+void recordDraws(const Application* pApplication, VkCommandBuffer commandBuffer, uint32_t firstDraw, uint32_t drawCount)
 {
-    FILE* pFile = fopen(pShaderPath, "rb");
-    if (pFile == NULL)
+    const DrawList* pDrawList = &pApplication->drawList;
+
+    bindMesh(pApplication, commandBuffer, pDrawList->pipeline);
+
+    for (uint32_t i = firstDraw; i < firstDraw + drawCount; ++i)
     {
-        printError("Failed to open file \"%s\" for reading!", pShaderPath);
-        return FAIL;
+        uint32_t objectIndex = (pDrawList->pObjectIndices != NULL) ? pDrawList->pObjectIndices[i] : i;
+
+        PushConstants pushConstants;
+        pushConstants.model = getObjectModel(pDrawList, objectIndex);
+        pushConstants.modelViewProjection = multiplyMat4(pDrawList->viewProjection, pushConstants.model);
+
+        vkCmdPushConstants(commandBuffer, pApplication->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
+        vkCmdDrawIndexed(commandBuffer, pApplication->mesh.indexCount, 1, 0, 0, 0);
     }
+}
 
-    fseek(pFile, 0, SEEK_END);
-    size_t codeSize = ftell(pFile);
+void recordCulledDraws(Application* pApplication, VkCommandBuffer commandBuffer)
+{
+    const DrawList* pDrawList = &pApplication->drawList;
+
+    bindMesh(pApplication, commandBuffer, pDrawList->pipeline);
+
+    CulledPushConstants pushConstants;
+    pushConstants.viewProjection = pDrawList->viewProjection;
+    pushConstants.rotation = pDrawList->rotation;
+
+    vkCmdPushConstants(commandBuffer, pApplication->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+    drawCulledObjects(&pApplication->gpuCulling, commandBuffer, pApplication->currentFrame, pApplication->pipelineLayout);
+}
+
+uint32_t recordInstancedDraws(Application* pApplication, VkCommandBuffer commandBuffer)
+{
+    const DrawList* pDrawList = &pApplication->drawList;
+    DrawItem* pItems = pApplication->pDrawItems;
 
-    char* pCode = malloc(codeSize);
-    if (pCode == NULL)
+    // Every object is a copy of the one mesh with the one material of the viewer, so all of them end up in a single batch
+    for (uint32_t i = 0; i < pDrawList->drawCount; ++i)
     {
-        printError("Failed to allocate %lu bytes of memory for shader code!", codeSize);
-        fclose(pFile);
-        return FAIL;
+        pItems[i].mesh = 0;
+        pItems[i].material = 0;
+        pItems[i].object = (pDrawList->pObjectIndices != NULL) ? pDrawList->pObjectIndices[i] : i;
     }
 
-    rewind(pFile);
-    fread(pCode, 1, codeSize, pFile);
+    uint32_t batchCount = batchDrawItems(pItems, pDrawList->drawCount, pApplication->pDrawBatches);
 
-    fclose(pFile);
+    // The fence of this frame has been waited on, so the GPU is done reading its instances
+    InstanceData* pInstances = pApplication->pInstanceAllocations[pApplication->currentFrame].pMapped;
+    for (uint32_t i = 0; i < pDrawList->drawCount; ++i)
+    {
+        pInstances[i].model = getObjectModel(pDrawList, pItems[i].object);
+    }
 
-    VkShaderModuleCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.codeSize = codeSize;
-    createInfo.pCode = (const uint32_t*)pCode;
+    bindMesh(pApplication, commandBuffer, pDrawList->pipeline);
 
-    int result = vkCreateShaderModule(pApplication->device, &createInfo, NULL, pModule);
+    VkDeviceSize instanceOffset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, INSTANCE_BINDING, 1, &pApplication->pInstanceBuffers[pApplication->currentFrame], &instanceOffset);
 
-    free(pCode);
+    InstancedPushConstants pushConstants;
+    pushConstants.viewProjection = pDrawList->viewProjection;
 
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
-}
+    vkCmdPushConstants(commandBuffer, pApplication->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
 
-Result createPipelineLayout(Application* pApplication)
-{
-    VkPipelineLayoutCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.setLayoutCount = 0;
-    createInfo.pSetLayouts = NULL;
-    createInfo.pushConstantRangeCount = 0;
-    createInfo.pPushConstantRanges = NULL;
+    // The mesh and pipeline of a batch would be bound here once there is more than one of each
+    for (uint32_t i = 0; i < batchCount; ++i)
+    {
+        const DrawBatch* pBatch = &pApplication->pDrawBatches[i];
+        vkCmdDrawIndexed(commandBuffer, pApplication->mesh.indexCount, pBatch->instanceCount, 0, 0, pBatch->firstInstance);
+    }
 
-    int result = vkCreatePipelineLayout(pApplication->device, &createInfo, NULL, &pApplication->pipelineLayout);
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+    return batchCount;
 }
 
-Result createRenderPass(Application* pApplication)
+Result recordSecondaryCommandBuffers(Application* pApplication, VkCommandBuffer commandBuffer, uint32_t imageIndex)
 {
-    VkAttachmentDescription attachment;
-    attachment.flags = 0;
-    attachment.format = pApplication->swapchainImageFormat;
-    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    uint32_t drawCount = pApplication->drawList.drawCount;
+    uint32_t jobCount = pApplication->recordJobCount;
+    uint32_t drawsPerJob = (drawCount + jobCount - 1) / jobCount;
+    Result result = SUCCESS;
 
-    VkAttachmentReference attachmentRef;
-    attachmentRef.attachment = 0;
-    attachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    for (uint32_t i = 0; i < jobCount; ++i)
+    {
+        RecordJob* pJob = &pApplication->pRecordJobs[i];
+        pJob->imageIndex = imageIndex;
+        pJob->firstDraw = i * drawsPerJob;
+        pJob->drawCount = (pJob->firstDraw < drawCount) ? SDL_min(drawsPerJob, drawCount - pJob->firstDraw) : 0;
+        pJob->result = SUCCESS;
+
+        // Fewer draws than threads leave the last jobs empty
+        if (pJob->drawCount == 0)
+        {
+            continue;
+        }
 
-    VkSubpassDescription subpass;
-    subpass.flags = 0;
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.inputAttachmentCount = 0;
-    subpass.pInputAttachments = NULL;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &attachmentRef;
-    subpass.pResolveAttachments = NULL;
-    subpass.pDepthStencilAttachment = NULL;
-    subpass.preserveAttachmentCount = 0;
-    subpass.pPreserveAttachments = NULL;
+        if (submitJob(&pApplication->recordThreadPool, recordJob, pJob) != SUCCESS)
+        {
+            pJob->drawCount = 0;
+            result = FAIL;
+            break;
+        }
+    }
 
-    VkRenderPassCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.attachmentCount = 1;
-    createInfo.pAttachments = &attachment;
-    createInfo.subpassCount = 1;
-    createInfo.pSubpasses = &subpass;
-    createInfo.dependencyCount = 0;
-    createInfo.pDependencies = NULL;
+    // Jobs already submitted still record into this frame's pools, so they are waited for even after a failure
+    waitForJobs(&pApplication->recordThreadPool);
 
-    int result = vkCreateRenderPass(pApplication->device, &createInfo, NULL, &pApplication->renderPass);
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
-}
+    VkCommandBuffer pCommandBuffers[MAX_RECORD_THREADS];
+    uint32_t commandBufferCount = 0;
 
-Result createGraphicsPipeline(Application* pApplication)
-{
-    VkShaderModule vertShaderModule;
-    if (createShaderModule(pApplication, "../shaders/vert.spv", &vertShaderModule) != SUCCESS)
+    for (uint32_t i = 0; i < jobCount; ++i)
+    {
+        RecordJob* pJob = &pApplication->pRecordJobs[i];
+        if (pJob->drawCount == 0)
+        {
+            continue;
+        }
+
+        if (pJob->result != SUCCESS)
+        {
+            printError("Failed to record draws %u to %u!", pJob->firstDraw, pJob->firstDraw + pJob->drawCount - 1);
+            result = FAIL;
+        }
+
+        pCommandBuffers[commandBufferCount++] = pJob->pCommandBuffers[pApplication->currentFrame];
+    }
+
+    if (result != SUCCESS)
     {
-        printError("Failed to create vertex shader module!");
         return FAIL;
     }
 
-    VkShaderModule fragShaderModule;
-    if (createShaderModule(pApplication, "../shaders/frag.spv", &fragShaderModule) != SUCCESS)
+    // Culling may leave nothing to draw
+    if (commandBufferCount > 0)
     {
-        printError("Failed to create fragment shader module!");
-        vkDestroyShaderModule(pApplication->device, vertShaderModule, NULL);
-        return FAIL;
-    }
-
-    VkPipelineShaderStageCreateInfo pStages[2];
-
-    pStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    pStages[0].pNext = NULL;
-    pStages[0].flags = 0;
-    pStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    pStages[0].module = vertShaderModule;
-    pStages[0].pName = "main";
-    pStages[0].pSpecializationInfo = NULL;
-
-    pStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    pStages[1].pNext = NULL;
-    pStages[1].flags = 0;
-    pStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    pStages[1].module = fragShaderModule;
-    pStages[1].pName = "main";
-    pStages[1].pSpecializationInfo = NULL;
-
-    VkPipelineVertexInputStateCreateInfo vertexInputState;
-    vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputState.pNext = NULL;
-    vertexInputState.flags = 0;
-    vertexInputState.vertexBindingDescriptionCount = 0;
-    vertexInputState.pVertexBindingDescriptions = NULL;
-    vertexInputState.vertexAttributeDescriptionCount = 0;
-    vertexInputState.pVertexAttributeDescriptions = NULL;
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState;
-    inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssemblyState.pNext = NULL;
-    inputAssemblyState.flags = 0;
-    inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssemblyState.primitiveRestartEnable = VK_FALSE;
+        vkCmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
+    }
 
-    VkViewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = pApplication->swapchainExtent.width;
-    viewport.height = pApplication->swapchainExtent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+    return SUCCESS;
+}
 
-    VkRect2D scissor;
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent = pApplication->swapchainExtent;
+void recordJob(void* pUserData)
+{
+    RecordJob*             pJob = pUserData;
+    const Application*     pApplication = pJob->pApplication;
+    uint32_t               frameIndex = pApplication->currentFrame;
+    VkCommandBuffer        commandBuffer = pJob->pCommandBuffers[frameIndex];
+
+    // The fence of this frame has been waited on, so nothing allocated from the pool is still in use
+    vkResetCommandPool(pApplication->device, pJob->pCommandPools[frameIndex], 0);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo;
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = NULL;
+    inheritanceInfo.renderPass = pApplication->renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = pApplication->pFramebuffers[pJob->imageIndex];
+    inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+    inheritanceInfo.queryFlags = 0;
+    inheritanceInfo.pipelineStatistics = getProfilerStatisticFlags(&pApplication->gpuProfiler);
+
+    VkCommandBufferBeginInfo beginInfo;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = NULL;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        pJob->result = FAIL;
+        return;
+    }
 
-    VkPipelineViewportStateCreateInfo viewportState;
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.pNext = NULL;
-    viewportState.flags = 0;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    VkPipelineRasterizationStateCreateInfo rasterizationState;
-    rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizationState.pNext = NULL;
-    rasterizationState.flags = 0;
-    rasterizationState.depthClampEnable = VK_FALSE;
-    rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-    rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizationState.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizationState.depthBiasEnable = VK_FALSE;
-    rasterizationState.depthBiasConstantFactor = 0.0f;
-    rasterizationState.depthBiasClamp = 0.0f;
-    rasterizationState.depthBiasSlopeFactor = 0.0f;
-    rasterizationState.lineWidth = 1.0f;
-
-    VkPipelineMultisampleStateCreateInfo multisampleState;
-    multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampleState.pNext = NULL;
-    multisampleState.flags = 0;
-    multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampleState.sampleShadingEnable = VK_FALSE;
-    multisampleState.minSampleShading = 1.0f;
-    multisampleState.pSampleMask = NULL;
-    multisampleState.alphaToCoverageEnable = VK_FALSE;
-    multisampleState.alphaToOneEnable = VK_FALSE;
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT
-                                          | VK_COLOR_COMPONENT_G_BIT
-                                          | VK_COLOR_COMPONENT_B_BIT
-                                          | VK_COLOR_COMPONENT_A_BIT;
-
-    VkPipelineColorBlendStateCreateInfo colorBlendState;
-    colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlendState.pNext = NULL;
-    colorBlendState.flags = 0;
-    colorBlendState.logicOpEnable = VK_FALSE;
-    colorBlendState.logicOp = VK_LOGIC_OP_COPY;
-    colorBlendState.attachmentCount = 1;
-    colorBlendState.pAttachments = &colorBlendAttachment;
-    colorBlendState.blendConstants[0] = 0.0f;
-    colorBlendState.blendConstants[1] = 0.0f;
-    colorBlendState.blendConstants[2] = 0.0f;
-    colorBlendState.blendConstants[3] = 0.0f;
-
-    VkDynamicState pDynamicStates[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-
-    VkPipelineDynamicStateCreateInfo dynamicState;
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.pNext = NULL;
-    dynamicState.flags = 0;
-    dynamicState.dynamicStateCount = 2;
-    dynamicState.pDynamicStates = pDynamicStates;
-
-    VkGraphicsPipelineCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.stageCount = 2;
-    createInfo.pStages = pStages;
-    createInfo.pVertexInputState = &vertexInputState;
-    createInfo.pInputAssemblyState = &inputAssemblyState;
-    createInfo.pTessellationState = NULL;
-    createInfo.pViewportState = &viewportState;
-    createInfo.pRasterizationState = &rasterizationState;
-    createInfo.pMultisampleState = &multisampleState;
-    createInfo.pDepthStencilState = NULL;
-    createInfo.pColorBlendState = &colorBlendState;
-    createInfo.pDynamicState = &dynamicState;
-    createInfo.layout = pApplication->pipelineLayout;
-    createInfo.renderPass = pApplication->renderPass;
-    createInfo.subpass = 0;
-    createInfo.basePipelineHandle = VK_NULL_HANDLE;
-    createInfo.basePipelineIndex = -1;
-
-    int result = vkCreateGraphicsPipelines(pApplication->device, VK_NULL_HANDLE, 1, &createInfo, NULL, &pApplication->pipeline);
-
-    vkDestroyShaderModule(pApplication->device, fragShaderModule, NULL);
-    vkDestroyShaderModule(pApplication->device, vertShaderModule, NULL);
+    recordDraws(pApplication, commandBuffer, pJob->firstDraw, pJob->drawCount);
 
-    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+    pJob->result = (vkEndCommandBuffer(commandBuffer) == VK_SUCCESS) ? SUCCESS : FAIL;
 }
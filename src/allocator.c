@@ -0,0 +1,439 @@
+#include "allocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static VkDeviceSize getBlockSize(Allocator* pAllocator, uint32_t memoryTypeIndex);
+
+static Result createMemoryBlock(Allocator* pAllocator, uint32_t memoryTypeIndex, VkDeviceSize size, const AllocationInfo* pInfo, SDL_bool dedicated, MemoryBlock** ppBlock);
+
+static void destroyMemoryBlock(Allocator* pAllocator, MemoryBlock* pBlock);
+
+static Result allocateFromBlock(MemoryBlock* pBlock, const VkMemoryRequirements* pRequirements, Allocation* pAllocation);
+
+Result findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties* pMemoryProperties, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags, uint32_t* pMemoryTypeIndex)
+{
+    // Among the types with every required flag pick the one missing the fewest preferred flags
+    uint32_t bestMissingCount = UINT32_MAX;
+
+    for (uint32_t i = 0; i < pMemoryProperties->memoryTypeCount; ++i)
+    {
+        VkMemoryPropertyFlags flags = pMemoryProperties->memoryTypes[i].propertyFlags;
+
+        if (((memoryTypeBits & (1u << i)) == 0) || ((flags & requiredFlags) != requiredFlags))
+        {
+            continue;
+        }
+
+        uint32_t missingCount = 0;
+        for (VkMemoryPropertyFlags missing = preferredFlags & ~flags; missing != 0; missing &= missing - 1)
+        {
+            ++missingCount;
+        }
+
+        if (missingCount < bestMissingCount)
+        {
+            bestMissingCount = missingCount;
+            *pMemoryTypeIndex = i;
+        }
+    }
+
+    return (bestMissingCount != UINT32_MAX) ? SUCCESS : FAIL;
+}
+
+Result createAllocator(Allocator* pAllocator, VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    pAllocator->physicalDevice = physicalDevice;
+    pAllocator->device = device;
+    pAllocator->blockSize = DEFAULT_MEMORY_BLOCK_SIZE;
+    pAllocator->blockCount = 0;
+    pAllocator->blockCapacity = 0;
+    pAllocator->ppBlocks = NULL;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &pAllocator->memoryProperties);
+
+    pAllocator->pMutex = SDL_CreateMutex();
+    if (pAllocator->pMutex == NULL)
+    {
+        printError("Failed to create allocator mutex!");
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyAllocator(Allocator* pAllocator)
+{
+    for (uint32_t i = 0; i < pAllocator->blockCount; ++i)
+    {
+        if (pAllocator->ppBlocks[i]->allocator.allocationCount > 0)
+        {
+            printError("Memory block %u still has %u allocations!", i, pAllocator->ppBlocks[i]->allocator.allocationCount);
+        }
+
+        destroyMemoryBlock(pAllocator, pAllocator->ppBlocks[i]);
+    }
+
+    free(pAllocator->ppBlocks);
+    pAllocator->ppBlocks = NULL;
+
+    pAllocator->blockCount = 0;
+    pAllocator->blockCapacity = 0;
+
+    if (pAllocator->pMutex != NULL)
+    {
+        SDL_DestroyMutex(pAllocator->pMutex);
+        pAllocator->pMutex = NULL;
+    }
+}
+
+Result allocateMemory(Allocator* pAllocator, const VkMemoryRequirements* pRequirements, const AllocationInfo* pInfo, Allocation* pAllocation)
+{
+    uint32_t memoryTypeIndex;
+    if (findMemoryTypeIndex(&pAllocator->memoryProperties, pRequirements->memoryTypeBits, pInfo->requiredFlags, pInfo->preferredFlags, &memoryTypeIndex) != SUCCESS)
+    {
+        printError("Failed to find memory type for memory type bits 0x%x and property flags 0x%x!", pRequirements->memoryTypeBits, pInfo->requiredFlags);
+        return FAIL;
+    }
+
+    VkDeviceSize blockSize = getBlockSize(pAllocator, memoryTypeIndex);
+
+    SDL_LockMutex(pAllocator->pMutex);
+
+    MemoryBlock* pBlock = NULL;
+
+    if (pRequirements->size < blockSize / 2)
+    {
+        // Buffers and optimal tiling images live in separate blocks, so bufferImageGranularity never applies
+        for (uint32_t i = 0; i < pAllocator->blockCount; ++i)
+        {
+            MemoryBlock* pCandidate = pAllocator->ppBlocks[i];
+            if ((pCandidate->dedicated != SDL_TRUE)
+                && (pCandidate->memoryTypeIndex == memoryTypeIndex)
+                && (pCandidate->optimalImage == pInfo->optimalImage)
+                && (pCandidate->allocator.strategy == pInfo->strategy)
+                && (allocateFromBlock(pCandidate, pRequirements, pAllocation) == SUCCESS))
+            {
+                pBlock = pCandidate;
+                break;
+            }
+        }
+
+        if (pBlock == NULL)
+        {
+            if ((createMemoryBlock(pAllocator, memoryTypeIndex, blockSize, pInfo, SDL_FALSE, &pBlock) != SUCCESS)
+                || (allocateFromBlock(pBlock, pRequirements, pAllocation) != SUCCESS))
+            {
+                SDL_UnlockMutex(pAllocator->pMutex);
+                return FAIL;
+            }
+        }
+    }
+    else
+    {
+        if ((createMemoryBlock(pAllocator, memoryTypeIndex, pRequirements->size, pInfo, SDL_TRUE, &pBlock) != SUCCESS)
+            || (allocateFromBlock(pBlock, pRequirements, pAllocation) != SUCCESS))
+        {
+            SDL_UnlockMutex(pAllocator->pMutex);
+            return FAIL;
+        }
+    }
+
+    SDL_UnlockMutex(pAllocator->pMutex);
+
+    return SUCCESS;
+}
+
+void freeMemory(Allocator* pAllocator, Allocation* pAllocation)
+{
+    MemoryBlock* pBlock = pAllocation->pBlock;
+    if (pBlock == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(pAllocator->pMutex);
+
+    blockFree(&pBlock->allocator, pAllocation->offset, pAllocation->size);
+
+    // Shared blocks are kept for reuse, dedicated ones go back to the driver right away
+    if ((pBlock->dedicated == SDL_TRUE) && (pBlock->allocator.allocationCount == 0))
+    {
+        for (uint32_t i = 0; i < pAllocator->blockCount; ++i)
+        {
+            if (pAllocator->ppBlocks[i] == pBlock)
+            {
+                pAllocator->ppBlocks[i] = pAllocator->ppBlocks[--pAllocator->blockCount];
+                break;
+            }
+        }
+
+        destroyMemoryBlock(pAllocator, pBlock);
+    }
+
+    SDL_UnlockMutex(pAllocator->pMutex);
+
+    pAllocation->memory = VK_NULL_HANDLE;
+    pAllocation->offset = 0;
+    pAllocation->size = 0;
+    pAllocation->pMapped = NULL;
+    pAllocation->pBlock = NULL;
+}
+
+Result createBuffer(Allocator* pAllocator, VkDeviceSize size, VkBufferUsageFlags usage, const AllocationInfo* pInfo, VkBuffer* pBuffer, Allocation* pAllocation)
+{
+    VkBufferCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.size = size;
+    createInfo.usage = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = NULL;
+
+    if (vkCreateBuffer(pAllocator->device, &createInfo, NULL, pBuffer) != VK_SUCCESS)
+    {
+        printError("Failed to create buffer of %llu bytes!", (unsigned long long)size);
+        return FAIL;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(pAllocator->device, *pBuffer, &requirements);
+
+    if (allocateMemory(pAllocator, &requirements, pInfo, pAllocation) != SUCCESS)
+    {
+        printError("Failed to allocate memory for buffer!");
+        vkDestroyBuffer(pAllocator->device, *pBuffer, NULL);
+        *pBuffer = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    if (vkBindBufferMemory(pAllocator->device, *pBuffer, pAllocation->memory, pAllocation->offset) != VK_SUCCESS)
+    {
+        printError("Failed to bind buffer memory!");
+        destroyBuffer(pAllocator, *pBuffer, pAllocation);
+        *pBuffer = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyBuffer(Allocator* pAllocator, VkBuffer buffer, Allocation* pAllocation)
+{
+    vkDestroyBuffer(pAllocator->device, buffer, NULL);
+    freeMemory(pAllocator, pAllocation);
+}
+
+Result createImage(Allocator* pAllocator, const VkImageCreateInfo* pCreateInfo, const AllocationInfo* pInfo, VkImage* pImage, Allocation* pAllocation)
+{
+    if (vkCreateImage(pAllocator->device, pCreateInfo, NULL, pImage) != VK_SUCCESS)
+    {
+        printError("Failed to create %ux%u image!", pCreateInfo->extent.width, pCreateInfo->extent.height);
+        return FAIL;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(pAllocator->device, *pImage, &requirements);
+
+    AllocationInfo info = *pInfo;
+    info.optimalImage = (pCreateInfo->tiling == VK_IMAGE_TILING_OPTIMAL) ? SDL_TRUE : SDL_FALSE;
+
+    if (allocateMemory(pAllocator, &requirements, &info, pAllocation) != SUCCESS)
+    {
+        printError("Failed to allocate memory for image!");
+        vkDestroyImage(pAllocator->device, *pImage, NULL);
+        *pImage = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    if (vkBindImageMemory(pAllocator->device, *pImage, pAllocation->memory, pAllocation->offset) != VK_SUCCESS)
+    {
+        printError("Failed to bind image memory!");
+        destroyImage(pAllocator, *pImage, pAllocation);
+        *pImage = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyImage(Allocator* pAllocator, VkImage image, Allocation* pAllocation)
+{
+    vkDestroyImage(pAllocator->device, image, NULL);
+    freeMemory(pAllocator, pAllocation);
+}
+
+void getAllocatorStats(Allocator* pAllocator, AllocatorStats* pStats)
+{
+    memset(pStats, 0, sizeof(*pStats));
+
+    SDL_LockMutex(pAllocator->pMutex);
+
+    for (uint32_t i = 0; i < pAllocator->blockCount; ++i)
+    {
+        MemoryBlock* pBlock = pAllocator->ppBlocks[i];
+
+        BlockAllocatorStats blockStats;
+        getBlockAllocatorStats(&pBlock->allocator, &blockStats);
+
+        ++pStats->blockCount;
+        if (pBlock->dedicated == SDL_TRUE)
+        {
+            ++pStats->dedicatedBlockCount;
+        }
+
+        pStats->allocationCount += blockStats.allocationCount;
+        pStats->blockBytes += blockStats.size;
+        pStats->usedBytes += blockStats.usedSize;
+        pStats->requestedBytes += blockStats.requestedSize;
+        pStats->freeBytes += blockStats.size - blockStats.usedSize;
+
+        if (blockStats.largestFreeRegion > pStats->largestFreeRegion)
+        {
+            pStats->largestFreeRegion = blockStats.largestFreeRegion;
+        }
+    }
+
+    SDL_UnlockMutex(pAllocator->pMutex);
+
+    // External fragmentation: 0 when all free memory is one region, approaching 1 when it is scattered
+    if (pStats->freeBytes > 0)
+    {
+        pStats->fragmentation = 1.0f - (float)pStats->largestFreeRegion / (float)pStats->freeBytes;
+    }
+}
+
+void printAllocatorStats(Allocator* pAllocator)
+{
+    AllocatorStats stats;
+    getAllocatorStats(pAllocator, &stats);
+
+    printf("Device memory:\n");
+    printf("    blocks: %u (%u dedicated), allocations: %u\n", stats.blockCount, stats.dedicatedBlockCount, stats.allocationCount);
+    printf("    reserved: %.2f MiB, used: %.2f MiB, requested: %.2f MiB\n", stats.blockBytes / 1048576.0, stats.usedBytes / 1048576.0, stats.requestedBytes / 1048576.0);
+    printf("    free: %.2f MiB, largest free region: %.2f MiB, fragmentation: %.1f%%\n", stats.freeBytes / 1048576.0, stats.largestFreeRegion / 1048576.0, stats.fragmentation * 100.0f);
+    printf("\n");
+}
+
+VkDeviceSize getBlockSize(Allocator* pAllocator, uint32_t memoryTypeIndex)
+{
+    // Small heaps (integrated GPUs, BAR memory) would run dry after a couple of default sized blocks
+    uint32_t heapIndex = pAllocator->memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkDeviceSize heapSize = pAllocator->memoryProperties.memoryHeaps[heapIndex].size;
+
+    VkDeviceSize blockSize = pAllocator->blockSize;
+    while ((blockSize > MIN_BUDDY_BLOCK_SIZE * 1024) && (blockSize > heapSize / 8))
+    {
+        blockSize /= 2;
+    }
+
+    return blockSize;
+}
+
+Result createMemoryBlock(Allocator* pAllocator, uint32_t memoryTypeIndex, VkDeviceSize size, const AllocationInfo* pInfo, SDL_bool dedicated, MemoryBlock** ppBlock)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(pAllocator->physicalDevice, &properties);
+
+    if (pAllocator->blockCount >= properties.limits.maxMemoryAllocationCount)
+    {
+        printError("Reached maxMemoryAllocationCount of %u!", properties.limits.maxMemoryAllocationCount);
+        return FAIL;
+    }
+
+    if (pAllocator->blockCount == pAllocator->blockCapacity)
+    {
+        uint32_t newCapacity = (pAllocator->blockCapacity > 0) ? pAllocator->blockCapacity * 2 : 16;
+
+        MemoryBlock** ppBlocks = realloc(pAllocator->ppBlocks, newCapacity * sizeof(MemoryBlock*));
+        if (ppBlocks == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for memory blocks!", newCapacity * sizeof(MemoryBlock*));
+            return FAIL;
+        }
+
+        pAllocator->ppBlocks = ppBlocks;
+        pAllocator->blockCapacity = newCapacity;
+    }
+
+    MemoryBlock* pBlock = calloc(1, sizeof(MemoryBlock));
+    if (pBlock == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for memory block!", sizeof(MemoryBlock));
+        return FAIL;
+    }
+
+    pBlock->memoryTypeIndex = memoryTypeIndex;
+    pBlock->optimalImage = pInfo->optimalImage;
+    pBlock->dedicated = dedicated;
+
+    AllocationStrategy strategy = (dedicated == SDL_TRUE) ? ALLOCATION_STRATEGY_LINEAR : pInfo->strategy;
+    if (createBlockAllocator(&pBlock->allocator, strategy, size, MIN_BUDDY_BLOCK_SIZE) != SUCCESS)
+    {
+        free(pBlock);
+        return FAIL;
+    }
+
+    VkMemoryAllocateInfo allocateInfo;
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext = NULL;
+    allocateInfo.allocationSize = size;
+    allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(pAllocator->device, &allocateInfo, NULL, &pBlock->memory) != VK_SUCCESS)
+    {
+        printError("Failed to allocate %llu bytes of device memory of type %u!", (unsigned long long)size, memoryTypeIndex);
+        destroyBlockAllocator(&pBlock->allocator);
+        free(pBlock);
+        return FAIL;
+    }
+
+    // Host visible blocks stay mapped for their whole lifetime, mapping per allocation is needlessly slow
+    VkMemoryPropertyFlags flags = pAllocator->memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
+    {
+        if (vkMapMemory(pAllocator->device, pBlock->memory, 0, VK_WHOLE_SIZE, 0, &pBlock->pMapped) != VK_SUCCESS)
+        {
+            printError("Failed to map memory block!");
+            destroyMemoryBlock(pAllocator, pBlock);
+            return FAIL;
+        }
+    }
+
+    pAllocator->ppBlocks[pAllocator->blockCount++] = pBlock;
+
+    *ppBlock = pBlock;
+    return SUCCESS;
+}
+
+void destroyMemoryBlock(Allocator* pAllocator, MemoryBlock* pBlock)
+{
+    if (pBlock->pMapped != NULL)
+    {
+        vkUnmapMemory(pAllocator->device, pBlock->memory);
+    }
+
+    vkFreeMemory(pAllocator->device, pBlock->memory, NULL);
+    destroyBlockAllocator(&pBlock->allocator);
+    free(pBlock);
+}
+
+Result allocateFromBlock(MemoryBlock* pBlock, const VkMemoryRequirements* pRequirements, Allocation* pAllocation)
+{
+    uint64_t offset;
+    if (blockAllocate(&pBlock->allocator, pRequirements->size, pRequirements->alignment, &offset) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    pAllocation->memory = pBlock->memory;
+    pAllocation->offset = offset;
+    pAllocation->size = pRequirements->size;
+    pAllocation->pMapped = (pBlock->pMapped != NULL) ? (char*)pBlock->pMapped + offset : NULL;
+    pAllocation->pBlock = pBlock;
+
+    return SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include "arena.h"
+
+#include <stdlib.h>
+
+struct ArenaBlock
+{
+    ArenaBlock*    pNext;
+    size_t         size;
+    size_t         usedSize;
+};
+
+// The data of a block follows its header, rounded up so that it starts aligned
+#define ARENA_BLOCK_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+void createArena(Arena* pArena, size_t blockSize)
+{
+    pArena->blockSize = blockSize;
+    pArena->pBlocks = NULL;
+}
+
+void destroyArena(Arena* pArena)
+{
+    ArenaBlock* pBlock = pArena->pBlocks;
+    while (pBlock != NULL)
+    {
+        ArenaBlock* pNext = pBlock->pNext;
+        free(pBlock);
+        pBlock = pNext;
+    }
+
+    pArena->pBlocks = NULL;
+}
+
+void* arenaAllocate(Arena* pArena, size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    ArenaBlock* pBlock = pArena->pBlocks;
+    if ((pBlock == NULL) || (pBlock->size - pBlock->usedSize < size))
+    {
+        size_t blockSize = (size > pArena->blockSize) ? size : pArena->blockSize;
+
+        pBlock = malloc(ARENA_BLOCK_HEADER_SIZE + blockSize);
+        if (pBlock == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for arena block!", ARENA_BLOCK_HEADER_SIZE + blockSize);
+            return NULL;
+        }
+
+        pBlock->pNext = pArena->pBlocks;
+        pBlock->size = blockSize;
+        pBlock->usedSize = 0;
+
+        pArena->pBlocks = pBlock;
+    }
+
+    void* pData = (char*)pBlock + ARENA_BLOCK_HEADER_SIZE + pBlock->usedSize;
+    pBlock->usedSize += size;
+
+    return pData;
+}
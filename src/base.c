@@ -2,10 +2,22 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include <SDL.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static int compareFloats(const void* pA, const void* pB);
+
 void printError(const char* pFormat, ...)
 {
     va_list arg;
@@ -22,3 +34,210 @@ void printError(const char* pFormat, ...)
 
     fprintf(stderr, "\n");
 }
+
+uint64_t hashBytes(const void* pData, size_t size, uint64_t seed)
+{
+    // 64-bit FNV-1a, pass HASH_SEED or a previous hash to continue hashing
+    const unsigned char* pBytes = pData;
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= pBytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+void sortFloats(float* pValues, uint32_t count)
+{
+    qsort(pValues, count, sizeof(float), compareFloats);
+}
+
+float getSortedPercentile(const float* pSorted, uint32_t count, uint32_t percentile)
+{
+    return pSorted[((uint64_t)count * percentile + 99) / 100 - 1];
+}
+
+Result readFile(const char* pPath, char** ppData, size_t* pSize)
+{
+    FILE* pFile = fopen(pPath, "rb");
+    if (pFile == NULL)
+    {
+        printError("Failed to open file \"%s\" for reading!", pPath);
+        return FAIL;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    long size = ftell(pFile);
+    rewind(pFile);
+
+    if (size < 0)
+    {
+        printError("Failed to get size of file \"%s\"!", pPath);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    char* pData = malloc((size_t)size + 1);
+    if (pData == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for file \"%s\"!", (unsigned long)size + 1, pPath);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    if (fread(pData, 1, (size_t)size, pFile) != (size_t)size)
+    {
+        printError("Failed to read file \"%s\"!", pPath);
+        free(pData);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    fclose(pFile);
+
+    pData[size] = '\0';
+
+    *ppData = pData;
+    *pSize = (size_t)size;
+    return SUCCESS;
+}
+
+Result mapFile(const char* pPath, MappedFile* pFile)
+{
+    pFile->pData = NULL;
+    pFile->size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        printError("Failed to open file \"%s\" for mapping!", pPath);
+        return FAIL;
+    }
+
+    LARGE_INTEGER size;
+    if ((GetFileSizeEx(file, &size) == 0) || (size.QuadPart == 0))
+    {
+        printError("Failed to get size of file \"%s\" or it is empty!", pPath);
+        CloseHandle(file);
+        return FAIL;
+    }
+
+    // The view keeps the mapping and the file alive, so both handles can be closed right away
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        printError("Failed to create mapping of file \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    void* pData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (pData == NULL)
+    {
+        printError("Failed to map file \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    pFile->pData = pData;
+    pFile->size = (size_t)size.QuadPart;
+#else
+    int file = open(pPath, O_RDONLY);
+    if (file < 0)
+    {
+        printError("Failed to open file \"%s\" for mapping!", pPath);
+        return FAIL;
+    }
+
+    struct stat status;
+    if ((fstat(file, &status) != 0) || (status.st_size == 0))
+    {
+        printError("Failed to get size of file \"%s\" or it is empty!", pPath);
+        close(file);
+        return FAIL;
+    }
+
+    void* pData = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (pData == MAP_FAILED)
+    {
+        printError("Failed to map file \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    pFile->pData = pData;
+    pFile->size = (size_t)status.st_size;
+#endif
+
+    return SUCCESS;
+}
+
+void unmapFile(MappedFile* pFile)
+{
+    if (pFile->pData == NULL)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(pFile->pData);
+#else
+    munmap(pFile->pData, pFile->size);
+#endif
+
+    pFile->pData = NULL;
+    pFile->size = 0;
+}
+
+Result replaceFile(const char* pSourcePath, const char* pPath)
+{
+#ifdef _WIN32
+    return (MoveFileExA(pSourcePath, pPath, MOVEFILE_REPLACE_EXISTING) != 0) ? SUCCESS : FAIL;
+#else
+    return (rename(pSourcePath, pPath) == 0) ? SUCCESS : FAIL;
+#endif
+}
+
+Result getFileStamp(const char* pPath, uint64_t* pSize, int64_t* pModifiedTime)
+{
+    struct stat status;
+    if (stat(pPath, &status) != 0)
+    {
+        return FAIL;
+    }
+
+    *pSize = (uint64_t)status.st_size;
+    *pModifiedTime = (int64_t)status.st_mtime;
+    return SUCCESS;
+}
+
+char* getPreferencePath(const char* pFileName)
+{
+    char* pPrefPath = SDL_GetPrefPath("vulkan_viewer", "vulkan_viewer");
+    if (pPrefPath == NULL)
+    {
+        return NULL;
+    }
+
+    size_t pathSize = strlen(pPrefPath) + strlen(pFileName) + 1;
+    char* pPath = malloc(pathSize);
+    if (pPath != NULL)
+    {
+        snprintf(pPath, pathSize, "%s%s", pPrefPath, pFileName);
+    }
+
+    SDL_free(pPrefPath);
+
+    return pPath;
+}
+
+int compareFloats(const void* pA, const void* pB)
+{
+    float a = *(const float*)pA;
+    float b = *(const float*)pB;
+    return (a > b) - (a < b);
+}
@@ -0,0 +1,981 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_image.h>
+
+#include "Application.h"
+#include "config.h"
+#include "cpuCulling.h"
+#include "drawSort.h"
+#include "gpuProfiler.h"
+#include "math3d.h"
+#include "pipelineBuilder.h"
+#include "stagingRing.h"
+#include "texture.h"
+#include "threadPool.h"
+
+#define BENCH_WIDTH                 1280
+#define BENCH_HEIGHT                720
+#define BENCH_TIME_STEP_MS          16
+#define DEFAULT_BENCH_FRAMES        300
+#define BENCH_WARMUP_FRAMES         30
+#define BENCH_WARMUP_TIMEOUT_MS     60000
+#define UPLOAD_BENCH_SIZE           (64ull * 1024 * 1024)
+#define UPLOAD_BENCH_REPEATS        4
+#define PIPELINE_BENCH_VARIANTS     32
+#define CULLING_BENCH_OBJECTS       (1u << 20)
+#define CULLING_BENCH_REPEATS       50
+#define DRAW_SORT_BENCH_REPEATS     20
+#define TEXTURE_BENCH_SIZE          2048
+#define TEXTURE_BENCH_REPEATS       4
+#define TEXTURE_BENCH_PNG_PATH      "bench_texture.png"
+#define TEXTURE_BENCH_KTX2_PATH     "bench_texture_bc1" KTX2_EXTENSION
+
+typedef struct BenchOptions
+{
+    const char*    pOutputPath;
+    uint32_t       frameCount;
+} BenchOptions;
+
+typedef struct BenchReport
+{
+    FILE*       pFile;
+    SDL_bool    firstResult;
+} BenchReport;
+
+static const uint32_t pTriangleCounts[] = { 1000, 10000, 100000, 1000000, 4000000 };
+static const uint32_t pDrawCounts[] = { 1, 16, 256, 1024, 4096 };
+static const uint32_t pPipelineThreadCounts[] = { 1, 2, 4, 8 };
+static const uint32_t pRecordDrawCounts[] = { 10000, 100000 };
+static const uint32_t pCullingDrawCounts[] = { 1024, 16384, 100000 };
+static const char* const pCullingModeNames[] = { "none", "cpu", "gpu" };
+static const uint32_t pInstancingDrawCounts[] = { 1024, 16384, 100000 };
+static const uint32_t pDrawSortCounts[] = { 1024, 16384, 100000, 1000000 };
+static const uint32_t pDrawOrderDrawCounts[] = { 1024, 16384, 100000 };
+#ifdef VIEWER_VALIDATION
+static const uint32_t pValidationDrawCounts[] = { 1, 1024, 16384 };
+#endif
+
+static Result parseBenchOptions(int argc, char* argv[], BenchOptions* pOptions);
+
+static void printBenchUsage(const char* pProgramName);
+
+static void setBenchConfig(Config* pConfig);
+
+static Result createBenchApplication(Application* pApplication, const Config* pConfig);
+
+static void beginBenchResult(BenchReport* pReport, const char* pName);
+
+static void writeTimingStats(BenchReport* pReport, const char* pName, const ProfilerScopeStats* pStats);
+
+static Result runFrameScenario(BenchReport* pReport, const BenchOptions* pOptions, const char* pName, const Config* pConfig);
+
+static Result runUploadScenario(BenchReport* pReport, Application* pApplication);
+
+static Result runPipelineScenario(BenchReport* pReport, Application* pApplication, uint32_t threadCount);
+
+static Result writeBenchPng(const char* pPath);
+
+static Result writeBenchKtx2(const char* pPath);
+
+static void writeUint32(uint8_t* pBytes, uint32_t value);
+
+static void writeUint64(uint8_t* pBytes, uint64_t value);
+
+static Result runTextureScenario(BenchReport* pReport, Application* pApplication, const char* pPath);
+
+static Result createCullingBenchBounds(ObjectBounds* pBounds);
+
+static Result runDrawSortScenario(BenchReport* pReport, uint32_t keyCount);
+
+static int compareDrawSortKeys(const void* pA, const void* pB);
+
+static float getBenchRandom(uint32_t* pState);
+
+static Result runCpuCullingScenario(BenchReport* pReport, const ObjectBounds* pBounds, CullingInstructionSet instructionSet, ThreadPool* pThreadPool);
+
+static Result createCullingBenchBounds(ObjectBounds* pBounds)
+{
+    if (createObjectBounds(pBounds, CULLING_BENCH_OBJECTS) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    // Scattered around the camera, so only part of them is in view and the kernels cannot predict the outcome
+    uint32_t random = 1;
+    for (uint32_t i = 0; i < CULLING_BENCH_OBJECTS; ++i)
+    {
+        pBounds->pCenterX[i] = getBenchRandom(&random) * 100.0f - 50.0f;
+        pBounds->pCenterY[i] = getBenchRandom(&random) * 100.0f - 50.0f;
+        pBounds->pCenterZ[i] = getBenchRandom(&random) * 100.0f - 80.0f;
+        pBounds->pRadii[i] = getBenchRandom(&random);
+    }
+
+    return SUCCESS;
+}
+
+Result runDrawSortScenario(BenchReport* pReport, uint32_t keyCount)
+{
+    printf("Scenario \"draw sort\": %u keys\n\n", keyCount);
+
+    DrawSorter sorter;
+    if (createDrawSorter(&sorter, keyCount) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    // Keys as a scene would make them, few pipelines and materials and depths spread over the view
+    uint64_t* pSourceKeys = malloc(keyCount * sizeof(uint64_t));
+    if (pSourceKeys == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for sort keys!", keyCount * sizeof(uint64_t));
+        destroyDrawSorter(&sorter);
+        return FAIL;
+    }
+
+    uint32_t random = 1;
+    for (uint32_t i = 0; i < keyCount; ++i)
+    {
+        uint32_t pipeline = (uint32_t)(getBenchRandom(&random) * 4.0f);
+        uint32_t material = (uint32_t)(getBenchRandom(&random) * 64.0f);
+        pSourceKeys[i] = makeDrawSortKey(pipeline, material, 0.1f + getBenchRandom(&random) * 100.0f);
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double minRadixSeconds = 0.0;
+    double minQsortSeconds = 0.0;
+
+    for (uint32_t i = 0; i < DRAW_SORT_BENCH_REPEATS; ++i)
+    {
+        for (uint32_t j = 0; j < keyCount; ++j)
+        {
+            sorter.pKeys[j] = pSourceKeys[j];
+            sorter.pValues[j] = j;
+        }
+
+        uint64_t startTicks = SDL_GetPerformanceCounter();
+        sortDraws(&sorter, keyCount);
+        double seconds = (SDL_GetPerformanceCounter() - startTicks) / frequency;
+        minRadixSeconds = ((i == 0) || (seconds < minRadixSeconds)) ? seconds : minRadixSeconds;
+
+        // The comparison sort as the baseline, on the keys alone
+        memcpy(sorter.pScratchKeys, pSourceKeys, keyCount * sizeof(uint64_t));
+
+        startTicks = SDL_GetPerformanceCounter();
+        qsort(sorter.pScratchKeys, keyCount, sizeof(uint64_t), compareDrawSortKeys);
+        seconds = (SDL_GetPerformanceCounter() - startTicks) / frequency;
+        minQsortSeconds = ((i == 0) || (seconds < minQsortSeconds)) ? seconds : minQsortSeconds;
+    }
+
+    beginBenchResult(pReport, "drawSort");
+    fprintf(pReport->pFile, ", \"keys\": %u, \"radixMs\": %.4f, \"qsortMs\": %.4f, \"radixKeysPerNs\": %.3f}", keyCount, minRadixSeconds * 1000.0, minQsortSeconds * 1000.0,
+        keyCount / (minRadixSeconds * 1e9));
+
+    free(pSourceKeys);
+    destroyDrawSorter(&sorter);
+
+    return SUCCESS;
+}
+
+int compareDrawSortKeys(const void* pA, const void* pB)
+{
+    uint64_t a = *(const uint64_t*)pA;
+    uint64_t b = *(const uint64_t*)pB;
+    return (a > b) - (a < b);
+}
+
+float getBenchRandom(uint32_t* pState)
+{
+    // Same sequence on every machine, unlike rand
+    *pState = *pState * 1664525u + 1013904223u;
+    return (float)(*pState >> 8) / (float)(1u << 24);
+}
+
+Result runCpuCullingScenario(BenchReport* pReport, const ObjectBounds* pBounds, CullingInstructionSet instructionSet, ThreadPool* pThreadPool)
+{
+    uint32_t threadCount = (pThreadPool != NULL) ? pThreadPool->threadCount + 1 : 1;
+    printf("Scenario \"cpu culling\": %u objects with %s on %u threads\n\n", pBounds->objectCount, getCullingInstructionSetName(instructionSet), threadCount);
+
+    CpuCulling culling;
+    if (createCpuCulling(&culling, pBounds, pThreadPool, instructionSet) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    Mat4 viewProjection = perspectiveMat4(1.0f, (float)BENCH_WIDTH / BENCH_HEIGHT, 0.1f, 100.0f);
+    float pPlanes[6][4];
+    getFrustumPlanes(&viewProjection, pPlanes);
+
+    // The first pass faults in the output and wakes the workers
+    uint32_t visibleCount = cullObjects(&culling, pPlanes, 1.0f);
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double minSeconds = 0.0;
+    double sumSeconds = 0.0;
+
+    for (uint32_t i = 0; i < CULLING_BENCH_REPEATS; ++i)
+    {
+        uint64_t startTicks = SDL_GetPerformanceCounter();
+        cullObjects(&culling, pPlanes, 1.0f);
+        double seconds = (SDL_GetPerformanceCounter() - startTicks) / frequency;
+
+        minSeconds = ((i == 0) || (seconds < minSeconds)) ? seconds : minSeconds;
+        sumSeconds += seconds;
+    }
+
+    beginBenchResult(pReport, "cpuCulling");
+    fprintf(pReport->pFile, ", \"instructionSet\": \"%s\", \"threads\": %u, \"objects\": %u, \"visible\": %u, \"minMs\": %.4f, \"avgMs\": %.4f, \"objectsPerNs\": %.3f}",
+        getCullingInstructionSetName(instructionSet), threadCount, pBounds->objectCount, visibleCount, minSeconds * 1000.0, sumSeconds * 1000.0 / CULLING_BENCH_REPEATS,
+        pBounds->objectCount / (minSeconds * 1e9));
+
+    destroyCpuCulling(&culling);
+
+    return SUCCESS;
+}
+
+Result writeBenchPng(const char* pPath)
+{
+    SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormat(0, TEXTURE_BENCH_SIZE, TEXTURE_BENCH_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+    if (pSurface == NULL)
+    {
+        printError("Failed to create texture surface!");
+        return FAIL;
+    }
+
+    // Noise on top of a checkerboard, so the PNG does not compress down to nothing
+    uint32_t random = 1;
+    for (int y = 0; y < pSurface->h; ++y)
+    {
+        uint8_t* pRow = (uint8_t*)pSurface->pixels + y * pSurface->pitch;
+        for (int x = 0; x < pSurface->w; ++x)
+        {
+            uint8_t base = (((x / 64) + (y / 64)) % 2 == 0) ? 192 : 64;
+            uint8_t noise = (uint8_t)(getBenchRandom(&random) * 32.0f);
+            pRow[x * 4 + 0] = base + noise;
+            pRow[x * 4 + 1] = base;
+            pRow[x * 4 + 2] = base - noise;
+            pRow[x * 4 + 3] = 255;
+        }
+    }
+
+    int result = IMG_SavePNG(pSurface, pPath);
+    SDL_FreeSurface(pSurface);
+
+    if (result != 0)
+    {
+        printError("Failed to write \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+Result writeBenchKtx2(const char* pPath)
+{
+    static const uint8_t pIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    uint32_t levelCount = 1;
+    while ((TEXTURE_BENCH_SIZE >> (levelCount - 1)) > 1)
+    {
+        ++levelCount;
+    }
+
+    // Only what the texture loader reads, the data format descriptor is left out
+    size_t headerSize = 80 + levelCount * 24;
+    size_t fileSize = headerSize;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        uint32_t blocks = SDL_max((TEXTURE_BENCH_SIZE >> i) / 4, 1);
+        fileSize += (size_t)blocks * blocks * 8;
+    }
+
+    uint8_t* pBytes = calloc(fileSize, 1);
+    if (pBytes == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for KTX2 file!", fileSize);
+        return FAIL;
+    }
+
+    memcpy(pBytes, pIdentifier, sizeof(pIdentifier));
+    writeUint32(pBytes + 12, VK_FORMAT_BC1_RGBA_SRGB_BLOCK);
+    writeUint32(pBytes + 16, 1);
+    writeUint32(pBytes + 20, TEXTURE_BENCH_SIZE);
+    writeUint32(pBytes + 24, TEXTURE_BENCH_SIZE);
+    writeUint32(pBytes + 36, 1);
+    writeUint32(pBytes + 40, levelCount);
+
+    // Every block is a single color, alternating like the checkerboard of the PNG
+    size_t offset = headerSize;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        uint32_t blocks = SDL_max((TEXTURE_BENCH_SIZE >> i) / 4, 1);
+        uint64_t size = (uint64_t)blocks * blocks * 8;
+
+        writeUint64(pBytes + 80 + i * 24, offset);
+        writeUint64(pBytes + 80 + i * 24 + 8, size);
+        writeUint64(pBytes + 80 + i * 24 + 16, size);
+
+        for (uint32_t y = 0; y < blocks; ++y)
+        {
+            for (uint32_t x = 0; x < blocks; ++x)
+            {
+                uint16_t color = (((x + y) % 2) == 0) ? 0xC618 : 0x4208;
+                uint8_t* pBlock = pBytes + offset + ((size_t)y * blocks + x) * 8;
+                pBlock[0] = (uint8_t)color;
+                pBlock[1] = (uint8_t)(color >> 8);
+                pBlock[2] = (uint8_t)color;
+                pBlock[3] = (uint8_t)(color >> 8);
+            }
+        }
+
+        offset += size;
+    }
+
+    FILE* pFile = fopen(pPath, "wb");
+    if (pFile == NULL)
+    {
+        printError("Failed to open \"%s\"!", pPath);
+        free(pBytes);
+        return FAIL;
+    }
+
+    size_t written = fwrite(pBytes, 1, fileSize, pFile);
+    int closeResult = fclose(pFile);
+    free(pBytes);
+
+    if ((written != fileSize) || (closeResult != 0))
+    {
+        printError("Failed to write \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void writeUint32(uint8_t* pBytes, uint32_t value)
+{
+    memcpy(pBytes, &value, sizeof(value));
+}
+
+void writeUint64(uint8_t* pBytes, uint64_t value)
+{
+    memcpy(pBytes, &value, sizeof(value));
+}
+
+Result runTextureScenario(BenchReport* pReport, Application* pApplication, const char* pPath)
+{
+    printf("Scenario \"textures\": \"%s\", %u times\n\n", pPath, TEXTURE_BENCH_REPEATS);
+
+    double decodeMs = 0.0;
+    double uploadMs = 0.0;
+    TextureLoadStats stats;
+
+    for (uint32_t i = 0; i < TEXTURE_BENCH_REPEATS; ++i)
+    {
+        Texture texture;
+        if (loadTextures(&pApplication->textureLoader, 1, &pPath, &texture, &stats) != SUCCESS)
+        {
+            return FAIL;
+        }
+
+        decodeMs += stats.decodeMs;
+        uploadMs += stats.uploadMs;
+
+        destroyTexture(&pApplication->textureLoader, &texture);
+    }
+
+    beginBenchResult(pReport, "textures");
+    fprintf(pReport->pFile, ", \"path\": \"%s\", \"compressed\": %s, \"width\": %u, \"height\": %u, \"decodeMs\": %.3f, \"uploadMs\": %.3f, \"memoryBytes\": %llu, \"uncompressedBytes\": %llu}",
+        pPath, (stats.compressedCount > 0) ? "true" : "false", TEXTURE_BENCH_SIZE, TEXTURE_BENCH_SIZE, decodeMs / TEXTURE_BENCH_REPEATS, uploadMs / TEXTURE_BENCH_REPEATS,
+        (unsigned long long)stats.memoryBytes, (unsigned long long)stats.uncompressedBytes);
+
+    return SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (parseBenchOptions(argc, argv, &options) != SUCCESS)
+    {
+        printBenchUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Mesa keeps compiled shaders on disk, which would turn every pipeline build after the first run into a cache hit
+    SDL_setenv("MESA_SHADER_CACHE_DISABLE", "true", 0);
+
+    BenchReport report;
+    report.firstResult = SDL_TRUE;
+    report.pFile = fopen(options.pOutputPath, "w");
+    if (report.pFile == NULL)
+    {
+        printError("Failed to open file \"%s\" for writing!", options.pOutputPath);
+        return EXIT_FAILURE;
+    }
+
+    int exitCode = EXIT_SUCCESS;
+
+    // Device wide scenarios share one application, which also provides the device description
+    Config config;
+    setBenchConfig(&config);
+
+    Application application;
+    if (createBenchApplication(&application, &config) != SUCCESS)
+    {
+        printError("Failed to create benchmark application!");
+        fclose(report.pFile);
+        return EXIT_FAILURE;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(application.physicalDevice, &properties);
+
+    fprintf(report.pFile, "{\n    \"device\": \"%s\",\n    \"driverVersion\": %u,\n    \"apiVersion\": \"%u.%u.%u\",\n", properties.deviceName, properties.driverVersion,
+        VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion), VK_API_VERSION_PATCH(properties.apiVersion));
+    fprintf(report.pFile, "    \"width\": %u,\n    \"height\": %u,\n    \"frames\": %u,\n    \"timeStepMs\": %u,\n    \"results\": [", BENCH_WIDTH, BENCH_HEIGHT, options.frameCount, BENCH_TIME_STEP_MS);
+
+    if (runUploadScenario(&report, &application) != SUCCESS)
+    {
+        printError("Upload scenario failed!");
+        exitCode = EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0; i < sizeof(pPipelineThreadCounts) / sizeof(pPipelineThreadCounts[0]); ++i)
+    {
+        if (runPipelineScenario(&report, &application, pPipelineThreadCounts[i]) != SUCCESS)
+        {
+            printError("Pipeline scenario with %u threads failed!", pPipelineThreadCounts[i]);
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    // The same image decoded from PNG with mips generated on the GPU and as BC1 blocks with mips of its own
+    if ((writeBenchPng(TEXTURE_BENCH_PNG_PATH) != SUCCESS) || (runTextureScenario(&report, &application, TEXTURE_BENCH_PNG_PATH) != SUCCESS))
+    {
+        printError("PNG texture scenario failed!");
+        exitCode = EXIT_FAILURE;
+    }
+
+    if ((writeBenchKtx2(TEXTURE_BENCH_KTX2_PATH) != SUCCESS) || (runTextureScenario(&report, &application, TEXTURE_BENCH_KTX2_PATH) != SUCCESS))
+    {
+        printError("KTX2 texture scenario failed!");
+        exitCode = EXIT_FAILURE;
+    }
+
+    remove(TEXTURE_BENCH_PNG_PATH);
+    remove(TEXTURE_BENCH_KTX2_PATH);
+
+    destroyApplication(&application);
+
+    // Culling throughput needs no device, each instruction set alone and on every core
+    ObjectBounds bounds;
+    if (createCullingBenchBounds(&bounds) == SUCCESS)
+    {
+        ThreadPool threadPool;
+        uint32_t workerCount = getDefaultThreadCount() - 1;
+        SDL_bool threadPoolCreated = ((workerCount > 0) && (createThreadPool(&threadPool, workerCount) == SUCCESS)) ? SDL_TRUE : SDL_FALSE;
+
+        for (uint32_t i = CULLING_INSTRUCTION_SET_SCALAR; i <= CULLING_INSTRUCTION_SET_AVX; ++i)
+        {
+            if (isCullingInstructionSetSupported((CullingInstructionSet)i) != SDL_TRUE)
+            {
+                continue;
+            }
+
+            if ((runCpuCullingScenario(&report, &bounds, (CullingInstructionSet)i, NULL) != SUCCESS)
+                || ((threadPoolCreated == SDL_TRUE) && (runCpuCullingScenario(&report, &bounds, (CullingInstructionSet)i, &threadPool) != SUCCESS)))
+            {
+                printError("CPU culling scenario with %s failed!", getCullingInstructionSetName((CullingInstructionSet)i));
+                exitCode = EXIT_FAILURE;
+            }
+        }
+
+        if (threadPoolCreated == SDL_TRUE)
+        {
+            destroyThreadPool(&threadPool);
+        }
+
+        destroyObjectBounds(&bounds);
+    }
+    else
+    {
+        exitCode = EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0; i < sizeof(pDrawSortCounts) / sizeof(pDrawSortCounts[0]); ++i)
+    {
+        if (runDrawSortScenario(&report, pDrawSortCounts[i]) != SUCCESS)
+        {
+            printError("Draw sort scenario with %u keys failed!", pDrawSortCounts[i]);
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    for (uint32_t i = 0; i < sizeof(pTriangleCounts) / sizeof(pTriangleCounts[0]); ++i)
+    {
+        setBenchConfig(&config);
+        config.gridTriangleCount = pTriangleCounts[i];
+
+        if (runFrameScenario(&report, &options, "triangles", &config) != SUCCESS)
+        {
+            printError("Triangle scenario with %u triangles failed!", pTriangleCounts[i]);
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    // A single quad per draw, so the cost is in the draw calls and not in the geometry
+    for (uint32_t i = 0; i < sizeof(pDrawCounts) / sizeof(pDrawCounts[0]); ++i)
+    {
+        setBenchConfig(&config);
+        config.gridTriangleCount = 2;
+        config.drawCount = pDrawCounts[i];
+
+        if (runFrameScenario(&report, &options, "draws", &config) != SUCCESS)
+        {
+            printError("Draw scenario with %u draws failed!", pDrawCounts[i]);
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    // Recording scaling from the main thread alone over doubling thread counts up to one per core
+    uint32_t coreCount = SDL_min(getDefaultThreadCount(), MAX_RECORD_THREADS);
+    for (uint32_t i = 0; i < sizeof(pRecordDrawCounts) / sizeof(pRecordDrawCounts[0]); ++i)
+    {
+        uint32_t threadCount = 0;
+        for (;;)
+        {
+            setBenchConfig(&config);
+            config.gridTriangleCount = 2;
+            config.drawCount = pRecordDrawCounts[i];
+            config.recordThreadCount = threadCount;
+
+            if (runFrameScenario(&report, &options, "recording", &config) != SUCCESS)
+            {
+                printError("Recording scenario with %u draws on %u threads failed!", pRecordDrawCounts[i], threadCount);
+                exitCode = EXIT_FAILURE;
+            }
+
+            if (threadCount == coreCount)
+            {
+                break;
+            }
+
+            threadCount = (threadCount == 0) ? 1 : SDL_min(threadCount * 2, coreCount);
+        }
+    }
+
+    // The same draws recorded one by one, culled on the CPU first, and culled and drawn indirectly by the GPU
+    for (uint32_t i = 0; i < sizeof(pCullingDrawCounts) / sizeof(pCullingDrawCounts[0]); ++i)
+    {
+        for (uint32_t mode = 0; mode < sizeof(pCullingModeNames) / sizeof(pCullingModeNames[0]); ++mode)
+        {
+            setBenchConfig(&config);
+            config.gridTriangleCount = 2;
+            config.drawCount = pCullingDrawCounts[i];
+            config.cpuCulling = (mode == 1) ? CPU_CULLING_OPTION_AUTO : CPU_CULLING_OPTION_OFF;
+            config.gpuCulling = (mode == 2) ? SDL_TRUE : SDL_FALSE;
+
+            if (runFrameScenario(&report, &options, "culling", &config) != SUCCESS)
+            {
+                printError("Culling scenario with %u draws failed!", pCullingDrawCounts[i]);
+                exitCode = EXIT_FAILURE;
+            }
+        }
+    }
+
+    // The same copies drawn one by one and as instances of a single draw
+    for (uint32_t i = 0; i < sizeof(pInstancingDrawCounts) / sizeof(pInstancingDrawCounts[0]); ++i)
+    {
+        for (uint32_t instancing = 0; instancing < 2; ++instancing)
+        {
+            setBenchConfig(&config);
+            config.gridTriangleCount = 2;
+            config.drawCount = pInstancingDrawCounts[i];
+            config.instancing = (instancing == 1) ? SDL_TRUE : SDL_FALSE;
+
+            if (runFrameScenario(&report, &options, "instancing", &config) != SUCCESS)
+            {
+                printError("Instancing scenario with %u draws failed!", pInstancingDrawCounts[i]);
+                exitCode = EXIT_FAILURE;
+            }
+        }
+    }
+
+    // The same draws sorted front to back and in grid order, for the cost of the sort and the overdraw it saves
+    for (uint32_t i = 0; i < sizeof(pDrawOrderDrawCounts) / sizeof(pDrawOrderDrawCounts[0]); ++i)
+    {
+        for (uint32_t sorted = 0; sorted < 2; ++sorted)
+        {
+            setBenchConfig(&config);
+            config.gridTriangleCount = 2;
+            config.drawCount = pDrawOrderDrawCounts[i];
+            config.sortDraws = (sorted == 1) ? SDL_TRUE : SDL_FALSE;
+
+            if (runFrameScenario(&report, &options, "draw order", &config) != SUCCESS)
+            {
+                printError("Draw order scenario with %u draws failed!", pDrawOrderDrawCounts[i]);
+                exitCode = EXIT_FAILURE;
+            }
+        }
+    }
+
+#ifdef VIEWER_VALIDATION
+    // What every validation level costs per frame, the draw count scales the per-call overhead
+    for (uint32_t i = 0; i < sizeof(pValidationDrawCounts) / sizeof(pValidationDrawCounts[0]); ++i)
+    {
+        for (uint32_t level = VALIDATION_LEVEL_OFF; level <= VALIDATION_LEVEL_GPU; ++level)
+        {
+            setBenchConfig(&config);
+            config.gridTriangleCount = 2;
+            config.drawCount = pValidationDrawCounts[i];
+            config.validation = (ValidationLevel)level;
+
+            if (runFrameScenario(&report, &options, "validation", &config) != SUCCESS)
+            {
+                printError("Validation scenario at level %s with %u draws failed!", getValidationLevelName((ValidationLevel)level), pValidationDrawCounts[i]);
+                exitCode = EXIT_FAILURE;
+            }
+        }
+    }
+#endif
+
+    fprintf(report.pFile, "\n    ]\n}\n");
+
+    if (fclose(report.pFile) != 0)
+    {
+        printError("Failed to write \"%s\"!", options.pOutputPath);
+        return EXIT_FAILURE;
+    }
+
+    printf("Results written to \"%s\"\n", options.pOutputPath);
+
+    return exitCode;
+}
+
+Result parseBenchOptions(int argc, char* argv[], BenchOptions* pOptions)
+{
+    pOptions->pOutputPath = "bench_results.json";
+    pOptions->frameCount = DEFAULT_BENCH_FRAMES;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--output") == 0)
+        {
+            pOptions->pOutputPath = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--frames") == 0)
+        {
+            char* pEnd = NULL;
+            unsigned long frameCount = strtoul(argv[i + 1], &pEnd, 10);
+            if ((pEnd == argv[i + 1]) || (*pEnd != '\0') || (frameCount == 0) || (frameCount > UINT32_MAX))
+            {
+                printError("Invalid value \"%s\" for option \"--frames\"!", argv[i + 1]);
+                return FAIL;
+            }
+
+            pOptions->frameCount = (uint32_t)frameCount;
+        }
+        else
+        {
+            printError("Unknown option \"%s\"!", argv[i]);
+            return FAIL;
+        }
+    }
+
+    if (argc % 2 == 0)
+    {
+        printError("Unknown option \"%s\" or missing value!", argv[argc - 1]);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void printBenchUsage(const char* pProgramName)
+{
+    printf("Usage: %s [options]\n", pProgramName);
+    printf("    --output <path>     JSON results file (default bench_results.json)\n");
+    printf("    --frames <n>        Measured frames per scenario (default %u)\n", DEFAULT_BENCH_FRAMES);
+    printf("\n");
+    printf("Runs headless from the build directory like the viewer. On machines without a GPU select lavapipe with\n");
+    printf("VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json\n");
+    printf("\n");
+}
+
+void setBenchConfig(Config* pConfig)
+{
+    setDefaultConfig(pConfig);
+    pConfig->headless = SDL_TRUE;
+    pConfig->width = BENCH_WIDTH;
+    pConfig->height = BENCH_HEIGHT;
+    pConfig->timeStepMs = BENCH_TIME_STEP_MS;
+
+    // Validation would be measured along with everything else, only the validation scenario turns it on
+    pConfig->validation = VALIDATION_LEVEL_OFF;
+}
+
+Result createBenchApplication(Application* pApplication, const Config* pConfig)
+{
+    if (createApplication(pApplication, pConfig) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    // Frames only count once the mesh is resident, the pipeline is compiled and every frame in flight was used
+    uint64_t deadline = SDL_GetPerformanceCounter() + SDL_GetPerformanceFrequency() * BENCH_WARMUP_TIMEOUT_MS / 1000;
+    uint32_t readyFrameCount = 0;
+
+    while (readyFrameCount < BENCH_WARMUP_FRAMES)
+    {
+        // drawFrame reports its own failures, a pipeline that failed to build among them
+        if (drawFrame(pApplication) != SUCCESS)
+        {
+            destroyApplication(pApplication);
+            return FAIL;
+        }
+
+        if (SDL_GetPerformanceCounter() > deadline)
+        {
+            printError("Benchmark application did not get ready within %u ms!", BENCH_WARMUP_TIMEOUT_MS);
+            destroyApplication(pApplication);
+            return FAIL;
+        }
+
+        if ((pApplication->meshReady == SDL_TRUE) && (pApplication->pipelinesReady == SDL_TRUE))
+        {
+            ++readyFrameCount;
+        }
+    }
+
+    // Every run starts the fixed camera path from the beginning
+    pApplication->frameNumber = 0;
+    pApplication->recordTicks = 0;
+    pApplication->cullTicks = 0;
+    pApplication->sortTicks = 0;
+    pApplication->sortedDrawSum = 0;
+    pApplication->reorderedDrawSum = 0;
+    pApplication->drawCallSum = 0;
+    pApplication->drawnObjectSum = 0;
+    resetGpuProfilerStats(&pApplication->gpuProfiler);
+
+    return SUCCESS;
+}
+
+void beginBenchResult(BenchReport* pReport, const char* pName)
+{
+    fprintf(pReport->pFile, "%s\n        {\"name\": \"%s\"", (pReport->firstResult == SDL_TRUE) ? "" : ",", pName);
+    pReport->firstResult = SDL_FALSE;
+}
+
+void writeTimingStats(BenchReport* pReport, const char* pName, const ProfilerScopeStats* pStats)
+{
+    fprintf(pReport->pFile, ", \"%s\": {\"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f}", pName, pStats->minMs, pStats->averageMs, pStats->p99Ms);
+}
+
+Result runFrameScenario(BenchReport* pReport, const BenchOptions* pOptions, const char* pName, const Config* pConfig)
+{
+    printf("Scenario \"%s\": %u triangles, %u draws, %u record threads, %s culling%s\n\n", pName, pConfig->gridTriangleCount, pConfig->drawCount, pConfig->recordThreadCount,
+        (pConfig->gpuCulling == SDL_TRUE) ? "GPU" : (pConfig->cpuCulling != CPU_CULLING_OPTION_OFF) ? "CPU" : "no", (pConfig->instancing == SDL_TRUE) ? ", instancing" : "");
+
+    float* pFrameTimes = malloc(pOptions->frameCount * sizeof(float));
+    if (pFrameTimes == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for frame times!", pOptions->frameCount * sizeof(float));
+        return FAIL;
+    }
+
+    Application application;
+    if (createBenchApplication(&application, pConfig) != SUCCESS)
+    {
+        free(pFrameTimes);
+        return FAIL;
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    Result result = SUCCESS;
+
+    for (uint32_t i = 0; (i < pOptions->frameCount) && (result == SUCCESS); ++i)
+    {
+        uint64_t frameStart = SDL_GetPerformanceCounter();
+        result = drawFrame(&application);
+        pFrameTimes[i] = (float)((SDL_GetPerformanceCounter() - frameStart) * 1000.0 / frequency);
+    }
+
+    double totalSeconds = (SDL_GetPerformanceCounter() - startTicks) / frequency;
+
+    // Otherwise the sorted and unsorted runs of the draw order scenario would measure the same order
+    if ((result == SUCCESS) && (application.sortedDrawSum > pOptions->frameCount) && (application.reorderedDrawSum == 0))
+    {
+        printError("Sorting never changed the draw order!");
+        result = FAIL;
+    }
+
+    if (result == SUCCESS)
+    {
+        double sum = 0.0;
+        for (uint32_t i = 0; i < pOptions->frameCount; ++i)
+        {
+            sum += pFrameTimes[i];
+        }
+
+        sortFloats(pFrameTimes, pOptions->frameCount);
+
+        ProfilerScopeStats cpuStats;
+        cpuStats.sampleCount = pOptions->frameCount;
+        cpuStats.minMs = pFrameTimes[0];
+        cpuStats.averageMs = (float)(sum / pOptions->frameCount);
+        cpuStats.p99Ms = getSortedPercentile(pFrameTimes, pOptions->frameCount, 99);
+
+        beginBenchResult(pReport, pName);
+        const char* pCulling = (application.gpuCullingEnabled == SDL_TRUE) ? "gpu" : (application.cpuCullingEnabled == SDL_TRUE) ? "cpu" : "none";
+        fprintf(pReport->pFile, ", \"triangles\": %u, \"draws\": %u, \"recordThreads\": %u, \"culling\": \"%s\", \"instancing\": %s, \"sorted\": %s, \"fps\": %.2f", pConfig->gridTriangleCount,
+            pConfig->drawCount, pConfig->recordThreadCount, pCulling, (application.instancingEnabled == SDL_TRUE) ? "true" : "false", (application.drawSortEnabled == SDL_TRUE) ? "true" : "false",
+            pOptions->frameCount / totalSeconds);
+        fprintf(pReport->pFile, ", \"drawCallsPerFrame\": %.1f, \"startupMs\": %.3f, \"validation\": \"%s\"", (double)application.drawCallSum / pOptions->frameCount,
+            (application.startupStepTicks - application.startTicks) * 1000.0 / frequency, getValidationLevelName(application.validationLevel));
+        writeTimingStats(pReport, "cpuFrameMs", &cpuStats);
+        fprintf(pReport->pFile, ", \"cpuRecordMs\": %.4f, \"cpuCullMs\": %.4f, \"cpuSortMs\": %.4f, \"reorderedDrawsPerFrame\": %.1f", application.recordTicks * 1000.0 / frequency / pOptions->frameCount,
+            application.cullTicks * 1000.0 / frequency / pOptions->frameCount, application.sortTicks * 1000.0 / frequency / pOptions->frameCount,
+            (double)application.reorderedDrawSum / pOptions->frameCount);
+
+        double overdraw;
+        if (getOverdraw(&application, &overdraw) == SUCCESS)
+        {
+            fprintf(pReport->pFile, ", \"overdraw\": %.3f", overdraw);
+        }
+
+        ProfilerScopeStats gpuStats;
+        if (getProfilerScopeStats(&application.gpuProfiler, "frame", &gpuStats) == SUCCESS)
+        {
+            writeTimingStats(pReport, "gpuFrameMs", &gpuStats);
+        }
+
+        fprintf(pReport->pFile, "}");
+    }
+
+    destroyApplication(&application);
+    free(pFrameTimes);
+
+    return result;
+}
+
+Result runUploadScenario(BenchReport* pReport, Application* pApplication)
+{
+    printf("Scenario \"upload\": %llu MiB, %u times\n\n", UPLOAD_BENCH_SIZE / (1024 * 1024), UPLOAD_BENCH_REPEATS);
+
+    void* pData = malloc(UPLOAD_BENCH_SIZE);
+    if (pData == NULL)
+    {
+        printError("Failed to allocate %llu bytes of memory for upload data!", UPLOAD_BENCH_SIZE);
+        return FAIL;
+    }
+
+    // Touches every page, so the first repetition does not measure page faults
+    memset(pData, 0x5A, UPLOAD_BENCH_SIZE);
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    VkBuffer buffer;
+    Allocation allocation;
+    if (createBuffer(&pApplication->allocator, UPLOAD_BENCH_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT, &allocationInfo, &buffer, &allocation) != SUCCESS)
+    {
+        printError("Failed to create upload destination buffer!");
+        free(pData);
+        return FAIL;
+    }
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    Result result = SUCCESS;
+
+    for (uint32_t i = 0; (i < UPLOAD_BENCH_REPEATS) && (result == SUCCESS); ++i)
+    {
+        if ((stageBuffer(&pApplication->stagingRing, buffer, 0, pData, UPLOAD_BENCH_SIZE) != SUCCESS) || (flushStagingRing(&pApplication->stagingRing) != SUCCESS))
+        {
+            result = FAIL;
+        }
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - startTicks) / SDL_GetPerformanceFrequency();
+
+    if (result == SUCCESS)
+    {
+        beginBenchResult(pReport, "upload");
+        fprintf(pReport->pFile, ", \"bytes\": %llu, \"repeats\": %u, \"ms\": %.3f, \"mibPerSecond\": %.1f}", UPLOAD_BENCH_SIZE, UPLOAD_BENCH_REPEATS, seconds * 1000.0,
+            UPLOAD_BENCH_SIZE * UPLOAD_BENCH_REPEATS / (1024.0 * 1024.0) / seconds);
+    }
+
+    destroyBuffer(&pApplication->allocator, buffer, &allocation);
+    free(pData);
+
+    return result;
+}
+
+Result runPipelineScenario(BenchReport* pReport, Application* pApplication, uint32_t threadCount)
+{
+    printf("Scenario \"pipelines\": %u pipelines on %u threads\n\n", PIPELINE_BENCH_VARIANTS, threadCount);
+
+    // Every combination of these states, so the driver cannot hand out an already compiled pipeline
+    static const VkCullModeFlags pCullModes[] = { VK_CULL_MODE_NONE, VK_CULL_MODE_FRONT_BIT, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_AND_BACK };
+    static const VkFrontFace pFrontFaces[] = { VK_FRONT_FACE_COUNTER_CLOCKWISE, VK_FRONT_FACE_CLOCKWISE };
+    static const VkPrimitiveTopology pTopologies[] = { VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP };
+
+    GraphicsPipelineState* pStates = malloc(PIPELINE_BENCH_VARIANTS * sizeof(GraphicsPipelineState));
+    if (pStates == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for pipeline states!", PIPELINE_BENCH_VARIANTS * sizeof(GraphicsPipelineState));
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < PIPELINE_BENCH_VARIANTS; ++i)
+    {
+        getMeshPipelineState(pApplication, &pStates[i]);
+        pStates[i].rasterizationState.cullMode = pCullModes[i % 4];
+        pStates[i].rasterizationState.frontFace = pFrontFaces[(i / 4) % 2];
+        pStates[i].inputAssemblyState.topology = pTopologies[(i / 8) % 2];
+        pStates[i].colorBlendAttachment.blendEnable = ((i / 16) % 2 == 0) ? VK_FALSE : VK_TRUE;
+    }
+
+    // No pipeline cache, the builds would be hits after the first thread count otherwise
+    PipelineBuilder builder;
+    if (createPipelineBuilder(&builder, pApplication->device, VK_NULL_HANDLE, threadCount) != SUCCESS)
+    {
+        free(pStates);
+        return FAIL;
+    }
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+
+    uint32_t firstPipeline;
+    Result result = submitGraphicsPipelines(&builder, PIPELINE_BENCH_VARIANTS, pStates, &firstPipeline);
+    if ((result == SUCCESS) && (waitForPipelines(&builder) != SUCCESS))
+    {
+        result = FAIL;
+    }
+
+    double milliseconds = (double)(SDL_GetPerformanceCounter() - startTicks) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    for (uint32_t i = 0; (i < PIPELINE_BENCH_VARIANTS) && (result == SUCCESS); ++i)
+    {
+        if (getPipelineStatus(&builder, firstPipeline + i) != PIPELINE_STATUS_READY)
+        {
+            result = FAIL;
+        }
+    }
+
+    if (result == SUCCESS)
+    {
+        beginBenchResult(pReport, "pipelines");
+        fprintf(pReport->pFile, ", \"threads\": %u, \"pipelines\": %u, \"ms\": %.3f, \"msPerPipeline\": %.3f}", threadCount, PIPELINE_BENCH_VARIANTS, milliseconds, milliseconds / PIPELINE_BENCH_VARIANTS);
+    }
+
+    destroyPipelineBuilder(&builder);
+    free(pStates);
+
+    return result;
+}
@@ -0,0 +1,216 @@
+#include "blockAllocator.h"
+
+#include <stdlib.h>
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment);
+
+static uint32_t orderOfSize(uint64_t units);
+
+static void updateBuddyParents(BlockAllocator* pAllocator, uint64_t node, uint32_t order);
+
+Result createBlockAllocator(BlockAllocator* pAllocator, AllocationStrategy strategy, uint64_t size, uint64_t minBlockSize)
+{
+    pAllocator->strategy = strategy;
+    pAllocator->size = size;
+    pAllocator->usedSize = 0;
+    pAllocator->requestedSize = 0;
+    pAllocator->allocationCount = 0;
+    pAllocator->linearOffset = 0;
+    pAllocator->minBlockSize = minBlockSize;
+    pAllocator->maxOrder = 0;
+    pAllocator->pLongestFree = NULL;
+
+    if (strategy == ALLOCATION_STRATEGY_LINEAR)
+    {
+        return SUCCESS;
+    }
+
+    uint64_t leafCount = (minBlockSize > 0) ? size / minBlockSize : 0;
+    if ((leafCount == 0) || ((leafCount & (leafCount - 1)) != 0) || (leafCount * minBlockSize != size))
+    {
+        printError("Buddy allocator size %llu is not a power of two multiple of %llu!", (unsigned long long)size, (unsigned long long)minBlockSize);
+        return FAIL;
+    }
+
+    pAllocator->maxOrder = orderOfSize(leafCount);
+
+    // Implicit binary tree, each node holds (order + 1) of the largest free block below it or 0 if none
+    uint64_t nodeCount = leafCount * 2 - 1;
+    pAllocator->pLongestFree = malloc(nodeCount);
+    if (pAllocator->pLongestFree == NULL)
+    {
+        printError("Failed to allocate %llu bytes of memory for buddy allocator tree!", (unsigned long long)nodeCount);
+        return FAIL;
+    }
+
+    uint32_t order = pAllocator->maxOrder;
+    uint64_t levelEnd = 1;
+    for (uint64_t node = 0; node < nodeCount; ++node)
+    {
+        if (node == levelEnd)
+        {
+            --order;
+            levelEnd = levelEnd * 2 + 1;
+        }
+
+        pAllocator->pLongestFree[node] = (uint8_t)(order + 1);
+    }
+
+    return SUCCESS;
+}
+
+void destroyBlockAllocator(BlockAllocator* pAllocator)
+{
+    free(pAllocator->pLongestFree);
+    pAllocator->pLongestFree = NULL;
+}
+
+Result blockAllocate(BlockAllocator* pAllocator, uint64_t size, uint64_t alignment, uint64_t* pOffset)
+{
+    if (size == 0)
+    {
+        return FAIL;
+    }
+
+    if (alignment == 0)
+    {
+        alignment = 1;
+    }
+
+    if (pAllocator->strategy == ALLOCATION_STRATEGY_LINEAR)
+    {
+        uint64_t offset = alignUp(pAllocator->linearOffset, alignment);
+        if ((offset > pAllocator->size) || (size > pAllocator->size - offset))
+        {
+            return FAIL;
+        }
+
+        pAllocator->usedSize += offset + size - pAllocator->linearOffset;
+        pAllocator->requestedSize += size;
+        pAllocator->linearOffset = offset + size;
+        ++pAllocator->allocationCount;
+
+        *pOffset = offset;
+        return SUCCESS;
+    }
+
+    // Buddy blocks are naturally aligned to their own size, so alignment is honoured by rounding up to it
+    uint64_t blockSize = (size > alignment) ? size : alignment;
+    uint64_t units = (blockSize + pAllocator->minBlockSize - 1) / pAllocator->minBlockSize;
+    uint32_t order = orderOfSize(units);
+
+    if ((order > pAllocator->maxOrder) || (pAllocator->pLongestFree[0] < order + 1))
+    {
+        return FAIL;
+    }
+
+    uint64_t node = 0;
+    for (uint32_t nodeOrder = pAllocator->maxOrder; nodeOrder != order; --nodeOrder)
+    {
+        uint64_t left = node * 2 + 1;
+        node = (pAllocator->pLongestFree[left] >= order + 1) ? left : left + 1;
+    }
+
+    pAllocator->pLongestFree[node] = 0;
+    updateBuddyParents(pAllocator, node, order);
+
+    uint64_t firstNodeOfLevel = (1ull << (pAllocator->maxOrder - order)) - 1;
+    uint64_t blockBytes = pAllocator->minBlockSize << order;
+
+    pAllocator->usedSize += blockBytes;
+    pAllocator->requestedSize += size;
+    ++pAllocator->allocationCount;
+
+    *pOffset = (node - firstNodeOfLevel) * blockBytes;
+    return SUCCESS;
+}
+
+void blockFree(BlockAllocator* pAllocator, uint64_t offset, uint64_t size)
+{
+    pAllocator->requestedSize -= size;
+    --pAllocator->allocationCount;
+
+    if (pAllocator->strategy == ALLOCATION_STRATEGY_LINEAR)
+    {
+        // Individual frees cannot be reused, the whole range is reclaimed when the last one goes away
+        if (pAllocator->allocationCount == 0)
+        {
+            pAllocator->usedSize = 0;
+            pAllocator->linearOffset = 0;
+        }
+        return;
+    }
+
+    // Climb from the leaf at the offset to the node that was handed out, it is the first one marked used
+    uint64_t leafCount = 1ull << pAllocator->maxOrder;
+    uint64_t node = offset / pAllocator->minBlockSize + leafCount - 1;
+    uint32_t order = 0;
+
+    while (pAllocator->pLongestFree[node] != 0)
+    {
+        node = (node - 1) / 2;
+        ++order;
+    }
+
+    pAllocator->pLongestFree[node] = (uint8_t)(order + 1);
+    pAllocator->usedSize -= pAllocator->minBlockSize << order;
+
+    updateBuddyParents(pAllocator, node, order);
+}
+
+void getBlockAllocatorStats(const BlockAllocator* pAllocator, BlockAllocatorStats* pStats)
+{
+    pStats->size = pAllocator->size;
+    pStats->usedSize = pAllocator->usedSize;
+    pStats->requestedSize = pAllocator->requestedSize;
+    pStats->allocationCount = pAllocator->allocationCount;
+
+    if (pAllocator->strategy == ALLOCATION_STRATEGY_LINEAR)
+    {
+        pStats->largestFreeRegion = pAllocator->size - pAllocator->linearOffset;
+    }
+    else
+    {
+        uint8_t longest = pAllocator->pLongestFree[0];
+        pStats->largestFreeRegion = (longest > 0) ? (pAllocator->minBlockSize << (longest - 1)) : 0;
+    }
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t orderOfSize(uint64_t units)
+{
+    uint32_t order = 0;
+    while ((1ull << order) < units)
+    {
+        ++order;
+    }
+    return order;
+}
+
+void updateBuddyParents(BlockAllocator* pAllocator, uint64_t node, uint32_t order)
+{
+    uint8_t* pLongestFree = pAllocator->pLongestFree;
+
+    while (node != 0)
+    {
+        node = (node - 1) / 2;
+        ++order;
+
+        uint8_t left = pLongestFree[node * 2 + 1];
+        uint8_t right = pLongestFree[node * 2 + 2];
+
+        // Two untouched children merge back into one free block of the parent's size
+        if ((left == order) && (right == order))
+        {
+            pLongestFree[node] = (uint8_t)(order + 1);
+        }
+        else
+        {
+            pLongestFree[node] = (left > right) ? left : right;
+        }
+    }
+}
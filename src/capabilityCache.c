@@ -0,0 +1,243 @@
+#include "capabilityCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "extensions.h"
+
+#define CAPABILITY_CACHE_FILE_MAGIC     0x43435656u // "VVCC"
+#define CAPABILITY_CACHE_FILE_VERSION   1u
+#define MAX_CAPABILITY_RECORDS          64
+
+// Device extension lists are a few hundred entries at most
+#define CAPABILITY_ARENA_BLOCK_SIZE     (64 * 1024)
+
+typedef struct CapabilityCacheFileHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    recordCount;
+    uint32_t    reserved;
+    uint64_t    recordHash;
+} CapabilityCacheFileHeader;
+
+static Result readCapabilityCacheFile(CapabilityCache* pCache);
+
+static Result queryDeviceCapabilities(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceProperties* pProperties, DeviceCapabilities* pCapabilities);
+
+Result loadCapabilityCache(CapabilityCache* pCache, const char* pPath)
+{
+    memset(pCache, 0, sizeof(CapabilityCache));
+
+    pCache->pRecords = malloc(MAX_CAPABILITY_RECORDS * sizeof(DeviceCapabilities));
+    if (pCache->pRecords == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for device capabilities!", MAX_CAPABILITY_RECORDS * sizeof(DeviceCapabilities));
+        return FAIL;
+    }
+
+    if (pPath == NULL)
+    {
+        return SUCCESS;
+    }
+
+    pCache->pPath = strdup(pPath);
+    if (pCache->pPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for capability cache path!", strlen(pPath) + 1);
+        destroyCapabilityCache(pCache);
+        return FAIL;
+    }
+
+    if (readCapabilityCacheFile(pCache) != SUCCESS)
+    {
+        // Starts over and replaces the file once the devices have been queried again
+        pCache->recordCount = 0;
+        pCache->dirty = SDL_TRUE;
+    }
+
+    return SUCCESS;
+}
+
+Result saveCapabilityCache(CapabilityCache* pCache)
+{
+    if ((pCache->pPath == NULL) || (pCache->dirty != SDL_TRUE))
+    {
+        return SUCCESS;
+    }
+
+    CapabilityCacheFileHeader header;
+    header.magic = CAPABILITY_CACHE_FILE_MAGIC;
+    header.version = CAPABILITY_CACHE_FILE_VERSION;
+    header.recordCount = pCache->recordCount;
+    header.reserved = 0;
+    header.recordHash = hashBytes(pCache->pRecords, pCache->recordCount * sizeof(DeviceCapabilities), HASH_SEED);
+
+    // Written next to the target and renamed like the pipeline cache
+    size_t temporaryPathSize = strlen(pCache->pPath) + 5;
+    char* pTemporaryPath = malloc(temporaryPathSize);
+    if (pTemporaryPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for temporary capability cache path!", temporaryPathSize);
+        return FAIL;
+    }
+
+    snprintf(pTemporaryPath, temporaryPathSize, "%s.tmp", pCache->pPath);
+
+    FILE* pFile = fopen(pTemporaryPath, "wb");
+    if (pFile == NULL)
+    {
+        printError("Failed to open file \"%s\" for writing!", pTemporaryPath);
+        free(pTemporaryPath);
+        return FAIL;
+    }
+
+    SDL_bool written = (fwrite(&header, sizeof(header), 1, pFile) == 1)
+                       && (fwrite(pCache->pRecords, sizeof(DeviceCapabilities), pCache->recordCount, pFile) == pCache->recordCount);
+    written = (fclose(pFile) == 0) && written;
+
+    if ((written != SDL_TRUE) || (replaceFile(pTemporaryPath, pCache->pPath) != SUCCESS))
+    {
+        printError("Failed to write capability cache to \"%s\"!", pCache->pPath);
+        remove(pTemporaryPath);
+        free(pTemporaryPath);
+        return FAIL;
+    }
+
+    free(pTemporaryPath);
+
+    pCache->dirty = SDL_FALSE;
+
+    return SUCCESS;
+}
+
+void destroyCapabilityCache(CapabilityCache* pCache)
+{
+    free(pCache->pRecords);
+    free(pCache->pPath);
+    memset(pCache, 0, sizeof(CapabilityCache));
+}
+
+Result getDeviceCapabilities(CapabilityCache* pCache, VkPhysicalDevice physicalDevice, const VkPhysicalDeviceProperties* pProperties, DeviceCapabilities* pCapabilities)
+{
+    for (uint32_t i = 0; i < pCache->recordCount; ++i)
+    {
+        const DeviceCapabilities* pRecord = &pCache->pRecords[i];
+        if ((pRecord->vendorID == pProperties->vendorID) && (pRecord->deviceID == pProperties->deviceID)
+            && (pRecord->driverVersion == pProperties->driverVersion) && (pRecord->apiVersion == pProperties->apiVersion))
+        {
+            *pCapabilities = *pRecord;
+            ++pCache->hitCount;
+            return SUCCESS;
+        }
+    }
+
+    if (queryDeviceCapabilities(physicalDevice, pProperties, pCapabilities) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    ++pCache->missCount;
+
+    // Records of drivers that have since been updated would pile up, so a full cache starts over
+    if (pCache->recordCount == MAX_CAPABILITY_RECORDS)
+    {
+        pCache->recordCount = 0;
+    }
+
+    pCache->pRecords[pCache->recordCount++] = *pCapabilities;
+    pCache->dirty = SDL_TRUE;
+
+    return SUCCESS;
+}
+
+Result readCapabilityCacheFile(CapabilityCache* pCache)
+{
+    FILE* pFile = fopen(pCache->pPath, "rb");
+    if (pFile == NULL)
+    {
+        // Nothing cached yet is the normal cold start
+        return SUCCESS;
+    }
+
+    CapabilityCacheFileHeader header;
+    SDL_bool valid = (fread(&header, sizeof(header), 1, pFile) == 1)
+                     && (header.magic == CAPABILITY_CACHE_FILE_MAGIC)
+                     && (header.version == CAPABILITY_CACHE_FILE_VERSION)
+                     && (header.recordCount <= MAX_CAPABILITY_RECORDS);
+
+    if (valid == SDL_TRUE)
+    {
+        valid = (fread(pCache->pRecords, sizeof(DeviceCapabilities), header.recordCount, pFile) == header.recordCount)
+                && (hashBytes(pCache->pRecords, header.recordCount * sizeof(DeviceCapabilities), HASH_SEED) == header.recordHash);
+    }
+
+    fclose(pFile);
+
+    if (valid != SDL_TRUE)
+    {
+        printf("Capability cache \"%s\" is damaged or of another version, dropping it\n\n", pCache->pPath);
+        return FAIL;
+    }
+
+    pCache->recordCount = header.recordCount;
+
+    return SUCCESS;
+}
+
+Result queryDeviceCapabilities(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceProperties* pProperties, DeviceCapabilities* pCapabilities)
+{
+    memset(pCapabilities, 0, sizeof(DeviceCapabilities));
+    pCapabilities->vendorID = pProperties->vendorID;
+    pCapabilities->deviceID = pProperties->deviceID;
+    pCapabilities->driverVersion = pProperties->driverVersion;
+    pCapabilities->apiVersion = pProperties->apiVersion;
+
+    Arena arena;
+    createArena(&arena, CAPABILITY_ARENA_BLOCK_SIZE);
+
+    uint32_t                  extensionCount;
+    VkExtensionProperties*    pExtensions;
+
+    if (getAvailableDeviceExtensions(&arena, physicalDevice, &extensionCount, &pExtensions) != SUCCESS)
+    {
+        printError("Failed to get available device extensions!");
+        destroyArena(&arena);
+        return FAIL;
+    }
+
+    if (hasExtension(extensionCount, pExtensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == SDL_TRUE)
+    {
+        pCapabilities->flags |= DEVICE_CAPABILITY_SWAPCHAIN;
+    }
+
+    destroyArena(&arena);
+
+    // The Vulkan 1.2 feature structure must not be chained for older devices
+    if (pProperties->apiVersion >= VK_API_VERSION_1_2)
+    {
+        VkPhysicalDeviceVulkan12Features features12;
+        memset(&features12, 0, sizeof(features12));
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features;
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &features12;
+
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+        if (features12.timelineSemaphore == VK_TRUE)
+        {
+            pCapabilities->flags |= DEVICE_CAPABILITY_TIMELINE_SEMAPHORE;
+        }
+
+        if (features12.drawIndirectCount == VK_TRUE)
+        {
+            pCapabilities->flags |= DEVICE_CAPABILITY_DRAW_INDIRECT_COUNT;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,444 @@
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "deviceSelection.h"
+#include "meshCache.h"
+#include "texture.h"
+#include "tileFile.h"
+
+static Result parseUnsigned(const char* pOption, const char* pText, uint32_t* pValue);
+
+void setDefaultConfig(Config* pConfig)
+{
+    pConfig->showHelp = SDL_FALSE;
+    pConfig->verbose = SDL_FALSE;
+    pConfig->timing = SDL_FALSE;
+#ifdef VIEWER_VALIDATION
+    pConfig->validation = VIEWER_DEFAULT_VALIDATION;
+#else
+    pConfig->validation = VALIDATION_LEVEL_OFF;
+#endif
+    pConfig->headless = SDL_FALSE;
+    pConfig->width = DEFAULT_WIDTH;
+    pConfig->height = DEFAULT_HEIGHT;
+    pConfig->framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    pConfig->presentMode = PRESENT_MODE_OPTION_DEFAULT;
+    pConfig->swapchainImageCount = 0;
+    pConfig->targetFps = 0;
+    pConfig->frameLimit = 0;
+    pConfig->pPipelineCachePath = NULL;
+    pConfig->pipelineThreadCount = 0;
+    pConfig->recordThreadCount = 0;
+    pConfig->pMeshPath = NULL;
+    pConfig->verifyMeshCache = SDL_FALSE;
+    pConfig->pTexturePath = NULL;
+    pConfig->pVirtualTexturePath = NULL;
+    pConfig->virtualTextureBudgetMb = DEFAULT_VIRTUAL_TEXTURE_MB;
+    pConfig->gridTriangleCount = 0;
+    pConfig->drawCount = 1;
+    pConfig->gpuCulling = SDL_FALSE;
+    pConfig->cpuCulling = CPU_CULLING_OPTION_OFF;
+    pConfig->instancing = SDL_FALSE;
+    pConfig->sortDraws = SDL_TRUE;
+    pConfig->timeStepMs = 0;
+    pConfig->pConvertPath = NULL;
+    pConfig->pProfilePath = NULL;
+    pConfig->pCpuTracePath = NULL;
+
+    // The environment picks the device for every run, --device still overrides it
+    pConfig->pDevice = getenv(DEVICE_ENVIRONMENT_VARIABLE);
+}
+
+Result parseCommandLine(int argc, char* argv[], Config* pConfig)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* pOption = argv[i];
+
+        if ((strcmp(pOption, "-h") == 0) || (strcmp(pOption, "--help") == 0))
+        {
+            pConfig->showHelp = SDL_TRUE;
+            continue;
+        }
+
+        if (strcmp(pOption, "--verbose") == 0)
+        {
+            pConfig->verbose = SDL_TRUE;
+            continue;
+        }
+
+        if (strcmp(pOption, "--timing") == 0)
+        {
+            pConfig->timing = SDL_TRUE;
+            continue;
+        }
+
+        if (strcmp(pOption, "--headless") == 0)
+        {
+            pConfig->headless = SDL_TRUE;
+            continue;
+        }
+
+        if (strcmp(pOption, "--gpu-culling") == 0)
+        {
+            pConfig->gpuCulling = SDL_TRUE;
+            continue;
+        }
+
+        if (strcmp(pOption, "--instancing") == 0)
+        {
+            pConfig->instancing = SDL_TRUE;
+            continue;
+        }
+
+        if (strcmp(pOption, "--verify-mesh-cache") == 0)
+        {
+            pConfig->verifyMeshCache = SDL_TRUE;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            printError("Unknown option \"%s\" or missing value!", pOption);
+            return FAIL;
+        }
+
+        const char* pValue = argv[++i];
+
+        if (strcmp(pOption, "--frames-in-flight") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->framesInFlight) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            if ((pConfig->framesInFlight < 1) || (pConfig->framesInFlight > MAX_FRAMES_IN_FLIGHT))
+            {
+                printError("Frames in flight must be in range [1, %u]!", MAX_FRAMES_IN_FLIGHT);
+                return FAIL;
+            }
+        }
+        else if ((strcmp(pOption, "--width") == 0) || (strcmp(pOption, "--height") == 0))
+        {
+            uint32_t* pSize = (pOption[2] == 'w') ? &pConfig->width : &pConfig->height;
+            if (parseUnsigned(pOption, pValue, pSize) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            if (*pSize == 0)
+            {
+                printError("Option \"%s\" must be greater than zero!", pOption);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--present-mode") == 0)
+        {
+            if (strcmp(pValue, "fifo") == 0)
+            {
+                pConfig->presentMode = PRESENT_MODE_OPTION_FIFO;
+            }
+            else if (strcmp(pValue, "fifo-relaxed") == 0)
+            {
+                pConfig->presentMode = PRESENT_MODE_OPTION_FIFO_RELAXED;
+            }
+            else if (strcmp(pValue, "mailbox") == 0)
+            {
+                pConfig->presentMode = PRESENT_MODE_OPTION_MAILBOX;
+            }
+            else if (strcmp(pValue, "immediate") == 0)
+            {
+                pConfig->presentMode = PRESENT_MODE_OPTION_IMMEDIATE;
+            }
+            else
+            {
+                printError("Invalid value \"%s\" for option \"%s\"!", pValue, pOption);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--swapchain-images") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->swapchainImageCount) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--fps") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->targetFps) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--frames") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->frameLimit) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--pipeline-cache") == 0)
+        {
+            pConfig->pPipelineCachePath = pValue;
+        }
+        else if (strcmp(pOption, "--pipeline-threads") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->pipelineThreadCount) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--record-threads") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->recordThreadCount) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            if (pConfig->recordThreadCount > MAX_RECORD_THREADS)
+            {
+                printError("Record threads must be in range [0, %u]!", MAX_RECORD_THREADS);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--mesh") == 0)
+        {
+            pConfig->pMeshPath = pValue;
+        }
+        else if (strcmp(pOption, "--texture") == 0)
+        {
+            pConfig->pTexturePath = pValue;
+        }
+        else if (strcmp(pOption, "--virtual-texture") == 0)
+        {
+            pConfig->pVirtualTexturePath = pValue;
+        }
+        else if (strcmp(pOption, "--virtual-texture-budget") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->virtualTextureBudgetMb) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            if (pConfig->virtualTextureBudgetMb == 0)
+            {
+                printError("Option \"%s\" must be greater than zero!", pOption);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--grid") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->gridTriangleCount) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--draws") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->drawCount) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            if (pConfig->drawCount == 0)
+            {
+                printError("Option \"%s\" must be greater than zero!", pOption);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--cpu-culling") == 0)
+        {
+            if (strcmp(pValue, "off") == 0)
+            {
+                pConfig->cpuCulling = CPU_CULLING_OPTION_OFF;
+            }
+            else if (strcmp(pValue, "auto") == 0)
+            {
+                pConfig->cpuCulling = CPU_CULLING_OPTION_AUTO;
+            }
+            else if (strcmp(pValue, "scalar") == 0)
+            {
+                pConfig->cpuCulling = CPU_CULLING_OPTION_SCALAR;
+            }
+            else if (strcmp(pValue, "sse") == 0)
+            {
+                pConfig->cpuCulling = CPU_CULLING_OPTION_SSE;
+            }
+            else if (strcmp(pValue, "avx") == 0)
+            {
+                pConfig->cpuCulling = CPU_CULLING_OPTION_AVX;
+            }
+            else
+            {
+                printError("Invalid value \"%s\" for option \"%s\"!", pValue, pOption);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--draw-order") == 0)
+        {
+            if (strcmp(pValue, "front-to-back") == 0)
+            {
+                pConfig->sortDraws = SDL_TRUE;
+            }
+            else if (strcmp(pValue, "submission") == 0)
+            {
+                pConfig->sortDraws = SDL_FALSE;
+            }
+            else
+            {
+                printError("Invalid value \"%s\" for option \"%s\"!", pValue, pOption);
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--time-step") == 0)
+        {
+            if (parseUnsigned(pOption, pValue, &pConfig->timeStepMs) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+        else if (strcmp(pOption, "--convert") == 0)
+        {
+            pConfig->pConvertPath = pValue;
+        }
+        else if (strcmp(pOption, "--profile") == 0)
+        {
+            pConfig->pProfilePath = pValue;
+        }
+        else if (strcmp(pOption, "--cpu-trace") == 0)
+        {
+            pConfig->pCpuTracePath = pValue;
+        }
+        else if (strcmp(pOption, "--device") == 0)
+        {
+            pConfig->pDevice = pValue;
+        }
+        else if (strcmp(pOption, "--validation") == 0)
+        {
+            if (strcmp(pValue, "off") == 0)
+            {
+                pConfig->validation = VALIDATION_LEVEL_OFF;
+            }
+            else if (strcmp(pValue, "standard") == 0)
+            {
+                pConfig->validation = VALIDATION_LEVEL_STANDARD;
+            }
+            else if (strcmp(pValue, "sync") == 0)
+            {
+                pConfig->validation = VALIDATION_LEVEL_SYNC;
+            }
+            else if (strcmp(pValue, "gpu") == 0)
+            {
+                pConfig->validation = VALIDATION_LEVEL_GPU;
+            }
+            else
+            {
+                printError("Unknown validation level \"%s\"!", pValue);
+                return FAIL;
+            }
+
+#ifndef VIEWER_VALIDATION
+            if (pConfig->validation != VALIDATION_LEVEL_OFF)
+            {
+                printError("Validation is compiled out of this build, configure it with -DVIEWER_VALIDATION=ON!");
+                return FAIL;
+            }
+#endif
+        }
+        else
+        {
+            printError("Unknown option \"%s\"!", pOption);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+void printUsage(const char* pProgramName)
+{
+#ifdef VIEWER_VALIDATION
+    const char* pDefaultValidation = getValidationLevelName(VIEWER_DEFAULT_VALIDATION);
+#else
+    const char* pDefaultValidation = "off, compiled out of this build";
+#endif
+
+    printf("Usage: %s [options]\n", pProgramName);
+    printf("    -h, --help                  Show this message\n");
+    printf("    --verbose                   List the available layers, extensions and devices at startup\n");
+    printf("    --timing                    Print how long every startup step took and when the first frame was submitted\n");
+    printf("    --validation <level>        off, standard, sync (adds synchronization validation) or gpu (adds GPU-assisted validation\n");
+    printf("                                and best practices), falls back to off when the layer is missing (default %s)\n", pDefaultValidation);
+    printf("    --headless                  Render to offscreen images without a window or surface\n");
+    printf("    --width <n>                 Width of the window or offscreen images (default %u)\n", DEFAULT_WIDTH);
+    printf("    --height <n>                Height of the window or offscreen images (default %u)\n", DEFAULT_HEIGHT);
+    printf("    --device <device>           Index, UUID or part of the name of the device to render on, overrides %s\n", DEVICE_ENVIRONMENT_VARIABLE);
+    printf("                                (default is the fastest suitable device, discrete GPUs first)\n");
+    printf("    --frames-in-flight <n>      Number of frames the CPU may record ahead of the GPU (1-%u, default %u)\n", MAX_FRAMES_IN_FLIGHT, DEFAULT_FRAMES_IN_FLIGHT);
+    printf("    --present-mode <mode>       fifo, fifo-relaxed, mailbox or immediate, falls back to fifo when unsupported\n");
+    printf("                                (default is mailbox when supported and fifo otherwise)\n");
+    printf("    --swapchain-images <n>      Swapchain images to ask for, clamped to what the surface allows (0 = one more than the minimum, default)\n");
+    printf("    --fps <n>                   Limit the frame rate to n, on top of what the present mode allows (0 = uncapped, default)\n");
+    printf("    --frames <n>                Exit after rendering n frames (0 = run until closed)\n");
+    printf("    --pipeline-cache <path>     Pipeline cache file (default is in the user preferences directory)\n");
+    printf("    --pipeline-threads <n>      Threads compiling pipelines (0 = one per CPU core, default)\n");
+    printf("    --record-threads <n>        Split the draws across n threads recording secondary command buffers (0-%u, 0 = main thread, default)\n", MAX_RECORD_THREADS);
+    printf("    --mesh <path>               Mesh to display, Wavefront .obj or binary glTF .glb (default is a triangle)\n");
+    printf("                                Models are cached next to the source as <path>%s and reloaded from there\n", MESH_CACHE_EXTENSION);
+    printf("    --verify-mesh-cache         Hash the whole mesh cache and its model on load instead of trusting their size and time\n");
+    printf("    --texture <path>            Texture of the mesh, PNG, JPEG or KTX2 with BC1, BC3 or BC7 blocks (default is white)\n");
+    printf("                                A PNG or JPEG is replaced by <name>%s next to it when the device supports its format\n", KTX2_EXTENSION);
+    printf("    --virtual-texture <path>    Stream a texture of any size into a cache of fixed size instead of --texture, PNG or JPEG\n");
+    printf("                                Tiles are written next to the source as <path>%s on first use\n", TILE_FILE_EXTENSION);
+    printf("    --virtual-texture-budget <MiB>\n");
+    printf("                                Device memory of the virtual texture cache and its staging tiles (default %u)\n", DEFAULT_VIRTUAL_TEXTURE_MB);
+    printf("    --grid <n>                  Display a generated grid of n triangles instead of a model\n");
+    printf("    --draws <n>                 Draw the mesh n times per frame, laid out on a square grid (default 1)\n");
+    printf("    --gpu-culling               Cull the draws against the view in a compute shader and draw them indirectly\n");
+    printf("    --cpu-culling <mode>        Cull the draws against the view on all CPU cores before recording them: off (default),\n");
+    printf("                                auto for the widest instruction set the CPU supports, scalar, sse or avx\n");
+    printf("                                Also used when --gpu-culling is not supported by the device\n");
+    printf("    --instancing                Batch draws of the same mesh and material into instanced draws\n");
+    printf("    --draw-order <order>        front-to-back (default) sorts the draws by pipeline, material and depth before recording them,\n");
+    printf("                                submission keeps the grid order. Draws culled on the GPU or instanced are not sorted\n");
+    printf("    --time-step <ms>            Advance the animation by a fixed step per frame instead of by the clock (0 = clock, default)\n");
+    printf("    --convert <path>            Write the mesh cache of a model and exit without rendering\n");
+    printf("    --profile <path>            Write GPU timings of every frame, as a Chrome trace for .json and as CSV otherwise\n");
+    printf("    --cpu-trace <path>          Record CPU scopes and write them as a Chrome trace on exit, T pauses and resumes\n");
+    printf("\n");
+}
+
+Result parseUnsigned(const char* pOption, const char* pText, uint32_t* pValue)
+{
+    char* pEnd = NULL;
+    errno = 0;
+    unsigned long value = strtoul(pText, &pEnd, 10);
+
+    if ((errno != 0) || (pText[0] == '-') || (pEnd == pText) || (*pEnd != '\0') || (value > UINT32_MAX))
+    {
+        printError("Invalid value \"%s\" for option \"%s\"!", pText, pOption);
+        return FAIL;
+    }
+
+    *pValue = (uint32_t)value;
+    return SUCCESS;
+}
+
+const char* getValidationLevelName(ValidationLevel level)
+{
+    switch (level)
+    {
+        case VALIDATION_LEVEL_STANDARD:
+            return "standard";
+        case VALIDATION_LEVEL_SYNC:
+            return "sync";
+        case VALIDATION_LEVEL_GPU:
+            return "gpu";
+        default:
+            return "off";
+    }
+}
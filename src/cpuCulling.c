@@ -0,0 +1,338 @@
+#include "cpuCulling.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CULLING_X86
+#include <immintrin.h>
+#endif
+
+// Only the AVX kernel is compiled for AVX, the rest of the viewer keeps running on CPUs without it
+#if defined(CULLING_X86) && defined(__GNUC__)
+#define TARGET_AVX __attribute__((target("avx")))
+#else
+#define TARGET_AVX
+#endif
+
+#define BOUNDS_ALIGNMENT    32
+
+static void cullChunk(void* pUserData);
+
+static uint32_t cullRangeScalar(const ObjectBounds* pBounds, const float pPlanes[6][4], float radiusScale, uint32_t first, uint32_t end, uint32_t* pVisibleObjects);
+
+#ifdef CULLING_X86
+static uint32_t cullRangeSse(const ObjectBounds* pBounds, const float pPlanes[6][4], float radiusScale, uint32_t first, uint32_t end, uint32_t* pVisibleObjects);
+
+static TARGET_AVX uint32_t cullRangeAvx(const ObjectBounds* pBounds, const float pPlanes[6][4], float radiusScale, uint32_t first, uint32_t end, uint32_t* pVisibleObjects);
+#endif
+
+Result createObjectBounds(ObjectBounds* pBounds, uint32_t objectCount)
+{
+    // Every array starts on a vector boundary, the padding is never read
+    size_t arraySize = ((size_t)objectCount * sizeof(float) + BOUNDS_ALIGNMENT - 1) / BOUNDS_ALIGNMENT * BOUNDS_ALIGNMENT;
+
+    float* pData = SDL_SIMDAlloc(4 * arraySize + BOUNDS_ALIGNMENT);
+    if (pData == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for object bounds!", 4 * arraySize + BOUNDS_ALIGNMENT);
+        return FAIL;
+    }
+
+    memset(pData, 0, 4 * arraySize);
+
+    pBounds->objectCount = objectCount;
+    pBounds->pCenterX = pData;
+    pBounds->pCenterY = (float*)((char*)pData + arraySize);
+    pBounds->pCenterZ = (float*)((char*)pData + 2 * arraySize);
+    pBounds->pRadii = (float*)((char*)pData + 3 * arraySize);
+
+    return SUCCESS;
+}
+
+void destroyObjectBounds(ObjectBounds* pBounds)
+{
+    SDL_SIMDFree(pBounds->pCenterX);
+    pBounds->pCenterX = NULL;
+    pBounds->pCenterY = NULL;
+    pBounds->pCenterZ = NULL;
+    pBounds->pRadii = NULL;
+    pBounds->objectCount = 0;
+}
+
+CullingInstructionSet getBestCullingInstructionSet(void)
+{
+    if (isCullingInstructionSetSupported(CULLING_INSTRUCTION_SET_AVX) == SDL_TRUE)
+    {
+        return CULLING_INSTRUCTION_SET_AVX;
+    }
+
+    if (isCullingInstructionSetSupported(CULLING_INSTRUCTION_SET_SSE) == SDL_TRUE)
+    {
+        return CULLING_INSTRUCTION_SET_SSE;
+    }
+
+    return CULLING_INSTRUCTION_SET_SCALAR;
+}
+
+SDL_bool isCullingInstructionSetSupported(CullingInstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+        case CULLING_INSTRUCTION_SET_SCALAR:
+            return SDL_TRUE;
+    #ifdef CULLING_X86
+        case CULLING_INSTRUCTION_SET_SSE:
+            return SDL_HasSSE2();
+        case CULLING_INSTRUCTION_SET_AVX:
+            return SDL_HasAVX();
+    #endif
+        default:
+            return SDL_FALSE;
+    }
+}
+
+const char* getCullingInstructionSetName(CullingInstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+        case CULLING_INSTRUCTION_SET_SSE:
+            return "SSE";
+        case CULLING_INSTRUCTION_SET_AVX:
+            return "AVX";
+        default:
+            return "scalar";
+    }
+}
+
+Result createCpuCulling(CpuCulling* pCulling, const ObjectBounds* pBounds, ThreadPool* pThreadPool, CullingInstructionSet instructionSet)
+{
+    memset(pCulling, 0, sizeof(CpuCulling));
+    pCulling->pBounds = pBounds;
+    pCulling->pThreadPool = pThreadPool;
+    pCulling->instructionSet = instructionSet;
+    pCulling->chunkCount = (pBounds->objectCount + CPU_CULLING_CHUNK_SIZE - 1) / CPU_CULLING_CHUNK_SIZE;
+
+    if (isCullingInstructionSetSupported(instructionSet) != SDL_TRUE)
+    {
+        printError("CPU does not support %s!", getCullingInstructionSetName(instructionSet));
+        return FAIL;
+    }
+
+    // One more than needed, so neither allocation is empty without objects
+    pCulling->pChunks = calloc(pCulling->chunkCount + 1, sizeof(CullingChunk));
+    if (pCulling->pChunks == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for culling chunks!", (pCulling->chunkCount + 1) * sizeof(CullingChunk));
+        destroyCpuCulling(pCulling);
+        return FAIL;
+    }
+
+    pCulling->pVisibleObjects = malloc((pBounds->objectCount + 1) * sizeof(uint32_t));
+    if (pCulling->pVisibleObjects == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for visible objects!", (pBounds->objectCount + 1) * sizeof(uint32_t));
+        destroyCpuCulling(pCulling);
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < pCulling->chunkCount; ++i)
+    {
+        CullingChunk* pChunk = &pCulling->pChunks[i];
+        pChunk->pCulling = pCulling;
+        pChunk->firstObject = i * CPU_CULLING_CHUNK_SIZE;
+        pChunk->objectCount = SDL_min(CPU_CULLING_CHUNK_SIZE, pBounds->objectCount - pChunk->firstObject);
+    }
+
+    return SUCCESS;
+}
+
+void destroyCpuCulling(CpuCulling* pCulling)
+{
+    free(pCulling->pVisibleObjects);
+    pCulling->pVisibleObjects = NULL;
+
+    free(pCulling->pChunks);
+    pCulling->pChunks = NULL;
+}
+
+uint32_t cullObjects(CpuCulling* pCulling, const float pPlanes[6][4], float radiusScale)
+{
+    memcpy(pCulling->pPlanes, pPlanes, sizeof(pCulling->pPlanes));
+    pCulling->radiusScale = radiusScale;
+
+    // The calling thread takes the first chunk instead of only waiting, a single chunk never leaves it
+    for (uint32_t i = 1; i < pCulling->chunkCount; ++i)
+    {
+        if ((pCulling->pThreadPool == NULL) || (submitJob(pCulling->pThreadPool, cullChunk, &pCulling->pChunks[i]) != SUCCESS))
+        {
+            cullChunk(&pCulling->pChunks[i]);
+        }
+    }
+
+    if (pCulling->chunkCount > 0)
+    {
+        cullChunk(&pCulling->pChunks[0]);
+    }
+
+    if ((pCulling->pThreadPool != NULL) && (pCulling->chunkCount > 1))
+    {
+        waitForJobs(pCulling->pThreadPool);
+    }
+
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < pCulling->chunkCount; ++i)
+    {
+        const CullingChunk* pChunk = &pCulling->pChunks[i];
+        if (visibleCount != pChunk->firstObject)
+        {
+            memmove(&pCulling->pVisibleObjects[visibleCount], &pCulling->pVisibleObjects[pChunk->firstObject], pChunk->visibleCount * sizeof(uint32_t));
+        }
+
+        visibleCount += pChunk->visibleCount;
+    }
+
+    return visibleCount;
+}
+
+void cullChunk(void* pUserData)
+{
+    CullingChunk* pChunk = pUserData;
+    const CpuCulling* pCulling = pChunk->pCulling;
+
+    uint32_t first = pChunk->firstObject;
+    uint32_t end = first + pChunk->objectCount;
+    uint32_t* pVisibleObjects = &pCulling->pVisibleObjects[first];
+
+    switch (pCulling->instructionSet)
+    {
+#ifdef CULLING_X86
+        case CULLING_INSTRUCTION_SET_SSE:
+            pChunk->visibleCount = cullRangeSse(pCulling->pBounds, pCulling->pPlanes, pCulling->radiusScale, first, end, pVisibleObjects);
+            break;
+        case CULLING_INSTRUCTION_SET_AVX:
+            pChunk->visibleCount = cullRangeAvx(pCulling->pBounds, pCulling->pPlanes, pCulling->radiusScale, first, end, pVisibleObjects);
+            break;
+#endif
+        default:
+            pChunk->visibleCount = cullRangeScalar(pCulling->pBounds, pCulling->pPlanes, pCulling->radiusScale, first, end, pVisibleObjects);
+            break;
+    }
+}
+
+// The kernels write an index for every object and only advance past the visible ones, which keeps the compaction
+// free of branches. No write lands past the slot of the object being tested, so chunks stay within their own range.
+
+uint32_t cullRangeScalar(const ObjectBounds* pBounds, const float pPlanes[6][4], float radiusScale, uint32_t first, uint32_t end, uint32_t* pVisibleObjects)
+{
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = first; i < end; ++i)
+    {
+        float x = pBounds->pCenterX[i];
+        float y = pBounds->pCenterY[i];
+        float z = pBounds->pCenterZ[i];
+        float negativeRadius = -pBounds->pRadii[i] * radiusScale;
+
+        uint32_t visible = 1;
+        for (uint32_t j = 0; j < 6; ++j)
+        {
+            float distance = pPlanes[j][0] * x + pPlanes[j][1] * y + pPlanes[j][2] * z + pPlanes[j][3];
+            visible &= (distance >= negativeRadius);
+        }
+
+        pVisibleObjects[visibleCount] = i;
+        visibleCount += visible;
+    }
+
+    return visibleCount;
+}
+
+#ifdef CULLING_X86
+uint32_t cullRangeSse(const ObjectBounds* pBounds, const float pPlanes[6][4], float radiusScale, uint32_t first, uint32_t end, uint32_t* pVisibleObjects)
+{
+    __m128 pPlaneX[6];
+    __m128 pPlaneY[6];
+    __m128 pPlaneZ[6];
+    __m128 pPlaneW[6];
+    for (uint32_t j = 0; j < 6; ++j)
+    {
+        pPlaneX[j] = _mm_set1_ps(pPlanes[j][0]);
+        pPlaneY[j] = _mm_set1_ps(pPlanes[j][1]);
+        pPlaneZ[j] = _mm_set1_ps(pPlanes[j][2]);
+        pPlaneW[j] = _mm_set1_ps(pPlanes[j][3]);
+    }
+
+    __m128 negativeScale = _mm_set1_ps(-radiusScale);
+    uint32_t visibleCount = 0;
+    uint32_t i = first;
+
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&pBounds->pCenterX[i]);
+        __m128 y = _mm_loadu_ps(&pBounds->pCenterY[i]);
+        __m128 z = _mm_loadu_ps(&pBounds->pCenterZ[i]);
+        __m128 negativeRadius = _mm_mul_ps(_mm_loadu_ps(&pBounds->pRadii[i]), negativeScale);
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t j = 0; j < 6; ++j)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pPlaneX[j], x), _mm_mul_ps(pPlaneY[j], y)), _mm_add_ps(_mm_mul_ps(pPlaneZ[j], z), pPlaneW[j]));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        uint32_t mask = (uint32_t)_mm_movemask_ps(visible);
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            pVisibleObjects[visibleCount] = i + k;
+            visibleCount += (mask >> k) & 1;
+        }
+    }
+
+    return visibleCount + cullRangeScalar(pBounds, pPlanes, radiusScale, i, end, &pVisibleObjects[visibleCount]);
+}
+
+TARGET_AVX uint32_t cullRangeAvx(const ObjectBounds* pBounds, const float pPlanes[6][4], float radiusScale, uint32_t first, uint32_t end, uint32_t* pVisibleObjects)
+{
+    __m256 pPlaneX[6];
+    __m256 pPlaneY[6];
+    __m256 pPlaneZ[6];
+    __m256 pPlaneW[6];
+    for (uint32_t j = 0; j < 6; ++j)
+    {
+        pPlaneX[j] = _mm256_set1_ps(pPlanes[j][0]);
+        pPlaneY[j] = _mm256_set1_ps(pPlanes[j][1]);
+        pPlaneZ[j] = _mm256_set1_ps(pPlanes[j][2]);
+        pPlaneW[j] = _mm256_set1_ps(pPlanes[j][3]);
+    }
+
+    __m256 negativeScale = _mm256_set1_ps(-radiusScale);
+    uint32_t visibleCount = 0;
+    uint32_t i = first;
+
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(&pBounds->pCenterX[i]);
+        __m256 y = _mm256_loadu_ps(&pBounds->pCenterY[i]);
+        __m256 z = _mm256_loadu_ps(&pBounds->pCenterZ[i]);
+        __m256 negativeRadius = _mm256_mul_ps(_mm256_loadu_ps(&pBounds->pRadii[i]), negativeScale);
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t j = 0; j < 6; ++j)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(pPlaneX[j], x), _mm256_mul_ps(pPlaneY[j], y)),
+                _mm256_add_ps(_mm256_mul_ps(pPlaneZ[j], z), pPlaneW[j]));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+
+        uint32_t mask = (uint32_t)_mm256_movemask_ps(visible);
+        for (uint32_t k = 0; k < 8; ++k)
+        {
+            pVisibleObjects[visibleCount] = i + k;
+            visibleCount += (mask >> k) & 1;
+        }
+    }
+
+    return visibleCount + cullRangeScalar(pBounds, pPlanes, radiusScale, i, end, &pVisibleObjects[visibleCount]);
+}
+#endif
@@ -0,0 +1,223 @@
+#include "cpuTrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct CpuTraceEvent
+{
+    const char*    pName;
+    uint64_t       startTicks;
+    uint64_t       endTicks;
+} CpuTraceEvent;
+
+typedef struct CpuTraceBuffer
+{
+    unsigned long             threadId;
+    char                      pThreadName[CPU_TRACE_THREAD_NAME_SIZE];
+    uint64_t                  eventCount;
+    CpuTraceEvent             pEvents[CPU_TRACE_EVENT_COUNT];
+    struct CpuTraceBuffer*    pNext;
+} CpuTraceBuffer;
+
+typedef struct CpuTrace
+{
+    SDL_atomic_t       enabled;
+    char*              pOutputPath;
+    SDL_TLSID          bufferId;
+    SDL_mutex*         pMutex;
+    CpuTraceBuffer*    pBuffers;
+    uint64_t           startTicks;
+} CpuTrace;
+
+static CpuTrace trace;
+
+static CpuTraceBuffer* getThreadBuffer(void);
+
+static Result writeCpuTrace(void);
+
+Result createCpuTrace(const char* pOutputPath)
+{
+    memset(&trace, 0, sizeof(trace));
+    SDL_AtomicSet(&trace.enabled, 0);
+
+    if (pOutputPath == NULL)
+    {
+        return SUCCESS;
+    }
+
+    trace.pOutputPath = SDL_strdup(pOutputPath);
+    trace.pMutex = SDL_CreateMutex();
+    trace.bufferId = SDL_TLSCreate();
+
+    if ((trace.pOutputPath == NULL) || (trace.pMutex == NULL) || (trace.bufferId == 0))
+    {
+        printError("Failed to create CPU trace!");
+        destroyCpuTrace();
+        return FAIL;
+    }
+
+    trace.startTicks = SDL_GetPerformanceCounter();
+    SDL_AtomicSet(&trace.enabled, 1);
+
+    return SUCCESS;
+}
+
+void destroyCpuTrace(void)
+{
+    SDL_AtomicSet(&trace.enabled, 0);
+
+    if ((trace.pOutputPath != NULL) && (trace.pBuffers != NULL) && (writeCpuTrace() != SUCCESS))
+    {
+        printError("Failed to write CPU trace to \"%s\"!", trace.pOutputPath);
+    }
+
+    while (trace.pBuffers != NULL)
+    {
+        CpuTraceBuffer* pNext = trace.pBuffers->pNext;
+        free(trace.pBuffers);
+        trace.pBuffers = pNext;
+    }
+
+    if (trace.pMutex != NULL)
+    {
+        SDL_DestroyMutex(trace.pMutex);
+        trace.pMutex = NULL;
+    }
+
+    SDL_free(trace.pOutputPath);
+    trace.pOutputPath = NULL;
+}
+
+void setCpuTraceEnabled(SDL_bool enabled)
+{
+    if (trace.pOutputPath != NULL)
+    {
+        SDL_AtomicSet(&trace.enabled, (enabled == SDL_TRUE) ? 1 : 0);
+    }
+}
+
+SDL_bool isCpuTraceEnabled(void)
+{
+    return (SDL_AtomicGet(&trace.enabled) != 0) ? SDL_TRUE : SDL_FALSE;
+}
+
+void nameCpuTraceThread(const char* pName)
+{
+    if (trace.pOutputPath == NULL)
+    {
+        return;
+    }
+
+    CpuTraceBuffer* pBuffer = getThreadBuffer();
+    if (pBuffer != NULL)
+    {
+        SDL_strlcpy(pBuffer->pThreadName, pName, CPU_TRACE_THREAD_NAME_SIZE);
+    }
+}
+
+uint64_t beginCpuTrace(void)
+{
+    return (SDL_AtomicGet(&trace.enabled) != 0) ? SDL_GetPerformanceCounter() : 0;
+}
+
+void endCpuTrace(const char* pName, uint64_t startTicks)
+{
+    // Zero means tracing was off when the scope began
+    if (startTicks == 0)
+    {
+        return;
+    }
+
+    CpuTraceBuffer* pBuffer = getThreadBuffer();
+    if (pBuffer == NULL)
+    {
+        return;
+    }
+
+    CpuTraceEvent* pEvent = &pBuffer->pEvents[pBuffer->eventCount % CPU_TRACE_EVENT_COUNT];
+    pEvent->pName = pName;
+    pEvent->startTicks = startTicks;
+    pEvent->endTicks = SDL_GetPerformanceCounter();
+
+    ++pBuffer->eventCount;
+}
+
+CpuTraceBuffer* getThreadBuffer(void)
+{
+    CpuTraceBuffer* pBuffer = SDL_TLSGet(trace.bufferId);
+    if (pBuffer != NULL)
+    {
+        return pBuffer;
+    }
+
+    // Only the first event of a thread gets here, the buffer stays in the list after the thread exits
+    pBuffer = malloc(sizeof(CpuTraceBuffer));
+    if (pBuffer == NULL)
+    {
+        return NULL;
+    }
+
+    pBuffer->threadId = SDL_ThreadID();
+    pBuffer->pThreadName[0] = '\0';
+    pBuffer->eventCount = 0;
+
+    SDL_LockMutex(trace.pMutex);
+    pBuffer->pNext = trace.pBuffers;
+    trace.pBuffers = pBuffer;
+    SDL_UnlockMutex(trace.pMutex);
+
+    SDL_TLSSet(trace.bufferId, pBuffer, NULL);
+
+    return pBuffer;
+}
+
+Result writeCpuTrace(void)
+{
+    FILE* pFile = fopen(trace.pOutputPath, "w");
+    if (pFile == NULL)
+    {
+        return FAIL;
+    }
+
+    double microsecondsPerTick = 1000000.0 / SDL_GetPerformanceFrequency();
+    SDL_bool firstEvent = SDL_TRUE;
+    uint64_t writtenEventCount = 0;
+
+    fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\n\"traceEvents\":[");
+
+    for (CpuTraceBuffer* pBuffer = trace.pBuffers; pBuffer != NULL; pBuffer = pBuffer->pNext)
+    {
+        if (pBuffer->pThreadName[0] != '\0')
+        {
+            fprintf(pFile, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}", (firstEvent == SDL_TRUE) ? "" : ",", pBuffer->threadId, pBuffer->pThreadName);
+            firstEvent = SDL_FALSE;
+        }
+
+        // A full ring starts with its oldest event right after the newest one
+        uint64_t eventCount = (pBuffer->eventCount < CPU_TRACE_EVENT_COUNT) ? pBuffer->eventCount : CPU_TRACE_EVENT_COUNT;
+        uint64_t firstIndex = pBuffer->eventCount - eventCount;
+
+        for (uint64_t i = firstIndex; i < pBuffer->eventCount; ++i)
+        {
+            const CpuTraceEvent* pEvent = &pBuffer->pEvents[i % CPU_TRACE_EVENT_COUNT];
+            fprintf(pFile, "%s\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}", (firstEvent == SDL_TRUE) ? "" : ",", pEvent->pName, pBuffer->threadId,
+                (double)(pEvent->startTicks - trace.startTicks) * microsecondsPerTick, (double)(pEvent->endTicks - pEvent->startTicks) * microsecondsPerTick);
+            firstEvent = SDL_FALSE;
+        }
+
+        writtenEventCount += eventCount;
+    }
+
+    fprintf(pFile, "\n]}\n");
+
+    Result result = (ferror(pFile) == 0) ? SUCCESS : FAIL;
+    fclose(pFile);
+
+    if (result == SUCCESS)
+    {
+        printf("Wrote %llu CPU trace events to \"%s\"\n\n", (unsigned long long)writtenEventCount, trace.pOutputPath);
+    }
+
+    return result;
+}
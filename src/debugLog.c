@@ -0,0 +1,361 @@
+#include "debugLog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static SDL_bool popDebugLogEntry(DebugLog* pLog);
+
+static void processDebugLogEntry(DebugLog* pLog, const DebugLogEntry* pEntry);
+
+static DebugLogCounter* getDebugLogCounter(DebugLog* pLog, const DebugLogEntry* pEntry);
+
+static void writeDebugLogEntry(DebugLog* pLog, const DebugLogEntry* pEntry, uint64_t count, uint64_t suppressedCount);
+
+static void printDebugLogSummary(DebugLog* pLog);
+
+static const char* getSeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
+
+static void writeMessageTypes(FILE* pStream, VkDebugUtilsMessageTypeFlagsEXT types);
+
+static int loggerThread(void* pData);
+
+Result createDebugLog(DebugLog* pLog)
+{
+    pLog->pEntries = NULL;
+    SDL_AtomicSet(&pLog->enqueuePosition, 0);
+    pLog->dequeuePosition = 0;
+    SDL_AtomicSet(&pLog->droppedCount, 0);
+    SDL_AtomicSet(&pLog->quit, 0);
+    pLog->pWakeSemaphore = NULL;
+    pLog->pThread = NULL;
+    pLog->pCounters = NULL;
+    pLog->startTicks = SDL_GetPerformanceCounter();
+
+    pLog->pEntries = malloc(DEBUG_LOG_QUEUE_SIZE * sizeof(DebugLogEntry));
+    if (pLog->pEntries == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for debug log entries!", DEBUG_LOG_QUEUE_SIZE * sizeof(DebugLogEntry));
+        destroyDebugLog(pLog);
+        return FAIL;
+    }
+
+    // An entry is free for the producer that claims position i when its sequence is i, and holds a message for
+    // the logger when it is i + 1
+    for (uint32_t i = 0; i < DEBUG_LOG_QUEUE_SIZE; ++i)
+    {
+        SDL_AtomicSet(&pLog->pEntries[i].sequence, (int)i);
+    }
+
+    pLog->pCounters = calloc(DEBUG_LOG_COUNTER_COUNT, sizeof(DebugLogCounter));
+    if (pLog->pCounters == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for debug log counters!", DEBUG_LOG_COUNTER_COUNT * sizeof(DebugLogCounter));
+        destroyDebugLog(pLog);
+        return FAIL;
+    }
+
+    pLog->pWakeSemaphore = SDL_CreateSemaphore(0);
+    if (pLog->pWakeSemaphore == NULL)
+    {
+        printError("Failed to create debug log semaphore!");
+        destroyDebugLog(pLog);
+        return FAIL;
+    }
+
+    pLog->pThread = SDL_CreateThread(loggerThread, "debug log", pLog);
+    if (pLog->pThread == NULL)
+    {
+        printError("Failed to create debug log thread!");
+        destroyDebugLog(pLog);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyDebugLog(DebugLog* pLog)
+{
+    if (pLog->pThread != NULL)
+    {
+        SDL_AtomicSet(&pLog->quit, 1);
+        SDL_SemPost(pLog->pWakeSemaphore);
+        SDL_WaitThread(pLog->pThread, NULL);
+        pLog->pThread = NULL;
+
+        printDebugLogSummary(pLog);
+    }
+
+    if (pLog->pWakeSemaphore != NULL)
+    {
+        SDL_DestroySemaphore(pLog->pWakeSemaphore);
+        pLog->pWakeSemaphore = NULL;
+    }
+
+    free(pLog->pCounters);
+    pLog->pCounters = NULL;
+
+    free(pLog->pEntries);
+    pLog->pEntries = NULL;
+}
+
+void pushDebugLogMessage(DebugLog* pLog, VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData)
+{
+    // Positions wrap around, so they are compared by their unsigned difference
+    uint32_t position = (uint32_t)SDL_AtomicGet(&pLog->enqueuePosition);
+    DebugLogEntry* pEntry;
+    for (;;)
+    {
+        pEntry = &pLog->pEntries[position & (DEBUG_LOG_QUEUE_SIZE - 1)];
+        int32_t difference = (int32_t)((uint32_t)SDL_AtomicGet(&pEntry->sequence) - position);
+
+        if (difference == 0)
+        {
+            if (SDL_AtomicCAS(&pLog->enqueuePosition, (int)position, (int)(position + 1)) == SDL_TRUE)
+            {
+                break;
+            }
+
+            position = (uint32_t)SDL_AtomicGet(&pLog->enqueuePosition);
+        }
+        else if (difference < 0)
+        {
+            // The logger is a whole queue behind
+            SDL_AtomicAdd(&pLog->droppedCount, 1);
+            return;
+        }
+        else
+        {
+            position = (uint32_t)SDL_AtomicGet(&pLog->enqueuePosition);
+        }
+    }
+
+    pEntry->severity = severity;
+    pEntry->types = types;
+    pEntry->messageIdNumber = pCallbackData->messageIdNumber;
+    pEntry->ticks = SDL_GetPerformanceCounter();
+    SDL_strlcpy(pEntry->pMessageIdName, (pCallbackData->pMessageIdName != NULL) ? pCallbackData->pMessageIdName : "", DEBUG_LOG_ID_NAME_SIZE);
+    SDL_strlcpy(pEntry->pMessage, (pCallbackData->pMessage != NULL) ? pCallbackData->pMessage : "", DEBUG_LOG_MESSAGE_SIZE);
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&pEntry->sequence, (int)(position + 1));
+
+    // Errors often come right before a crash or a device loss, so they are not left waiting for the next flush
+    if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+    {
+        SDL_SemPost(pLog->pWakeSemaphore);
+    }
+}
+
+SDL_bool popDebugLogEntry(DebugLog* pLog)
+{
+    DebugLogEntry* pEntry = &pLog->pEntries[pLog->dequeuePosition & (DEBUG_LOG_QUEUE_SIZE - 1)];
+    if ((uint32_t)SDL_AtomicGet(&pEntry->sequence) != pLog->dequeuePosition + 1)
+    {
+        return SDL_FALSE;
+    }
+    SDL_MemoryBarrierAcquire();
+
+    processDebugLogEntry(pLog, pEntry);
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&pEntry->sequence, (int)(pLog->dequeuePosition + DEBUG_LOG_QUEUE_SIZE));
+    ++pLog->dequeuePosition;
+
+    return SDL_TRUE;
+}
+
+void processDebugLogEntry(DebugLog* pLog, const DebugLogEntry* pEntry)
+{
+    DebugLogCounter* pCounter = getDebugLogCounter(pLog, pEntry);
+    if (pCounter == NULL)
+    {
+        writeDebugLogEntry(pLog, pEntry, 0, 0);
+        return;
+    }
+
+    ++pCounter->count;
+
+    uint64_t intervalTicks = SDL_GetPerformanceFrequency() * DEBUG_LOG_INTERVAL_MS / 1000;
+    if ((pCounter->printedCount >= DEBUG_LOG_BURST) && (pEntry->ticks - pCounter->lastPrintTicks < intervalTicks))
+    {
+        ++pCounter->suppressedCount;
+        return;
+    }
+
+    writeDebugLogEntry(pLog, pEntry, pCounter->count, pCounter->suppressedCount);
+
+    ++pCounter->printedCount;
+    pCounter->suppressedCount = 0;
+    pCounter->lastPrintTicks = pEntry->ticks;
+}
+
+DebugLogCounter* getDebugLogCounter(DebugLog* pLog, const DebugLogEntry* pEntry)
+{
+    if (pEntry->messageIdNumber == 0)
+    {
+        return NULL;
+    }
+
+    // Open addressing with linear probing, once the table is full new IDs are simply not limited
+    uint32_t hash = (uint32_t)pEntry->messageIdNumber * 2654435761u;
+    for (uint32_t i = 0; i < DEBUG_LOG_COUNTER_COUNT; ++i)
+    {
+        DebugLogCounter* pCounter = &pLog->pCounters[(hash + i) % DEBUG_LOG_COUNTER_COUNT];
+
+        if (pCounter->used != SDL_TRUE)
+        {
+            pCounter->used = SDL_TRUE;
+            pCounter->messageIdNumber = pEntry->messageIdNumber;
+            pCounter->severity = pEntry->severity;
+            SDL_strlcpy(pCounter->pMessageIdName, pEntry->pMessageIdName, DEBUG_LOG_ID_NAME_SIZE);
+            return pCounter;
+        }
+
+        if (pCounter->messageIdNumber == pEntry->messageIdNumber)
+        {
+            return pCounter;
+        }
+    }
+
+    return NULL;
+}
+
+void writeDebugLogEntry(DebugLog* pLog, const DebugLogEntry* pEntry, uint64_t count, uint64_t suppressedCount)
+{
+    FILE* pStream = (pEntry->severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) ? stderr : stdout;
+
+    double time = (double)(pEntry->ticks - pLog->startTicks) / (double)SDL_GetPerformanceFrequency();
+
+    fprintf(pStream, "vulkan time=%.3f severity=%s type=", time, getSeverityName(pEntry->severity));
+    writeMessageTypes(pStream, pEntry->types);
+    fprintf(pStream, " id=0x%08x", (uint32_t)pEntry->messageIdNumber);
+
+    if (pEntry->pMessageIdName[0] != '\0')
+    {
+        fprintf(pStream, " name=\"%s\"", pEntry->pMessageIdName);
+    }
+
+    if (count > 0)
+    {
+        fprintf(pStream, " count=%llu", (unsigned long long)count);
+    }
+
+    if (suppressedCount > 0)
+    {
+        fprintf(pStream, " suppressed=%llu", (unsigned long long)suppressedCount);
+    }
+
+    // Keeps every message on one line
+    fputs(" message=\"", pStream);
+    for (const char* pCharacter = pEntry->pMessage; *pCharacter != '\0'; ++pCharacter)
+    {
+        switch (*pCharacter)
+        {
+            case '"':
+            case '\\':
+                fputc('\\', pStream);
+                fputc(*pCharacter, pStream);
+                break;
+            case '\n':
+            case '\r':
+                fputc(' ', pStream);
+                break;
+            default:
+                fputc(*pCharacter, pStream);
+                break;
+        }
+    }
+    fputs("\"\n", pStream);
+}
+
+void printDebugLogSummary(DebugLog* pLog)
+{
+    for (uint32_t i = 0; i < DEBUG_LOG_COUNTER_COUNT; ++i)
+    {
+        const DebugLogCounter* pCounter = &pLog->pCounters[i];
+        if ((pCounter->used == SDL_TRUE) && (pCounter->count > pCounter->printedCount))
+        {
+            fprintf(stderr, "vulkan summary severity=%s id=0x%08x name=\"%s\" count=%llu printed=%llu\n",
+                    getSeverityName(pCounter->severity), (uint32_t)pCounter->messageIdNumber, pCounter->pMessageIdName, (unsigned long long)pCounter->count,
+                    (unsigned long long)pCounter->printedCount);
+        }
+    }
+
+    int droppedCount = SDL_AtomicGet(&pLog->droppedCount);
+    if (droppedCount > 0)
+    {
+        fprintf(stderr, "vulkan summary dropped=%d\n", droppedCount);
+    }
+}
+
+const char* getSeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+{
+    switch (severity)
+    {
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
+            return "verbose";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
+            return "info";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
+            return "warning";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
+            return "error";
+        default:
+            return "unknown";
+    }
+}
+
+void writeMessageTypes(FILE* pStream, VkDebugUtilsMessageTypeFlagsEXT types)
+{
+    static const struct
+    {
+        VkDebugUtilsMessageTypeFlagsEXT    type;
+        const char*                        pName;
+    } pTypeNames[] = {
+        {VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT, "general"},
+        {VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT, "validation"},
+        {VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT, "performance"},
+        {VK_DEBUG_UTILS_MESSAGE_TYPE_DEVICE_ADDRESS_BINDING_BIT_EXT, "address-binding"}
+    };
+
+    SDL_bool first = SDL_TRUE;
+    for (uint32_t i = 0; i < sizeof(pTypeNames) / sizeof(pTypeNames[0]); ++i)
+    {
+        if ((types & pTypeNames[i].type) != 0)
+        {
+            fprintf(pStream, (first == SDL_TRUE) ? "%s" : ",%s", pTypeNames[i].pName);
+            first = SDL_FALSE;
+        }
+    }
+
+    if (first == SDL_TRUE)
+    {
+        fputs("none", pStream);
+    }
+}
+
+int loggerThread(void* pData)
+{
+    DebugLog* pLog = pData;
+
+    for (;;)
+    {
+        // Read before draining, so everything pushed before destroyDebugLog is still written
+        SDL_bool quit = (SDL_AtomicGet(&pLog->quit) != 0) ? SDL_TRUE : SDL_FALSE;
+
+        while (popDebugLogEntry(pLog) == SDL_TRUE)
+        {
+        }
+        fflush(stdout);
+
+        if (quit == SDL_TRUE)
+        {
+            break;
+        }
+
+        SDL_SemWaitTimeout(pLog->pWakeSemaphore, DEBUG_LOG_FLUSH_MS);
+    }
+
+    return 0;
+}
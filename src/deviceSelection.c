@@ -0,0 +1,352 @@
+#include "deviceSelection.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEVICE_UUID_TEXT_SIZE   37
+
+static Result getDeviceCandidate(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, CapabilityCache* pCache, DeviceCandidate* pCandidate);
+
+static void printDeviceCandidate(const DeviceCandidate* pCandidate, uint32_t index, SDL_bool selected);
+
+static uint32_t getDeviceTypeRank(VkPhysicalDeviceType type);
+
+static const char* getDeviceTypeName(VkPhysicalDeviceType type);
+
+static void formatDeviceUuid(const uint8_t* pUuid, char* pText);
+
+static SDL_bool matchesDeviceSelection(const DeviceCandidate* pCandidate, uint32_t index, const char* pSelection);
+
+static SDL_bool containsIgnoringCase(const char* pText, const char* pPart);
+
+Result selectPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, CapabilityCache* pCache, const char* pSelection, SDL_bool verbose, VkPhysicalDevice* pPhysicalDevice)
+{
+    uint32_t physicalDeviceCount;
+    vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, NULL);
+
+    if (physicalDeviceCount < 1)
+    {
+        printError("There are no physical devices!");
+        return FAIL;
+    }
+
+    VkPhysicalDevice* pPhysicalDevices = malloc(physicalDeviceCount * sizeof(VkPhysicalDevice));
+    DeviceCandidate* pCandidates = malloc(physicalDeviceCount * sizeof(DeviceCandidate));
+    if ((pPhysicalDevices == NULL) || (pCandidates == NULL))
+    {
+        printError("Failed to allocate %lu bytes of memory for physical devices!", physicalDeviceCount * (sizeof(VkPhysicalDevice) + sizeof(DeviceCandidate)));
+        free(pCandidates);
+        free(pPhysicalDevices);
+        return FAIL;
+    }
+
+    vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, pPhysicalDevices);
+
+    for (uint32_t i = 0; i < physicalDeviceCount; ++i)
+    {
+        if (getDeviceCandidate(pPhysicalDevices[i], surface, pCache, &pCandidates[i]) != SUCCESS)
+        {
+            printError("Failed to query physical device %u!", i);
+            free(pCandidates);
+            free(pPhysicalDevices);
+            return FAIL;
+        }
+    }
+
+    free(pPhysicalDevices);
+
+    // An empty selection, as from an empty environment variable, leaves the choice to the score
+    if ((pSelection != NULL) && (pSelection[0] == '\0'))
+    {
+        pSelection = NULL;
+    }
+
+    uint32_t selectedIndex = UINT32_MAX;
+    SDL_bool matched = SDL_FALSE;
+
+    for (uint32_t i = 0; i < physicalDeviceCount; ++i)
+    {
+        if ((pSelection != NULL) && (matchesDeviceSelection(&pCandidates[i], i, pSelection) != SDL_TRUE))
+        {
+            continue;
+        }
+
+        matched = SDL_TRUE;
+
+        if ((pCandidates[i].pUnsuitableReason == NULL) && ((selectedIndex == UINT32_MAX) || (pCandidates[i].score > pCandidates[selectedIndex].score)))
+        {
+            selectedIndex = i;
+        }
+    }
+
+    if (verbose == SDL_TRUE)
+    {
+        printf("Physical devices[%u]:\n", physicalDeviceCount);
+        for (uint32_t i = 0; i < physicalDeviceCount; ++i)
+        {
+            printDeviceCandidate(&pCandidates[i], i, (i == selectedIndex) ? SDL_TRUE : SDL_FALSE);
+        }
+        printf("\n");
+    }
+    else if (selectedIndex != UINT32_MAX)
+    {
+        printf("Physical device:\n");
+        printDeviceCandidate(&pCandidates[selectedIndex], selectedIndex, SDL_TRUE);
+        printf("\n");
+    }
+
+    if ((pSelection != NULL) && (matched != SDL_TRUE))
+    {
+        printError("No physical device matches \"%s\"!", pSelection);
+        free(pCandidates);
+        return FAIL;
+    }
+
+    if (selectedIndex == UINT32_MAX)
+    {
+        if (pSelection != NULL)
+        {
+            printError("No physical device matching \"%s\" is suitable!", pSelection);
+        }
+        else
+        {
+            printError("No physical device is suitable!");
+        }
+
+        free(pCandidates);
+        return FAIL;
+    }
+
+    *pPhysicalDevice = pCandidates[selectedIndex].physicalDevice;
+
+    free(pCandidates);
+
+    return SUCCESS;
+}
+
+Result getDeviceCandidate(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, CapabilityCache* pCache, DeviceCandidate* pCandidate)
+{
+    memset(pCandidate, 0, sizeof(DeviceCandidate));
+    pCandidate->physicalDevice = physicalDevice;
+
+    vkGetPhysicalDeviceProperties(physicalDevice, &pCandidate->properties);
+
+    if (pCandidate->properties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        VkPhysicalDeviceIDProperties idProperties;
+        idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+        idProperties.pNext = NULL;
+
+        VkPhysicalDeviceProperties2 properties2;
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &idProperties;
+
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        memcpy(pCandidate->pUuid, idProperties.deviceUUID, VK_UUID_SIZE);
+        pCandidate->uuidValid = SDL_TRUE;
+    }
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        if ((memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0)
+        {
+            pCandidate->localMemorySize += memoryProperties.memoryHeaps[i].size;
+        }
+    }
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, NULL);
+
+    VkQueueFamilyProperties* pFamilies = malloc(familyCount * sizeof(VkQueueFamilyProperties));
+    if (pFamilies == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for queue families!", familyCount * sizeof(VkQueueFamilyProperties));
+        return FAIL;
+    }
+
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, pFamilies);
+
+    SDL_bool graphicsQueue = SDL_FALSE;
+    for (uint32_t i = 0; i < familyCount; ++i)
+    {
+        VkQueueFlags flags = pFamilies[i].queueFlags;
+
+        VkBool32 presentSupported = VK_TRUE;
+        if (surface != NULL)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupported);
+        }
+
+        if (((flags & VK_QUEUE_GRAPHICS_BIT) != 0) && (presentSupported == VK_TRUE))
+        {
+            graphicsQueue = SDL_TRUE;
+        }
+
+        if (((flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) && ((flags & VK_QUEUE_TRANSFER_BIT) != 0))
+        {
+            pCandidate->dedicatedTransferQueue = SDL_TRUE;
+        }
+    }
+
+    free(pFamilies);
+
+    if (pCandidate->properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        pCandidate->pUnsuitableReason = "no Vulkan 1.2";
+        return SUCCESS;
+    }
+
+    DeviceCapabilities capabilities;
+    if (getDeviceCapabilities(pCache, physicalDevice, &pCandidate->properties, &capabilities) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    pCandidate->drawIndirectCount = ((capabilities.flags & DEVICE_CAPABILITY_DRAW_INDIRECT_COUNT) != 0) ? SDL_TRUE : SDL_FALSE;
+
+    if ((capabilities.flags & DEVICE_CAPABILITY_TIMELINE_SEMAPHORE) == 0)
+    {
+        pCandidate->pUnsuitableReason = "no timeline semaphores";
+    }
+    else if (graphicsQueue != SDL_TRUE)
+    {
+        pCandidate->pUnsuitableReason = (surface != NULL) ? "no graphics queue family that can present" : "no graphics queue family";
+    }
+    else if ((surface != NULL) && ((capabilities.flags & DEVICE_CAPABILITY_SWAPCHAIN) == 0))
+    {
+        pCandidate->pUnsuitableReason = "no " VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    }
+
+    // The device type decides, memory in MiB breaks ties between devices of a type and the optional features come last
+    VkDeviceSize localMemoryMb = pCandidate->localMemorySize >> 20;
+    pCandidate->score = ((uint64_t)getDeviceTypeRank(pCandidate->properties.deviceType) << 56)
+                        | (((localMemoryMb < (1ull << 40)) ? localMemoryMb : ((1ull << 40) - 1)) << 8)
+                        | ((pCandidate->dedicatedTransferQueue == SDL_TRUE) ? 2 : 0)
+                        | ((pCandidate->drawIndirectCount == SDL_TRUE) ? 1 : 0);
+
+    return SUCCESS;
+}
+
+void printDeviceCandidate(const DeviceCandidate* pCandidate, uint32_t index, SDL_bool selected)
+{
+    char pUuidText[DEVICE_UUID_TEXT_SIZE] = "unknown";
+    if (pCandidate->uuidValid == SDL_TRUE)
+    {
+        formatDeviceUuid(pCandidate->pUuid, pUuidText);
+    }
+
+    printf("  %c %u: %s (%s, Vulkan %u.%u, %llu MiB, UUID %s)", (selected == SDL_TRUE) ? '*' : ' ', index, pCandidate->properties.deviceName,
+        getDeviceTypeName(pCandidate->properties.deviceType), VK_API_VERSION_MAJOR(pCandidate->properties.apiVersion),
+        VK_API_VERSION_MINOR(pCandidate->properties.apiVersion), (unsigned long long)(pCandidate->localMemorySize >> 20), pUuidText);
+
+    if (pCandidate->pUnsuitableReason != NULL)
+    {
+        printf(", unsuitable: %s\n", pCandidate->pUnsuitableReason);
+    }
+    else
+    {
+        printf("\n");
+    }
+}
+
+uint32_t getDeviceTypeRank(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return 4;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return 3;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return 2;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+const char* getDeviceTypeName(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return "CPU";
+        default:
+            return "other";
+    }
+}
+
+void formatDeviceUuid(const uint8_t* pUuid, char* pText)
+{
+    snprintf(pText, DEVICE_UUID_TEXT_SIZE, "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x", pUuid[0], pUuid[1], pUuid[2], pUuid[3], pUuid[4],
+        pUuid[5], pUuid[6], pUuid[7], pUuid[8], pUuid[9], pUuid[10], pUuid[11], pUuid[12], pUuid[13], pUuid[14], pUuid[15]);
+}
+
+SDL_bool matchesDeviceSelection(const DeviceCandidate* pCandidate, uint32_t index, const char* pSelection)
+{
+    // All digits is an index in the order the devices are listed
+    size_t digitCount = strspn(pSelection, "0123456789");
+    if (pSelection[digitCount] == '\0')
+    {
+        return (strtoul(pSelection, NULL, 10) == index) ? SDL_TRUE : SDL_FALSE;
+    }
+
+    if (pCandidate->uuidValid == SDL_TRUE)
+    {
+        char pUuidText[DEVICE_UUID_TEXT_SIZE];
+        formatDeviceUuid(pCandidate->pUuid, pUuidText);
+
+        // The UUID matches with or without its dashes
+        const char* pCharacter = pSelection;
+        SDL_bool uuidMatches = SDL_TRUE;
+        for (uint32_t i = 0; (i < DEVICE_UUID_TEXT_SIZE - 1) && (uuidMatches == SDL_TRUE); ++i)
+        {
+            if ((pUuidText[i] == '-') && (*pCharacter != '-'))
+            {
+                continue;
+            }
+
+            uuidMatches = (tolower((unsigned char)*pCharacter) == pUuidText[i]) ? SDL_TRUE : SDL_FALSE;
+            ++pCharacter;
+        }
+
+        if ((uuidMatches == SDL_TRUE) && (*pCharacter == '\0'))
+        {
+            return SDL_TRUE;
+        }
+    }
+
+    return containsIgnoringCase(pCandidate->properties.deviceName, pSelection);
+}
+
+SDL_bool containsIgnoringCase(const char* pText, const char* pPart)
+{
+    for (; *pText != '\0'; ++pText)
+    {
+        size_t i = 0;
+        while ((pPart[i] != '\0') && (tolower((unsigned char)pText[i]) == tolower((unsigned char)pPart[i])))
+        {
+            ++i;
+        }
+
+        if (pPart[i] == '\0')
+        {
+            return SDL_TRUE;
+        }
+    }
+
+    return SDL_FALSE;
+}
@@ -0,0 +1,111 @@
+#include "drawSort.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DRAW_SORT_RADIX_BITS    8
+#define DRAW_SORT_BUCKETS       (1 << DRAW_SORT_RADIX_BITS)
+#define DRAW_SORT_PASSES        (64 / DRAW_SORT_RADIX_BITS)
+
+Result createDrawSorter(DrawSorter* pSorter, uint32_t capacity)
+{
+    memset(pSorter, 0, sizeof(DrawSorter));
+    pSorter->capacity = capacity;
+
+    pSorter->pKeys = malloc(capacity * sizeof(uint64_t));
+    pSorter->pValues = malloc(capacity * sizeof(uint32_t));
+    pSorter->pScratchKeys = malloc(capacity * sizeof(uint64_t));
+    pSorter->pScratchValues = malloc(capacity * sizeof(uint32_t));
+
+    if ((pSorter->pKeys == NULL) || (pSorter->pValues == NULL) || (pSorter->pScratchKeys == NULL) || (pSorter->pScratchValues == NULL))
+    {
+        printError("Failed to allocate %lu bytes of memory for draw sort keys!", capacity * 2 * (sizeof(uint64_t) + sizeof(uint32_t)));
+        destroyDrawSorter(pSorter);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyDrawSorter(DrawSorter* pSorter)
+{
+    free(pSorter->pScratchValues);
+    free(pSorter->pScratchKeys);
+    free(pSorter->pValues);
+    free(pSorter->pKeys);
+    memset(pSorter, 0, sizeof(DrawSorter));
+}
+
+uint64_t makeDrawSortKey(uint32_t pipeline, uint32_t material, float depth)
+{
+    // The bits of positive floats order like the floats themselves, NaN goes to the front as well
+    if (!(depth > 0.0f))
+    {
+        depth = 0.0f;
+    }
+
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    return ((uint64_t)(pipeline & 0xFF) << 56) | ((uint64_t)(material & 0xFFFFFF) << 32) | depthBits;
+}
+
+void sortDraws(DrawSorter* pSorter, uint32_t count)
+{
+    if (count < 2)
+    {
+        return;
+    }
+
+    // Least significant digit first, every histogram is counted in a single pass over the keys
+    uint32_t pHistograms[DRAW_SORT_PASSES][DRAW_SORT_BUCKETS];
+    memset(pHistograms, 0, sizeof(pHistograms));
+
+    const uint64_t* pKeys = pSorter->pKeys;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint64_t key = pKeys[i];
+        for (uint32_t pass = 0; pass < DRAW_SORT_PASSES; ++pass)
+        {
+            ++pHistograms[pass][(key >> (pass * DRAW_SORT_RADIX_BITS)) & (DRAW_SORT_BUCKETS - 1)];
+        }
+    }
+
+    for (uint32_t pass = 0; pass < DRAW_SORT_PASSES; ++pass)
+    {
+        uint32_t shift = pass * DRAW_SORT_RADIX_BITS;
+        uint32_t* pHistogram = pHistograms[pass];
+
+        // A digit shared by every key leaves the order as it is, which skips the unused state bits of most scenes
+        if (pHistogram[(pSorter->pKeys[0] >> shift) & (DRAW_SORT_BUCKETS - 1)] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < DRAW_SORT_BUCKETS; ++i)
+        {
+            uint32_t bucketCount = pHistogram[i];
+            pHistogram[i] = offset;
+            offset += bucketCount;
+        }
+
+        const uint64_t* pSourceKeys = pSorter->pKeys;
+        const uint32_t* pSourceValues = pSorter->pValues;
+        uint64_t* pTargetKeys = pSorter->pScratchKeys;
+        uint32_t* pTargetValues = pSorter->pScratchValues;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t key = pSourceKeys[i];
+            uint32_t target = pHistogram[(key >> shift) & (DRAW_SORT_BUCKETS - 1)]++;
+            pTargetKeys[target] = key;
+            pTargetValues[target] = pSourceValues[i];
+        }
+
+        pSorter->pScratchKeys = pSorter->pKeys;
+        pSorter->pScratchValues = pSorter->pValues;
+        pSorter->pKeys = pTargetKeys;
+        pSorter->pValues = pTargetValues;
+    }
+}
@@ -2,7 +2,6 @@
 
 #include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <vulkan/vulkan.h>
@@ -10,79 +9,71 @@
 #include <SDL.h>
 #include <SDL_vulkan.h>
 
-Result getAvailableInstanceExtensions(uint32_t* pExtensionCount, char*** pppExtensions)
+Result getAvailableInstanceExtensions(Arena* pArena, uint32_t* pExtensionCount, VkExtensionProperties** ppExtensions)
 {
+    *ppExtensions = NULL;
+
     vkEnumerateInstanceExtensionProperties(NULL, pExtensionCount, NULL);
 
     if (*pExtensionCount > 0)
     {
-        VkExtensionProperties* pProperties = malloc(*pExtensionCount * sizeof(VkExtensionProperties));
-        if (pProperties == NULL)
+        *ppExtensions = arenaAllocate(pArena, *pExtensionCount * sizeof(VkExtensionProperties));
+        if (*ppExtensions == NULL)
         {
             printError("Failed to allocate %lu bytes of memory for available instance extensions properties!", *pExtensionCount * sizeof(VkExtensionProperties));
             return FAIL;
         }
 
-        vkEnumerateInstanceExtensionProperties(NULL, pExtensionCount, pProperties);
-
-        *pppExtensions = calloc(*pExtensionCount, sizeof(char*));
-        if (*pppExtensions == NULL)
-        {
-            printError("Failed to allocate %lu bytes of memory for available instance extensions names!", *pExtensionCount * sizeof(char*));
-            free(pProperties);
-            return FAIL;
-        }
-
-        char** ppExtensions = *pppExtensions;
-
-        for (uint32_t i = 0; i < *pExtensionCount; ++i)
-        {
-            const char* pExtensionName = pProperties[i].extensionName;
-
-            ppExtensions[i] = malloc((strlen(pExtensionName) + 1) * sizeof(char));
-            if (ppExtensions[i] == NULL)
-            {
-                printError("Failed to allocate %lu bytes of memory for name of instance extension \"%s\"!", (strlen(pExtensionName) + 1) * sizeof(char), pExtensionName);
-                free(pProperties);
-                return FAIL;
-            }
-
-            strlcpy(ppExtensions[i], pExtensionName, (strlen(pExtensionName) + 1) * sizeof(char));
-        }
-
-        free(pProperties);
+        vkEnumerateInstanceExtensionProperties(NULL, pExtensionCount, *ppExtensions);
     }
 
     return SUCCESS;
 }
 
-void printAvailableInstanceExtensions(uint32_t extensionCount, char** ppExtensions)
+void printAvailableInstanceExtensions(uint32_t extensionCount, const VkExtensionProperties* pExtensions)
 {
     printf("Available instance extensions[%u]:\n", extensionCount);
     for (uint32_t i = 0; i < extensionCount; ++i)
     {
-        printf("    %s\n", ppExtensions[i]);
+        printf("    %s\n", pExtensions[i].extensionName);
     }
     printf("\n");
 }
 
-Result getRequiredInstanceExtensions(SDL_Window* pWindow, unsigned int* pExtensionCount, const char*** pppExtensions)
+Result getRequiredInstanceExtensions(Arena* pArena, SDL_Window* pWindow, SDL_bool validation, unsigned int* pExtensionCount, const char*** pppExtensions)
 {
-    SDL_Vulkan_GetInstanceExtensions(pWindow, pExtensionCount, NULL);
+    // Headless rendering has no window and needs no surface extensions
+    *pExtensionCount = 0;
+    if (pWindow != NULL)
+    {
+        SDL_Vulkan_GetInstanceExtensions(pWindow, pExtensionCount, NULL);
+    }
 
-    *pppExtensions = calloc(*pExtensionCount + 3, sizeof(char*));
+    *pppExtensions = arenaAllocate(pArena, (*pExtensionCount + 3) * sizeof(char*));
     if (*pppExtensions == NULL)
     {
-        printError("Failed to allocate %lu bytes of memory for required instance extensions names!", *pExtensionCount * sizeof(char*));
+        printError("Failed to allocate %lu bytes of memory for required instance extensions names!", (*pExtensionCount + 3) * sizeof(char*));
         return FAIL;
     }
 
     const char** ppExtensions = *pppExtensions;
 
-    SDL_Vulkan_GetInstanceExtensions(pWindow, pExtensionCount, *pppExtensions);
+    if (pWindow != NULL)
+    {
+        SDL_Vulkan_GetInstanceExtensions(pWindow, pExtensionCount, *pppExtensions);
+    }
+
+#ifdef VIEWER_VALIDATION
+    // The validation features extension is provided by the layer itself
+    if (validation == SDL_TRUE)
+    {
+        ppExtensions[(*pExtensionCount)++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+        ppExtensions[(*pExtensionCount)++] = VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME;
+    }
+#else
+    (void)validation;
+#endif
 
-    ppExtensions[(*pExtensionCount)++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
-    ppExtensions[(*pExtensionCount)++] = VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME;
     ppExtensions[(*pExtensionCount)++] = VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME;
 
     return SUCCESS;
@@ -98,89 +89,46 @@ void printRequiredInstanceExtensions(unsigned int extensionCount, const char** p
     printf("\n");
 }
 
-void freeInstanceExtensions(uint32_t* pAvailableExtensionCount, char*** pppAvailableExtensions, unsigned int* pRequiredExtensionCount, const char*** pppRequiredExtensions)
+Result getAvailableDeviceExtensions(Arena* pArena, VkPhysicalDevice physicalDevice, uint32_t* pExtensionCount, VkExtensionProperties** ppExtensions)
 {
-    free(*pppRequiredExtensions);
-    *pppRequiredExtensions = NULL;
-
-    *pRequiredExtensionCount = 0;
-
-    for (uint32_t i = 0; i < *pAvailableExtensionCount; ++i)
-    {
-        free((*pppAvailableExtensions)[i]);
-    }
-
-    free(*pppAvailableExtensions);
-    *pppAvailableExtensions = NULL;
+    *ppExtensions = NULL;
 
-    *pAvailableExtensionCount = 0;
-}
-
-Result getAvailableDeviceExtensions(VkPhysicalDevice physicalDevice, uint32_t* pExtensionCount, char*** pppExtensions)
-{
     vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, pExtensionCount, NULL);
 
     if (*pExtensionCount > 0)
     {
-        VkExtensionProperties* pProperties = malloc(*pExtensionCount * sizeof(VkExtensionProperties));
-        if (pProperties == NULL)
+        *ppExtensions = arenaAllocate(pArena, *pExtensionCount * sizeof(VkExtensionProperties));
+        if (*ppExtensions == NULL)
         {
             printError("Failed to allocate %lu bytes of memory for available device extensions properties!", *pExtensionCount * sizeof(VkExtensionProperties));
             return FAIL;
         }
 
-        vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, pExtensionCount, pProperties);
-
-        *pppExtensions = calloc(*pExtensionCount, sizeof(char*));
-        if (*pppExtensions == NULL)
-        {
-            printError("Failed to allocate %lu bytes of memory for available device extensions names!", *pExtensionCount * sizeof(char*));
-            free(pProperties);
-            return FAIL;
-        }
-
-        char** ppExtensions = *pppExtensions;
-
-        for (uint32_t i = 0; i < *pExtensionCount; ++i)
-        {
-            const char* pExtensionName = pProperties[i].extensionName;
-
-            ppExtensions[i] = malloc((strlen(pExtensionName) + 1) * sizeof(char));
-            if (ppExtensions[i] == NULL)
-            {
-                printError("Failed to allocate %lu bytes of memory for name of device extension \"%s\"!", (strlen(pExtensionName) + 1) * sizeof(char), pExtensionName);
-                free(pProperties);
-                return FAIL;
-            }
-
-            strlcpy(ppExtensions[i], pExtensionName, (strlen(pExtensionName) + 1) * sizeof(char));
-        }
-
-        free(pProperties);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, pExtensionCount, *ppExtensions);
     }
 
     return SUCCESS;
 }
 
-void printAvailableDeviceExtensions(uint32_t extensionCount, char** ppExtensions)
+void printAvailableDeviceExtensions(uint32_t extensionCount, const VkExtensionProperties* pExtensions)
 {
     printf("Available device extensions[%u]:\n", extensionCount);
     for (uint32_t i = 0; i < extensionCount; ++i)
     {
-        printf("    %s\n", ppExtensions[i]);
+        printf("    %s\n", pExtensions[i].extensionName);
     }
     printf("\n");
 }
 
-void freeDeviceExtensions(uint32_t* pAvailableExtensionCount, char*** pppAvailableExtensions)
+SDL_bool hasExtension(uint32_t extensionCount, const VkExtensionProperties* pExtensions, const char* pExtensionName)
 {
-    for (uint32_t i = 0; i < *pAvailableExtensionCount; ++i)
+    for (uint32_t i = 0; i < extensionCount; ++i)
     {
-        free((*pppAvailableExtensions)[i]);
+        if (strcmp(pExtensions[i].extensionName, pExtensionName) == 0)
+        {
+            return SDL_TRUE;
+        }
     }
 
-    free(*pppAvailableExtensions);
-    *pppAvailableExtensions = NULL;
-
-    *pAvailableExtensionCount = 0;
+    return SDL_FALSE;
 }
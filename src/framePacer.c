@@ -0,0 +1,74 @@
+#include "framePacer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "base.h"
+
+void createFramePacer(FramePacer* pPacer, uint32_t targetFps)
+{
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+
+    pPacer->frameTicks = (targetFps > 0) ? frequency / targetFps : 0;
+    pPacer->spinTicks = frequency * 2 / 1000;
+    pPacer->nextFrameTicks = SDL_GetPerformanceCounter();
+}
+
+void waitForNextFrame(FramePacer* pPacer)
+{
+    if (pPacer->frameTicks == 0)
+    {
+        return;
+    }
+
+    uint64_t ticks = SDL_GetPerformanceCounter();
+
+    // More than a whole frame behind, for example after the window was minimized
+    if (ticks >= pPacer->nextFrameTicks + pPacer->frameTicks)
+    {
+        pPacer->nextFrameTicks = ticks + pPacer->frameTicks;
+        return;
+    }
+
+    if (pPacer->nextFrameTicks > ticks + pPacer->spinTicks)
+    {
+        uint64_t sleepTicks = pPacer->nextFrameTicks - ticks - pPacer->spinTicks;
+        SDL_Delay((Uint32)(sleepTicks * 1000 / SDL_GetPerformanceFrequency()));
+    }
+
+    while (SDL_GetPerformanceCounter() < pPacer->nextFrameTicks)
+    {
+    }
+
+    pPacer->nextFrameTicks += pPacer->frameTicks;
+}
+
+void addLatencySample(LatencyHistory* pHistory, uint64_t startTicks, uint64_t endTicks)
+{
+    float latencyMs = (float)((double)(endTicks - startTicks) * 1000.0 / SDL_GetPerformanceFrequency());
+
+    pHistory->pSamples[pHistory->sampleCount % LATENCY_HISTORY_SIZE] = latencyMs;
+    ++pHistory->sampleCount;
+}
+
+void printLatencyHistory(const LatencyHistory* pHistory, const char* pName)
+{
+    if (pHistory->sampleCount == 0)
+    {
+        return;
+    }
+
+    float pSorted[LATENCY_HISTORY_SIZE];
+    uint32_t sampleCount = (pHistory->sampleCount < LATENCY_HISTORY_SIZE) ? (uint32_t)pHistory->sampleCount : LATENCY_HISTORY_SIZE;
+    memcpy(pSorted, pHistory->pSamples, sampleCount * sizeof(float));
+    sortFloats(pSorted, sampleCount);
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        sum += pSorted[i];
+    }
+
+    printf("%s: min %.3f ms, average %.3f ms, p99 %.3f ms, max %.3f ms over the last %u samples\n", pName,
+        pSorted[0], sum / sampleCount, getSortedPercentile(pSorted, sampleCount, 99), pSorted[sampleCount - 1], sampleCount);
+}
@@ -0,0 +1,311 @@
+#include "gpuCulling.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Result createCullingFrame(GpuCulling* pCulling, CullingFrame* pFrame, VkDescriptorSetLayout setLayout);
+
+Result createCullingSetLayout(VkDevice device, VkDescriptorSetLayout* pSetLayout)
+{
+    VkDescriptorSetLayoutBinding pBindings[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        pBindings[i].binding = i;
+        pBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pBindings[i].descriptorCount = 1;
+        pBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pBindings[i].pImmutableSamplers = NULL;
+    }
+
+    // The vertex shader reads the transforms of the objects the draws point at
+    pBindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.bindingCount = 3;
+    createInfo.pBindings = pBindings;
+
+    int result = vkCreateDescriptorSetLayout(device, &createInfo, NULL, pSetLayout);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result createGpuCulling(GpuCulling* pCulling, VkPhysicalDevice physicalDevice, VkDevice device, Allocator* pAllocator, VkDescriptorSetLayout setLayout,
+    VkShaderModule shaderModule, VkPipelineCache pipelineCache, uint32_t frameCount, uint32_t objectCount, const float* pPositionScales, SDL_bool drawCountSupported)
+{
+    memset(pCulling, 0, sizeof(GpuCulling));
+    pCulling->device = device;
+    pCulling->pAllocator = pAllocator;
+    pCulling->objectCount = objectCount;
+    pCulling->frameCount = frameCount;
+
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // Without multiDrawIndirect every indirect draw holds a single command
+    pCulling->multiDrawSupported = (features.multiDrawIndirect == VK_TRUE) ? SDL_TRUE : SDL_FALSE;
+    pCulling->maxDrawCount = (pCulling->multiDrawSupported == SDL_TRUE) ? properties.limits.maxDrawIndirectCount : 1;
+    pCulling->drawCountSupported = ((drawCountSupported == SDL_TRUE) && (objectCount <= pCulling->maxDrawCount)) ? SDL_TRUE : SDL_FALSE;
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    // Objects never move, so they are written once through a mapping instead of going through the staging ring
+    VkDeviceSize objectSize = (VkDeviceSize)objectCount * 4 * sizeof(float);
+    if (createBuffer(pAllocator, objectSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &allocationInfo, &pCulling->objectBuffer, &pCulling->objectAllocation) != SUCCESS)
+    {
+        printError("Failed to create culling object buffer!");
+        destroyGpuCulling(pCulling);
+        return FAIL;
+    }
+
+    memcpy(pCulling->objectAllocation.pMapped, pPositionScales, objectSize);
+
+    VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 3 * frameCount;
+
+    VkDescriptorPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = 0;
+    poolCreateInfo.maxSets = frameCount;
+    poolCreateInfo.poolSizeCount = 1;
+    poolCreateInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(device, &poolCreateInfo, NULL, &pCulling->descriptorPool) != VK_SUCCESS)
+    {
+        printError("Failed to create culling descriptor pool!");
+        destroyGpuCulling(pCulling);
+        return FAIL;
+    }
+
+    pCulling->pFrames = calloc(frameCount, sizeof(CullingFrame));
+    if (pCulling->pFrames == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for culling frames!", frameCount * sizeof(CullingFrame));
+        destroyGpuCulling(pCulling);
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        if (createCullingFrame(pCulling, &pCulling->pFrames[i], setLayout) != SUCCESS)
+        {
+            printError("Failed to create culling frame %u!", i);
+            destroyGpuCulling(pCulling);
+            return FAIL;
+        }
+    }
+
+    VkPushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullingPushConstants);
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo;
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.pNext = NULL;
+    layoutCreateInfo.flags = 0;
+    layoutCreateInfo.setLayoutCount = 1;
+    layoutCreateInfo.pSetLayouts = &setLayout;
+    layoutCreateInfo.pushConstantRangeCount = 1;
+    layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &layoutCreateInfo, NULL, &pCulling->pipelineLayout) != VK_SUCCESS)
+    {
+        printError("Failed to create culling pipeline layout!");
+        destroyGpuCulling(pCulling);
+        return FAIL;
+    }
+
+    // A single small compute pipeline, so it is built right away instead of on the pipeline builder
+    VkComputePipelineCreateInfo pipelineCreateInfo;
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = NULL;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineCreateInfo.stage.pNext = NULL;
+    pipelineCreateInfo.stage.flags = 0;
+    pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineCreateInfo.stage.module = shaderModule;
+    pipelineCreateInfo.stage.pName = "main";
+    pipelineCreateInfo.stage.pSpecializationInfo = NULL;
+    pipelineCreateInfo.layout = pCulling->pipelineLayout;
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    if (vkCreateComputePipelines(device, pipelineCache, 1, &pipelineCreateInfo, NULL, &pCulling->pipeline) != VK_SUCCESS)
+    {
+        printError("Failed to create culling pipeline!");
+        destroyGpuCulling(pCulling);
+        return FAIL;
+    }
+
+    printf("GPU culling of %u objects, drawn with %s\n\n", objectCount, (pCulling->drawCountSupported == SDL_TRUE) ? "vkCmdDrawIndexedIndirectCount" : "vkCmdDrawIndexedIndirect");
+
+    return SUCCESS;
+}
+
+void destroyGpuCulling(GpuCulling* pCulling)
+{
+    vkDestroyPipeline(pCulling->device, pCulling->pipeline, NULL);
+    pCulling->pipeline = VK_NULL_HANDLE;
+
+    vkDestroyPipelineLayout(pCulling->device, pCulling->pipelineLayout, NULL);
+    pCulling->pipelineLayout = VK_NULL_HANDLE;
+
+    if (pCulling->pFrames != NULL)
+    {
+        for (uint32_t i = 0; i < pCulling->frameCount; ++i)
+        {
+            CullingFrame* pFrame = &pCulling->pFrames[i];
+            if (pFrame->drawBuffer != VK_NULL_HANDLE)
+            {
+                destroyBuffer(pCulling->pAllocator, pFrame->drawBuffer, &pFrame->drawAllocation);
+            }
+
+            if (pFrame->countBuffer != VK_NULL_HANDLE)
+            {
+                destroyBuffer(pCulling->pAllocator, pFrame->countBuffer, &pFrame->countAllocation);
+            }
+        }
+    }
+
+    free(pCulling->pFrames);
+    pCulling->pFrames = NULL;
+
+    // Frees the descriptor sets with it
+    vkDestroyDescriptorPool(pCulling->device, pCulling->descriptorPool, NULL);
+    pCulling->descriptorPool = VK_NULL_HANDLE;
+
+    if (pCulling->objectBuffer != VK_NULL_HANDLE)
+    {
+        destroyBuffer(pCulling->pAllocator, pCulling->objectBuffer, &pCulling->objectAllocation);
+        pCulling->objectBuffer = VK_NULL_HANDLE;
+    }
+}
+
+void recordCulling(GpuCulling* pCulling, VkCommandBuffer commandBuffer, uint32_t frameIndex, const Mat4* pViewProjection, float objectRadius, uint32_t indexCount)
+{
+    CullingFrame* pFrame = &pCulling->pFrames[frameIndex];
+
+    // The fence of this frame has been waited on, so the draws of its previous use are no longer read
+    VkMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+
+    if (pCulling->drawCountSupported == SDL_TRUE)
+    {
+        vkCmdFillBuffer(commandBuffer, pFrame->countBuffer, 0, sizeof(uint32_t), 0);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+    }
+
+    CullingPushConstants pushConstants;
+    getFrustumPlanes(pViewProjection, pushConstants.pFrustumPlanes);
+    pushConstants.objectCount = pCulling->objectCount;
+    pushConstants.indexCount = indexCount;
+    pushConstants.objectRadius = objectRadius;
+    pushConstants.compact = (pCulling->drawCountSupported == SDL_TRUE) ? 1 : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pCulling->pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pCulling->pipelineLayout, 0, 1, &pFrame->descriptorSet, 0, NULL);
+    vkCmdPushConstants(commandBuffer, pCulling->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, (pCulling->objectCount + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+void drawCulledObjects(GpuCulling* pCulling, VkCommandBuffer commandBuffer, uint32_t frameIndex, VkPipelineLayout pipelineLayout)
+{
+    CullingFrame* pFrame = &pCulling->pFrames[frameIndex];
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &pFrame->descriptorSet, 0, NULL);
+
+    if (pCulling->drawCountSupported == SDL_TRUE)
+    {
+        vkCmdDrawIndexedIndirectCount(commandBuffer, pFrame->drawBuffer, 0, pFrame->countBuffer, 0, pCulling->objectCount, stride);
+        return;
+    }
+
+    // Culled objects still cost a command each, but the GPU skips them without the CPU knowing which they are
+    for (uint32_t firstDraw = 0; firstDraw < pCulling->objectCount; firstDraw += pCulling->maxDrawCount)
+    {
+        uint32_t drawCount = SDL_min(pCulling->maxDrawCount, pCulling->objectCount - firstDraw);
+        vkCmdDrawIndexedIndirect(commandBuffer, pFrame->drawBuffer, (VkDeviceSize)firstDraw * stride, drawCount, stride);
+    }
+}
+
+Result createCullingFrame(GpuCulling* pCulling, CullingFrame* pFrame, VkDescriptorSetLayout setLayout)
+{
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    VkDeviceSize drawSize = (VkDeviceSize)pCulling->objectCount * sizeof(VkDrawIndexedIndirectCommand);
+    if (createBuffer(pCulling->pAllocator, drawSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, &allocationInfo, &pFrame->drawBuffer, &pFrame->drawAllocation) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    if (createBuffer(pCulling->pAllocator, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        &allocationInfo, &pFrame->countBuffer, &pFrame->countAllocation) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    VkDescriptorSetAllocateInfo allocateInfo;
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext = NULL;
+    allocateInfo.descriptorPool = pCulling->descriptorPool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &setLayout;
+
+    if (vkAllocateDescriptorSets(pCulling->device, &allocateInfo, &pFrame->descriptorSet) != VK_SUCCESS)
+    {
+        return FAIL;
+    }
+
+    VkDescriptorBufferInfo pBufferInfos[3];
+    pBufferInfos[0].buffer = pCulling->objectBuffer;
+    pBufferInfos[1].buffer = pFrame->drawBuffer;
+    pBufferInfos[2].buffer = pFrame->countBuffer;
+
+    VkWriteDescriptorSet pWrites[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        pBufferInfos[i].offset = 0;
+        pBufferInfos[i].range = VK_WHOLE_SIZE;
+
+        pWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        pWrites[i].pNext = NULL;
+        pWrites[i].dstSet = pFrame->descriptorSet;
+        pWrites[i].dstBinding = i;
+        pWrites[i].dstArrayElement = 0;
+        pWrites[i].descriptorCount = 1;
+        pWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pWrites[i].pImageInfo = NULL;
+        pWrites[i].pBufferInfo = &pBufferInfos[i];
+        pWrites[i].pTexelBufferView = NULL;
+    }
+
+    vkUpdateDescriptorSets(pCulling->device, 3, pWrites, 0, NULL);
+
+    return SUCCESS;
+}
@@ -0,0 +1,530 @@
+#include "gpuProfiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char* ppStatisticNames[PROFILER_STATISTIC_COUNT] = {
+    "vertices",
+    "primitives",
+    "vertex invocations",
+    "clipped primitives",
+    "fragment invocations"
+};
+
+static uint32_t findProfilerScope(GpuProfiler* pProfiler, const char* pName);
+
+static void resolveProfilerFrame(GpuProfiler* pProfiler, ProfilerFrame* pFrame);
+
+static void writeProfilerEvent(GpuProfiler* pProfiler, const ProfilerFrame* pFrame, const ProfilerScope* pScope, uint32_t depth, double startMs, double durationMs, const uint64_t* pStatistics);
+
+static void computeScopeStats(const ProfilerScope* pScope, ProfilerScopeStats* pStats);
+
+Result createGpuProfiler(GpuProfiler* pProfiler, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, const char* pOutputPath)
+{
+    memset(pProfiler, 0, sizeof(GpuProfiler));
+    pProfiler->device = device;
+    pProfiler->frameCount = frameCount;
+    pProfiler->firstTraceEvent = SDL_TRUE;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, NULL);
+
+    VkQueueFamilyProperties* pFamilies = malloc(familyCount * sizeof(VkQueueFamilyProperties));
+    if (pFamilies == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for queue families!", familyCount * sizeof(VkQueueFamilyProperties));
+        return FAIL;
+    }
+
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, pFamilies);
+    uint32_t validBits = pFamilies[queueFamilyIndex].timestampValidBits;
+    free(pFamilies);
+
+    if (validBits == 0)
+    {
+        printf("Queue family %u does not support timestamps, GPU profiling is disabled\n\n", queueFamilyIndex);
+        return SUCCESS;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+
+    pProfiler->enabled = SDL_TRUE;
+    pProfiler->statisticsSupported = (features.pipelineStatisticsQuery == VK_TRUE) ? SDL_TRUE : SDL_FALSE;
+    pProfiler->inheritedQueriesSupported = (features.inheritedQueries == VK_TRUE) ? SDL_TRUE : SDL_FALSE;
+    pProfiler->timestampPeriod = properties.limits.timestampPeriod;
+    pProfiler->timestampMask = (validBits >= 64) ? UINT64_MAX : ((1ull << validBits) - 1);
+
+    pProfiler->pFrames = calloc(frameCount, sizeof(ProfilerFrame));
+    if (pProfiler->pFrames == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for profiler frames!", frameCount * sizeof(ProfilerFrame));
+        destroyGpuProfiler(pProfiler);
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        VkQueryPoolCreateInfo createInfo;
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.pNext = NULL;
+        createInfo.flags = 0;
+        createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        createInfo.queryCount = 2 * MAX_PROFILER_FRAME_SCOPES;
+        createInfo.pipelineStatistics = 0;
+
+        if (vkCreateQueryPool(device, &createInfo, NULL, &pProfiler->pFrames[i].timestampPool) != VK_SUCCESS)
+        {
+            printError("Failed to create timestamp query pool %u!", i);
+            destroyGpuProfiler(pProfiler);
+            return FAIL;
+        }
+
+        if (pProfiler->statisticsSupported != SDL_TRUE)
+        {
+            continue;
+        }
+
+        // Results are returned in bit order, which is the order of ppStatisticNames
+        createInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        createInfo.queryCount = MAX_PROFILER_FRAME_STATISTICS;
+        createInfo.pipelineStatistics = PROFILER_STATISTIC_FLAGS;
+
+        if (vkCreateQueryPool(device, &createInfo, NULL, &pProfiler->pFrames[i].statisticsPool) != VK_SUCCESS)
+        {
+            printError("Failed to create pipeline statistics query pool %u!", i);
+            destroyGpuProfiler(pProfiler);
+            return FAIL;
+        }
+    }
+
+    if (pOutputPath == NULL)
+    {
+        return SUCCESS;
+    }
+
+    size_t pathLength = strlen(pOutputPath);
+    pProfiler->output = ((pathLength >= 5) && (SDL_strcasecmp(pOutputPath + pathLength - 5, ".json") == 0)) ? PROFILER_OUTPUT_CHROME_TRACE : PROFILER_OUTPUT_CSV;
+
+    pProfiler->pOutputFile = fopen(pOutputPath, "w");
+    if (pProfiler->pOutputFile == NULL)
+    {
+        printError("Failed to open profile output file \"%s\"!", pOutputPath);
+        pProfiler->output = PROFILER_OUTPUT_NONE;
+        destroyGpuProfiler(pProfiler);
+        return FAIL;
+    }
+
+    // The device and driver go first, runs are only comparable with them
+    uint32_t apiVersion = properties.apiVersion;
+    if (pProfiler->output == PROFILER_OUTPUT_CHROME_TRACE)
+    {
+        fprintf(pProfiler->pOutputFile, "{\"otherData\":{\"device\":\"%s\",\"driverVersion\":%u,\"apiVersion\":\"%u.%u.%u\"},\n\"traceEvents\":[",
+            properties.deviceName, properties.driverVersion, VK_API_VERSION_MAJOR(apiVersion), VK_API_VERSION_MINOR(apiVersion), VK_API_VERSION_PATCH(apiVersion));
+    }
+    else
+    {
+        fprintf(pProfiler->pOutputFile, "# %s, driver version %u (0x%08x), Vulkan %u.%u.%u\n",
+            properties.deviceName, properties.driverVersion, properties.driverVersion, VK_API_VERSION_MAJOR(apiVersion), VK_API_VERSION_MINOR(apiVersion), VK_API_VERSION_PATCH(apiVersion));
+        fprintf(pProfiler->pOutputFile, "frame,scope,depth,start_ms,duration_ms");
+        for (uint32_t i = 0; i < PROFILER_STATISTIC_COUNT; ++i)
+        {
+            fprintf(pProfiler->pOutputFile, ",%s", ppStatisticNames[i]);
+        }
+        fprintf(pProfiler->pOutputFile, "\n");
+    }
+
+    return SUCCESS;
+}
+
+void destroyGpuProfiler(GpuProfiler* pProfiler)
+{
+    if (pProfiler->pFrames != NULL)
+    {
+        // Oldest frame first, so the output stays in submission order
+        for (;;)
+        {
+            ProfilerFrame* pOldestFrame = NULL;
+            for (uint32_t i = 0; i < pProfiler->frameCount; ++i)
+            {
+                ProfilerFrame* pFrame = &pProfiler->pFrames[i];
+                if ((pFrame->recorded == SDL_TRUE) && ((pOldestFrame == NULL) || (pFrame->frameNumber < pOldestFrame->frameNumber)))
+                {
+                    pOldestFrame = pFrame;
+                }
+            }
+
+            if (pOldestFrame == NULL)
+            {
+                break;
+            }
+
+            resolveProfilerFrame(pProfiler, pOldestFrame);
+        }
+
+        for (uint32_t i = 0; i < pProfiler->frameCount; ++i)
+        {
+            vkDestroyQueryPool(pProfiler->device, pProfiler->pFrames[i].statisticsPool, NULL);
+            vkDestroyQueryPool(pProfiler->device, pProfiler->pFrames[i].timestampPool, NULL);
+        }
+    }
+
+    free(pProfiler->pFrames);
+    pProfiler->pFrames = NULL;
+
+    if (pProfiler->pOutputFile != NULL)
+    {
+        if (pProfiler->output == PROFILER_OUTPUT_CHROME_TRACE)
+        {
+            fprintf(pProfiler->pOutputFile, "\n]}\n");
+        }
+
+        fclose(pProfiler->pOutputFile);
+        pProfiler->pOutputFile = NULL;
+    }
+
+    pProfiler->enabled = SDL_FALSE;
+}
+
+void beginProfilerFrame(GpuProfiler* pProfiler, VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (pProfiler->enabled != SDL_TRUE)
+    {
+        return;
+    }
+
+    // The fence of this frame slot was waited on before recording, so its queries are complete and read without blocking
+    ProfilerFrame* pFrame = &pProfiler->pFrames[frameIndex];
+    if (pFrame->recorded == SDL_TRUE)
+    {
+        resolveProfilerFrame(pProfiler, pFrame);
+    }
+
+    vkCmdResetQueryPool(commandBuffer, pFrame->timestampPool, 0, 2 * MAX_PROFILER_FRAME_SCOPES);
+    if (pFrame->statisticsPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, pFrame->statisticsPool, 0, MAX_PROFILER_FRAME_STATISTICS);
+    }
+
+    pFrame->recorded = SDL_TRUE;
+    pFrame->frameNumber = pProfiler->recordedFrameCount++;
+    pFrame->scopeCount = 0;
+    pFrame->statisticsCount = 0;
+
+    pProfiler->pCurrentFrame = pFrame;
+    pProfiler->openScopeCount = 0;
+    pProfiler->overflowScopeCount = 0;
+    pProfiler->statisticsOpen = SDL_FALSE;
+}
+
+void beginProfilerScope(GpuProfiler* pProfiler, VkCommandBuffer commandBuffer, const char* pName, SDL_bool collectStatistics)
+{
+    if ((pProfiler->enabled != SDL_TRUE) || (pProfiler->pCurrentFrame == NULL))
+    {
+        return;
+    }
+
+    ProfilerFrame* pFrame = pProfiler->pCurrentFrame;
+    uint32_t scopeIndex = findProfilerScope(pProfiler, pName);
+
+    // Scopes nested deeper than the stack are only counted, so that their ends do not close the enclosing scopes
+    if (pProfiler->openScopeCount >= MAX_PROFILER_DEPTH)
+    {
+        ++pProfiler->overflowScopeCount;
+        return;
+    }
+
+    // Scopes past the limits are still pushed, so that endProfilerScope stays balanced
+    if ((scopeIndex == UINT32_MAX) || (pFrame->scopeCount >= MAX_PROFILER_FRAME_SCOPES))
+    {
+        pProfiler->pOpenScopes[pProfiler->openScopeCount++] = UINT32_MAX;
+        return;
+    }
+
+    uint32_t slot = pFrame->scopeCount++;
+    pFrame->pScopeIndices[slot] = scopeIndex;
+    pFrame->pScopeDepths[slot] = pProfiler->openScopeCount;
+    pFrame->pStatisticsSlots[slot] = UINT32_MAX;
+
+    if ((collectStatistics == SDL_TRUE) && (pFrame->statisticsPool != VK_NULL_HANDLE) && (pProfiler->statisticsOpen != SDL_TRUE)
+        && (pFrame->statisticsCount < MAX_PROFILER_FRAME_STATISTICS))
+    {
+        pFrame->pStatisticsSlots[slot] = pFrame->statisticsCount++;
+        pProfiler->statisticsOpen = SDL_TRUE;
+        vkCmdBeginQuery(commandBuffer, pFrame->statisticsPool, pFrame->pStatisticsSlots[slot], 0);
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pFrame->timestampPool, 2 * slot);
+
+    pProfiler->pOpenScopes[pProfiler->openScopeCount++] = slot;
+}
+
+void endProfilerScope(GpuProfiler* pProfiler, VkCommandBuffer commandBuffer)
+{
+    if ((pProfiler->enabled != SDL_TRUE) || (pProfiler->pCurrentFrame == NULL) || (pProfiler->openScopeCount == 0))
+    {
+        return;
+    }
+
+    if (pProfiler->overflowScopeCount > 0)
+    {
+        --pProfiler->overflowScopeCount;
+        return;
+    }
+
+    ProfilerFrame* pFrame = pProfiler->pCurrentFrame;
+    uint32_t slot = pProfiler->pOpenScopes[--pProfiler->openScopeCount];
+
+    if (slot == UINT32_MAX)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pFrame->timestampPool, 2 * slot + 1);
+
+    if (pFrame->pStatisticsSlots[slot] != UINT32_MAX)
+    {
+        vkCmdEndQuery(commandBuffer, pFrame->statisticsPool, pFrame->pStatisticsSlots[slot]);
+        pProfiler->statisticsOpen = SDL_FALSE;
+    }
+}
+
+void printGpuProfilerStats(const GpuProfiler* pProfiler)
+{
+    if ((pProfiler->enabled != SDL_TRUE) || (pProfiler->resolvedFrameCount == 0))
+    {
+        return;
+    }
+
+    printf("GPU time over the last %u samples (%llu frames resolved, %llu dropped):\n", PROFILER_HISTORY_SIZE,
+        (unsigned long long)pProfiler->resolvedFrameCount, (unsigned long long)pProfiler->droppedFrameCount);
+
+    for (uint32_t i = 0; i < pProfiler->scopeCount; ++i)
+    {
+        const ProfilerScope* pScope = &pProfiler->pScopes[i];
+        if (pScope->sampleCount == 0)
+        {
+            continue;
+        }
+
+        ProfilerScopeStats stats;
+        computeScopeStats(pScope, &stats);
+
+        int indent = (int)(pScope->depth * 2);
+
+        printf("    %*s%-*s min %.3f ms, avg %.3f ms, p99 %.3f ms\n", indent, "", 24 - indent, pScope->pName, stats.minMs, stats.averageMs, stats.p99Ms);
+
+        if (pScope->hasStatistics == SDL_TRUE)
+        {
+            printf("    %*s%-*s", indent, "", 24 - indent, "");
+            for (uint32_t j = 0; j < PROFILER_STATISTIC_COUNT; ++j)
+            {
+                printf("%s%s %.0f", (j > 0) ? ", " : " ", ppStatisticNames[j], (double)pScope->pStatisticSums[j] / pScope->statisticSampleCount);
+            }
+            printf("\n");
+        }
+    }
+
+    printf("\n");
+}
+
+VkQueryPipelineStatisticFlags getProfilerStatisticFlags(const GpuProfiler* pProfiler)
+{
+    if ((pProfiler->enabled != SDL_TRUE) || (pProfiler->statisticsSupported != SDL_TRUE) || (pProfiler->inheritedQueriesSupported != SDL_TRUE))
+    {
+        return 0;
+    }
+
+    return PROFILER_STATISTIC_FLAGS;
+}
+
+void resetGpuProfilerStats(GpuProfiler* pProfiler)
+{
+    for (uint32_t i = 0; i < pProfiler->scopeCount; ++i)
+    {
+        ProfilerScope* pScope = &pProfiler->pScopes[i];
+        pScope->sampleCount = 0;
+        pScope->hasStatistics = SDL_FALSE;
+        pScope->statisticSampleCount = 0;
+        memset(pScope->pStatisticSums, 0, sizeof(pScope->pStatisticSums));
+    }
+
+    pProfiler->resolvedFrameCount = 0;
+    pProfiler->droppedFrameCount = 0;
+}
+
+Result getProfilerScopeStats(const GpuProfiler* pProfiler, const char* pName, ProfilerScopeStats* pStats)
+{
+    for (uint32_t i = 0; i < pProfiler->scopeCount; ++i)
+    {
+        const ProfilerScope* pScope = &pProfiler->pScopes[i];
+        if ((strcmp(pScope->pName, pName) == 0) && (pScope->sampleCount > 0))
+        {
+            computeScopeStats(pScope, pStats);
+            return SUCCESS;
+        }
+    }
+
+    return FAIL;
+}
+
+Result getProfilerScopeStatistic(const GpuProfiler* pProfiler, const char* pName, uint32_t statistic, double* pAverage)
+{
+    for (uint32_t i = 0; i < pProfiler->scopeCount; ++i)
+    {
+        const ProfilerScope* pScope = &pProfiler->pScopes[i];
+        if ((strcmp(pScope->pName, pName) == 0) && (pScope->hasStatistics == SDL_TRUE) && (pScope->statisticSampleCount > 0))
+        {
+            *pAverage = (double)pScope->pStatisticSums[statistic] / pScope->statisticSampleCount;
+            return SUCCESS;
+        }
+    }
+
+    return FAIL;
+}
+
+uint32_t findProfilerScope(GpuProfiler* pProfiler, const char* pName)
+{
+    for (uint32_t i = 0; i < pProfiler->scopeCount; ++i)
+    {
+        if ((pProfiler->pScopes[i].pName == pName) || (strcmp(pProfiler->pScopes[i].pName, pName) == 0))
+        {
+            return i;
+        }
+    }
+
+    if (pProfiler->scopeCount >= MAX_PROFILER_SCOPES)
+    {
+        return UINT32_MAX;
+    }
+
+    ProfilerScope* pScope = &pProfiler->pScopes[pProfiler->scopeCount];
+    memset(pScope, 0, sizeof(ProfilerScope));
+    pScope->pName = pName;
+
+    return pProfiler->scopeCount++;
+}
+
+void resolveProfilerFrame(GpuProfiler* pProfiler, ProfilerFrame* pFrame)
+{
+    pFrame->recorded = SDL_FALSE;
+
+    if (pFrame->scopeCount == 0)
+    {
+        return;
+    }
+
+    // Without the wait bit unfinished queries give VK_NOT_READY, which only happens for frames that were never submitted
+    uint64_t pTimestamps[2 * MAX_PROFILER_FRAME_SCOPES];
+    if (vkGetQueryPoolResults(pProfiler->device, pFrame->timestampPool, 0, 2 * pFrame->scopeCount, sizeof(pTimestamps), pTimestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        ++pProfiler->droppedFrameCount;
+        return;
+    }
+
+    uint64_t pStatistics[MAX_PROFILER_FRAME_STATISTICS * PROFILER_STATISTIC_COUNT];
+    SDL_bool statisticsValid = SDL_FALSE;
+    if (pFrame->statisticsCount > 0)
+    {
+        statisticsValid = (vkGetQueryPoolResults(pProfiler->device, pFrame->statisticsPool, 0, pFrame->statisticsCount, sizeof(pStatistics), pStatistics,
+            PROFILER_STATISTIC_COUNT * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) ? SDL_TRUE : SDL_FALSE;
+    }
+
+    if (pProfiler->hasTimeOrigin != SDL_TRUE)
+    {
+        pProfiler->timeOrigin = pTimestamps[0];
+        pProfiler->hasTimeOrigin = SDL_TRUE;
+    }
+
+    double msPerTick = pProfiler->timestampPeriod / 1000000.0;
+
+    for (uint32_t i = 0; i < pFrame->scopeCount; ++i)
+    {
+        ProfilerScope* pScope = &pProfiler->pScopes[pFrame->pScopeIndices[i]];
+
+        // Masked differences stay correct when the counter wraps around
+        uint64_t begin = pTimestamps[2 * i];
+        uint64_t end = pTimestamps[2 * i + 1];
+        double startMs = (double)((begin - pProfiler->timeOrigin) & pProfiler->timestampMask) * msPerTick;
+        double durationMs = (double)((end - begin) & pProfiler->timestampMask) * msPerTick;
+
+        pScope->pHistory[pScope->sampleCount % PROFILER_HISTORY_SIZE] = (float)durationMs;
+        ++pScope->sampleCount;
+        pScope->depth = pFrame->pScopeDepths[i];
+
+        const uint64_t* pScopeStatistics = NULL;
+        if ((statisticsValid == SDL_TRUE) && (pFrame->pStatisticsSlots[i] != UINT32_MAX))
+        {
+            pScopeStatistics = &pStatistics[pFrame->pStatisticsSlots[i] * PROFILER_STATISTIC_COUNT];
+            for (uint32_t j = 0; j < PROFILER_STATISTIC_COUNT; ++j)
+            {
+                pScope->pStatisticSums[j] += pScopeStatistics[j];
+            }
+            ++pScope->statisticSampleCount;
+            pScope->hasStatistics = SDL_TRUE;
+        }
+
+        writeProfilerEvent(pProfiler, pFrame, pScope, pFrame->pScopeDepths[i], startMs, durationMs, pScopeStatistics);
+    }
+
+    ++pProfiler->resolvedFrameCount;
+}
+
+void writeProfilerEvent(GpuProfiler* pProfiler, const ProfilerFrame* pFrame, const ProfilerScope* pScope, uint32_t depth, double startMs, double durationMs, const uint64_t* pStatistics)
+{
+    FILE* pFile = pProfiler->pOutputFile;
+
+    if (pProfiler->output == PROFILER_OUTPUT_CSV)
+    {
+        fprintf(pFile, "%llu,%s,%u,%.6f,%.6f", (unsigned long long)pFrame->frameNumber, pScope->pName, depth, startMs, durationMs);
+        for (uint32_t i = 0; i < PROFILER_STATISTIC_COUNT; ++i)
+        {
+            if (pStatistics != NULL)
+            {
+                fprintf(pFile, ",%llu", (unsigned long long)pStatistics[i]);
+            }
+            else
+            {
+                fprintf(pFile, ",");
+            }
+        }
+        fprintf(pFile, "\n");
+    }
+    else if (pProfiler->output == PROFILER_OUTPUT_CHROME_TRACE)
+    {
+        // Complete events in microseconds, the viewer nests them by time
+        fprintf(pFile, "%s\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu",
+            (pProfiler->firstTraceEvent == SDL_TRUE) ? "" : ",", pScope->pName, startMs * 1000.0, durationMs * 1000.0, (unsigned long long)pFrame->frameNumber);
+        if (pStatistics != NULL)
+        {
+            for (uint32_t i = 0; i < PROFILER_STATISTIC_COUNT; ++i)
+            {
+                fprintf(pFile, ",\"%s\":%llu", ppStatisticNames[i], (unsigned long long)pStatistics[i]);
+            }
+        }
+        fprintf(pFile, "}}");
+        pProfiler->firstTraceEvent = SDL_FALSE;
+    }
+}
+
+void computeScopeStats(const ProfilerScope* pScope, ProfilerScopeStats* pStats)
+{
+    float pSorted[PROFILER_HISTORY_SIZE];
+    uint32_t sampleCount = (pScope->sampleCount < PROFILER_HISTORY_SIZE) ? (uint32_t)pScope->sampleCount : PROFILER_HISTORY_SIZE;
+    memcpy(pSorted, pScope->pHistory, sampleCount * sizeof(float));
+    sortFloats(pSorted, sampleCount);
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        sum += pSorted[i];
+    }
+
+    pStats->sampleCount = sampleCount;
+    pStats->minMs = pSorted[0];
+    pStats->averageMs = (float)(sum / sampleCount);
+    pStats->p99Ms = getSortedPercentile(pSorted, sampleCount, 99);
+}
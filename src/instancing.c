@@ -0,0 +1,72 @@
+#include "instancing.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+static int compareDrawItems(const void* pA, const void* pB);
+
+void addInstanceInputState(uint32_t* pBindingCount, VkVertexInputBindingDescription* pBindings, uint32_t* pAttributeCount, VkVertexInputAttributeDescription* pAttributes)
+{
+    VkVertexInputBindingDescription* pBinding = &pBindings[(*pBindingCount)++];
+    pBinding->binding = INSTANCE_BINDING;
+    pBinding->stride = sizeof(InstanceData);
+    pBinding->inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        VkVertexInputAttributeDescription* pAttribute = &pAttributes[(*pAttributeCount)++];
+        pAttribute->location = INSTANCE_FIRST_LOCATION + i;
+        pAttribute->binding = INSTANCE_BINDING;
+        pAttribute->format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        pAttribute->offset = offsetof(InstanceData, model) + i * 4 * sizeof(float);
+    }
+}
+
+uint32_t batchDrawItems(DrawItem* pItems, uint32_t itemCount, DrawBatch* pBatches)
+{
+    // Scenes are mostly submitted grouped already, which saves the sort
+    for (uint32_t i = 1; i < itemCount; ++i)
+    {
+        if (compareDrawItems(&pItems[i - 1], &pItems[i]) > 0)
+        {
+            qsort(pItems, itemCount, sizeof(DrawItem), compareDrawItems);
+            break;
+        }
+    }
+
+    uint32_t batchCount = 0;
+    for (uint32_t i = 0; i < itemCount; ++i)
+    {
+        if ((batchCount > 0) && (pBatches[batchCount - 1].mesh == pItems[i].mesh) && (pBatches[batchCount - 1].material == pItems[i].material))
+        {
+            ++pBatches[batchCount - 1].instanceCount;
+            continue;
+        }
+
+        DrawBatch* pBatch = &pBatches[batchCount++];
+        pBatch->mesh = pItems[i].mesh;
+        pBatch->material = pItems[i].material;
+        pBatch->firstInstance = i;
+        pBatch->instanceCount = 1;
+    }
+
+    return batchCount;
+}
+
+int compareDrawItems(const void* pA, const void* pB)
+{
+    const DrawItem* pItemA = pA;
+    const DrawItem* pItemB = pB;
+
+    if (pItemA->mesh != pItemB->mesh)
+    {
+        return (pItemA->mesh < pItemB->mesh) ? -1 : 1;
+    }
+
+    if (pItemA->material != pItemB->material)
+    {
+        return (pItemA->material < pItemB->material) ? -1 : 1;
+    }
+
+    return (pItemA->object > pItemB->object) - (pItemA->object < pItemB->object);
+}
@@ -0,0 +1,360 @@
+#include "json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_JSON_DEPTH 64
+
+typedef struct JsonParser
+{
+    const char*      pText;
+    const char*      pEnd;
+    const char*      pCurrent;
+    JsonDocument*    pDocument;
+} JsonParser;
+
+static void skipWhitespace(JsonParser* pParser);
+
+static Result addValue(JsonParser* pParser, JsonType type, uint32_t* pIndex);
+
+static Result parseString(JsonParser* pParser, const char** ppString, uint32_t* pLength);
+
+static Result parseValue(JsonParser* pParser, uint32_t depth, uint32_t* pIndex);
+
+static void appendChild(JsonDocument* pDocument, uint32_t parent, uint32_t child);
+
+Result parseJson(const char* pText, size_t length, JsonDocument* pDocument)
+{
+    pDocument->valueCount = 0;
+    pDocument->valueCapacity = 0;
+    pDocument->pValues = NULL;
+
+    JsonParser parser;
+    parser.pText = pText;
+    parser.pEnd = pText + length;
+    parser.pCurrent = pText;
+    parser.pDocument = pDocument;
+
+    uint32_t root;
+    if (parseValue(&parser, 0, &root) != SUCCESS)
+    {
+        printError("Failed to parse JSON at offset %lu!", (unsigned long)(parser.pCurrent - pText));
+        destroyJson(pDocument);
+        return FAIL;
+    }
+
+    skipWhitespace(&parser);
+    if ((parser.pCurrent < parser.pEnd) && (*parser.pCurrent != '\0'))
+    {
+        printError("Unexpected data after JSON value at offset %lu!", (unsigned long)(parser.pCurrent - pText));
+        destroyJson(pDocument);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyJson(JsonDocument* pDocument)
+{
+    free(pDocument->pValues);
+    pDocument->pValues = NULL;
+    pDocument->valueCount = 0;
+    pDocument->valueCapacity = 0;
+}
+
+uint32_t getJsonMember(const JsonDocument* pDocument, uint32_t object, const char* pKey)
+{
+    if ((object == JSON_NONE) || (pDocument->pValues[object].type != JSON_TYPE_OBJECT))
+    {
+        return JSON_NONE;
+    }
+
+    size_t keyLength = strlen(pKey);
+
+    for (uint32_t child = pDocument->pValues[object].firstChild; child != JSON_NONE; child = pDocument->pValues[child].nextSibling)
+    {
+        const JsonValue* pValue = &pDocument->pValues[child];
+        if ((pValue->keyLength == keyLength) && (memcmp(pValue->pKey, pKey, keyLength) == 0))
+        {
+            return child;
+        }
+    }
+
+    return JSON_NONE;
+}
+
+uint32_t getJsonElement(const JsonDocument* pDocument, uint32_t array, uint32_t index)
+{
+    if ((array == JSON_NONE) || (pDocument->pValues[array].type != JSON_TYPE_ARRAY) || (index >= pDocument->pValues[array].childCount))
+    {
+        return JSON_NONE;
+    }
+
+    uint32_t child = pDocument->pValues[array].firstChild;
+    for (uint32_t i = 0; i < index; ++i)
+    {
+        child = pDocument->pValues[child].nextSibling;
+    }
+
+    return child;
+}
+
+double getJsonNumber(const JsonDocument* pDocument, uint32_t object, const char* pKey, double defaultValue)
+{
+    uint32_t member = getJsonMember(pDocument, object, pKey);
+    if ((member == JSON_NONE) || (pDocument->pValues[member].type != JSON_TYPE_NUMBER))
+    {
+        return defaultValue;
+    }
+
+    return pDocument->pValues[member].number;
+}
+
+SDL_bool isJsonString(const JsonDocument* pDocument, uint32_t value, const char* pString)
+{
+    if ((value == JSON_NONE) || (pDocument->pValues[value].type != JSON_TYPE_STRING))
+    {
+        return SDL_FALSE;
+    }
+
+    size_t length = strlen(pString);
+    const JsonValue* pValue = &pDocument->pValues[value];
+
+    return ((pValue->stringLength == length) && (memcmp(pValue->pString, pString, length) == 0)) ? SDL_TRUE : SDL_FALSE;
+}
+
+void skipWhitespace(JsonParser* pParser)
+{
+    while ((pParser->pCurrent < pParser->pEnd)
+        && ((*pParser->pCurrent == ' ') || (*pParser->pCurrent == '\t') || (*pParser->pCurrent == '\n') || (*pParser->pCurrent == '\r')))
+    {
+        ++pParser->pCurrent;
+    }
+}
+
+Result addValue(JsonParser* pParser, JsonType type, uint32_t* pIndex)
+{
+    JsonDocument* pDocument = pParser->pDocument;
+
+    if (pDocument->valueCount == pDocument->valueCapacity)
+    {
+        uint32_t newCapacity = (pDocument->valueCapacity > 0) ? pDocument->valueCapacity * 2 : 256;
+
+        JsonValue* pValues = realloc(pDocument->pValues, newCapacity * sizeof(JsonValue));
+        if (pValues == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for JSON values!", newCapacity * sizeof(JsonValue));
+            return FAIL;
+        }
+
+        pDocument->pValues = pValues;
+        pDocument->valueCapacity = newCapacity;
+    }
+
+    JsonValue* pValue = &pDocument->pValues[pDocument->valueCount];
+    memset(pValue, 0, sizeof(JsonValue));
+    pValue->type = type;
+    pValue->firstChild = JSON_NONE;
+    pValue->lastChild = JSON_NONE;
+    pValue->nextSibling = JSON_NONE;
+
+    *pIndex = pDocument->valueCount++;
+    return SUCCESS;
+}
+
+Result parseString(JsonParser* pParser, const char** ppString, uint32_t* pLength)
+{
+    if ((pParser->pCurrent >= pParser->pEnd) || (*pParser->pCurrent != '"'))
+    {
+        return FAIL;
+    }
+
+    const char* pStart = ++pParser->pCurrent;
+
+    while (pParser->pCurrent < pParser->pEnd)
+    {
+        char c = *pParser->pCurrent;
+        if (c == '"')
+        {
+            *ppString = pStart;
+            *pLength = (uint32_t)(pParser->pCurrent - pStart);
+            ++pParser->pCurrent;
+            return SUCCESS;
+        }
+
+        // Escapes are kept as they are, only skip the escaped character so \" does not end the string
+        pParser->pCurrent += (c == '\\') ? 2 : 1;
+    }
+
+    return FAIL;
+}
+
+Result parseValue(JsonParser* pParser, uint32_t depth, uint32_t* pIndex)
+{
+    if (depth > MAX_JSON_DEPTH)
+    {
+        return FAIL;
+    }
+
+    skipWhitespace(pParser);
+    if (pParser->pCurrent >= pParser->pEnd)
+    {
+        return FAIL;
+    }
+
+    char c = *pParser->pCurrent;
+
+    if ((c == '{') || (c == '['))
+    {
+        SDL_bool object = (c == '{') ? SDL_TRUE : SDL_FALSE;
+        char closing = (object == SDL_TRUE) ? '}' : ']';
+
+        uint32_t container;
+        if (addValue(pParser, (object == SDL_TRUE) ? JSON_TYPE_OBJECT : JSON_TYPE_ARRAY, &container) != SUCCESS)
+        {
+            return FAIL;
+        }
+
+        ++pParser->pCurrent;
+        skipWhitespace(pParser);
+
+        if ((pParser->pCurrent < pParser->pEnd) && (*pParser->pCurrent == closing))
+        {
+            ++pParser->pCurrent;
+            *pIndex = container;
+            return SUCCESS;
+        }
+
+        while (1)
+        {
+            const char* pKey = NULL;
+            uint32_t keyLength = 0;
+
+            if (object == SDL_TRUE)
+            {
+                skipWhitespace(pParser);
+                if (parseString(pParser, &pKey, &keyLength) != SUCCESS)
+                {
+                    return FAIL;
+                }
+
+                skipWhitespace(pParser);
+                if ((pParser->pCurrent >= pParser->pEnd) || (*pParser->pCurrent != ':'))
+                {
+                    return FAIL;
+                }
+
+                ++pParser->pCurrent;
+            }
+
+            uint32_t child;
+            if (parseValue(pParser, depth + 1, &child) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            pParser->pDocument->pValues[child].pKey = pKey;
+            pParser->pDocument->pValues[child].keyLength = keyLength;
+            appendChild(pParser->pDocument, container, child);
+
+            skipWhitespace(pParser);
+            if (pParser->pCurrent >= pParser->pEnd)
+            {
+                return FAIL;
+            }
+
+            if (*pParser->pCurrent == ',')
+            {
+                ++pParser->pCurrent;
+                continue;
+            }
+
+            if (*pParser->pCurrent == closing)
+            {
+                ++pParser->pCurrent;
+                *pIndex = container;
+                return SUCCESS;
+            }
+
+            return FAIL;
+        }
+    }
+
+    if (c == '"')
+    {
+        if (addValue(pParser, JSON_TYPE_STRING, pIndex) != SUCCESS)
+        {
+            return FAIL;
+        }
+
+        JsonValue* pValue = &pParser->pDocument->pValues[*pIndex];
+        return parseString(pParser, &pValue->pString, &pValue->stringLength);
+    }
+
+    if ((c == '-') || ((c >= '0') && (c <= '9')))
+    {
+        // The text is not null terminated in binary containers, so copy the number out before strtod
+        char pNumber[64];
+        size_t length = 0;
+        while ((pParser->pCurrent + length < pParser->pEnd) && (length < sizeof(pNumber) - 1)
+            && (strchr("+-.eE0123456789", pParser->pCurrent[length]) != NULL))
+        {
+            pNumber[length] = pParser->pCurrent[length];
+            ++length;
+        }
+
+        pNumber[length] = '\0';
+
+        char* pNumberEnd = NULL;
+        double number = strtod(pNumber, &pNumberEnd);
+        if (pNumberEnd != pNumber + length)
+        {
+            return FAIL;
+        }
+
+        if (addValue(pParser, JSON_TYPE_NUMBER, pIndex) != SUCCESS)
+        {
+            return FAIL;
+        }
+
+        pParser->pDocument->pValues[*pIndex].number = number;
+        pParser->pCurrent += length;
+        return SUCCESS;
+    }
+
+    static const char* ppLiterals[] = { "true", "false", "null" };
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        size_t length = strlen(ppLiterals[i]);
+        if (((size_t)(pParser->pEnd - pParser->pCurrent) >= length) && (memcmp(pParser->pCurrent, ppLiterals[i], length) == 0))
+        {
+            if (addValue(pParser, (i < 2) ? JSON_TYPE_BOOLEAN : JSON_TYPE_NULL, pIndex) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            pParser->pDocument->pValues[*pIndex].number = (i == 0) ? 1.0 : 0.0;
+            pParser->pCurrent += length;
+            return SUCCESS;
+        }
+    }
+
+    return FAIL;
+}
+
+void appendChild(JsonDocument* pDocument, uint32_t parent, uint32_t child)
+{
+    JsonValue* pParent = &pDocument->pValues[parent];
+
+    if (pParent->lastChild == JSON_NONE)
+    {
+        pParent->firstChild = child;
+    }
+    else
+    {
+        pDocument->pValues[pParent->lastChild].nextSibling = child;
+    }
+
+    pParent->lastChild = child;
+    ++pParent->childCount;
+}
@@ -1,89 +1,62 @@
 #include "layers.h"
 
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
-#include <vulkan/vulkan.h>
-
 #include <SDL.h>
 
-Result getAvailableInstanceLayers(uint32_t* pLayerCount, char*** pppLayers)
+Result getAvailableInstanceLayers(Arena* pArena, uint32_t* pLayerCount, VkLayerProperties** ppLayers)
 {
+    *ppLayers = NULL;
+
     vkEnumerateInstanceLayerProperties(pLayerCount, NULL);
 
     if (*pLayerCount > 0)
     {
-        VkLayerProperties* pProperties = malloc(*pLayerCount * sizeof(VkLayerProperties));
-        if (pProperties == NULL)
+        *ppLayers = arenaAllocate(pArena, *pLayerCount * sizeof(VkLayerProperties));
+        if (*ppLayers == NULL)
         {
             printError("Failed to allocate %lu bytes of memory for available instance layers properties!", *pLayerCount * sizeof(VkLayerProperties));
             return FAIL;
         }
 
-        vkEnumerateInstanceLayerProperties(pLayerCount, pProperties);
-
-        *pppLayers = calloc(*pLayerCount, sizeof(char*));
-        if (*pppLayers == NULL)
-        {
-            printError("Failed to allocate %lu bytes of memory for available instance layers names!", *pLayerCount * sizeof(char*));
-            free(pProperties);
-            return FAIL;
-        }
-
-        char** ppLayers = *pppLayers;
-
-        for (uint32_t i = 0; i < *pLayerCount; ++i)
-        {
-            const char* pLayerName = pProperties[i].layerName;
-
-            ppLayers[i] = malloc((strlen(pLayerName) + 1) * sizeof(char));
-            if (ppLayers[i] == NULL)
-            {
-                printError("Failed to allocate %lu bytes of memory for name of instance layer \"%s\"!", (strlen(pLayerName) + 1) * sizeof(char), pLayerName);
-                free(pProperties);
-                return FAIL;
-            }
-
-            strlcpy(ppLayers[i], pLayerName, (strlen(pLayerName) + 1) * sizeof(char));
-        }
-
-        free(pProperties);
+        // Lowers the count if layers were removed in between
+        vkEnumerateInstanceLayerProperties(pLayerCount, *ppLayers);
     }
 
     return SUCCESS;
 }
 
-Result printAvailableInstanceLayers(uint32_t layerCount, char** ppLayers)
+Result printAvailableInstanceLayers(Arena* pArena, uint32_t layerCount, const VkLayerProperties* pLayers)
 {
     printf("Available instance layers[%u]:\n", layerCount);
     for (uint32_t i = 0; i < layerCount; ++i)
     {
+        const char* pLayerName = pLayers[i].layerName;
+
         uint32_t extensionCount;
-        vkEnumerateInstanceExtensionProperties(ppLayers[i], &extensionCount, NULL);
+        vkEnumerateInstanceExtensionProperties(pLayerName, &extensionCount, NULL);
 
         if (extensionCount == 0)
         {
-            printf("    %s\n", ppLayers[i]);
+            printf("    %s\n", pLayerName);
         }
         else
         {
-            VkExtensionProperties* pProperties = malloc(extensionCount * sizeof(VkExtensionProperties));
+            VkExtensionProperties* pProperties = arenaAllocate(pArena, extensionCount * sizeof(VkExtensionProperties));
             if (pProperties == NULL)
             {
-                printError("Failed to allocate %lu bytes of memory for extensions properties of instance layer \"%s\"!", extensionCount * sizeof(VkExtensionProperties), ppLayers[i]);
+                printError("Failed to allocate %lu bytes of memory for extensions properties of instance layer \"%s\"!", extensionCount * sizeof(VkExtensionProperties), pLayerName);
                 return FAIL;
             }
 
-            vkEnumerateInstanceExtensionProperties(ppLayers[i], &extensionCount, pProperties);
+            vkEnumerateInstanceExtensionProperties(pLayerName, &extensionCount, pProperties);
 
-            printf("    %s[%u]:\n", ppLayers[i], extensionCount);
+            printf("    %s[%u]:\n", pLayerName, extensionCount);
             for (uint32_t j = 0; j < extensionCount; ++j)
             {
                 printf("        %s\n", pProperties[j].extensionName);
             }
-
-            free(pProperties);
         }
     }
     printf("\n");
@@ -91,14 +64,14 @@ Result printAvailableInstanceLayers(uint32_t layerCount, char** ppLayers)
     return SUCCESS;
 }
 
-Result checkAvailabilityOfRequiredInstanceLayers(uint32_t availableLayerCount, char** ppAvailableLayers, uint32_t requiredLayerCount, const char** ppRequiredLayers)
+Result checkAvailabilityOfRequiredInstanceLayers(uint32_t availableLayerCount, const VkLayerProperties* pAvailableLayers, uint32_t requiredLayerCount, const char** ppRequiredLayers)
 {
     for (uint32_t i = 0; i < requiredLayerCount; ++i)
     {
         SDL_bool found = SDL_FALSE;
         for (uint32_t j = 0; j < availableLayerCount; ++j)
         {
-            if (strcmp(ppRequiredLayers[i], ppAvailableLayers[j]) == 0)
+            if (strcmp(ppRequiredLayers[i], pAvailableLayers[j].layerName) == 0)
             {
                 found = SDL_TRUE;
                 break;
@@ -114,16 +87,3 @@ Result checkAvailabilityOfRequiredInstanceLayers(uint32_t availableLayerCount, c
 
     return SUCCESS;
 }
-
-void freeInstanceLayers(uint32_t* pAvailableLayerCount, char*** pppAvailableLayers)
-{
-    for (uint32_t i = 0; i < *pAvailableLayerCount; ++i)
-    {
-        free((*pppAvailableLayers)[i]);
-    }
-
-    free(*pppAvailableLayers);
-    *pppAvailableLayers = NULL;
-
-    *pAvailableLayerCount = 0;
-}
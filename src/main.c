@@ -1,39 +1,222 @@
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "Application.h"
+#include "config.h"
+#include "cpuTrace.h"
+#include "meshCache.h"
 
 int main(int argc, char* argv[])
 {
+    Config config;
+    setDefaultConfig(&config);
+
+    if (parseCommandLine(argc, argv, &config) != SUCCESS)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (config.showHelp == SDL_TRUE)
+    {
+        printUsage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+
+    if (config.pConvertPath != NULL)
+    {
+        return (convertMesh(config.pConvertPath) == SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (createCpuTrace(config.pCpuTracePath) != SUCCESS)
+    {
+        printError("Failed to create CPU trace!");
+        return EXIT_FAILURE;
+    }
+
+    nameCpuTraceThread("main");
+
     Application application;
-    if (createApplication(&application) != SUCCESS)
+    if (createApplication(&application, &config) != SUCCESS)
     {
         printError("Failed to create application!");
+        destroyCpuTrace();
         return EXIT_FAILURE;
     }
 
+    if (config.timing == SDL_TRUE)
+    {
+        printStartupTiming(&application);
+    }
+
+    int         exitCode = EXIT_SUCCESS;
+    uint32_t    renderedFrameCount = 0;
+    uint64_t    startTicks = SDL_GetPerformanceCounter();
+
+    FramePacer framePacer;
+    createFramePacer(&framePacer, config.targetFps);
+
     SDL_bool quit = SDL_FALSE;
     while (quit != SDL_TRUE)
     {
+        // Before polling, so the frame sees the input that arrived while waiting
+        uint64_t traceStart = beginCpuTrace();
+        waitForNextFrame(&framePacer);
+        endCpuTrace("pace", traceStart);
+
+        uint64_t frameTraceStart = beginCpuTrace();
+        traceStart = beginCpuTrace();
+
         SDL_Event event;
         while (SDL_PollEvent(&event) == 1)
         {
+            // SDL stamps events in milliseconds when they are queued, so the time spent blocked on the GPU before polling is included
+            SDL_bool isInput = ((event.type == SDL_KEYDOWN) || (event.type == SDL_KEYUP) || (event.type == SDL_MOUSEMOTION) ||
+                (event.type == SDL_MOUSEBUTTONDOWN) || (event.type == SDL_MOUSEBUTTONUP) || (event.type == SDL_MOUSEWHEEL)) ? SDL_TRUE : SDL_FALSE;
+            if ((isInput == SDL_TRUE) && (application.inputTicks == 0))
+            {
+                uint64_t ageMs = SDL_GetTicks() - event.common.timestamp;
+                application.inputTicks = SDL_GetPerformanceCounter() - ageMs * SDL_GetPerformanceFrequency() / 1000;
+            }
+
             switch (event.type)
             {
                 case SDL_QUIT: quit = SDL_TRUE; break;
+                case SDL_WINDOWEVENT:
+                {
+                    // Some platforms never report a resize through VK_ERROR_OUT_OF_DATE_KHR
+                    if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                    {
+                        application.swapchainOutdated = SDL_TRUE;
+                    }
+                    break;
+                }
                 case SDL_KEYDOWN:
                 {
                     switch (event.key.keysym.sym)
                     {
                         case SDLK_ESCAPE: quit = SDL_TRUE; break;
+                        case SDLK_t:
+                        {
+                            if (config.pCpuTracePath != NULL)
+                            {
+                                setCpuTraceEnabled((isCpuTraceEnabled() == SDL_TRUE) ? SDL_FALSE : SDL_TRUE);
+                                printf("CPU trace %s\n", (isCpuTraceEnabled() == SDL_TRUE) ? "resumed" : "paused");
+                            }
+                            break;
+                        }
                         default: break;
                     }
                 }
                 default: break;
             }
         }
+
+        endCpuTrace("poll events", traceStart);
+
+        if (quit == SDL_TRUE)
+        {
+            break;
+        }
+
+        // A minimized window has nothing to render to, so sleep until it is restored
+        if ((application.pWindow != NULL) && ((SDL_GetWindowFlags(application.pWindow) & SDL_WINDOW_MINIMIZED) != 0))
+        {
+            SDL_WaitEvent(NULL);
+            continue;
+        }
+
+        if (drawFrame(&application) != SUCCESS)
+        {
+            printError("Failed to draw frame!");
+            exitCode = EXIT_FAILURE;
+            break;
+        }
+
+        endCpuTrace("frame", frameTraceStart);
+
+        ++renderedFrameCount;
+        if ((renderedFrameCount == 1) && (config.timing == SDL_TRUE))
+        {
+            printf("First frame submitted %.3f ms after startup\n\n", (SDL_GetPerformanceCounter() - application.startTicks) * 1000.0 / SDL_GetPerformanceFrequency());
+        }
+
+        if ((config.frameLimit > 0) && (renderedFrameCount >= config.frameLimit))
+        {
+            quit = SDL_TRUE;
+        }
+    }
+
+    if (renderedFrameCount > 0)
+    {
+        double frequency = (double)SDL_GetPerformanceFrequency();
+        double totalSeconds = (double)(SDL_GetPerformanceCounter() - startTicks) / frequency;
+        double waitSeconds = (double)application.waitTicks / frequency;
+
+        printf("Frames: %u, frames in flight: %u\n", renderedFrameCount, application.frameCount);
+        printf("Average frame time: %.3f ms (%.1f FPS)\n", totalSeconds * 1000.0 / renderedFrameCount, renderedFrameCount / totalSeconds);
+        printf("Average CPU time per frame: %.3f ms (%.3f ms waiting for the GPU)\n", (totalSeconds - waitSeconds) * 1000.0 / renderedFrameCount, waitSeconds * 1000.0 / renderedFrameCount);
+        printf("Average recording time per frame: %.3f ms (%u record threads)\n", (double)application.recordTicks * 1000.0 / frequency / renderedFrameCount, application.recordJobCount);
+
+        // Without instancing every object drawn is a draw call of its own
+        if (application.gpuCullingEnabled != SDL_TRUE)
+        {
+            printf("Average draw calls per frame: %.1f (%.1f without instancing)\n", (double)application.drawCallSum / renderedFrameCount,
+                (double)application.drawnObjectSum / renderedFrameCount);
+        }
+
+        if (application.cpuCullingEnabled == SDL_TRUE)
+        {
+            printf("Average CPU culling time per frame: %.3f ms (%.1f of %u objects visible)\n", (double)application.cullTicks * 1000.0 / frequency / renderedFrameCount,
+                (double)application.drawnObjectSum / renderedFrameCount, config.drawCount);
+        }
+
+        if (application.sortedDrawSum > 0)
+        {
+            double sortSeconds = (double)application.sortTicks / frequency;
+            printf("Average draw sort time per frame: %.3f ms (%.1f million draws per second, %.1f draws moved per frame)\n", sortSeconds * 1000.0 / renderedFrameCount,
+                application.sortedDrawSum / sortSeconds / 1e6, (double)application.reorderedDrawSum / renderedFrameCount);
+        }
+
+        double overdraw;
+        if (getOverdraw(&application, &overdraw) == SUCCESS)
+        {
+            printf("Overdraw: %.2f fragment shader invocations per pixel\n", overdraw);
+        }
+
+        if (application.virtualTextureEnabled == SDL_TRUE)
+        {
+            const VirtualTexture* pTexture = &application.virtualTexture;
+            printf("Virtual texture: %lu tiles uploaded, %lu evicted, %u of %u pages resident in %.3f MiB\n", (unsigned long)pTexture->uploadedTileCount,
+                (unsigned long)pTexture->evictedTileCount, pTexture->residentPageCount, pTexture->pageCount, getVirtualTextureMemory(pTexture) / 1048576.0);
+        }
+
+        if (config.headless != SDL_TRUE)
+        {
+            printf("Present mode: %s, swapchain images: %u, FPS limit: ", getPresentModeName(application.presentMode), application.swapchainImageCount);
+            if (config.targetFps > 0)
+            {
+                printf("%u\n", config.targetFps);
+            }
+            else
+            {
+                printf("none\n");
+            }
+
+            printLatencyHistory(&application.inputLatency, "Input to present");
+        }
+
+        printf("\n");
     }
 
+    printGpuProfilerStats(&application.gpuProfiler);
+
+    printAllocatorStats(&application.allocator);
+
     destroyApplication(&application);
 
-    return EXIT_SUCCESS;
+    // After the application, so the worker threads have been joined
+    destroyCpuTrace();
+
+    return exitCode;
 }
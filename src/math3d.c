@@ -0,0 +1,163 @@
+#include "math3d.h"
+
+#include <math.h>
+#include <string.h>
+
+Mat4 identityMat4(void)
+{
+    return scaleMat4(1.0f, 1.0f, 1.0f);
+}
+
+Mat4 multiplyMat4(Mat4 a, Mat4 b)
+{
+    Mat4 result;
+
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k)
+            {
+                sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+            }
+
+            result.m[column * 4 + row] = sum;
+        }
+    }
+
+    return result;
+}
+
+Mat4 translationMat4(float x, float y, float z)
+{
+    Mat4 result = identityMat4();
+    result.m[12] = x;
+    result.m[13] = y;
+    result.m[14] = z;
+    return result;
+}
+
+Mat4 scaleMat4(float x, float y, float z)
+{
+    Mat4 result;
+    memset(&result, 0, sizeof(result));
+    result.m[0] = x;
+    result.m[5] = y;
+    result.m[10] = z;
+    result.m[15] = 1.0f;
+    return result;
+}
+
+Mat4 rotationXMat4(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+
+    Mat4 result = identityMat4();
+    result.m[5] = c;
+    result.m[6] = s;
+    result.m[9] = -s;
+    result.m[10] = c;
+    return result;
+}
+
+Mat4 rotationYMat4(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+
+    Mat4 result = identityMat4();
+    result.m[0] = c;
+    result.m[2] = -s;
+    result.m[8] = s;
+    result.m[10] = c;
+    return result;
+}
+
+Mat4 quaternionMat4(float x, float y, float z, float w)
+{
+    Mat4 result = identityMat4();
+    result.m[0] = 1.0f - 2.0f * (y * y + z * z);
+    result.m[1] = 2.0f * (x * y + z * w);
+    result.m[2] = 2.0f * (x * z - y * w);
+    result.m[4] = 2.0f * (x * y - z * w);
+    result.m[5] = 1.0f - 2.0f * (x * x + z * z);
+    result.m[6] = 2.0f * (y * z + x * w);
+    result.m[8] = 2.0f * (x * z + y * w);
+    result.m[9] = 2.0f * (y * z - x * w);
+    result.m[10] = 1.0f - 2.0f * (x * x + y * y);
+    return result;
+}
+
+Mat4 perspectiveMat4(float fovY, float aspect, float zNear, float zFar)
+{
+    float f = 1.0f / tanf(fovY * 0.5f);
+
+    // Vulkan clip space has Y pointing down, flipping it here keeps counter-clockwise faces front facing
+    Mat4 result;
+    memset(&result, 0, sizeof(result));
+    result.m[0] = f / aspect;
+    result.m[5] = -f;
+    result.m[10] = zFar / (zNear - zFar);
+    result.m[11] = -1.0f;
+    result.m[14] = zNear * zFar / (zNear - zFar);
+    return result;
+}
+
+void transformPoint(const Mat4* pMatrix, const float* pPoint, float* pResult)
+{
+    const float* m = pMatrix->m;
+    float x = pPoint[0];
+    float y = pPoint[1];
+    float z = pPoint[2];
+
+    pResult[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+    pResult[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+    pResult[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+}
+
+void transformDirection(const Mat4* pMatrix, const float* pDirection, float* pResult)
+{
+    const float* m = pMatrix->m;
+    float x = pDirection[0];
+    float y = pDirection[1];
+    float z = pDirection[2];
+
+    pResult[0] = m[0] * x + m[4] * y + m[8] * z;
+    pResult[1] = m[1] * x + m[5] * y + m[9] * z;
+    pResult[2] = m[2] * x + m[6] * y + m[10] * z;
+}
+
+void getFrustumPlanes(const Mat4* pViewProjection, float pPlanes[6][4])
+{
+    const float* m = pViewProjection->m;
+
+    // Clip space is -w <= x, y <= w and 0 <= z <= w, each plane is a sum of rows of the matrix
+    for (int i = 0; i < 4; ++i)
+    {
+        float row0 = m[i * 4 + 0];
+        float row1 = m[i * 4 + 1];
+        float row2 = m[i * 4 + 2];
+        float row3 = m[i * 4 + 3];
+
+        pPlanes[0][i] = row3 + row0;
+        pPlanes[1][i] = row3 - row0;
+        pPlanes[2][i] = row3 + row1;
+        pPlanes[3][i] = row3 - row1;
+        pPlanes[4][i] = row2;
+        pPlanes[5][i] = row3 - row2;
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        float length = sqrtf(pPlanes[i][0] * pPlanes[i][0] + pPlanes[i][1] * pPlanes[i][1] + pPlanes[i][2] * pPlanes[i][2]);
+        if (length > 0.0f)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                pPlanes[i][j] /= length;
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "mesh.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+Result createMesh(Allocator* pAllocator, StagingRing* pRing, const MeshData* pMeshData, Mesh* pMesh)
+{
+    if (pMeshData->vertexCount > UINT16_MAX + 1)
+    {
+        return createMeshBuffers(pAllocator, pRing, pMeshData->vertexCount, pMeshData->pVertices, pMeshData->indexCount, VK_INDEX_TYPE_UINT32, pMeshData->pIndices, pMesh);
+    }
+
+    uint16_t* pIndices = malloc(pMeshData->indexCount * sizeof(uint16_t));
+    if (pIndices == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for 16-bit indices!", pMeshData->indexCount * sizeof(uint16_t));
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < pMeshData->indexCount; ++i)
+    {
+        pIndices[i] = (uint16_t)pMeshData->pIndices[i];
+    }
+
+    Result result = createMeshBuffers(pAllocator, pRing, pMeshData->vertexCount, pMeshData->pVertices, pMeshData->indexCount, VK_INDEX_TYPE_UINT16, pIndices, pMesh);
+
+    free(pIndices);
+
+    return result;
+}
+
+Result createMeshBuffers(Allocator* pAllocator, StagingRing* pRing, uint32_t vertexCount, const Vertex* pVertices, uint32_t indexCount, VkIndexType indexType, const void* pIndices, Mesh* pMesh)
+{
+    memset(pMesh, 0, sizeof(Mesh));
+    pMesh->vertexCount = vertexCount;
+    pMesh->indexCount = indexCount;
+    pMesh->indexType = indexType;
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    VkDeviceSize vertexSize = (VkDeviceSize)vertexCount * sizeof(Vertex);
+    if (createBuffer(pAllocator, vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, &allocationInfo, &pMesh->vertexBuffer, &pMesh->vertexAllocation) != SUCCESS)
+    {
+        printError("Failed to create vertex buffer!");
+        destroyMesh(pAllocator, pMesh);
+        return FAIL;
+    }
+
+    VkDeviceSize indexSize = (VkDeviceSize)indexCount * ((indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t));
+    if (createBuffer(pAllocator, indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, &allocationInfo, &pMesh->indexBuffer, &pMesh->indexAllocation) != SUCCESS)
+    {
+        printError("Failed to create index buffer!");
+        destroyMesh(pAllocator, pMesh);
+        return FAIL;
+    }
+
+    if ((stageBuffer(pRing, pMesh->vertexBuffer, 0, pVertices, vertexSize) != SUCCESS)
+        || (stageBuffer(pRing, pMesh->indexBuffer, 0, pIndices, indexSize) != SUCCESS))
+    {
+        printError("Failed to upload mesh!");
+        destroyMesh(pAllocator, pMesh);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyMesh(Allocator* pAllocator, Mesh* pMesh)
+{
+    destroyBuffer(pAllocator, pMesh->indexBuffer, &pMesh->indexAllocation);
+    destroyBuffer(pAllocator, pMesh->vertexBuffer, &pMesh->vertexAllocation);
+
+    pMesh->indexBuffer = VK_NULL_HANDLE;
+    pMesh->vertexBuffer = VK_NULL_HANDLE;
+}
+
+void getVertexInputState(uint32_t* pBindingCount, VkVertexInputBindingDescription* pBindings, uint32_t* pAttributeCount, VkVertexInputAttributeDescription* pAttributes)
+{
+    *pBindingCount = 1;
+    pBindings[0].binding = 0;
+    pBindings[0].stride = sizeof(Vertex);
+    pBindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    *pAttributeCount = 3;
+    pAttributes[0].location = 0;
+    pAttributes[0].binding = 0;
+    pAttributes[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    pAttributes[0].offset = offsetof(Vertex, position);
+
+    pAttributes[1].location = 1;
+    pAttributes[1].binding = 0;
+    pAttributes[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    pAttributes[1].offset = offsetof(Vertex, normal);
+
+    pAttributes[2].location = 2;
+    pAttributes[2].binding = 0;
+    pAttributes[2].format = VK_FORMAT_R32G32_SFLOAT;
+    pAttributes[2].offset = offsetof(Vertex, texCoord);
+}
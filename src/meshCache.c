@@ -0,0 +1,331 @@
+#include "meshCache.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static SDL_bool writePadding(FILE* pFile, uint64_t* pOffset);
+
+static Result hashSourceFile(const char* pPath, uint64_t* pSize, uint64_t* pHash);
+
+static uint64_t hashMeshData(const MeshCacheHeader* pHeader, const MeshData* pMeshData);
+
+static SDL_bool areIndicesInRange(const MeshCacheHeader* pHeader, const void* pIndices);
+
+SDL_bool isMeshCachePath(const char* pPath)
+{
+    size_t length = strlen(pPath);
+    size_t extensionLength = strlen(MESH_CACHE_EXTENSION);
+
+    return ((length > extensionLength) && (SDL_strcasecmp(pPath + length - extensionLength, MESH_CACHE_EXTENSION) == 0)) ? SDL_TRUE : SDL_FALSE;
+}
+
+char* getMeshCachePath(const char* pSourcePath)
+{
+    size_t pathSize = strlen(pSourcePath) + strlen(MESH_CACHE_EXTENSION) + 1;
+
+    char* pPath = malloc(pathSize);
+    if (pPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for mesh cache path!", pathSize);
+        return NULL;
+    }
+
+    snprintf(pPath, pathSize, "%s%s", pSourcePath, MESH_CACHE_EXTENSION);
+    return pPath;
+}
+
+Result openMeshCache(const char* pPath, const char* pSourcePath, SDL_bool verify, MeshCache* pCache)
+{
+    memset(pCache, 0, sizeof(MeshCache));
+
+    // A missing cache is the normal first run, it is not worth an error message
+    uint64_t cacheSize = 0;
+    int64_t cacheModifiedTime = 0;
+    if (getFileStamp(pPath, &cacheSize, &cacheModifiedTime) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    if (mapFile(pPath, &pCache->file) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    MeshCacheHeader* pHeader = &pCache->header;
+    const char* pReason = NULL;
+
+    if (pCache->file.size < sizeof(MeshCacheHeader))
+    {
+        pReason = "it is truncated";
+    }
+    else
+    {
+        memcpy(pHeader, pCache->file.pData, sizeof(MeshCacheHeader));
+
+        uint64_t vertexSize = (uint64_t)pHeader->vertexCount * pHeader->vertexStride;
+        uint64_t indexSize = (uint64_t)pHeader->indexCount * pHeader->indexSize;
+
+        if ((pHeader->magic != MESH_CACHE_MAGIC) || (pHeader->headerHash != hashBytes(pHeader, offsetof(MeshCacheHeader, headerHash), HASH_SEED)))
+        {
+            pReason = "it is not a mesh cache or it is corrupt";
+        }
+        else if ((pHeader->version != MESH_CACHE_VERSION) || (pHeader->vertexStride != sizeof(Vertex)))
+        {
+            pReason = "it was written by another version of the viewer";
+        }
+        else if (((pHeader->indexSize != 2) && (pHeader->indexSize != 4)) || (pHeader->indexCount == 0)
+            || ((pHeader->vertexOffset % MESH_CACHE_ALIGNMENT) != 0) || ((pHeader->indexOffset % MESH_CACHE_ALIGNMENT) != 0)
+            || (pHeader->vertexOffset + vertexSize > pCache->file.size) || (pHeader->indexOffset + indexSize > pCache->file.size))
+        {
+            pReason = "its layout is invalid";
+        }
+        else if (verify == SDL_TRUE)
+        {
+            const char* pData = pCache->file.pData;
+            uint64_t dataHash = hashBytes(pData + pHeader->vertexOffset, vertexSize, HASH_SEED);
+            dataHash = hashBytes(pData + pHeader->indexOffset, indexSize, dataHash);
+
+            if ((dataHash != pHeader->dataHash) || (areIndicesInRange(pHeader, pData + pHeader->indexOffset) != SDL_TRUE))
+            {
+                pReason = "its vertices or indices are corrupt";
+            }
+        }
+    }
+
+    if ((pReason == NULL) && (pSourcePath != NULL))
+    {
+        uint64_t sourceSize = 0;
+        int64_t sourceModifiedTime = 0;
+        if (getFileStamp(pSourcePath, &sourceSize, &sourceModifiedTime) != SUCCESS)
+        {
+            printError("Failed to read source model \"%s\"!", pSourcePath);
+            closeMeshCache(pCache);
+            return FAIL;
+        }
+
+        if (pHeader->sourceSize != sourceSize)
+        {
+            pReason = "the source model changed";
+        }
+        else if ((pHeader->sourceModifiedTime != sourceModifiedTime) || (verify == SDL_TRUE))
+        {
+            // Only hashed when the time alone cannot tell, the source is read in full
+            uint64_t sourceHash = 0;
+            if (hashSourceFile(pSourcePath, &sourceSize, &sourceHash) != SUCCESS)
+            {
+                closeMeshCache(pCache);
+                return FAIL;
+            }
+
+            if ((pHeader->sourceSize != sourceSize) || (pHeader->sourceHash != sourceHash))
+            {
+                pReason = "the source model changed";
+            }
+        }
+    }
+
+    if (pReason != NULL)
+    {
+        printf("Ignoring mesh cache \"%s\" because %s\n", pPath, pReason);
+        closeMeshCache(pCache);
+        return FAIL;
+    }
+
+    pCache->pVertices = (const Vertex*)((const char*)pCache->file.pData + pHeader->vertexOffset);
+    pCache->pIndices = (const char*)pCache->file.pData + pHeader->indexOffset;
+
+    return SUCCESS;
+}
+
+void closeMeshCache(MeshCache* pCache)
+{
+    unmapFile(&pCache->file);
+    pCache->pVertices = NULL;
+    pCache->pIndices = NULL;
+}
+
+Result writeMeshCache(const char* pPath, const char* pSourcePath, const MeshData* pMeshData)
+{
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.indexSize = (pMeshData->vertexCount <= UINT16_MAX + 1) ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.vertexCount = pMeshData->vertexCount;
+    header.indexCount = pMeshData->indexCount;
+    memcpy(header.pMin, pMeshData->pMin, sizeof(header.pMin));
+    memcpy(header.pMax, pMeshData->pMax, sizeof(header.pMax));
+
+    if (getFileStamp(pSourcePath, &header.sourceSize, &header.sourceModifiedTime) != SUCCESS)
+    {
+        printError("Failed to read source model \"%s\"!", pSourcePath);
+        return FAIL;
+    }
+
+    if (hashSourceFile(pSourcePath, &header.sourceSize, &header.sourceHash) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    uint64_t vertexSize = (uint64_t)header.vertexCount * header.vertexStride;
+    header.vertexOffset = MESH_CACHE_ALIGNMENT;
+    header.indexOffset = (header.vertexOffset + vertexSize + MESH_CACHE_ALIGNMENT - 1) & ~(uint64_t)(MESH_CACHE_ALIGNMENT - 1);
+    header.dataHash = hashMeshData(&header, pMeshData);
+    header.headerHash = hashBytes(&header, offsetof(MeshCacheHeader, headerHash), HASH_SEED);
+
+    // Same as the pipeline cache, written next to the target and renamed so readers never map a partial file
+    size_t temporaryPathSize = strlen(pPath) + 5;
+    char* pTemporaryPath = malloc(temporaryPathSize);
+    if (pTemporaryPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for temporary mesh cache path!", temporaryPathSize);
+        return FAIL;
+    }
+
+    snprintf(pTemporaryPath, temporaryPathSize, "%s.tmp", pPath);
+
+    FILE* pFile = fopen(pTemporaryPath, "wb");
+    if (pFile == NULL)
+    {
+        printError("Failed to open file \"%s\" for writing!", pTemporaryPath);
+        free(pTemporaryPath);
+        return FAIL;
+    }
+
+    uint64_t offset = sizeof(header);
+    SDL_bool written = (fwrite(&header, sizeof(header), 1, pFile) == 1) && (writePadding(pFile, &offset) == SDL_TRUE);
+    written = written && (fwrite(pMeshData->pVertices, header.vertexStride, header.vertexCount, pFile) == header.vertexCount);
+
+    offset += vertexSize;
+    written = written && (writePadding(pFile, &offset) == SDL_TRUE);
+
+    if (header.indexSize == sizeof(uint32_t))
+    {
+        written = written && (fwrite(pMeshData->pIndices, sizeof(uint32_t), header.indexCount, pFile) == header.indexCount);
+    }
+    else
+    {
+        for (uint32_t i = 0; (written == SDL_TRUE) && (i < header.indexCount); ++i)
+        {
+            uint16_t index = (uint16_t)pMeshData->pIndices[i];
+            written = (fwrite(&index, sizeof(index), 1, pFile) == 1) ? SDL_TRUE : SDL_FALSE;
+        }
+    }
+
+    written = (fclose(pFile) == 0) && written;
+
+    if ((written != SDL_TRUE) || (replaceFile(pTemporaryPath, pPath) != SUCCESS))
+    {
+        printError("Failed to write mesh cache to \"%s\"!", pPath);
+        remove(pTemporaryPath);
+        free(pTemporaryPath);
+        return FAIL;
+    }
+
+    free(pTemporaryPath);
+
+    return SUCCESS;
+}
+
+Result convertMesh(const char* pSourcePath)
+{
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+
+    MeshData meshData;
+    if (loadMeshData(pSourcePath, &meshData) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    char* pCachePath = getMeshCachePath(pSourcePath);
+    if (pCachePath == NULL)
+    {
+        destroyMeshData(&meshData);
+        return FAIL;
+    }
+
+    Result result = writeMeshCache(pCachePath, pSourcePath, &meshData);
+    if (result == SUCCESS)
+    {
+        printf("Converted \"%s\" to \"%s\": %u vertices, %u triangles in %.3f ms\n", pSourcePath, pCachePath,
+            meshData.vertexCount, meshData.indexCount / 3, (SDL_GetPerformanceCounter() - startTicks) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+
+    free(pCachePath);
+    destroyMeshData(&meshData);
+
+    return result;
+}
+
+SDL_bool writePadding(FILE* pFile, uint64_t* pOffset)
+{
+    static const char pZeros[MESH_CACHE_ALIGNMENT] = { 0 };
+
+    uint64_t paddingSize = (MESH_CACHE_ALIGNMENT - (*pOffset % MESH_CACHE_ALIGNMENT)) % MESH_CACHE_ALIGNMENT;
+    *pOffset += paddingSize;
+
+    return ((paddingSize == 0) || (fwrite(pZeros, 1, paddingSize, pFile) == paddingSize)) ? SDL_TRUE : SDL_FALSE;
+}
+
+Result hashSourceFile(const char* pPath, uint64_t* pSize, uint64_t* pHash)
+{
+    MappedFile file;
+    if (mapFile(pPath, &file) != SUCCESS)
+    {
+        printError("Failed to read source model \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    *pSize = file.size;
+    *pHash = hashBytes(file.pData, file.size, HASH_SEED);
+
+    unmapFile(&file);
+
+    return SUCCESS;
+}
+
+uint64_t hashMeshData(const MeshCacheHeader* pHeader, const MeshData* pMeshData)
+{
+    uint64_t hash = hashBytes(pMeshData->pVertices, (uint64_t)pHeader->vertexCount * pHeader->vertexStride, HASH_SEED);
+
+    // Hashes the indices as they are written, narrowed to 16 bits when they fit
+    if (pHeader->indexSize == sizeof(uint32_t))
+    {
+        return hashBytes(pMeshData->pIndices, pHeader->indexCount * sizeof(uint32_t), hash);
+    }
+
+    for (uint32_t i = 0; i < pHeader->indexCount; ++i)
+    {
+        uint16_t index = (uint16_t)pMeshData->pIndices[i];
+        hash = hashBytes(&index, sizeof(index), hash);
+    }
+
+    return hash;
+}
+
+SDL_bool areIndicesInRange(const MeshCacheHeader* pHeader, const void* pIndices)
+{
+    uint32_t maxIndex = 0;
+
+    if (pHeader->indexSize == sizeof(uint32_t))
+    {
+        const uint32_t* pIndices32 = pIndices;
+        for (uint32_t i = 0; i < pHeader->indexCount; ++i)
+        {
+            maxIndex = SDL_max(maxIndex, pIndices32[i]);
+        }
+    }
+    else
+    {
+        const uint16_t* pIndices16 = pIndices;
+        for (uint32_t i = 0; i < pHeader->indexCount; ++i)
+        {
+            maxIndex = SDL_max(maxIndex, (uint32_t)pIndices16[i]);
+        }
+    }
+
+    return (maxIndex < pHeader->vertexCount) ? SDL_TRUE : SDL_FALSE;
+}
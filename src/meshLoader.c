@@ -0,0 +1,1039 @@
+#include "meshLoader.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "json.h"
+#include "math3d.h"
+
+#define GLB_MAGIC               0x46546C67
+#define GLB_CHUNK_TYPE_JSON     0x4E4F534A
+#define GLB_CHUNK_TYPE_BIN      0x004E4942
+#define MAX_GLTF_NODE_DEPTH     64
+
+typedef struct ObjCorner
+{
+    int32_t    position;
+    int32_t    texCoord;
+    int32_t    normal;
+} ObjCorner;
+
+// Maps each distinct position/texCoord/normal triple of an OBJ file to one vertex
+typedef struct ObjVertexMap
+{
+    uint32_t      capacity;
+    ObjCorner*    pKeys;
+    uint32_t*     pVertices;
+} ObjVertexMap;
+
+typedef struct GltfAccessor
+{
+    const uint8_t*    pData;
+    uint32_t          count;
+    uint32_t          stride;
+    uint32_t          componentType;
+    uint32_t          componentCount;
+} GltfAccessor;
+
+typedef struct GltfContext
+{
+    const JsonDocument*    pDocument;
+    uint32_t               root;
+    const uint8_t*         pBinary;
+    size_t                 binarySize;
+    SDL_bool               hasNormals;
+} GltfContext;
+
+static Result growArray(void** ppArray, uint32_t* pCapacity, uint32_t requiredCount, size_t elementSize);
+
+static Result loadObj(const char* pText, MeshData* pMeshData, SDL_bool* pHasNormals);
+
+static Result parseObjCorner(const char** ppText, uint32_t positionCount, uint32_t texCoordCount, uint32_t normalCount, ObjCorner* pCorner);
+
+static Result getObjVertex(ObjVertexMap* pMap, MeshData* pMeshData, const ObjCorner* pCorner, const float* pPositions, const float* pTexCoords, const float* pNormals, uint32_t* pVertex);
+
+static Result loadGlb(const char* pData, size_t size, MeshData* pMeshData, SDL_bool* pHasNormals);
+
+static Result appendGltfNode(GltfContext* pContext, MeshData* pMeshData, uint32_t node, Mat4 parentMatrix, uint32_t depth);
+
+static Result appendGltfMesh(GltfContext* pContext, MeshData* pMeshData, uint32_t mesh, const Mat4* pMatrix);
+
+static Result getGltfAccessor(GltfContext* pContext, uint32_t accessorIndex, GltfAccessor* pAccessor);
+
+static float readGltfComponent(const GltfAccessor* pAccessor, uint32_t element, uint32_t component);
+
+static void generateNormals(MeshData* pMeshData);
+
+static Result optimizeVertexFetch(MeshData* pMeshData);
+
+Result loadMeshData(const char* pPath, MeshData* pMeshData)
+{
+    memset(pMeshData, 0, sizeof(MeshData));
+
+    char* pData = NULL;
+    size_t size = 0;
+    if (readFile(pPath, &pData, &size) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    SDL_bool hasNormals = SDL_FALSE;
+    Result result;
+
+    const char* pExtension = strrchr(pPath, '.');
+    if ((pExtension != NULL) && (SDL_strcasecmp(pExtension, ".obj") == 0))
+    {
+        result = loadObj(pData, pMeshData, &hasNormals);
+    }
+    else if ((pExtension != NULL) && (SDL_strcasecmp(pExtension, ".glb") == 0))
+    {
+        result = loadGlb(pData, size, pMeshData, &hasNormals);
+    }
+    else
+    {
+        printError("Unsupported mesh format of \"%s\", expected .obj or .glb!", pPath);
+        result = FAIL;
+    }
+
+    free(pData);
+
+    if (result != SUCCESS)
+    {
+        printError("Failed to load mesh \"%s\"!", pPath);
+        destroyMeshData(pMeshData);
+        return FAIL;
+    }
+
+    if (pMeshData->indexCount == 0)
+    {
+        printError("Mesh \"%s\" contains no triangles!", pPath);
+        destroyMeshData(pMeshData);
+        return FAIL;
+    }
+
+    if (hasNormals != SDL_TRUE)
+    {
+        generateNormals(pMeshData);
+    }
+
+    if (optimizeVertexFetch(pMeshData) != SUCCESS)
+    {
+        destroyMeshData(pMeshData);
+        return FAIL;
+    }
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        pMeshData->pMin[axis] = pMeshData->pVertices[0].position[axis];
+        pMeshData->pMax[axis] = pMeshData->pVertices[0].position[axis];
+    }
+
+    for (uint32_t i = 1; i < pMeshData->vertexCount; ++i)
+    {
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float value = pMeshData->pVertices[i].position[axis];
+            pMeshData->pMin[axis] = (value < pMeshData->pMin[axis]) ? value : pMeshData->pMin[axis];
+            pMeshData->pMax[axis] = (value > pMeshData->pMax[axis]) ? value : pMeshData->pMax[axis];
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result createTriangleMeshData(MeshData* pMeshData)
+{
+    memset(pMeshData, 0, sizeof(MeshData));
+
+    if ((growArray((void**)&pMeshData->pVertices, &pMeshData->vertexCapacity, 3, sizeof(Vertex)) != SUCCESS)
+        || (growArray((void**)&pMeshData->pIndices, &pMeshData->indexCapacity, 3, sizeof(uint32_t)) != SUCCESS))
+    {
+        destroyMeshData(pMeshData);
+        return FAIL;
+    }
+
+    static const float pPositions[3][3] = { { -0.5f, -0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.0f, 0.5f, 0.0f } };
+    static const float pTexCoords[3][2] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 0.5f, 0.0f } };
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        Vertex* pVertex = &pMeshData->pVertices[i];
+        memcpy(pVertex->position, pPositions[i], sizeof(pVertex->position));
+        pVertex->normal[0] = 0.0f;
+        pVertex->normal[1] = 0.0f;
+        pVertex->normal[2] = 1.0f;
+        memcpy(pVertex->texCoord, pTexCoords[i], sizeof(pVertex->texCoord));
+
+        pMeshData->pIndices[i] = i;
+    }
+
+    pMeshData->vertexCount = 3;
+    pMeshData->indexCount = 3;
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        pMeshData->pMin[axis] = (axis < 2) ? -0.5f : 0.0f;
+        pMeshData->pMax[axis] = (axis < 2) ? 0.5f : 0.0f;
+    }
+
+    return SUCCESS;
+}
+
+Result createGridMeshData(uint32_t triangleCount, MeshData* pMeshData)
+{
+    memset(pMeshData, 0, sizeof(MeshData));
+
+    uint32_t quadCount = (triangleCount + 1) / 2;
+    uint32_t columnCount = (uint32_t)ceil(sqrt((double)quadCount));
+    uint32_t rowCount = (columnCount > 0) ? (quadCount + columnCount - 1) / columnCount : 0;
+    uint64_t vertexCount = (uint64_t)(columnCount + 1) * (rowCount + 1);
+
+    if ((triangleCount == 0) || (triangleCount > UINT32_MAX / 3) || (vertexCount > UINT32_MAX))
+    {
+        printError("Grid of %u triangles is out of range!", triangleCount);
+        return FAIL;
+    }
+
+    if ((growArray((void**)&pMeshData->pVertices, &pMeshData->vertexCapacity, (uint32_t)vertexCount, sizeof(Vertex)) != SUCCESS)
+        || (growArray((void**)&pMeshData->pIndices, &pMeshData->indexCapacity, triangleCount * 3, sizeof(uint32_t)) != SUCCESS))
+    {
+        destroyMeshData(pMeshData);
+        return FAIL;
+    }
+
+    float cellSize = 2.0f / columnCount;
+
+    for (uint32_t y = 0; y <= rowCount; ++y)
+    {
+        for (uint32_t x = 0; x <= columnCount; ++x)
+        {
+            Vertex* pVertex = &pMeshData->pVertices[y * (columnCount + 1) + x];
+            pVertex->position[0] = -1.0f + x * cellSize;
+            pVertex->position[1] = -1.0f + y * cellSize;
+            pVertex->position[2] = 0.0f;
+            pVertex->normal[0] = 0.0f;
+            pVertex->normal[1] = 0.0f;
+            pVertex->normal[2] = 1.0f;
+            pVertex->texCoord[0] = (float)x / columnCount;
+            pVertex->texCoord[1] = 1.0f - (float)y / rowCount;
+        }
+    }
+
+    // Rows are filled bottom up, the last quad only gets its first triangle when the count is odd
+    for (uint32_t i = 0; i < triangleCount; ++i)
+    {
+        uint32_t quad = i / 2;
+        uint32_t bottomLeft = (quad / columnCount) * (columnCount + 1) + quad % columnCount;
+        uint32_t topLeft = bottomLeft + columnCount + 1;
+        uint32_t* pTriangle = &pMeshData->pIndices[i * 3];
+
+        pTriangle[0] = bottomLeft;
+        pTriangle[1] = ((i & 1) == 0) ? bottomLeft + 1 : topLeft + 1;
+        pTriangle[2] = ((i & 1) == 0) ? topLeft + 1 : topLeft;
+    }
+
+    pMeshData->vertexCount = (uint32_t)vertexCount;
+    pMeshData->indexCount = triangleCount * 3;
+
+    pMeshData->pMin[0] = -1.0f;
+    pMeshData->pMin[1] = -1.0f;
+    pMeshData->pMin[2] = 0.0f;
+    pMeshData->pMax[0] = -1.0f + columnCount * cellSize;
+    pMeshData->pMax[1] = -1.0f + rowCount * cellSize;
+    pMeshData->pMax[2] = 0.0f;
+
+    return SUCCESS;
+}
+
+void destroyMeshData(MeshData* pMeshData)
+{
+    free(pMeshData->pVertices);
+    free(pMeshData->pIndices);
+    memset(pMeshData, 0, sizeof(MeshData));
+}
+
+Result growArray(void** ppArray, uint32_t* pCapacity, uint32_t requiredCount, size_t elementSize)
+{
+    if (requiredCount <= *pCapacity)
+    {
+        return SUCCESS;
+    }
+
+    uint32_t newCapacity = (*pCapacity > 0) ? *pCapacity : 1024;
+    while (newCapacity < requiredCount)
+    {
+        newCapacity *= 2;
+    }
+
+    void* pArray = realloc(*ppArray, (size_t)newCapacity * elementSize);
+    if (pArray == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for mesh data!", (unsigned long)newCapacity * elementSize);
+        return FAIL;
+    }
+
+    *ppArray = pArray;
+    *pCapacity = newCapacity;
+    return SUCCESS;
+}
+
+Result loadObj(const char* pText, MeshData* pMeshData, SDL_bool* pHasNormals)
+{
+    float* pPositions = NULL;
+    float* pTexCoords = NULL;
+    float* pNormals = NULL;
+    ObjCorner* pCorners = NULL;
+    uint32_t positionCount = 0, positionCapacity = 0;
+    uint32_t texCoordCount = 0, texCoordCapacity = 0;
+    uint32_t normalCount = 0, normalCapacity = 0;
+    uint32_t cornerCapacity = 0;
+    uint32_t lineNumber = 0;
+
+    ObjVertexMap map;
+    memset(&map, 0, sizeof(map));
+
+    Result result = SUCCESS;
+    const char* pLine = pText;
+
+    while ((result == SUCCESS) && (*pLine != '\0'))
+    {
+        ++lineNumber;
+
+        const char* pLineEnd = strchr(pLine, '\n');
+        if (pLineEnd == NULL)
+        {
+            pLineEnd = pLine + strlen(pLine);
+        }
+
+        const char* p = pLine;
+        while ((*p == ' ') || (*p == '\t'))
+        {
+            ++p;
+        }
+
+        if ((p[0] == 'v') && ((p[1] == ' ') || (p[1] == 't') || (p[1] == 'n')))
+        {
+            float* pValues;
+            uint32_t componentCount = (p[1] == 't') ? 2 : 3;
+
+            if (p[1] == ' ')
+            {
+                result = growArray((void**)&pPositions, &positionCapacity, positionCount + 1, 3 * sizeof(float));
+                pValues = pPositions + 3 * positionCount++;
+            }
+            else if (p[1] == 't')
+            {
+                result = growArray((void**)&pTexCoords, &texCoordCapacity, texCoordCount + 1, 2 * sizeof(float));
+                pValues = pTexCoords + 2 * texCoordCount++;
+            }
+            else
+            {
+                result = growArray((void**)&pNormals, &normalCapacity, normalCount + 1, 3 * sizeof(float));
+                pValues = pNormals + 3 * normalCount++;
+            }
+
+            if (result != SUCCESS)
+            {
+                break;
+            }
+
+            p += 2;
+            for (uint32_t i = 0; i < componentCount; ++i)
+            {
+                char* pEnd = NULL;
+                pValues[i] = strtof(p, &pEnd);
+                if ((pEnd == p) || (pEnd > pLineEnd))
+                {
+                    pValues[i] = 0.0f;
+                    pEnd = (char*)p;
+                }
+
+                p = pEnd;
+            }
+        }
+        else if ((p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+        {
+            uint32_t cornerCount = 0;
+            ++p;
+
+            while (p < pLineEnd)
+            {
+                while ((p < pLineEnd) && ((*p == ' ') || (*p == '\t') || (*p == '\r')))
+                {
+                    ++p;
+                }
+
+                if (p >= pLineEnd)
+                {
+                    break;
+                }
+
+                result = growArray((void**)&pCorners, &cornerCapacity, cornerCount + 1, sizeof(ObjCorner));
+                if (result != SUCCESS)
+                {
+                    break;
+                }
+
+                result = parseObjCorner(&p, positionCount, texCoordCount, normalCount, &pCorners[cornerCount]);
+                if (result != SUCCESS)
+                {
+                    printError("Invalid face on line %u!", lineNumber);
+                    break;
+                }
+
+                ++cornerCount;
+            }
+
+            // Polygons are triangulated as a fan around the first corner
+            for (uint32_t i = 2; (result == SUCCESS) && (i < cornerCount); ++i)
+            {
+                result = growArray((void**)&pMeshData->pIndices, &pMeshData->indexCapacity, pMeshData->indexCount + 3, sizeof(uint32_t));
+
+                const uint32_t pCornerIndices[3] = { 0, i - 1, i };
+                for (uint32_t j = 0; (result == SUCCESS) && (j < 3); ++j)
+                {
+                    result = getObjVertex(&map, pMeshData, &pCorners[pCornerIndices[j]], pPositions, pTexCoords, pNormals, &pMeshData->pIndices[pMeshData->indexCount++]);
+                }
+            }
+        }
+
+        pLine = (*pLineEnd == '\n') ? pLineEnd + 1 : pLineEnd;
+    }
+
+    *pHasNormals = (normalCount > 0) ? SDL_TRUE : SDL_FALSE;
+
+    free(pPositions);
+    free(pTexCoords);
+    free(pNormals);
+    free(pCorners);
+    free(map.pKeys);
+    free(map.pVertices);
+
+    return result;
+}
+
+Result parseObjCorner(const char** ppText, uint32_t positionCount, uint32_t texCoordCount, uint32_t normalCount, ObjCorner* pCorner)
+{
+    // v, v/vt, v//vn or v/vt/vn with 1-based or negative (relative to the end) indices
+    int32_t* ppIndices[3] = { &pCorner->position, &pCorner->texCoord, &pCorner->normal };
+    const uint32_t pCounts[3] = { positionCount, texCoordCount, normalCount };
+    const char* p = *ppText;
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        *ppIndices[i] = -1;
+
+        if ((i > 0) && (*p == '/'))
+        {
+            ++p;
+        }
+        else if (i > 0)
+        {
+            continue;
+        }
+
+        if ((*p == '/') || (*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n') || (*p == '\0'))
+        {
+            if (i == 0)
+            {
+                return FAIL;
+            }
+
+            continue;
+        }
+
+        char* pEnd = NULL;
+        long index = strtol(p, &pEnd, 10);
+        if (pEnd == p)
+        {
+            return FAIL;
+        }
+
+        p = pEnd;
+
+        long resolved = (index < 0) ? (long)pCounts[i] + index : index - 1;
+        if ((index == 0) || (resolved < 0) || (resolved >= (long)pCounts[i]))
+        {
+            return FAIL;
+        }
+
+        *ppIndices[i] = (int32_t)resolved;
+    }
+
+    *ppText = p;
+    return SUCCESS;
+}
+
+Result getObjVertex(ObjVertexMap* pMap, MeshData* pMeshData, const ObjCorner* pCorner, const float* pPositions, const float* pTexCoords, const float* pNormals, uint32_t* pVertex)
+{
+    // Keep the open addressing table at most half full
+    if ((pMeshData->vertexCount + 1) * 2 > pMap->capacity)
+    {
+        uint32_t newCapacity = (pMap->capacity > 0) ? pMap->capacity * 2 : 4096;
+
+        ObjCorner* pKeys = malloc(newCapacity * sizeof(ObjCorner));
+        uint32_t* pVertices = malloc(newCapacity * sizeof(uint32_t));
+        if ((pKeys == NULL) || (pVertices == NULL))
+        {
+            printError("Failed to allocate memory for vertex map of %u entries!", newCapacity);
+            free(pKeys);
+            free(pVertices);
+            return FAIL;
+        }
+
+        memset(pVertices, 0xFF, newCapacity * sizeof(uint32_t));
+
+        for (uint32_t i = 0; i < pMap->capacity; ++i)
+        {
+            if (pMap->pVertices[i] == UINT32_MAX)
+            {
+                continue;
+            }
+
+            uint32_t slot = (uint32_t)hashBytes(&pMap->pKeys[i], sizeof(ObjCorner), HASH_SEED) & (newCapacity - 1);
+            while (pVertices[slot] != UINT32_MAX)
+            {
+                slot = (slot + 1) & (newCapacity - 1);
+            }
+
+            pKeys[slot] = pMap->pKeys[i];
+            pVertices[slot] = pMap->pVertices[i];
+        }
+
+        free(pMap->pKeys);
+        free(pMap->pVertices);
+        pMap->pKeys = pKeys;
+        pMap->pVertices = pVertices;
+        pMap->capacity = newCapacity;
+    }
+
+    uint32_t slot = (uint32_t)hashBytes(pCorner, sizeof(ObjCorner), HASH_SEED) & (pMap->capacity - 1);
+    while (pMap->pVertices[slot] != UINT32_MAX)
+    {
+        if (memcmp(&pMap->pKeys[slot], pCorner, sizeof(ObjCorner)) == 0)
+        {
+            *pVertex = pMap->pVertices[slot];
+            return SUCCESS;
+        }
+
+        slot = (slot + 1) & (pMap->capacity - 1);
+    }
+
+    if (growArray((void**)&pMeshData->pVertices, &pMeshData->vertexCapacity, pMeshData->vertexCount + 1, sizeof(Vertex)) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    Vertex* pNewVertex = &pMeshData->pVertices[pMeshData->vertexCount];
+    memcpy(pNewVertex->position, pPositions + 3 * pCorner->position, sizeof(pNewVertex->position));
+    memset(pNewVertex->normal, 0, sizeof(pNewVertex->normal));
+    memset(pNewVertex->texCoord, 0, sizeof(pNewVertex->texCoord));
+
+    if (pCorner->normal >= 0)
+    {
+        memcpy(pNewVertex->normal, pNormals + 3 * pCorner->normal, sizeof(pNewVertex->normal));
+    }
+
+    // OBJ texture coordinates start at the bottom left, Vulkan samples from the top left
+    if (pCorner->texCoord >= 0)
+    {
+        pNewVertex->texCoord[0] = pTexCoords[2 * pCorner->texCoord];
+        pNewVertex->texCoord[1] = 1.0f - pTexCoords[2 * pCorner->texCoord + 1];
+    }
+
+    pMap->pKeys[slot] = *pCorner;
+    pMap->pVertices[slot] = pMeshData->vertexCount;
+
+    *pVertex = pMeshData->vertexCount++;
+    return SUCCESS;
+}
+
+Result loadGlb(const char* pData, size_t size, MeshData* pMeshData, SDL_bool* pHasNormals)
+{
+    uint32_t pHeader[5];
+    if (size < sizeof(pHeader))
+    {
+        printError("File is too small to be a binary glTF file!");
+        return FAIL;
+    }
+
+    memcpy(pHeader, pData, sizeof(pHeader));
+
+    if ((pHeader[0] != GLB_MAGIC) || (pHeader[1] != 2) || (pHeader[2] > size))
+    {
+        printError("Not a binary glTF 2.0 file!");
+        return FAIL;
+    }
+
+    size = pHeader[2];
+
+    uint32_t jsonSize = pHeader[3];
+    if ((pHeader[4] != GLB_CHUNK_TYPE_JSON) || (jsonSize > size - 20))
+    {
+        printError("Binary glTF file does not start with a JSON chunk!");
+        return FAIL;
+    }
+
+    const char* pJson = pData + 20;
+
+    GltfContext context;
+    context.pBinary = NULL;
+    context.binarySize = 0;
+    context.hasNormals = SDL_TRUE;
+
+    size_t binaryChunkOffset = 20 + ((jsonSize + 3) & ~3u);
+    if (binaryChunkOffset + 8 <= size)
+    {
+        uint32_t pChunkHeader[2];
+        memcpy(pChunkHeader, pData + binaryChunkOffset, sizeof(pChunkHeader));
+
+        if ((pChunkHeader[1] == GLB_CHUNK_TYPE_BIN) && (pChunkHeader[0] <= size - binaryChunkOffset - 8))
+        {
+            context.pBinary = (const uint8_t*)pData + binaryChunkOffset + 8;
+            context.binarySize = pChunkHeader[0];
+        }
+    }
+
+    JsonDocument document;
+    if (parseJson(pJson, jsonSize, &document) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    context.pDocument = &document;
+    context.root = 0;
+
+    Result result = SUCCESS;
+
+    uint32_t scenes = getJsonMember(&document, 0, "scenes");
+    uint32_t scene = getJsonElement(&document, scenes, (uint32_t)getJsonNumber(&document, 0, "scene", 0.0));
+
+    if (scene != JSON_NONE)
+    {
+        uint32_t nodes = getJsonMember(&document, scene, "nodes");
+        for (uint32_t node = (nodes != JSON_NONE) ? document.pValues[nodes].firstChild : JSON_NONE; (result == SUCCESS) && (node != JSON_NONE); node = document.pValues[node].nextSibling)
+        {
+            result = appendGltfNode(&context, pMeshData, (uint32_t)document.pValues[node].number, identityMat4(), 0);
+        }
+    }
+    else
+    {
+        // Files without scenes are still meant to be displayed, draw every mesh untransformed
+        Mat4 identity = identityMat4();
+        uint32_t meshes = getJsonMember(&document, 0, "meshes");
+        uint32_t meshCount = (meshes != JSON_NONE) ? document.pValues[meshes].childCount : 0;
+        for (uint32_t mesh = 0; (result == SUCCESS) && (mesh < meshCount); ++mesh)
+        {
+            result = appendGltfMesh(&context, pMeshData, mesh, &identity);
+        }
+    }
+
+    *pHasNormals = context.hasNormals;
+
+    destroyJson(&document);
+
+    return result;
+}
+
+Result appendGltfNode(GltfContext* pContext, MeshData* pMeshData, uint32_t nodeIndex, Mat4 parentMatrix, uint32_t depth)
+{
+    const JsonDocument* pDocument = pContext->pDocument;
+
+    uint32_t node = getJsonElement(pDocument, getJsonMember(pDocument, pContext->root, "nodes"), nodeIndex);
+    if ((node == JSON_NONE) || (depth > MAX_GLTF_NODE_DEPTH))
+    {
+        printError("Invalid glTF node %u!", nodeIndex);
+        return FAIL;
+    }
+
+    Mat4 localMatrix = identityMat4();
+
+    uint32_t matrix = getJsonMember(pDocument, node, "matrix");
+    if (matrix != JSON_NONE)
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t element = getJsonElement(pDocument, matrix, i);
+            localMatrix.m[i] = (element != JSON_NONE) ? (float)pDocument->pValues[element].number : localMatrix.m[i];
+        }
+    }
+    else
+    {
+        float pTranslation[3] = { 0.0f, 0.0f, 0.0f };
+        float pRotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        float pScale[3] = { 1.0f, 1.0f, 1.0f };
+
+        const char* ppKeys[3] = { "translation", "rotation", "scale" };
+        float* ppValues[3] = { pTranslation, pRotation, pScale };
+        const uint32_t pCounts[3] = { 3, 4, 3 };
+
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            uint32_t array = getJsonMember(pDocument, node, ppKeys[i]);
+            for (uint32_t j = 0; (array != JSON_NONE) && (j < pCounts[i]); ++j)
+            {
+                uint32_t element = getJsonElement(pDocument, array, j);
+                ppValues[i][j] = (element != JSON_NONE) ? (float)pDocument->pValues[element].number : ppValues[i][j];
+            }
+        }
+
+        localMatrix = multiplyMat4(translationMat4(pTranslation[0], pTranslation[1], pTranslation[2]),
+            multiplyMat4(quaternionMat4(pRotation[0], pRotation[1], pRotation[2], pRotation[3]), scaleMat4(pScale[0], pScale[1], pScale[2])));
+    }
+
+    Mat4 worldMatrix = multiplyMat4(parentMatrix, localMatrix);
+
+    uint32_t mesh = getJsonMember(pDocument, node, "mesh");
+    if ((mesh != JSON_NONE) && (appendGltfMesh(pContext, pMeshData, (uint32_t)pDocument->pValues[mesh].number, &worldMatrix) != SUCCESS))
+    {
+        return FAIL;
+    }
+
+    uint32_t children = getJsonMember(pDocument, node, "children");
+    for (uint32_t child = (children != JSON_NONE) ? pDocument->pValues[children].firstChild : JSON_NONE; child != JSON_NONE; child = pDocument->pValues[child].nextSibling)
+    {
+        if (appendGltfNode(pContext, pMeshData, (uint32_t)pDocument->pValues[child].number, worldMatrix, depth + 1) != SUCCESS)
+        {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result appendGltfMesh(GltfContext* pContext, MeshData* pMeshData, uint32_t meshIndex, const Mat4* pMatrix)
+{
+    const JsonDocument* pDocument = pContext->pDocument;
+
+    uint32_t mesh = getJsonElement(pDocument, getJsonMember(pDocument, pContext->root, "meshes"), meshIndex);
+    if (mesh == JSON_NONE)
+    {
+        printError("Invalid glTF mesh %u!", meshIndex);
+        return FAIL;
+    }
+
+    // Mirroring transforms turn the winding around, swap two corners to keep faces front facing
+    const float* m = pMatrix->m;
+    float determinant = m[0] * (m[5] * m[10] - m[9] * m[6]) - m[4] * (m[1] * m[10] - m[9] * m[2]) + m[8] * (m[1] * m[6] - m[5] * m[2]);
+    SDL_bool flipWinding = (determinant < 0.0f) ? SDL_TRUE : SDL_FALSE;
+
+    uint32_t primitives = getJsonMember(pDocument, mesh, "primitives");
+    for (uint32_t primitive = (primitives != JSON_NONE) ? pDocument->pValues[primitives].firstChild : JSON_NONE; primitive != JSON_NONE; primitive = pDocument->pValues[primitive].nextSibling)
+    {
+        // Only triangle lists are drawn, points, lines and strips are skipped
+        if (getJsonNumber(pDocument, primitive, "mode", 4.0) != 4.0)
+        {
+            continue;
+        }
+
+        uint32_t attributes = getJsonMember(pDocument, primitive, "attributes");
+        uint32_t position = getJsonMember(pDocument, attributes, "POSITION");
+        uint32_t normal = getJsonMember(pDocument, attributes, "NORMAL");
+        uint32_t texCoord = getJsonMember(pDocument, attributes, "TEXCOORD_0");
+        uint32_t indices = getJsonMember(pDocument, primitive, "indices");
+
+        if (position == JSON_NONE)
+        {
+            continue;
+        }
+
+        GltfAccessor positions;
+        GltfAccessor normals;
+        GltfAccessor texCoords;
+        GltfAccessor indexAccessor;
+
+        if ((getGltfAccessor(pContext, (uint32_t)pDocument->pValues[position].number, &positions) != SUCCESS)
+            || ((normal != JSON_NONE) && (getGltfAccessor(pContext, (uint32_t)pDocument->pValues[normal].number, &normals) != SUCCESS))
+            || ((texCoord != JSON_NONE) && (getGltfAccessor(pContext, (uint32_t)pDocument->pValues[texCoord].number, &texCoords) != SUCCESS))
+            || ((indices != JSON_NONE) && (getGltfAccessor(pContext, (uint32_t)pDocument->pValues[indices].number, &indexAccessor) != SUCCESS)))
+        {
+            return FAIL;
+        }
+
+        if ((positions.componentCount != 3)
+            || ((normal != JSON_NONE) && ((normals.componentCount != 3) || (normals.count != positions.count)))
+            || ((texCoord != JSON_NONE) && ((texCoords.componentCount != 2) || (texCoords.count != positions.count)))
+            || ((indices != JSON_NONE) && (indexAccessor.componentCount != 1)))
+        {
+            printError("Unsupported attribute layout in glTF mesh %u!", meshIndex);
+            return FAIL;
+        }
+
+        if (normal == JSON_NONE)
+        {
+            pContext->hasNormals = SDL_FALSE;
+        }
+
+        uint32_t firstVertex = pMeshData->vertexCount;
+        uint32_t indexCount = (indices != JSON_NONE) ? indexAccessor.count : positions.count;
+        indexCount -= indexCount % 3;
+
+        if ((growArray((void**)&pMeshData->pVertices, &pMeshData->vertexCapacity, firstVertex + positions.count, sizeof(Vertex)) != SUCCESS)
+            || (growArray((void**)&pMeshData->pIndices, &pMeshData->indexCapacity, pMeshData->indexCount + indexCount, sizeof(uint32_t)) != SUCCESS))
+        {
+            return FAIL;
+        }
+
+        for (uint32_t i = 0; i < positions.count; ++i)
+        {
+            Vertex* pVertex = &pMeshData->pVertices[firstVertex + i];
+
+            float pPosition[3];
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                pPosition[j] = readGltfComponent(&positions, i, j);
+            }
+
+            transformPoint(pMatrix, pPosition, pVertex->position);
+
+            memset(pVertex->normal, 0, sizeof(pVertex->normal));
+            if (normal != JSON_NONE)
+            {
+                float pNormal[3];
+                for (uint32_t j = 0; j < 3; ++j)
+                {
+                    pNormal[j] = readGltfComponent(&normals, i, j);
+                }
+
+                transformDirection(pMatrix, pNormal, pVertex->normal);
+
+                float length = sqrtf(pVertex->normal[0] * pVertex->normal[0] + pVertex->normal[1] * pVertex->normal[1] + pVertex->normal[2] * pVertex->normal[2]);
+                for (uint32_t j = 0; (length > 0.0f) && (j < 3); ++j)
+                {
+                    pVertex->normal[j] /= length;
+                }
+            }
+
+            pVertex->texCoord[0] = (texCoord != JSON_NONE) ? readGltfComponent(&texCoords, i, 0) : 0.0f;
+            pVertex->texCoord[1] = (texCoord != JSON_NONE) ? readGltfComponent(&texCoords, i, 1) : 0.0f;
+        }
+
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t index = (indices != JSON_NONE) ? (uint32_t)readGltfComponent(&indexAccessor, i, 0) : i;
+            if (index >= positions.count)
+            {
+                printError("Index %u is out of range in glTF mesh %u!", index, meshIndex);
+                return FAIL;
+            }
+
+            // Swap the second and third corner of every triangle
+            uint32_t corner = i % 3;
+            uint32_t target = ((flipWinding == SDL_TRUE) && (corner > 0)) ? i - corner + 3 - corner : i;
+            pMeshData->pIndices[pMeshData->indexCount + target] = firstVertex + index;
+        }
+
+        pMeshData->vertexCount += positions.count;
+        pMeshData->indexCount += indexCount;
+    }
+
+    return SUCCESS;
+}
+
+Result getGltfAccessor(GltfContext* pContext, uint32_t accessorIndex, GltfAccessor* pAccessor)
+{
+    const JsonDocument* pDocument = pContext->pDocument;
+
+    uint32_t accessor = getJsonElement(pDocument, getJsonMember(pDocument, pContext->root, "accessors"), accessorIndex);
+    if (accessor == JSON_NONE)
+    {
+        printError("Invalid glTF accessor %u!", accessorIndex);
+        return FAIL;
+    }
+
+    if (getJsonMember(pDocument, accessor, "sparse") != JSON_NONE)
+    {
+        printError("Sparse glTF accessors are not supported!");
+        return FAIL;
+    }
+
+    uint32_t type = getJsonMember(pDocument, accessor, "type");
+    if (isJsonString(pDocument, type, "SCALAR") == SDL_TRUE)
+    {
+        pAccessor->componentCount = 1;
+    }
+    else if (isJsonString(pDocument, type, "VEC2") == SDL_TRUE)
+    {
+        pAccessor->componentCount = 2;
+    }
+    else if (isJsonString(pDocument, type, "VEC3") == SDL_TRUE)
+    {
+        pAccessor->componentCount = 3;
+    }
+    else if (isJsonString(pDocument, type, "VEC4") == SDL_TRUE)
+    {
+        pAccessor->componentCount = 4;
+    }
+    else
+    {
+        printError("Unsupported type of glTF accessor %u!", accessorIndex);
+        return FAIL;
+    }
+
+    pAccessor->componentType = (uint32_t)getJsonNumber(pDocument, accessor, "componentType", 0.0);
+    pAccessor->count = (uint32_t)getJsonNumber(pDocument, accessor, "count", 0.0);
+
+    uint32_t componentSize;
+    switch (pAccessor->componentType)
+    {
+        case 5121: componentSize = 1; break; // UNSIGNED_BYTE
+        case 5123: componentSize = 2; break; // UNSIGNED_SHORT
+        case 5125: componentSize = 4; break; // UNSIGNED_INT
+        case 5126: componentSize = 4; break; // FLOAT
+        default:
+        {
+            printError("Unsupported component type %u of glTF accessor %u!", pAccessor->componentType, accessorIndex);
+            return FAIL;
+        }
+    }
+
+    uint32_t bufferViewIndex = getJsonMember(pDocument, accessor, "bufferView");
+    uint32_t bufferView = (bufferViewIndex != JSON_NONE) ? getJsonElement(pDocument, getJsonMember(pDocument, pContext->root, "bufferViews"), (uint32_t)pDocument->pValues[bufferViewIndex].number) : JSON_NONE;
+    if ((bufferView == JSON_NONE) || (getJsonNumber(pDocument, bufferView, "buffer", 0.0) != 0.0) || (pContext->pBinary == NULL))
+    {
+        printError("glTF accessor %u does not point into the binary chunk!", accessorIndex);
+        return FAIL;
+    }
+
+    uint32_t elementSize = componentSize * pAccessor->componentCount;
+    size_t offset = (size_t)getJsonNumber(pDocument, bufferView, "byteOffset", 0.0) + (size_t)getJsonNumber(pDocument, accessor, "byteOffset", 0.0);
+    size_t viewEnd = (size_t)getJsonNumber(pDocument, bufferView, "byteOffset", 0.0) + (size_t)getJsonNumber(pDocument, bufferView, "byteLength", 0.0);
+
+    pAccessor->stride = (uint32_t)getJsonNumber(pDocument, bufferView, "byteStride", (double)elementSize);
+
+    if ((pAccessor->count > 0) && ((viewEnd > pContext->binarySize) || (offset + (size_t)pAccessor->stride * (pAccessor->count - 1) + elementSize > viewEnd)))
+    {
+        printError("glTF accessor %u is out of bounds!", accessorIndex);
+        return FAIL;
+    }
+
+    pAccessor->pData = pContext->pBinary + offset;
+    return SUCCESS;
+}
+
+float readGltfComponent(const GltfAccessor* pAccessor, uint32_t element, uint32_t component)
+{
+    const uint8_t* pData = pAccessor->pData + (size_t)element * pAccessor->stride;
+
+    // Integer attributes other than indices are normalized in the files this viewer loads
+    switch (pAccessor->componentType)
+    {
+        case 5121:
+        {
+            return (pAccessor->componentCount == 1) ? (float)pData[component] : pData[component] / 255.0f;
+        }
+        case 5123:
+        {
+            uint16_t value;
+            memcpy(&value, pData + component * sizeof(value), sizeof(value));
+            return (pAccessor->componentCount == 1) ? (float)value : value / 65535.0f;
+        }
+        case 5125:
+        {
+            uint32_t value;
+            memcpy(&value, pData + component * sizeof(value), sizeof(value));
+            return (float)value;
+        }
+        default:
+        {
+            float value;
+            memcpy(&value, pData + component * sizeof(value), sizeof(value));
+            return value;
+        }
+    }
+}
+
+void generateNormals(MeshData* pMeshData)
+{
+    for (uint32_t i = 0; i < pMeshData->vertexCount; ++i)
+    {
+        memset(pMeshData->pVertices[i].normal, 0, sizeof(pMeshData->pVertices[i].normal));
+    }
+
+    // Unnormalized face normals weight every face by its area
+    for (uint32_t i = 0; i + 2 < pMeshData->indexCount; i += 3)
+    {
+        Vertex* pA = &pMeshData->pVertices[pMeshData->pIndices[i]];
+        Vertex* pB = &pMeshData->pVertices[pMeshData->pIndices[i + 1]];
+        Vertex* pC = &pMeshData->pVertices[pMeshData->pIndices[i + 2]];
+
+        float pEdge0[3];
+        float pEdge1[3];
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            pEdge0[axis] = pB->position[axis] - pA->position[axis];
+            pEdge1[axis] = pC->position[axis] - pA->position[axis];
+        }
+
+        float pNormal[3];
+        pNormal[0] = pEdge0[1] * pEdge1[2] - pEdge0[2] * pEdge1[1];
+        pNormal[1] = pEdge0[2] * pEdge1[0] - pEdge0[0] * pEdge1[2];
+        pNormal[2] = pEdge0[0] * pEdge1[1] - pEdge0[1] * pEdge1[0];
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            pA->normal[axis] += pNormal[axis];
+            pB->normal[axis] += pNormal[axis];
+            pC->normal[axis] += pNormal[axis];
+        }
+    }
+
+    for (uint32_t i = 0; i < pMeshData->vertexCount; ++i)
+    {
+        float* pNormal = pMeshData->pVertices[i].normal;
+        float length = sqrtf(pNormal[0] * pNormal[0] + pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
+
+        if (length > 0.0f)
+        {
+            pNormal[0] /= length;
+            pNormal[1] /= length;
+            pNormal[2] /= length;
+        }
+        else
+        {
+            pNormal[2] = 1.0f;
+        }
+    }
+}
+
+Result optimizeVertexFetch(MeshData* pMeshData)
+{
+    // Renumber vertices in the order the index buffer first uses them, unreferenced vertices are dropped
+    uint32_t* pRemap = malloc(pMeshData->vertexCount * sizeof(uint32_t));
+    Vertex* pVertices = malloc(pMeshData->vertexCount * sizeof(Vertex));
+    if ((pRemap == NULL) || (pVertices == NULL))
+    {
+        printError("Failed to allocate memory for reordering %u vertices!", pMeshData->vertexCount);
+        free(pRemap);
+        free(pVertices);
+        return FAIL;
+    }
+
+    memset(pRemap, 0xFF, pMeshData->vertexCount * sizeof(uint32_t));
+
+    uint32_t vertexCount = 0;
+    for (uint32_t i = 0; i < pMeshData->indexCount; ++i)
+    {
+        uint32_t index = pMeshData->pIndices[i];
+        if (pRemap[index] == UINT32_MAX)
+        {
+            pVertices[vertexCount] = pMeshData->pVertices[index];
+            pRemap[index] = vertexCount++;
+        }
+
+        pMeshData->pIndices[i] = pRemap[index];
+    }
+
+    free(pRemap);
+    free(pMeshData->pVertices);
+
+    pMeshData->pVertices = pVertices;
+    pMeshData->vertexCount = vertexCount;
+    pMeshData->vertexCapacity = pMeshData->vertexCount;
+
+    return SUCCESS;
+}
@@ -0,0 +1,285 @@
+#include "pipelineBuilder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct PipelineBuildJob
+{
+    PipelineBuilder*         pBuilder;
+    GraphicsPipelineState    state;
+    VkPipeline               pipeline;
+    SDL_atomic_t             status;
+};
+
+static void linkGraphicsPipelineState(GraphicsPipelineState* pState);
+
+static void buildGraphicsPipeline(void* pUserData);
+
+void setDefaultGraphicsPipelineState(GraphicsPipelineState* pState)
+{
+    memset(pState, 0, sizeof(*pState));
+
+    for (uint32_t i = 0; i < MAX_SHADER_STAGES; ++i)
+    {
+        pState->pStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pState->pStages[i].pNext = NULL;
+        pState->pStages[i].flags = 0;
+        pState->pStages[i].pName = "main";
+        pState->pStages[i].pSpecializationInfo = NULL;
+    }
+
+    pState->vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    pState->vertexInputState.pNext = NULL;
+    pState->vertexInputState.flags = 0;
+
+    pState->inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    pState->inputAssemblyState.pNext = NULL;
+    pState->inputAssemblyState.flags = 0;
+    pState->inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    pState->inputAssemblyState.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are dynamic, only their counts are baked into the pipeline
+    pState->viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    pState->viewportState.pNext = NULL;
+    pState->viewportState.flags = 0;
+    pState->viewportState.viewportCount = 1;
+    pState->viewportState.pViewports = NULL;
+    pState->viewportState.scissorCount = 1;
+    pState->viewportState.pScissors = NULL;
+
+    pState->rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    pState->rasterizationState.pNext = NULL;
+    pState->rasterizationState.flags = 0;
+    pState->rasterizationState.depthClampEnable = VK_FALSE;
+    pState->rasterizationState.rasterizerDiscardEnable = VK_FALSE;
+    pState->rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+    pState->rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;
+    pState->rasterizationState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    pState->rasterizationState.depthBiasEnable = VK_FALSE;
+    pState->rasterizationState.depthBiasConstantFactor = 0.0f;
+    pState->rasterizationState.depthBiasClamp = 0.0f;
+    pState->rasterizationState.depthBiasSlopeFactor = 0.0f;
+    pState->rasterizationState.lineWidth = 1.0f;
+
+    pState->multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    pState->multisampleState.pNext = NULL;
+    pState->multisampleState.flags = 0;
+    pState->multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    pState->multisampleState.sampleShadingEnable = VK_FALSE;
+    pState->multisampleState.minSampleShading = 1.0f;
+    pState->multisampleState.pSampleMask = NULL;
+    pState->multisampleState.alphaToCoverageEnable = VK_FALSE;
+    pState->multisampleState.alphaToOneEnable = VK_FALSE;
+
+    pState->depthStencilEnable = SDL_FALSE;
+    pState->depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    pState->depthStencilState.pNext = NULL;
+    pState->depthStencilState.flags = 0;
+    pState->depthStencilState.depthTestEnable = VK_FALSE;
+    pState->depthStencilState.depthWriteEnable = VK_FALSE;
+    pState->depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    pState->depthStencilState.depthBoundsTestEnable = VK_FALSE;
+    pState->depthStencilState.stencilTestEnable = VK_FALSE;
+    pState->depthStencilState.minDepthBounds = 0.0f;
+    pState->depthStencilState.maxDepthBounds = 1.0f;
+
+    pState->colorBlendAttachment.blendEnable = VK_FALSE;
+    pState->colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    pState->colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    pState->colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    pState->colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    pState->colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    pState->colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    pState->colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT
+                                                  | VK_COLOR_COMPONENT_G_BIT
+                                                  | VK_COLOR_COMPONENT_B_BIT
+                                                  | VK_COLOR_COMPONENT_A_BIT;
+
+    pState->colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    pState->colorBlendState.pNext = NULL;
+    pState->colorBlendState.flags = 0;
+    pState->colorBlendState.logicOpEnable = VK_FALSE;
+    pState->colorBlendState.logicOp = VK_LOGIC_OP_COPY;
+    pState->colorBlendState.attachmentCount = 1;
+    pState->colorBlendState.blendConstants[0] = 0.0f;
+    pState->colorBlendState.blendConstants[1] = 0.0f;
+    pState->colorBlendState.blendConstants[2] = 0.0f;
+    pState->colorBlendState.blendConstants[3] = 0.0f;
+
+    pState->dynamicStateCount = 2;
+    pState->pDynamicStates[0] = VK_DYNAMIC_STATE_VIEWPORT;
+    pState->pDynamicStates[1] = VK_DYNAMIC_STATE_SCISSOR;
+
+    pState->dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    pState->dynamicState.pNext = NULL;
+    pState->dynamicState.flags = 0;
+
+    pState->createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pState->createInfo.pNext = NULL;
+    pState->createInfo.flags = 0;
+    pState->createInfo.pTessellationState = NULL;
+    pState->createInfo.layout = VK_NULL_HANDLE;
+    pState->createInfo.renderPass = VK_NULL_HANDLE;
+    pState->createInfo.subpass = 0;
+    pState->createInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pState->createInfo.basePipelineIndex = -1;
+}
+
+Result createPipelineBuilder(PipelineBuilder* pBuilder, VkDevice device, VkPipelineCache pipelineCache, uint32_t threadCount)
+{
+    pBuilder->device = device;
+    pBuilder->pipelineCache = pipelineCache;
+    pBuilder->jobCount = 0;
+    pBuilder->jobCapacity = 0;
+    pBuilder->ppJobs = NULL;
+
+    // Pipeline caches are internally synchronized, so every worker compiles against the same cache
+    if (createThreadPool(&pBuilder->threadPool, threadCount) != SUCCESS)
+    {
+        printError("Failed to create pipeline builder thread pool!");
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyPipelineBuilder(PipelineBuilder* pBuilder)
+{
+    destroyThreadPool(&pBuilder->threadPool);
+
+    for (uint32_t i = 0; i < pBuilder->jobCount; ++i)
+    {
+        vkDestroyPipeline(pBuilder->device, pBuilder->ppJobs[i]->pipeline, NULL);
+        free(pBuilder->ppJobs[i]);
+    }
+
+    free(pBuilder->ppJobs);
+    pBuilder->ppJobs = NULL;
+
+    pBuilder->jobCount = 0;
+    pBuilder->jobCapacity = 0;
+}
+
+Result submitGraphicsPipelines(PipelineBuilder* pBuilder, uint32_t stateCount, const GraphicsPipelineState* pStates, uint32_t* pFirstPipelineId)
+{
+    if (pBuilder->jobCount + stateCount > pBuilder->jobCapacity)
+    {
+        uint32_t newCapacity = (pBuilder->jobCapacity > 0) ? pBuilder->jobCapacity : 16;
+        while (newCapacity < pBuilder->jobCount + stateCount)
+        {
+            newCapacity *= 2;
+        }
+
+        PipelineBuildJob** ppJobs = realloc(pBuilder->ppJobs, newCapacity * sizeof(PipelineBuildJob*));
+        if (ppJobs == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for pipeline build jobs!", newCapacity * sizeof(PipelineBuildJob*));
+            return FAIL;
+        }
+
+        pBuilder->ppJobs = ppJobs;
+        pBuilder->jobCapacity = newCapacity;
+    }
+
+    *pFirstPipelineId = pBuilder->jobCount;
+
+    for (uint32_t i = 0; i < stateCount; ++i)
+    {
+        PipelineBuildJob* pJob = malloc(sizeof(PipelineBuildJob));
+        if (pJob == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for pipeline build job!", sizeof(PipelineBuildJob));
+            return FAIL;
+        }
+
+        pJob->pBuilder = pBuilder;
+        pJob->state = pStates[i];
+        pJob->pipeline = VK_NULL_HANDLE;
+        SDL_AtomicSet(&pJob->status, PIPELINE_STATUS_PENDING);
+
+        linkGraphicsPipelineState(&pJob->state);
+
+        pBuilder->ppJobs[pBuilder->jobCount++] = pJob;
+
+        if (submitJob(&pBuilder->threadPool, buildGraphicsPipeline, pJob) != SUCCESS)
+        {
+            SDL_AtomicSet(&pJob->status, PIPELINE_STATUS_FAILED);
+            printError("Failed to submit pipeline build job!");
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+PipelineStatus getPipelineStatus(PipelineBuilder* pBuilder, uint32_t pipelineId)
+{
+    PipelineStatus status = SDL_AtomicGet(&pBuilder->ppJobs[pipelineId]->status);
+    SDL_MemoryBarrierAcquire();
+    return status;
+}
+
+VkPipeline getPipeline(PipelineBuilder* pBuilder, uint32_t pipelineId)
+{
+    if ((pipelineId >= pBuilder->jobCount) || (getPipelineStatus(pBuilder, pipelineId) != PIPELINE_STATUS_READY))
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    return pBuilder->ppJobs[pipelineId]->pipeline;
+}
+
+Result waitForPipelines(PipelineBuilder* pBuilder)
+{
+    waitForJobs(&pBuilder->threadPool);
+
+    for (uint32_t i = 0; i < pBuilder->jobCount; ++i)
+    {
+        if (getPipelineStatus(pBuilder, i) != PIPELINE_STATUS_READY)
+        {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+void linkGraphicsPipelineState(GraphicsPipelineState* pState)
+{
+    pState->vertexInputState.vertexBindingDescriptionCount = pState->vertexBindingCount;
+    pState->vertexInputState.pVertexBindingDescriptions = pState->pVertexBindings;
+    pState->vertexInputState.vertexAttributeDescriptionCount = pState->vertexAttributeCount;
+    pState->vertexInputState.pVertexAttributeDescriptions = pState->pVertexAttributes;
+
+    pState->colorBlendState.pAttachments = &pState->colorBlendAttachment;
+
+    pState->dynamicState.dynamicStateCount = pState->dynamicStateCount;
+    pState->dynamicState.pDynamicStates = pState->pDynamicStates;
+
+    pState->createInfo.stageCount = pState->stageCount;
+    pState->createInfo.pStages = pState->pStages;
+    pState->createInfo.pVertexInputState = &pState->vertexInputState;
+    pState->createInfo.pInputAssemblyState = &pState->inputAssemblyState;
+    pState->createInfo.pViewportState = &pState->viewportState;
+    pState->createInfo.pRasterizationState = &pState->rasterizationState;
+    pState->createInfo.pMultisampleState = &pState->multisampleState;
+    pState->createInfo.pDepthStencilState = (pState->depthStencilEnable == SDL_TRUE) ? &pState->depthStencilState : NULL;
+    pState->createInfo.pColorBlendState = &pState->colorBlendState;
+    pState->createInfo.pDynamicState = &pState->dynamicState;
+}
+
+void buildGraphicsPipeline(void* pUserData)
+{
+    PipelineBuildJob*    pJob = pUserData;
+    PipelineBuilder*     pBuilder = pJob->pBuilder;
+
+    int result = vkCreateGraphicsPipelines(pBuilder->device, pBuilder->pipelineCache, 1, &pJob->state.createInfo, NULL, &pJob->pipeline);
+    if (result != VK_SUCCESS)
+    {
+        printError("Failed to create graphics pipeline!");
+    }
+
+    // The handle has to be visible before the status that publishes it
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&pJob->status, (result == VK_SUCCESS) ? PIPELINE_STATUS_READY : PIPELINE_STATUS_FAILED);
+}
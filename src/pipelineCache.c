@@ -0,0 +1,241 @@
+#include "pipelineCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#define PIPELINE_CACHE_FILE_MAGIC      0x43505656u // "VVPC"
+#define PIPELINE_CACHE_FILE_VERSION    1u
+
+// Written in front of the driver blob. The driver validates its own header too, but a blob from another
+// driver version is silently ignored, so the file is checked here and dropped when it no longer matches.
+typedef struct PipelineCacheFileHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    vendorID;
+    uint32_t    deviceID;
+    uint32_t    driverVersion;
+    uint32_t    reserved;
+    uint8_t     deviceUUID[VK_UUID_SIZE];
+    uint8_t     pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t    dataSize;
+    uint64_t    dataHash;
+} PipelineCacheFileHeader;
+
+static void fillPipelineCacheFileHeader(VkPhysicalDevice physicalDevice, PipelineCacheFileHeader* pHeader);
+
+static Result readPipelineCacheFile(const char* pPath, const PipelineCacheFileHeader* pExpectedHeader, void** ppData, size_t* pDataSize);
+
+char* getDefaultPipelineCachePath(void)
+{
+    return getPreferencePath("pipeline_cache.bin");
+}
+
+Result loadPipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const char* pPath, VkPipelineCache* pPipelineCache)
+{
+    PipelineCacheFileHeader expectedHeader;
+    fillPipelineCacheFileHeader(physicalDevice, &expectedHeader);
+
+    void*     pData = NULL;
+    size_t    dataSize = 0;
+
+    if ((pPath != NULL) && (readPipelineCacheFile(pPath, &expectedHeader, &pData, &dataSize) != SUCCESS))
+    {
+        // A stale or damaged file would only be rejected again on every launch
+        remove(pPath);
+    }
+
+    VkPipelineCacheCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.initialDataSize = dataSize;
+    createInfo.pInitialData = pData;
+
+    int result = vkCreatePipelineCache(device, &createInfo, NULL, pPipelineCache);
+
+    free(pData);
+
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result savePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache, const char* pPath)
+{
+    size_t dataSize = 0;
+    if ((vkGetPipelineCacheData(device, pipelineCache, &dataSize, NULL) != VK_SUCCESS) || (dataSize == 0))
+    {
+        printError("Failed to get size of pipeline cache data!");
+        return FAIL;
+    }
+
+    void* pData = malloc(dataSize);
+    if (pData == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for pipeline cache data!", dataSize);
+        return FAIL;
+    }
+
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, pData) != VK_SUCCESS)
+    {
+        printError("Failed to get pipeline cache data!");
+        free(pData);
+        return FAIL;
+    }
+
+    PipelineCacheFileHeader header;
+    fillPipelineCacheFileHeader(physicalDevice, &header);
+    header.dataSize = dataSize;
+    header.dataHash = hashBytes(pData, dataSize, HASH_SEED);
+
+    // Written next to the target and renamed, so a crash mid-write never leaves a truncated cache behind
+    size_t temporaryPathSize = strlen(pPath) + 5;
+    char* pTemporaryPath = malloc(temporaryPathSize);
+    if (pTemporaryPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for temporary pipeline cache path!", temporaryPathSize);
+        free(pData);
+        return FAIL;
+    }
+
+    snprintf(pTemporaryPath, temporaryPathSize, "%s.tmp", pPath);
+
+    FILE* pFile = fopen(pTemporaryPath, "wb");
+    if (pFile == NULL)
+    {
+        printError("Failed to open file \"%s\" for writing!", pTemporaryPath);
+        free(pTemporaryPath);
+        free(pData);
+        return FAIL;
+    }
+
+    SDL_bool written = (fwrite(&header, sizeof(header), 1, pFile) == 1) && (fwrite(pData, 1, dataSize, pFile) == dataSize);
+    written = (fclose(pFile) == 0) && written;
+
+    free(pData);
+
+    if ((written != SDL_TRUE) || (replaceFile(pTemporaryPath, pPath) != SUCCESS))
+    {
+        printError("Failed to write pipeline cache to \"%s\"!", pPath);
+        remove(pTemporaryPath);
+        free(pTemporaryPath);
+        return FAIL;
+    }
+
+    free(pTemporaryPath);
+
+    return SUCCESS;
+}
+
+void fillPipelineCacheFileHeader(VkPhysicalDevice physicalDevice, PipelineCacheFileHeader* pHeader)
+{
+    memset(pHeader, 0, sizeof(*pHeader));
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    pHeader->magic = PIPELINE_CACHE_FILE_MAGIC;
+    pHeader->version = PIPELINE_CACHE_FILE_VERSION;
+    pHeader->vendorID = properties.vendorID;
+    pHeader->deviceID = properties.deviceID;
+    pHeader->driverVersion = properties.driverVersion;
+    memcpy(pHeader->pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    if (properties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        VkPhysicalDeviceIDProperties idProperties;
+        idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+        idProperties.pNext = NULL;
+
+        VkPhysicalDeviceProperties2 properties2;
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &idProperties;
+
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        memcpy(pHeader->deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+    }
+}
+
+Result readPipelineCacheFile(const char* pPath, const PipelineCacheFileHeader* pExpectedHeader, void** ppData, size_t* pDataSize)
+{
+    FILE* pFile = fopen(pPath, "rb");
+    if (pFile == NULL)
+    {
+        // Nothing cached yet is the normal cold start, not an error
+        return SUCCESS;
+    }
+
+    PipelineCacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, pFile) != 1)
+    {
+        printf("Pipeline cache \"%s\" is truncated, dropping it\n\n", pPath);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    if ((header.magic != pExpectedHeader->magic) || (header.version != pExpectedHeader->version))
+    {
+        printf("Pipeline cache \"%s\" has unknown format, dropping it\n\n", pPath);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    if ((header.vendorID != pExpectedHeader->vendorID)
+        || (header.deviceID != pExpectedHeader->deviceID)
+        || (header.driverVersion != pExpectedHeader->driverVersion)
+        || (memcmp(header.deviceUUID, pExpectedHeader->deviceUUID, VK_UUID_SIZE) != 0)
+        || (memcmp(header.pipelineCacheUUID, pExpectedHeader->pipelineCacheUUID, VK_UUID_SIZE) != 0))
+    {
+        printf("Pipeline cache \"%s\" was created for another device or driver, dropping it\n\n", pPath);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    if ((header.dataSize < sizeof(VkPipelineCacheHeaderVersionOne)) || (header.dataSize > SIZE_MAX))
+    {
+        printf("Pipeline cache \"%s\" has invalid size, dropping it\n\n", pPath);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    void* pData = malloc(header.dataSize);
+    if (pData == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for pipeline cache data!", (size_t)header.dataSize);
+        fclose(pFile);
+        return FAIL;
+    }
+
+    size_t readSize = fread(pData, 1, header.dataSize, pFile);
+
+    fclose(pFile);
+
+    if ((readSize != header.dataSize) || (hashBytes(pData, header.dataSize, HASH_SEED) != header.dataHash))
+    {
+        printf("Pipeline cache \"%s\" is corrupted, dropping it\n\n", pPath);
+        free(pData);
+        return FAIL;
+    }
+
+    // The driver header should agree with ours; reject it anyway if it does not
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    memcpy(&driverHeader, pData, sizeof(driverHeader));
+
+    if ((driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        || (driverHeader.vendorID != pExpectedHeader->vendorID)
+        || (driverHeader.deviceID != pExpectedHeader->deviceID)
+        || (memcmp(driverHeader.pipelineCacheUUID, pExpectedHeader->pipelineCacheUUID, VK_UUID_SIZE) != 0))
+    {
+        printf("Pipeline cache \"%s\" has mismatching driver header, dropping it\n\n", pPath);
+        free(pData);
+        return FAIL;
+    }
+
+    *ppData = pData;
+    *pDataSize = header.dataSize;
+
+    return SUCCESS;
+}
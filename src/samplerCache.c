@@ -0,0 +1,114 @@
+#include "samplerCache.h"
+
+#include <string.h>
+
+Result createSamplerCache(SamplerCache* pCache, VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    memset(pCache, 0, sizeof(SamplerCache));
+    pCache->device = device;
+
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // samplerAnisotropy is enabled on the device whenever it is supported
+    pCache->maxSupportedAnisotropy = (features.samplerAnisotropy == VK_TRUE) ? properties.limits.maxSamplerAnisotropy : 1.0f;
+
+    pCache->pMutex = SDL_CreateMutex();
+    if (pCache->pMutex == NULL)
+    {
+        printError("Failed to create sampler cache mutex!");
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroySamplerCache(SamplerCache* pCache)
+{
+    for (uint32_t i = 0; i < pCache->samplerCount; ++i)
+    {
+        vkDestroySampler(pCache->device, pCache->pSamplers[i], NULL);
+    }
+
+    pCache->samplerCount = 0;
+
+    if (pCache->pMutex != NULL)
+    {
+        SDL_DestroyMutex(pCache->pMutex);
+        pCache->pMutex = NULL;
+    }
+}
+
+void setDefaultSamplerKey(const SamplerCache* pCache, SamplerKey* pKey)
+{
+    pKey->filter = VK_FILTER_LINEAR;
+    pKey->mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    pKey->addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    pKey->maxAnisotropy = pCache->maxSupportedAnisotropy;
+}
+
+Result getSampler(SamplerCache* pCache, const SamplerKey* pKey, VkSampler* pSampler)
+{
+    SamplerKey key = *pKey;
+    key.maxAnisotropy = SDL_min(SDL_max(key.maxAnisotropy, 1.0f), pCache->maxSupportedAnisotropy);
+
+    SDL_LockMutex(pCache->pMutex);
+
+    for (uint32_t i = 0; i < pCache->samplerCount; ++i)
+    {
+        if (memcmp(&pCache->pKeys[i], &key, sizeof(SamplerKey)) == 0)
+        {
+            *pSampler = pCache->pSamplers[i];
+            SDL_UnlockMutex(pCache->pMutex);
+            return SUCCESS;
+        }
+    }
+
+    if (pCache->samplerCount == MAX_CACHED_SAMPLERS)
+    {
+        SDL_UnlockMutex(pCache->pMutex);
+        printError("Sampler cache is full, at most %u different samplers are supported!", MAX_CACHED_SAMPLERS);
+        return FAIL;
+    }
+
+    VkSamplerCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.magFilter = key.filter;
+    createInfo.minFilter = key.filter;
+    createInfo.mipmapMode = key.mipmapMode;
+    createInfo.addressModeU = key.addressMode;
+    createInfo.addressModeV = key.addressMode;
+    createInfo.addressModeW = key.addressMode;
+    createInfo.mipLodBias = 0.0f;
+    createInfo.anisotropyEnable = (key.maxAnisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+    createInfo.maxAnisotropy = key.maxAnisotropy;
+    createInfo.compareEnable = VK_FALSE;
+    createInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    createInfo.minLod = 0.0f;
+    createInfo.maxLod = VK_LOD_CLAMP_NONE;
+    createInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    createInfo.unnormalizedCoordinates = VK_FALSE;
+
+    VkSampler sampler;
+    if (vkCreateSampler(pCache->device, &createInfo, NULL, &sampler) != VK_SUCCESS)
+    {
+        SDL_UnlockMutex(pCache->pMutex);
+        printError("Failed to create sampler!");
+        return FAIL;
+    }
+
+    pCache->pKeys[pCache->samplerCount] = key;
+    pCache->pSamplers[pCache->samplerCount] = sampler;
+    ++pCache->samplerCount;
+
+    SDL_UnlockMutex(pCache->pMutex);
+
+    *pSampler = sampler;
+
+    return SUCCESS;
+}
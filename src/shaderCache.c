@@ -0,0 +1,214 @@
+#include "shaderCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPIRV_MAGIC 0x07230203u
+
+#ifdef VIEWER_EMBED_SHADERS
+typedef struct EmbeddedShader
+{
+    const char*        pName;
+    const uint32_t*    pCode;
+    size_t             codeSize;
+} EmbeddedShader;
+
+// Written by glslc -mfmt=num as comma separated SPIR-V words, which keeps the code aligned to its words.
+// Must list every shader CMakeLists.txt compiles.
+static const uint32_t pVertCode[] = {
+#include "shader_vert.inc"
+};
+
+static const uint32_t pFragCode[] = {
+#include "shader_frag.inc"
+};
+
+static const uint32_t pCulledVertCode[] = {
+#include "culled_vert.inc"
+};
+
+static const uint32_t pCullCompCode[] = {
+#include "cull_comp.inc"
+};
+
+static const uint32_t pInstancedVertCode[] = {
+#include "instanced_vert.inc"
+};
+
+static const uint32_t pVirtualFragCode[] = {
+#include "virtual_frag.inc"
+};
+
+static const EmbeddedShader pEmbeddedShaders[] = {
+    {"shader_vert.spv", pVertCode, sizeof(pVertCode)},
+    {"shader_frag.spv", pFragCode, sizeof(pFragCode)},
+    {"culled_vert.spv", pCulledVertCode, sizeof(pCulledVertCode)},
+    {"cull_comp.spv", pCullCompCode, sizeof(pCullCompCode)},
+    {"instanced_vert.spv", pInstancedVertCode, sizeof(pInstancedVertCode)},
+    {"virtual_frag.spv", pVirtualFragCode, sizeof(pVirtualFragCode)}
+};
+#else
+static Result mapShaderFile(const ShaderCache* pCache, const char* pName, MappedFile* pFile);
+#endif
+
+static Result createCachedShaderModule(ShaderCache* pCache, const char* pName, const uint32_t* pCode, size_t codeSize, VkShaderModule* pModule);
+
+Result createShaderCache(ShaderCache* pCache, VkDevice device)
+{
+    memset(pCache, 0, sizeof(ShaderCache));
+    pCache->device = device;
+
+    pCache->pMutex = SDL_CreateMutex();
+    if (pCache->pMutex == NULL)
+    {
+        printError("Failed to create shader cache mutex!");
+        return FAIL;
+    }
+
+#ifndef VIEWER_EMBED_SHADERS
+    // NULL when the platform cannot tell, the shaders are then looked for relative to the working directory
+    pCache->pBasePath = SDL_GetBasePath();
+#endif
+
+    return SUCCESS;
+}
+
+void destroyShaderCache(ShaderCache* pCache)
+{
+    for (uint32_t i = 0; i < pCache->shaderCount; ++i)
+    {
+        vkDestroyShaderModule(pCache->device, pCache->pModules[i], NULL);
+    }
+
+    pCache->shaderCount = 0;
+
+    SDL_free(pCache->pBasePath);
+    pCache->pBasePath = NULL;
+
+    if (pCache->pMutex != NULL)
+    {
+        SDL_DestroyMutex(pCache->pMutex);
+        pCache->pMutex = NULL;
+    }
+}
+
+Result getShaderModule(ShaderCache* pCache, const char* pName, VkShaderModule* pModule)
+{
+#ifdef VIEWER_EMBED_SHADERS
+    for (uint32_t i = 0; i < sizeof(pEmbeddedShaders) / sizeof(pEmbeddedShaders[0]); ++i)
+    {
+        if (strcmp(pEmbeddedShaders[i].pName, pName) == 0)
+        {
+            return createCachedShaderModule(pCache, pName, pEmbeddedShaders[i].pCode, pEmbeddedShaders[i].codeSize, pModule);
+        }
+    }
+
+    printError("Shader \"%s\" is not embedded!", pName);
+    return FAIL;
+#else
+    MappedFile file;
+    if (mapShaderFile(pCache, pName, &file) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    // Mappings start at a page boundary, so the code is aligned to its words
+    Result result = createCachedShaderModule(pCache, pName, file.pData, file.size, pModule);
+
+    unmapFile(&file);
+
+    return result;
+#endif
+}
+
+#ifndef VIEWER_EMBED_SHADERS
+Result mapShaderFile(const ShaderCache* pCache, const char* pName, MappedFile* pFile)
+{
+    const char* pBasePath = (pCache->pBasePath != NULL) ? pCache->pBasePath : "";
+    const char* ppDirectories[] = {"shaders/", "../shaders/"};
+
+    for (uint32_t i = 0; i < sizeof(ppDirectories) / sizeof(ppDirectories[0]); ++i)
+    {
+        size_t pathSize = strlen(pBasePath) + strlen(ppDirectories[i]) + strlen(pName) + 1;
+        char* pPath = malloc(pathSize);
+        if (pPath == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for shader path!", pathSize);
+            return FAIL;
+        }
+
+        snprintf(pPath, pathSize, "%s%s%s", pBasePath, ppDirectories[i], pName);
+
+        uint64_t size;
+        int64_t modifiedTime;
+        if (getFileStamp(pPath, &size, &modifiedTime) == SUCCESS)
+        {
+            Result result = mapFile(pPath, pFile);
+            free(pPath);
+            return result;
+        }
+
+        free(pPath);
+    }
+
+    printError("Failed to find shader \"%s\" in \"%sshaders/\" or \"%s../shaders/\"!", pName, pBasePath, pBasePath);
+    return FAIL;
+}
+#endif
+
+Result createCachedShaderModule(ShaderCache* pCache, const char* pName, const uint32_t* pCode, size_t codeSize, VkShaderModule* pModule)
+{
+    if ((codeSize == 0) || (codeSize % sizeof(uint32_t) != 0) || (pCode[0] != SPIRV_MAGIC))
+    {
+        printError("Shader \"%s\" is not SPIR-V!", pName);
+        return FAIL;
+    }
+
+    uint64_t hash = hashBytes(pCode, codeSize, HASH_SEED);
+
+    SDL_LockMutex(pCache->pMutex);
+
+    for (uint32_t i = 0; i < pCache->shaderCount; ++i)
+    {
+        if ((pCache->pHashes[i] == hash) && (pCache->pCodeSizes[i] == codeSize))
+        {
+            *pModule = pCache->pModules[i];
+            SDL_UnlockMutex(pCache->pMutex);
+            return SUCCESS;
+        }
+    }
+
+    if (pCache->shaderCount == MAX_CACHED_SHADERS)
+    {
+        SDL_UnlockMutex(pCache->pMutex);
+        printError("Shader cache is full, at most %u different shaders are supported!", MAX_CACHED_SHADERS);
+        return FAIL;
+    }
+
+    VkShaderModuleCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.codeSize = codeSize;
+    createInfo.pCode = pCode;
+
+    VkShaderModule module;
+    if (vkCreateShaderModule(pCache->device, &createInfo, NULL, &module) != VK_SUCCESS)
+    {
+        SDL_UnlockMutex(pCache->pMutex);
+        printError("Failed to create shader module for \"%s\"!", pName);
+        return FAIL;
+    }
+
+    pCache->pHashes[pCache->shaderCount] = hash;
+    pCache->pCodeSizes[pCache->shaderCount] = codeSize;
+    pCache->pModules[pCache->shaderCount] = module;
+    ++pCache->shaderCount;
+
+    SDL_UnlockMutex(pCache->pMutex);
+
+    *pModule = module;
+
+    return SUCCESS;
+}
@@ -0,0 +1,373 @@
+#include "stagingRing.h"
+
+#include <string.h>
+
+static Result beginSegment(StagingSegment* pSegment);
+
+static Result submitSegment(StagingRing* pRing, StagingSegment* pSegment);
+
+static Result waitForSegment(StagingRing* pRing, StagingSegment* pSegment);
+
+Result createStagingRing(StagingRing* pRing, Allocator* pAllocator, VkQueue queue, uint32_t queueFamilyIndex, uint32_t dstQueueFamilyIndex, VkDeviceSize size)
+{
+    memset(pRing, 0, sizeof(StagingRing));
+    pRing->device = pAllocator->device;
+    pRing->queue = queue;
+    pRing->queueFamilyIndex = queueFamilyIndex;
+    pRing->dstQueueFamilyIndex = dstQueueFamilyIndex;
+    pRing->pAllocator = pAllocator;
+    pRing->segmentSize = size / STAGING_SEGMENT_COUNT;
+
+    // Written once by the CPU and read once by the GPU, so a linear block is enough
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_LINEAR;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    if (createBuffer(pAllocator, pRing->segmentSize * STAGING_SEGMENT_COUNT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &allocationInfo, &pRing->buffer, &pRing->allocation) != SUCCESS)
+    {
+        printError("Failed to create staging buffer!");
+        destroyStagingRing(pRing);
+        return FAIL;
+    }
+
+    VkCommandPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+    if (vkCreateCommandPool(pRing->device, &poolCreateInfo, NULL, &pRing->commandPool) != VK_SUCCESS)
+    {
+        printError("Failed to create staging command pool!");
+        destroyStagingRing(pRing);
+        return FAIL;
+    }
+
+    VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo;
+    semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeCreateInfo.pNext = NULL;
+    semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeCreateInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo;
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+    semaphoreCreateInfo.flags = 0;
+
+    if (vkCreateSemaphore(pRing->device, &semaphoreCreateInfo, NULL, &pRing->timelineSemaphore) != VK_SUCCESS)
+    {
+        printError("Failed to create staging timeline semaphore!");
+        destroyStagingRing(pRing);
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < STAGING_SEGMENT_COUNT; ++i)
+    {
+        VkCommandBufferAllocateInfo allocateInfo;
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.pNext = NULL;
+        allocateInfo.commandPool = pRing->commandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(pRing->device, &allocateInfo, &pRing->pSegments[i].commandBuffer) != VK_SUCCESS)
+        {
+            printError("Failed to allocate staging command buffer %u!", i);
+            destroyStagingRing(pRing);
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+void destroyStagingRing(StagingRing* pRing)
+{
+    if (pRing->device == NULL)
+    {
+        return;
+    }
+
+    if (pRing->timelineSemaphore != NULL)
+    {
+        VkSemaphoreWaitInfo waitInfo;
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.pNext = NULL;
+        waitInfo.flags = 0;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &pRing->timelineSemaphore;
+        waitInfo.pValues = &pRing->lastTimelineValue;
+
+        vkWaitSemaphores(pRing->device, &waitInfo, UINT64_MAX);
+    }
+
+    vkDestroySemaphore(pRing->device, pRing->timelineSemaphore, NULL);
+
+    vkDestroyCommandPool(pRing->device, pRing->commandPool, NULL);
+
+    destroyBuffer(pRing->pAllocator, pRing->buffer, &pRing->allocation);
+
+    memset(pRing, 0, sizeof(StagingRing));
+}
+
+Result stageBuffer(StagingRing* pRing, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+{
+    const char* pBytes = pData;
+
+    while (size > 0)
+    {
+        StagingSegment* pSegment = &pRing->pSegments[pRing->currentSegment];
+
+        if (pSegment->usedSize == pRing->segmentSize)
+        {
+            if (submitSegment(pRing, pSegment) != SUCCESS)
+            {
+                return FAIL;
+            }
+
+            pRing->currentSegment = (pRing->currentSegment + 1) % STAGING_SEGMENT_COUNT;
+            pSegment = &pRing->pSegments[pRing->currentSegment];
+
+            if (waitForSegment(pRing, pSegment) != SUCCESS)
+            {
+                return FAIL;
+            }
+        }
+
+        if (beginSegment(pSegment) != SUCCESS)
+        {
+            return FAIL;
+        }
+
+        VkDeviceSize chunkSize = pRing->segmentSize - pSegment->usedSize;
+        chunkSize = (size < chunkSize) ? size : chunkSize;
+
+        VkDeviceSize srcOffset = pRing->currentSegment * pRing->segmentSize + pSegment->usedSize;
+        memcpy((char*)pRing->allocation.pMapped + srcOffset, pBytes, chunkSize);
+
+        VkBufferCopy region;
+        region.srcOffset = srcOffset;
+        region.dstOffset = dstOffset;
+        region.size = chunkSize;
+
+        vkCmdCopyBuffer(pSegment->commandBuffer, pRing->buffer, dstBuffer, 1, &region);
+
+        // Keep copy sources 16 byte aligned for the next chunk
+        pSegment->usedSize += (chunkSize + 15) & ~(VkDeviceSize)15;
+        pSegment->usedSize = (pSegment->usedSize < pRing->segmentSize) ? pSegment->usedSize : pRing->segmentSize;
+
+        pRing->stagedBytes += chunkSize;
+        pBytes += chunkSize;
+        dstOffset += chunkSize;
+        size -= chunkSize;
+    }
+
+    return SUCCESS;
+}
+
+Result releaseStagedBuffer(StagingRing* pRing, VkBuffer buffer)
+{
+    if (pRing->queueFamilyIndex == pRing->dstQueueFamilyIndex)
+    {
+        return SUCCESS;
+    }
+
+    // Copies of earlier segments were submitted before this one, so the barrier covers them too
+    StagingSegment* pSegment = &pRing->pSegments[pRing->currentSegment];
+    if (beginSegment(pSegment) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    VkBufferMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.srcQueueFamilyIndex = pRing->queueFamilyIndex;
+    barrier.dstQueueFamilyIndex = pRing->dstQueueFamilyIndex;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(pSegment->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+
+    return SUCCESS;
+}
+
+void acquireStagedBuffer(const StagingRing* pRing, VkCommandBuffer commandBuffer, VkBuffer buffer, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
+{
+    if (pRing->queueFamilyIndex == pRing->dstQueueFamilyIndex)
+    {
+        return;
+    }
+
+    VkBufferMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dstAccessMask;
+    barrier.srcQueueFamilyIndex = pRing->queueFamilyIndex;
+    barrier.dstQueueFamilyIndex = pRing->dstQueueFamilyIndex;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask, 0, 0, NULL, 1, &barrier, 0, NULL);
+}
+
+Result submitStagingRing(StagingRing* pRing, uint64_t* pTimelineValue)
+{
+    StagingSegment* pCurrent = &pRing->pSegments[pRing->currentSegment];
+    if (pCurrent->recording == SDL_TRUE)
+    {
+        if (submitSegment(pRing, pCurrent) != SUCCESS)
+        {
+            return FAIL;
+        }
+
+        // Start the next batch in a fresh segment, the submitted one stays untouched until its copies completed
+        pRing->currentSegment = (pRing->currentSegment + 1) % STAGING_SEGMENT_COUNT;
+        if (waitForSegment(pRing, &pRing->pSegments[pRing->currentSegment]) != SUCCESS)
+        {
+            return FAIL;
+        }
+    }
+
+    *pTimelineValue = pRing->lastTimelineValue;
+    return SUCCESS;
+}
+
+Result flushStagingRing(StagingRing* pRing)
+{
+    uint64_t timelineValue;
+    if (submitStagingRing(pRing, &timelineValue) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < STAGING_SEGMENT_COUNT; ++i)
+    {
+        if (waitForSegment(pRing, &pRing->pSegments[i]) != SUCCESS)
+        {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
+
+SDL_bool isTimelineValueReached(const StagingRing* pRing, uint64_t timelineValue)
+{
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(pRing->device, pRing->timelineSemaphore, &value) != VK_SUCCESS)
+    {
+        return SDL_FALSE;
+    }
+
+    return (value >= timelineValue) ? SDL_TRUE : SDL_FALSE;
+}
+
+Result beginSegment(StagingSegment* pSegment)
+{
+    if (pSegment->recording == SDL_TRUE)
+    {
+        return SUCCESS;
+    }
+
+    VkCommandBufferBeginInfo beginInfo;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = NULL;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = NULL;
+
+    if (vkBeginCommandBuffer(pSegment->commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        printError("Failed to begin staging command buffer!");
+        return FAIL;
+    }
+
+    pSegment->recording = SDL_TRUE;
+    return SUCCESS;
+}
+
+Result submitSegment(StagingRing* pRing, StagingSegment* pSegment)
+{
+    // Within one family the copies only need to be made visible to later submissions
+    if (pRing->queueFamilyIndex == pRing->dstQueueFamilyIndex)
+    {
+        VkMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+        vkCmdPipelineBarrier(pSegment->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+    }
+
+    if (vkEndCommandBuffer(pSegment->commandBuffer) != VK_SUCCESS)
+    {
+        printError("Failed to end staging command buffer!");
+        return FAIL;
+    }
+
+    uint64_t signalValue = pRing->lastTimelineValue + 1;
+
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo;
+    timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineSubmitInfo.pNext = NULL;
+    timelineSubmitInfo.waitSemaphoreValueCount = 0;
+    timelineSubmitInfo.pWaitSemaphoreValues = NULL;
+    timelineSubmitInfo.signalSemaphoreValueCount = 1;
+    timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+
+    VkSubmitInfo submitInfo;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineSubmitInfo;
+    submitInfo.waitSemaphoreCount = 0;
+    submitInfo.pWaitSemaphores = NULL;
+    submitInfo.pWaitDstStageMask = NULL;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &pSegment->commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &pRing->timelineSemaphore;
+
+    if (vkQueueSubmit(pRing->queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        printError("Failed to submit staging command buffer!");
+        return FAIL;
+    }
+
+    pRing->lastTimelineValue = signalValue;
+    pSegment->recording = SDL_FALSE;
+    pSegment->timelineValue = signalValue;
+    return SUCCESS;
+}
+
+Result waitForSegment(StagingRing* pRing, StagingSegment* pSegment)
+{
+    if (pSegment->timelineValue > 0)
+    {
+        VkSemaphoreWaitInfo waitInfo;
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.pNext = NULL;
+        waitInfo.flags = 0;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &pRing->timelineSemaphore;
+        waitInfo.pValues = &pSegment->timelineValue;
+
+        if ((vkWaitSemaphores(pRing->device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+            || (vkResetCommandBuffer(pSegment->commandBuffer, 0) != VK_SUCCESS))
+        {
+            printError("Failed to wait for staging segment!");
+            return FAIL;
+        }
+
+        pSegment->timelineValue = 0;
+    }
+
+    pSegment->usedSize = 0;
+    return SUCCESS;
+}
@@ -0,0 +1,797 @@
+#include "texture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_image.h>
+
+#include "cpuTrace.h"
+
+#define KTX2_HEADER_SIZE            80
+#define KTX2_LEVEL_INDEX_ENTRY      24
+#define TEXTURE_DATA_ALIGNMENT      16
+
+static const uint8_t pKtx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// Pixels of one texture in host memory, either decoded from PNG or JPEG or mapped straight from a KTX2 file
+typedef struct TextureData
+{
+    VkFormat        format;
+    uint32_t        width;
+    uint32_t        height;
+    uint32_t        levelCount;
+    const char*     pLevels[MAX_TEXTURE_LEVELS];
+    VkDeviceSize    pLevelSizes[MAX_TEXTURE_LEVELS];
+    void*           pPixels;
+    MappedFile      file;
+} TextureData;
+
+typedef struct DecodeJob
+{
+    const TextureLoader*    pLoader;
+    const char*             pPath;
+    TextureData             data;
+    Result                  result;
+} DecodeJob;
+
+static void decodeTexture(void* pUserData);
+
+static Result decodeImage(const char* pPath, TextureData* pData);
+
+static Result loadKtx2(const char* pPath, TextureData* pData);
+
+static void destroyTextureData(TextureData* pData);
+
+static char* getKtx2Path(const char* pPath);
+
+static uint32_t getBlockSize(VkFormat format);
+
+static SDL_bool isFormatSampled(const TextureLoader* pLoader, VkFormat format);
+
+static SDL_bool canGenerateMips(const TextureLoader* pLoader, VkFormat format);
+
+static Result uploadTextures(TextureLoader* pLoader, uint32_t textureCount, const TextureData* pData, Texture* pTextures);
+
+static Result createTextureImage(TextureLoader* pLoader, const TextureData* pData, Texture* pTexture);
+
+static void recordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, const VkDeviceSize* pLevelOffsets, const TextureData* pData, const Texture* pTexture);
+
+static void recordLayoutTransition(VkCommandBuffer commandBuffer, VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+    VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
+
+static uint32_t readUint32(const uint8_t* pBytes);
+
+static uint64_t readUint64(const uint8_t* pBytes);
+
+Result createTextureLoader(TextureLoader* pLoader, VkPhysicalDevice physicalDevice, VkDevice device, Allocator* pAllocator, VkQueue queue, uint32_t queueFamilyIndex,
+    uint32_t threadCount)
+{
+    memset(pLoader, 0, sizeof(TextureLoader));
+    pLoader->physicalDevice = physicalDevice;
+    pLoader->device = device;
+    pLoader->pAllocator = pAllocator;
+    pLoader->queue = queue;
+
+    // Not fatal, SDL_image may still read the format through a built-in decoder
+    int imageFlags = IMG_INIT_PNG | IMG_INIT_JPG;
+    if ((IMG_Init(imageFlags) & imageFlags) != imageFlags)
+    {
+        printError("SDL_image lacks PNG or JPEG support!");
+    }
+
+    VkCommandPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+    if (vkCreateCommandPool(device, &poolCreateInfo, NULL, &pLoader->commandPool) != VK_SUCCESS)
+    {
+        printError("Failed to create texture command pool!");
+        destroyTextureLoader(pLoader);
+        return FAIL;
+    }
+
+    VkFenceCreateInfo fenceCreateInfo;
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = NULL;
+    fenceCreateInfo.flags = 0;
+
+    if (vkCreateFence(device, &fenceCreateInfo, NULL, &pLoader->fence) != VK_SUCCESS)
+    {
+        printError("Failed to create texture upload fence!");
+        destroyTextureLoader(pLoader);
+        return FAIL;
+    }
+
+    if (createThreadPool(&pLoader->threadPool, threadCount) != SUCCESS)
+    {
+        printError("Failed to create texture decoder thread pool!");
+        destroyTextureLoader(pLoader);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyTextureLoader(TextureLoader* pLoader)
+{
+    destroyThreadPool(&pLoader->threadPool);
+
+    vkDestroyFence(pLoader->device, pLoader->fence, NULL);
+    pLoader->fence = VK_NULL_HANDLE;
+
+    vkDestroyCommandPool(pLoader->device, pLoader->commandPool, NULL);
+    pLoader->commandPool = VK_NULL_HANDLE;
+
+    IMG_Quit();
+}
+
+Result loadTextures(TextureLoader* pLoader, uint32_t textureCount, const char* const* ppPaths, Texture* pTextures, TextureLoadStats* pStats)
+{
+    DecodeJob* pJobs = calloc(textureCount, sizeof(DecodeJob));
+    if (pJobs == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for texture decode jobs!", textureCount * sizeof(DecodeJob));
+        return FAIL;
+    }
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        pJobs[i].pLoader = pLoader;
+        pJobs[i].pPath = ppPaths[i];
+        if (submitJob(&pLoader->threadPool, decodeTexture, &pJobs[i]) != SUCCESS)
+        {
+            decodeTexture(&pJobs[i]);
+        }
+    }
+
+    waitForJobs(&pLoader->threadPool);
+
+    uint64_t decodedTicks = SDL_GetPerformanceCounter();
+
+    TextureData* pData = malloc(textureCount * sizeof(TextureData));
+    Result result = (pData != NULL) ? SUCCESS : FAIL;
+    if (result != SUCCESS)
+    {
+        printError("Failed to allocate %lu bytes of memory for texture data!", textureCount * sizeof(TextureData));
+    }
+
+    for (uint32_t i = 0; (i < textureCount) && (result == SUCCESS); ++i)
+    {
+        result = pJobs[i].result;
+        pData[i] = pJobs[i].data;
+    }
+
+    if (result == SUCCESS)
+    {
+        result = uploadTextures(pLoader, textureCount, pData, pTextures);
+    }
+
+    uint64_t uploadedTicks = SDL_GetPerformanceCounter();
+
+    if ((result == SUCCESS) && (pStats != NULL))
+    {
+        double frequency = (double)SDL_GetPerformanceFrequency();
+
+        memset(pStats, 0, sizeof(TextureLoadStats));
+        pStats->textureCount = textureCount;
+        pStats->decodeMs = (decodedTicks - startTicks) * 1000.0 / frequency;
+        pStats->uploadMs = (uploadedTicks - decodedTicks) * 1000.0 / frequency;
+
+        for (uint32_t i = 0; i < textureCount; ++i)
+        {
+            const Texture* pTexture = &pTextures[i];
+            pStats->compressedCount += (pTexture->compressed == SDL_TRUE) ? 1 : 0;
+            pStats->memoryBytes += pTexture->allocation.size;
+
+            uint32_t width = pTexture->width;
+            uint32_t height = pTexture->height;
+            for (;;)
+            {
+                pStats->uncompressedBytes += (VkDeviceSize)width * height * 4;
+                if ((width == 1) && (height == 1))
+                {
+                    break;
+                }
+
+                width = SDL_max(width / 2, 1);
+                height = SDL_max(height / 2, 1);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        destroyTextureData(&pJobs[i].data);
+    }
+
+    free(pData);
+    free(pJobs);
+
+    return result;
+}
+
+Result createSolidTexture(TextureLoader* pLoader, const uint8_t pColor[4], Texture* pTexture)
+{
+    uint8_t pTexel[4];
+    memcpy(pTexel, pColor, sizeof(pTexel));
+
+    TextureData data;
+    memset(&data, 0, sizeof(data));
+    data.format = VK_FORMAT_R8G8B8A8_SRGB;
+    data.width = 1;
+    data.height = 1;
+    data.levelCount = 1;
+    data.pLevels[0] = (const char*)pTexel;
+    data.pLevelSizes[0] = sizeof(pTexel);
+
+    return uploadTextures(pLoader, 1, &data, pTexture);
+}
+
+void destroyTexture(TextureLoader* pLoader, Texture* pTexture)
+{
+    vkDestroyImageView(pLoader->device, pTexture->imageView, NULL);
+    pTexture->imageView = VK_NULL_HANDLE;
+
+    if (pTexture->image != VK_NULL_HANDLE)
+    {
+        destroyImage(pLoader->pAllocator, pTexture->image, &pTexture->allocation);
+        pTexture->image = VK_NULL_HANDLE;
+    }
+}
+
+void decodeTexture(void* pUserData)
+{
+    DecodeJob* pJob = pUserData;
+    uint64_t traceStart = beginCpuTrace();
+
+    size_t pathLength = strlen(pJob->pPath);
+    size_t extensionLength = strlen(KTX2_EXTENSION);
+
+    if ((pathLength >= extensionLength) && (SDL_strcasecmp(pJob->pPath + pathLength - extensionLength, KTX2_EXTENSION) == 0))
+    {
+        pJob->result = loadKtx2(pJob->pPath, &pJob->data);
+        if ((pJob->result == SUCCESS) && (isFormatSampled(pJob->pLoader, pJob->data.format) != SDL_TRUE))
+        {
+            printError("Device cannot sample the block compressed format of \"%s\"!", pJob->pPath);
+            pJob->result = FAIL;
+        }
+
+        endCpuTrace("load texture", traceStart);
+        return;
+    }
+
+    // The compressed version is only looked for, so a missing one is not an error
+    SDL_bool loaded = SDL_FALSE;
+    char* pKtx2Path = getKtx2Path(pJob->pPath);
+    FILE* pFile = (pKtx2Path != NULL) ? fopen(pKtx2Path, "rb") : NULL;
+    if (pFile != NULL)
+    {
+        fclose(pFile);
+
+        if (loadKtx2(pKtx2Path, &pJob->data) == SUCCESS)
+        {
+            if (isFormatSampled(pJob->pLoader, pJob->data.format) == SDL_TRUE)
+            {
+                loaded = SDL_TRUE;
+            }
+            else
+            {
+                destroyTextureData(&pJob->data);
+            }
+        }
+    }
+
+    free(pKtx2Path);
+
+    pJob->result = (loaded == SDL_TRUE) ? SUCCESS : decodeImage(pJob->pPath, &pJob->data);
+
+    endCpuTrace("load texture", traceStart);
+}
+
+Result decodeImage(const char* pPath, TextureData* pData)
+{
+    memset(pData, 0, sizeof(TextureData));
+
+    SDL_Surface* pSurface = IMG_Load(pPath);
+    if (pSurface == NULL)
+    {
+        printError("Failed to load image \"%s\"!", pPath);
+        return FAIL;
+    }
+
+    SDL_Surface* pConverted = SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(pSurface);
+    if (pConverted == NULL)
+    {
+        printError("Failed to convert image \"%s\" to RGBA!", pPath);
+        return FAIL;
+    }
+
+    size_t rowSize = (size_t)pConverted->w * 4;
+    pData->pPixels = malloc(rowSize * pConverted->h);
+    if (pData->pPixels == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for image \"%s\"!", rowSize * pConverted->h, pPath);
+        SDL_FreeSurface(pConverted);
+        return FAIL;
+    }
+
+    // Surface rows may be padded
+    for (int y = 0; y < pConverted->h; ++y)
+    {
+        memcpy((char*)pData->pPixels + y * rowSize, (const char*)pConverted->pixels + y * pConverted->pitch, rowSize);
+    }
+
+    pData->format = VK_FORMAT_R8G8B8A8_SRGB;
+    pData->width = (uint32_t)pConverted->w;
+    pData->height = (uint32_t)pConverted->h;
+    pData->levelCount = 1;
+    pData->pLevels[0] = pData->pPixels;
+    pData->pLevelSizes[0] = rowSize * pConverted->h;
+
+    SDL_FreeSurface(pConverted);
+
+    return SUCCESS;
+}
+
+Result loadKtx2(const char* pPath, TextureData* pData)
+{
+    memset(pData, 0, sizeof(TextureData));
+
+    if (mapFile(pPath, &pData->file) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    const uint8_t* pBytes = pData->file.pData;
+    size_t fileSize = pData->file.size;
+
+    if ((fileSize < KTX2_HEADER_SIZE) || (memcmp(pBytes, pKtx2Identifier, sizeof(pKtx2Identifier)) != 0))
+    {
+        printError("\"%s\" is not a KTX2 file!", pPath);
+        destroyTextureData(pData);
+        return FAIL;
+    }
+
+    VkFormat format = (VkFormat)readUint32(pBytes + 12);
+    uint32_t width = readUint32(pBytes + 20);
+    uint32_t height = readUint32(pBytes + 24);
+    uint32_t depth = readUint32(pBytes + 28);
+    uint32_t layerCount = readUint32(pBytes + 32);
+    uint32_t faceCount = readUint32(pBytes + 36);
+    uint32_t levelCount = SDL_max(readUint32(pBytes + 40), 1);
+    uint32_t supercompressionScheme = readUint32(pBytes + 44);
+
+    uint32_t blockSize = getBlockSize(format);
+    if (blockSize == 0)
+    {
+        printError("\"%s\" holds neither BC1, BC3 nor BC7 blocks!", pPath);
+        destroyTextureData(pData);
+        return FAIL;
+    }
+
+    if ((width == 0) || (height == 0) || (depth != 0) || (layerCount != 0) || (faceCount != 1) || (supercompressionScheme != 0) || (levelCount > MAX_TEXTURE_LEVELS)
+        || (fileSize < KTX2_HEADER_SIZE + (size_t)levelCount * KTX2_LEVEL_INDEX_ENTRY))
+    {
+        printError("\"%s\" is not a single uncompressed 2D texture with at most %u levels!", pPath, MAX_TEXTURE_LEVELS);
+        destroyTextureData(pData);
+        return FAIL;
+    }
+
+    // The image would be created with more levels than its size allows
+    uint32_t fullLevelCount = 1;
+    for (uint32_t size = SDL_max(width, height); size > 1; size >>= 1)
+    {
+        ++fullLevelCount;
+    }
+
+    if (levelCount > fullLevelCount)
+    {
+        printError("\"%s\" has %u levels, a %ux%u texture has at most %u!", pPath, levelCount, width, height, fullLevelCount);
+        destroyTextureData(pData);
+        return FAIL;
+    }
+
+    pData->format = format;
+    pData->width = width;
+    pData->height = height;
+    pData->levelCount = levelCount;
+
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const uint8_t* pEntry = pBytes + KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_ENTRY;
+        uint64_t offset = readUint64(pEntry);
+        uint64_t size = readUint64(pEntry + 8);
+
+        uint64_t levelWidth = SDL_max(width >> i, 1);
+        uint64_t levelHeight = SDL_max(height >> i, 1);
+        uint64_t expectedSize = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize;
+
+        if ((size != expectedSize) || (offset > fileSize) || (size > fileSize - offset))
+        {
+            printError("Level %u of \"%s\" is truncated or has the wrong size!", i, pPath);
+            destroyTextureData(pData);
+            return FAIL;
+        }
+
+        pData->pLevels[i] = (const char*)pBytes + offset;
+        pData->pLevelSizes[i] = size;
+    }
+
+    return SUCCESS;
+}
+
+void destroyTextureData(TextureData* pData)
+{
+    free(pData->pPixels);
+    pData->pPixels = NULL;
+
+    if (pData->file.pData != NULL)
+    {
+        unmapFile(&pData->file);
+    }
+}
+
+char* getKtx2Path(const char* pPath)
+{
+    const char* pExtension = strrchr(pPath, '.');
+    const char* pSeparator = strrchr(pPath, '/');
+    size_t stemLength = ((pExtension != NULL) && ((pSeparator == NULL) || (pExtension > pSeparator))) ? (size_t)(pExtension - pPath) : strlen(pPath);
+
+    size_t size = stemLength + strlen(KTX2_EXTENSION) + 1;
+    char* pKtx2Path = malloc(size);
+    if (pKtx2Path == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for KTX2 path!", size);
+        return NULL;
+    }
+
+    memcpy(pKtx2Path, pPath, stemLength);
+    strcpy(pKtx2Path + stemLength, KTX2_EXTENSION);
+
+    return pKtx2Path;
+}
+
+uint32_t getBlockSize(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+SDL_bool isFormatSampled(const TextureLoader* pLoader, VkFormat format)
+{
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(pLoader->physicalDevice, format, &properties);
+
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    return ((properties.optimalTilingFeatures & required) == required) ? SDL_TRUE : SDL_FALSE;
+}
+
+SDL_bool canGenerateMips(const TextureLoader* pLoader, VkFormat format)
+{
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(pLoader->physicalDevice, format, &properties);
+
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return ((properties.optimalTilingFeatures & required) == required) ? SDL_TRUE : SDL_FALSE;
+}
+
+Result uploadTextures(TextureLoader* pLoader, uint32_t textureCount, const TextureData* pData, Texture* pTextures)
+{
+    memset(pTextures, 0, textureCount * sizeof(Texture));
+
+    VkDeviceSize* pLevelOffsets = malloc(textureCount * MAX_TEXTURE_LEVELS * sizeof(VkDeviceSize));
+    if (pLevelOffsets == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for texture level offsets!", textureCount * MAX_TEXTURE_LEVELS * sizeof(VkDeviceSize));
+        return FAIL;
+    }
+
+    // Offsets are aligned for the largest texel block, copies from the staging buffer must start on a block
+    VkDeviceSize stagingSize = 0;
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        for (uint32_t j = 0; j < pData[i].levelCount; ++j)
+        {
+            stagingSize = (stagingSize + TEXTURE_DATA_ALIGNMENT - 1) / TEXTURE_DATA_ALIGNMENT * TEXTURE_DATA_ALIGNMENT;
+            pLevelOffsets[i * MAX_TEXTURE_LEVELS + j] = stagingSize;
+            stagingSize += pData[i].pLevelSizes[j];
+        }
+    }
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    VkBuffer stagingBuffer;
+    Allocation stagingAllocation;
+    if (createBuffer(pLoader->pAllocator, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &allocationInfo, &stagingBuffer, &stagingAllocation) != SUCCESS)
+    {
+        printError("Failed to create texture staging buffer!");
+        free(pLevelOffsets);
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        for (uint32_t j = 0; j < pData[i].levelCount; ++j)
+        {
+            memcpy((char*)stagingAllocation.pMapped + pLevelOffsets[i * MAX_TEXTURE_LEVELS + j], pData[i].pLevels[j], pData[i].pLevelSizes[j]);
+        }
+    }
+
+    Result result = SUCCESS;
+    for (uint32_t i = 0; (i < textureCount) && (result == SUCCESS); ++i)
+    {
+        result = createTextureImage(pLoader, &pData[i], &pTextures[i]);
+    }
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    if (result == SUCCESS)
+    {
+        vkResetCommandPool(pLoader->device, pLoader->commandPool, 0);
+
+        VkCommandBufferAllocateInfo allocateInfo;
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.pNext = NULL;
+        allocateInfo.commandPool = pLoader->commandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+
+        VkCommandBufferBeginInfo beginInfo;
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.pNext = NULL;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = NULL;
+
+        if ((vkAllocateCommandBuffers(pLoader->device, &allocateInfo, &commandBuffer) != VK_SUCCESS) || (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS))
+        {
+            printError("Failed to begin texture upload command buffer!");
+            result = FAIL;
+        }
+    }
+
+    if (result == SUCCESS)
+    {
+        for (uint32_t i = 0; i < textureCount; ++i)
+        {
+            recordTextureUpload(commandBuffer, stagingBuffer, &pLevelOffsets[i * MAX_TEXTURE_LEVELS], &pData[i], &pTextures[i]);
+        }
+
+        VkSubmitInfo submitInfo;
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = NULL;
+        submitInfo.waitSemaphoreCount = 0;
+        submitInfo.pWaitSemaphores = NULL;
+        submitInfo.pWaitDstStageMask = NULL;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        submitInfo.signalSemaphoreCount = 0;
+        submitInfo.pSignalSemaphores = NULL;
+
+        if ((vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) || (vkQueueSubmit(pLoader->queue, 1, &submitInfo, pLoader->fence) != VK_SUCCESS))
+        {
+            printError("Failed to submit texture uploads!");
+            result = FAIL;
+        }
+        else
+        {
+            vkWaitForFences(pLoader->device, 1, &pLoader->fence, VK_TRUE, UINT64_MAX);
+            vkResetFences(pLoader->device, 1, &pLoader->fence);
+        }
+    }
+
+    destroyBuffer(pLoader->pAllocator, stagingBuffer, &stagingAllocation);
+    free(pLevelOffsets);
+
+    if (result != SUCCESS)
+    {
+        for (uint32_t i = 0; i < textureCount; ++i)
+        {
+            destroyTexture(pLoader, &pTextures[i]);
+        }
+    }
+
+    return result;
+}
+
+Result createTextureImage(TextureLoader* pLoader, const TextureData* pData, Texture* pTexture)
+{
+    pTexture->format = pData->format;
+    pTexture->width = pData->width;
+    pTexture->height = pData->height;
+    pTexture->compressed = (getBlockSize(pData->format) > 0) ? SDL_TRUE : SDL_FALSE;
+    pTexture->levelCount = pData->levelCount;
+
+    // Decoded images get a full mip chain when the format can be blitted with filtering
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if ((pTexture->compressed != SDL_TRUE) && (canGenerateMips(pLoader, pData->format) == SDL_TRUE))
+    {
+        uint32_t size = SDL_max(pData->width, pData->height);
+        pTexture->levelCount = 1;
+        while ((size > 1) && (pTexture->levelCount < MAX_TEXTURE_LEVELS))
+        {
+            size /= 2;
+            ++pTexture->levelCount;
+        }
+
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
+    VkImageCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = pData->format;
+    createInfo.extent.width = pData->width;
+    createInfo.extent.height = pData->height;
+    createInfo.extent.depth = 1;
+    createInfo.mipLevels = pTexture->levelCount;
+    createInfo.arrayLayers = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.usage = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = NULL;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_TRUE;
+
+    if (createImage(pLoader->pAllocator, &createInfo, &allocationInfo, &pTexture->image, &pTexture->allocation) != SUCCESS)
+    {
+        pTexture->image = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    VkImageViewCreateInfo viewCreateInfo;
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = NULL;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = pTexture->image;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = pData->format;
+    viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewCreateInfo.subresourceRange.baseMipLevel = 0;
+    viewCreateInfo.subresourceRange.levelCount = pTexture->levelCount;
+    viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    viewCreateInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(pLoader->device, &viewCreateInfo, NULL, &pTexture->imageView) != VK_SUCCESS)
+    {
+        printError("Failed to create texture image view!");
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void recordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, const VkDeviceSize* pLevelOffsets, const TextureData* pData, const Texture* pTexture)
+{
+    recordLayoutTransition(commandBuffer, pTexture->image, 0, pTexture->levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    VkBufferImageCopy pRegions[MAX_TEXTURE_LEVELS];
+    for (uint32_t i = 0; i < pData->levelCount; ++i)
+    {
+        pRegions[i].bufferOffset = pLevelOffsets[i];
+        pRegions[i].bufferRowLength = 0;
+        pRegions[i].bufferImageHeight = 0;
+        pRegions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        pRegions[i].imageSubresource.mipLevel = i;
+        pRegions[i].imageSubresource.baseArrayLayer = 0;
+        pRegions[i].imageSubresource.layerCount = 1;
+        pRegions[i].imageOffset.x = 0;
+        pRegions[i].imageOffset.y = 0;
+        pRegions[i].imageOffset.z = 0;
+        pRegions[i].imageExtent.width = SDL_max(pData->width >> i, 1);
+        pRegions[i].imageExtent.height = SDL_max(pData->height >> i, 1);
+        pRegions[i].imageExtent.depth = 1;
+    }
+
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, pTexture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, pData->levelCount, pRegions);
+
+    // Every level is blitted from the one above it, which has to be finished and readable first
+    for (uint32_t i = pData->levelCount; i < pTexture->levelCount; ++i)
+    {
+        recordLayoutTransition(commandBuffer, pTexture->image, i - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        VkImageBlit blit;
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[0].x = 0;
+        blit.srcOffsets[0].y = 0;
+        blit.srcOffsets[0].z = 0;
+        blit.srcOffsets[1].x = (int32_t)SDL_max(pTexture->width >> (i - 1), 1);
+        blit.srcOffsets[1].y = (int32_t)SDL_max(pTexture->height >> (i - 1), 1);
+        blit.srcOffsets[1].z = 1;
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstOffsets[0] = blit.srcOffsets[0];
+        blit.dstOffsets[1].x = (int32_t)SDL_max(pTexture->width >> i, 1);
+        blit.dstOffsets[1].y = (int32_t)SDL_max(pTexture->height >> i, 1);
+        blit.dstOffsets[1].z = 1;
+
+        vkCmdBlitImage(commandBuffer, pTexture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pTexture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+    }
+
+    // Blit sources are left in the source layout, the rest is still a copy or blit destination
+    uint32_t sourceLevelCount = pTexture->levelCount - pData->levelCount;
+    if (sourceLevelCount > 0)
+    {
+        recordLayoutTransition(commandBuffer, pTexture->image, 0, sourceLevelCount, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    recordLayoutTransition(commandBuffer, pTexture->image, sourceLevelCount, pTexture->levelCount - sourceLevelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void recordLayoutTransition(VkCommandBuffer commandBuffer, VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+    VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+{
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseLevel;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+uint32_t readUint32(const uint8_t* pBytes)
+{
+    // KTX2 is little-endian like every platform the viewer runs on
+    uint32_t value;
+    memcpy(&value, pBytes, sizeof(value));
+    return value;
+}
+
+uint64_t readUint64(const uint8_t* pBytes)
+{
+    uint64_t value;
+    memcpy(&value, pBytes, sizeof(value));
+    return value;
+}
@@ -0,0 +1,210 @@
+#include "threadPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpuTrace.h"
+
+#define INITIAL_JOB_CAPACITY    64
+
+static int workerThread(void* pData);
+
+uint32_t getDefaultThreadCount(void)
+{
+    int cpuCount = SDL_GetCPUCount();
+    return (cpuCount > 0) ? (uint32_t)cpuCount : 1;
+}
+
+Result createThreadPool(ThreadPool* pThreadPool, uint32_t threadCount)
+{
+    pThreadPool->threadCount = 0;
+    pThreadPool->ppThreads = NULL;
+    pThreadPool->pMutex = NULL;
+    pThreadPool->pJobAvailableCondition = NULL;
+    pThreadPool->pIdleCondition = NULL;
+    pThreadPool->pJobs = NULL;
+    pThreadPool->jobCapacity = INITIAL_JOB_CAPACITY;
+    pThreadPool->firstJob = 0;
+    pThreadPool->queuedJobCount = 0;
+    pThreadPool->runningJobCount = 0;
+    pThreadPool->quit = SDL_FALSE;
+
+    pThreadPool->pMutex = SDL_CreateMutex();
+    pThreadPool->pJobAvailableCondition = SDL_CreateCond();
+    pThreadPool->pIdleCondition = SDL_CreateCond();
+    if ((pThreadPool->pMutex == NULL) || (pThreadPool->pJobAvailableCondition == NULL) || (pThreadPool->pIdleCondition == NULL))
+    {
+        printError("Failed to create thread pool synchronization primitives!");
+        destroyThreadPool(pThreadPool);
+        return FAIL;
+    }
+
+    pThreadPool->pJobs = malloc(pThreadPool->jobCapacity * sizeof(Job));
+    if (pThreadPool->pJobs == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for thread pool jobs!", pThreadPool->jobCapacity * sizeof(Job));
+        destroyThreadPool(pThreadPool);
+        return FAIL;
+    }
+
+    pThreadPool->ppThreads = calloc(threadCount, sizeof(SDL_Thread*));
+    if (pThreadPool->ppThreads == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for thread pool threads!", threadCount * sizeof(SDL_Thread*));
+        destroyThreadPool(pThreadPool);
+        return FAIL;
+    }
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        pThreadPool->ppThreads[i] = SDL_CreateThread(workerThread, "worker", pThreadPool);
+        if (pThreadPool->ppThreads[i] == NULL)
+        {
+            printError("Failed to create worker thread %u!", i);
+            destroyThreadPool(pThreadPool);
+            return FAIL;
+        }
+
+        ++pThreadPool->threadCount;
+    }
+
+    return SUCCESS;
+}
+
+void destroyThreadPool(ThreadPool* pThreadPool)
+{
+    if (pThreadPool->pMutex != NULL)
+    {
+        SDL_LockMutex(pThreadPool->pMutex);
+        pThreadPool->quit = SDL_TRUE;
+        SDL_CondBroadcast(pThreadPool->pJobAvailableCondition);
+        SDL_UnlockMutex(pThreadPool->pMutex);
+    }
+
+    for (uint32_t i = 0; i < pThreadPool->threadCount; ++i)
+    {
+        SDL_WaitThread(pThreadPool->ppThreads[i], NULL);
+    }
+
+    free(pThreadPool->ppThreads);
+    pThreadPool->ppThreads = NULL;
+    pThreadPool->threadCount = 0;
+
+    free(pThreadPool->pJobs);
+    pThreadPool->pJobs = NULL;
+
+    if (pThreadPool->pIdleCondition != NULL)
+    {
+        SDL_DestroyCond(pThreadPool->pIdleCondition);
+        pThreadPool->pIdleCondition = NULL;
+    }
+
+    if (pThreadPool->pJobAvailableCondition != NULL)
+    {
+        SDL_DestroyCond(pThreadPool->pJobAvailableCondition);
+        pThreadPool->pJobAvailableCondition = NULL;
+    }
+
+    if (pThreadPool->pMutex != NULL)
+    {
+        SDL_DestroyMutex(pThreadPool->pMutex);
+        pThreadPool->pMutex = NULL;
+    }
+}
+
+Result submitJob(ThreadPool* pThreadPool, JobFunction function, void* pUserData)
+{
+    SDL_LockMutex(pThreadPool->pMutex);
+
+    if (pThreadPool->queuedJobCount == pThreadPool->jobCapacity)
+    {
+        uint32_t newCapacity = pThreadPool->jobCapacity * 2;
+
+        Job* pJobs = malloc(newCapacity * sizeof(Job));
+        if (pJobs == NULL)
+        {
+            printError("Failed to allocate %lu bytes of memory for thread pool jobs!", newCapacity * sizeof(Job));
+            SDL_UnlockMutex(pThreadPool->pMutex);
+            return FAIL;
+        }
+
+        // Unwrap the ring so the queued jobs start at index 0 again
+        for (uint32_t i = 0; i < pThreadPool->queuedJobCount; ++i)
+        {
+            pJobs[i] = pThreadPool->pJobs[(pThreadPool->firstJob + i) % pThreadPool->jobCapacity];
+        }
+
+        free(pThreadPool->pJobs);
+        pThreadPool->pJobs = pJobs;
+        pThreadPool->jobCapacity = newCapacity;
+        pThreadPool->firstJob = 0;
+    }
+
+    Job* pJob = &pThreadPool->pJobs[(pThreadPool->firstJob + pThreadPool->queuedJobCount) % pThreadPool->jobCapacity];
+    pJob->function = function;
+    pJob->pUserData = pUserData;
+    ++pThreadPool->queuedJobCount;
+
+    SDL_CondSignal(pThreadPool->pJobAvailableCondition);
+    SDL_UnlockMutex(pThreadPool->pMutex);
+
+    return SUCCESS;
+}
+
+void waitForJobs(ThreadPool* pThreadPool)
+{
+    SDL_LockMutex(pThreadPool->pMutex);
+
+    while ((pThreadPool->queuedJobCount > 0) || (pThreadPool->runningJobCount > 0))
+    {
+        SDL_CondWait(pThreadPool->pIdleCondition, pThreadPool->pMutex);
+    }
+
+    SDL_UnlockMutex(pThreadPool->pMutex);
+}
+
+int workerThread(void* pData)
+{
+    ThreadPool* pThreadPool = pData;
+
+    nameCpuTraceThread("worker");
+
+    SDL_LockMutex(pThreadPool->pMutex);
+
+    for (;;)
+    {
+        while ((pThreadPool->queuedJobCount == 0) && (pThreadPool->quit != SDL_TRUE))
+        {
+            SDL_CondWait(pThreadPool->pJobAvailableCondition, pThreadPool->pMutex);
+        }
+
+        // Queued jobs are drained before quitting so that nobody waits on a job that never runs
+        if (pThreadPool->queuedJobCount == 0)
+        {
+            break;
+        }
+
+        Job job = pThreadPool->pJobs[pThreadPool->firstJob];
+        pThreadPool->firstJob = (pThreadPool->firstJob + 1) % pThreadPool->jobCapacity;
+        --pThreadPool->queuedJobCount;
+        ++pThreadPool->runningJobCount;
+
+        SDL_UnlockMutex(pThreadPool->pMutex);
+
+        uint64_t traceStart = beginCpuTrace();
+        job.function(job.pUserData);
+        endCpuTrace("job", traceStart);
+
+        SDL_LockMutex(pThreadPool->pMutex);
+
+        --pThreadPool->runningJobCount;
+        if ((pThreadPool->queuedJobCount == 0) && (pThreadPool->runningJobCount == 0))
+        {
+            SDL_CondBroadcast(pThreadPool->pIdleCondition);
+        }
+    }
+
+    SDL_UnlockMutex(pThreadPool->pMutex);
+
+    return 0;
+}
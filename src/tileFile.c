@@ -0,0 +1,317 @@
+#include "tileFile.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_image.h>
+
+static uint32_t getTileLevels(uint32_t width, uint32_t height, uint32_t levelCount, TileLevel* pLevels);
+
+static SDL_bool writeLevelTiles(FILE* pFile, const uint8_t* pPixels, const TileLevel* pLevel, uint8_t* pSlot);
+
+static void downsampleLevel(const uint8_t* pSource, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* pDestination, uint32_t width, uint32_t height);
+
+char* getTileFilePath(const char* pSourcePath)
+{
+    size_t pathSize = strlen(pSourcePath) + strlen(TILE_FILE_EXTENSION) + 1;
+
+    char* pPath = malloc(pathSize);
+    if (pPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for tile file path!", pathSize);
+        return NULL;
+    }
+
+    snprintf(pPath, pathSize, "%s%s", pSourcePath, TILE_FILE_EXTENSION);
+    return pPath;
+}
+
+Result openTileFile(const char* pPath, const char* pSourcePath, TileFile* pFile)
+{
+    memset(pFile, 0, sizeof(TileFile));
+
+    uint64_t sourceSize = 0;
+    int64_t sourceModifiedTime = 0;
+    if ((pSourcePath != NULL) && (getFileStamp(pSourcePath, &sourceSize, &sourceModifiedTime) != SUCCESS))
+    {
+        printError("Failed to get size and modification time of \"%s\"!", pSourcePath);
+        return FAIL;
+    }
+
+    // A missing tile file is the normal first run, it is not worth an error message
+    uint64_t fileSize = 0;
+    int64_t fileModifiedTime = 0;
+    if (getFileStamp(pPath, &fileSize, &fileModifiedTime) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    if (mapFile(pPath, &pFile->file) != SUCCESS)
+    {
+        return FAIL;
+    }
+
+    TileFileHeader* pHeader = &pFile->header;
+    const char* pReason = NULL;
+
+    if (pFile->file.size < sizeof(TileFileHeader))
+    {
+        pReason = "it is truncated";
+    }
+    else
+    {
+        memcpy(pHeader, pFile->file.pData, sizeof(TileFileHeader));
+
+        if ((pHeader->magic != TILE_FILE_MAGIC) || (pHeader->headerHash != hashBytes(pHeader, offsetof(TileFileHeader, headerHash), HASH_SEED)))
+        {
+            pReason = "it is not a tile file or it is corrupt";
+        }
+        else if ((pHeader->version != TILE_FILE_VERSION) || (pHeader->tileSize != TILE_SIZE) || (pHeader->border != TILE_BORDER))
+        {
+            pReason = "it was written by another version of the viewer";
+        }
+        else if ((pSourcePath != NULL) && ((pHeader->sourceSize != sourceSize) || (pHeader->sourceModifiedTime != sourceModifiedTime)))
+        {
+            pReason = "the source image changed";
+        }
+        else if ((pHeader->levelCount == 0) || (pHeader->levelCount > MAX_TILE_LEVELS)
+            || (getTileLevels(pHeader->width, pHeader->height, pHeader->levelCount, pFile->pLevels) != pHeader->pageCount)
+            || (TILE_FILE_ALIGNMENT + (uint64_t)pHeader->pageCount * TILE_SLOT_BYTES > pFile->file.size))
+        {
+            pReason = "its layout is invalid";
+        }
+    }
+
+    if (pReason != NULL)
+    {
+        printf("Ignoring tile file \"%s\" because %s\n", pPath, pReason);
+        closeTileFile(pFile);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void closeTileFile(TileFile* pFile)
+{
+    unmapFile(&pFile->file);
+}
+
+Result writeTileFile(const char* pPath, const char* pSourcePath)
+{
+    SDL_Surface* pSurface = IMG_Load(pSourcePath);
+    if (pSurface == NULL)
+    {
+        printError("Failed to load image \"%s\"!", pSourcePath);
+        return FAIL;
+    }
+
+    SDL_Surface* pConverted = SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(pSurface);
+    if (pConverted == NULL)
+    {
+        printError("Failed to convert image \"%s\" to RGBA!", pSourcePath);
+        return FAIL;
+    }
+
+    uint32_t width = (uint32_t)pConverted->w;
+    uint32_t height = (uint32_t)pConverted->h;
+
+    uint32_t levelCount = 1;
+    while ((SDL_max(width, height) >> (levelCount - 1)) > 1)
+    {
+        ++levelCount;
+    }
+
+    if (levelCount > MAX_TILE_LEVELS)
+    {
+        printError("Image \"%s\" is %ux%u, tile files hold at most %u texels per side!", pSourcePath, width, height, 1u << (MAX_TILE_LEVELS - 1));
+        SDL_FreeSurface(pConverted);
+        return FAIL;
+    }
+
+    TileFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TILE_FILE_MAGIC;
+    header.version = TILE_FILE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.levelCount = levelCount;
+    header.tileSize = TILE_SIZE;
+    header.border = TILE_BORDER;
+
+    TileLevel pLevels[MAX_TILE_LEVELS];
+    header.pageCount = getTileLevels(width, height, levelCount, pLevels);
+
+    if (getFileStamp(pSourcePath, &header.sourceSize, &header.sourceModifiedTime) != SUCCESS)
+    {
+        printError("Failed to get size and modification time of \"%s\"!", pSourcePath);
+        SDL_FreeSurface(pConverted);
+        return FAIL;
+    }
+
+    header.headerHash = hashBytes(&header, offsetof(TileFileHeader, headerHash), HASH_SEED);
+
+    // Only two levels are in memory at a time, the source and the one downsampled from it, which is at most half
+    // as large for images one texel wide
+    size_t levelSize = (size_t)width * height * 4;
+    uint8_t* pPixels = malloc(levelSize);
+    uint8_t* pNextPixels = malloc(levelSize / 2 + 4);
+    uint8_t* pSlot = malloc(TILE_SLOT_BYTES);
+    if ((pPixels == NULL) || (pNextPixels == NULL) || (pSlot == NULL))
+    {
+        printError("Failed to allocate %lu bytes of memory for tile file levels!", levelSize + levelSize / 2 + 4 + TILE_SLOT_BYTES);
+        free(pSlot);
+        free(pNextPixels);
+        free(pPixels);
+        SDL_FreeSurface(pConverted);
+        return FAIL;
+    }
+
+    // Surface rows may be padded
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        memcpy(pPixels + (size_t)y * width * 4, (const uint8_t*)pConverted->pixels + (size_t)y * pConverted->pitch, (size_t)width * 4);
+    }
+
+    SDL_FreeSurface(pConverted);
+
+    // Same as the mesh cache, written next to the target and renamed so readers never map a partial file
+    size_t temporaryPathSize = strlen(pPath) + 5;
+    char* pTemporaryPath = malloc(temporaryPathSize);
+    if (pTemporaryPath == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for temporary tile file path!", temporaryPathSize);
+        free(pSlot);
+        free(pNextPixels);
+        free(pPixels);
+        return FAIL;
+    }
+
+    snprintf(pTemporaryPath, temporaryPathSize, "%s.tmp", pPath);
+
+    FILE* pFile = fopen(pTemporaryPath, "wb");
+    if (pFile == NULL)
+    {
+        printError("Failed to open file \"%s\" for writing!", pTemporaryPath);
+        free(pTemporaryPath);
+        free(pSlot);
+        free(pNextPixels);
+        free(pPixels);
+        return FAIL;
+    }
+
+    static const char pZeros[TILE_FILE_ALIGNMENT - sizeof(TileFileHeader)] = { 0 };
+    SDL_bool written = ((fwrite(&header, sizeof(header), 1, pFile) == 1) && (fwrite(pZeros, sizeof(pZeros), 1, pFile) == 1)) ? SDL_TRUE : SDL_FALSE;
+
+    for (uint32_t i = 0; (written == SDL_TRUE) && (i < levelCount); ++i)
+    {
+        written = writeLevelTiles(pFile, pPixels, &pLevels[i], pSlot);
+
+        if (i + 1 < levelCount)
+        {
+            downsampleLevel(pPixels, pLevels[i].width, pLevels[i].height, pNextPixels, pLevels[i + 1].width, pLevels[i + 1].height);
+
+            uint8_t* pSwap = pPixels;
+            pPixels = pNextPixels;
+            pNextPixels = pSwap;
+        }
+    }
+
+    written = (fclose(pFile) == 0) && written;
+
+    free(pSlot);
+    free(pNextPixels);
+    free(pPixels);
+
+    if ((written != SDL_TRUE) || (replaceFile(pTemporaryPath, pPath) != SUCCESS))
+    {
+        printError("Failed to write tile file to \"%s\"!", pPath);
+        remove(pTemporaryPath);
+        free(pTemporaryPath);
+        return FAIL;
+    }
+
+    free(pTemporaryPath);
+
+    return SUCCESS;
+}
+
+const void* getTile(const TileFile* pFile, uint32_t page)
+{
+    return (const char*)pFile->file.pData + TILE_FILE_ALIGNMENT + (uint64_t)page * TILE_SLOT_BYTES;
+}
+
+uint32_t getTileLevels(uint32_t width, uint32_t height, uint32_t levelCount, TileLevel* pLevels)
+{
+    uint32_t pageCount = 0;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        TileLevel* pLevel = &pLevels[i];
+        pLevel->width = SDL_max(width >> i, 1);
+        pLevel->height = SDL_max(height >> i, 1);
+        pLevel->pagesX = (pLevel->width + TILE_SIZE - 1) / TILE_SIZE;
+        pLevel->pagesY = (pLevel->height + TILE_SIZE - 1) / TILE_SIZE;
+        pLevel->firstPage = pageCount;
+
+        pageCount += pLevel->pagesX * pLevel->pagesY;
+    }
+
+    return pageCount;
+}
+
+SDL_bool writeLevelTiles(FILE* pFile, const uint8_t* pPixels, const TileLevel* pLevel, uint8_t* pSlot)
+{
+    for (uint32_t pageY = 0; pageY < pLevel->pagesY; ++pageY)
+    {
+        for (uint32_t pageX = 0; pageX < pLevel->pagesX; ++pageX)
+        {
+            // Wrapping matches the repeat addressing of the virtual texture sampler
+            for (uint32_t y = 0; y < TILE_SLOT_SIZE; ++y)
+            {
+                int64_t sourceY = (int64_t)pageY * TILE_SIZE + y - TILE_BORDER;
+                sourceY = ((sourceY % pLevel->height) + pLevel->height) % pLevel->height;
+
+                for (uint32_t x = 0; x < TILE_SLOT_SIZE; ++x)
+                {
+                    int64_t sourceX = (int64_t)pageX * TILE_SIZE + x - TILE_BORDER;
+                    sourceX = ((sourceX % pLevel->width) + pLevel->width) % pLevel->width;
+
+                    memcpy(pSlot + ((size_t)y * TILE_SLOT_SIZE + x) * 4, pPixels + ((size_t)sourceY * pLevel->width + sourceX) * 4, 4);
+                }
+            }
+
+            if (fwrite(pSlot, TILE_SLOT_BYTES, 1, pFile) != 1)
+            {
+                return SDL_FALSE;
+            }
+        }
+    }
+
+    return SDL_TRUE;
+}
+
+void downsampleLevel(const uint8_t* pSource, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* pDestination, uint32_t width, uint32_t height)
+{
+    // A 2x2 box filter, odd sizes repeat the last row or column
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        uint32_t y0 = SDL_min(y * 2, sourceHeight - 1);
+        uint32_t y1 = SDL_min(y * 2 + 1, sourceHeight - 1);
+
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint32_t x0 = SDL_min(x * 2, sourceWidth - 1);
+            uint32_t x1 = SDL_min(x * 2 + 1, sourceWidth - 1);
+
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                uint32_t sum = pSource[((size_t)y0 * sourceWidth + x0) * 4 + c] + pSource[((size_t)y0 * sourceWidth + x1) * 4 + c]
+                    + pSource[((size_t)y1 * sourceWidth + x0) * 4 + c] + pSource[((size_t)y1 * sourceWidth + x1) * 4 + c];
+                pDestination[((size_t)y * width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
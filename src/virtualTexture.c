@@ -0,0 +1,1406 @@
+#include "virtualTexture.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpuTrace.h"
+
+#define NO_SLOT         UINT32_MAX
+#define PINNED_SLOT     UINT64_MAX
+
+// Entry of pinned mip tail pages, which live in memory of their own instead of a cache slot
+#define MIP_TAIL_ENTRY  UINT32_MAX
+
+static Result openVirtualTextureFile(VirtualTexture* pTexture, const char* pPath);
+
+static Result createAtlasCache(VirtualTexture* pTexture, VkPhysicalDevice physicalDevice, SamplerCache* pSamplerCache, VkDeviceSize budget);
+
+static Result createSparseCache(VirtualTexture* pTexture, VkPhysicalDevice physicalDevice, SamplerCache* pSamplerCache, uint32_t queueFamilyIndex, VkDeviceSize budget);
+
+static void destroyCache(VirtualTexture* pTexture);
+
+static Result createSlots(VirtualTexture* pTexture);
+
+static Result createUploads(VirtualTexture* pTexture);
+
+static Result createVirtualTextureFrames(VirtualTexture* pTexture, VkDescriptorSetLayout setLayout);
+
+static int loadTilesThread(void* pData);
+
+static uint32_t getPageLevel(const VirtualTexture* pTexture, uint32_t page, uint32_t* pPageX, uint32_t* pPageY);
+
+static void readFeedback(VirtualTexture* pTexture, VirtualTextureFrame* pFrame, uint64_t frameNumber);
+
+static void touchSlot(VirtualTexture* pTexture, uint32_t slot, uint64_t frameNumber);
+
+static void unlinkSlot(VirtualTexture* pTexture, uint32_t slot);
+
+static SDL_bool evictSlot(VirtualTexture* pTexture, uint64_t frameNumber);
+
+static void makePageResident(VirtualTexture* pTexture, uint32_t page, uint32_t slot, uint64_t frameNumber);
+
+static void getTileCopy(const VirtualTexture* pTexture, uint32_t upload, uint32_t page, uint32_t slot, VkBufferImageCopy* pCopy);
+
+static void addSparseBind(VirtualTexture* pTexture, uint32_t* pBindCount, uint32_t page, uint32_t slot);
+
+static Result bindSparsePages(VirtualTexture* pTexture, VirtualTextureFrame* pFrame, uint32_t bindCount);
+
+static void recordCacheCopies(VirtualTexture* pTexture, VkCommandBuffer commandBuffer, uint32_t copyCount);
+
+Result createVirtualTextureSetLayout(VkDevice device, VkDescriptorSetLayout* pSetLayout)
+{
+    VkDescriptorSetLayoutBinding pBindings[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        pBindings[i].binding = i;
+        pBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pBindings[i].descriptorCount = 1;
+        pBindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        pBindings[i].pImmutableSamplers = NULL;
+    }
+
+    pBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    VkDescriptorSetLayoutCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.bindingCount = 3;
+    createInfo.pBindings = pBindings;
+
+    int result = vkCreateDescriptorSetLayout(device, &createInfo, NULL, pSetLayout);
+    return (result == VK_SUCCESS) ? SUCCESS : FAIL;
+}
+
+Result createVirtualTexture(VirtualTexture* pTexture, VkPhysicalDevice physicalDevice, VkDevice device, Allocator* pAllocator, SamplerCache* pSamplerCache,
+    VkQueue queue, uint32_t queueFamilyIndex, VkDescriptorSetLayout setLayout, uint32_t frameCount, const char* pPath, VkDeviceSize budget, SDL_bool sparseSupported)
+{
+    memset(pTexture, 0, sizeof(VirtualTexture));
+    pTexture->device = device;
+    pTexture->pAllocator = pAllocator;
+    pTexture->queue = queue;
+    pTexture->frameCount = frameCount;
+    pTexture->lruHead = NO_SLOT;
+    pTexture->lruTail = NO_SLOT;
+    pTexture->pageTableVersion = 1;
+
+    // The feedback is written by the fragment shader
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+
+    if (features.fragmentStoresAndAtomics != VK_TRUE)
+    {
+        printError("Device does not support stores and atomics in fragment shaders, which virtual textures need!");
+        return FAIL;
+    }
+
+    if (openVirtualTextureFile(pTexture, pPath) != SUCCESS)
+    {
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    pTexture->pageCount = pTexture->tileFile.header.pageCount;
+    pTexture->pPageTable = calloc(pTexture->pageCount, sizeof(uint32_t));
+    pTexture->pPageStates = calloc(pTexture->pageCount, sizeof(uint8_t));
+    if ((pTexture->pPageTable == NULL) || (pTexture->pPageStates == NULL))
+    {
+        printError("Failed to allocate %lu bytes of memory for the page table!", pTexture->pageCount * (sizeof(uint32_t) + sizeof(uint8_t)));
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    pTexture->pMutex = SDL_CreateMutex();
+    pTexture->pCondition = SDL_CreateCond();
+    if ((pTexture->pMutex == NULL) || (pTexture->pCondition == NULL))
+    {
+        printError("Failed to create virtual texture mutex and condition!");
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    VkFenceCreateInfo fenceCreateInfo;
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = NULL;
+    fenceCreateInfo.flags = 0;
+
+    if (vkCreateFence(device, &fenceCreateInfo, NULL, &pTexture->bindFence) != VK_SUCCESS)
+    {
+        printError("Failed to create sparse binding fence!");
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    // Staging tiles count against the budget as well
+    VkDeviceSize stagingSize = (VkDeviceSize)frameCount * VIRTUAL_TEXTURE_UPLOADS_PER_FRAME * TILE_SLOT_BYTES;
+    VkDeviceSize cacheBudget = (budget > stagingSize) ? budget - stagingSize : 0;
+
+    if ((sparseSupported == SDL_TRUE) && (createSparseCache(pTexture, physicalDevice, pSamplerCache, queueFamilyIndex, cacheBudget) == SUCCESS))
+    {
+        pTexture->sparse = SDL_TRUE;
+    }
+    else if (createAtlasCache(pTexture, physicalDevice, pSamplerCache, cacheBudget) != SUCCESS)
+    {
+        printError("Failed to create virtual texture cache!");
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    if ((createSlots(pTexture) != SUCCESS) || (createUploads(pTexture) != SUCCESS) || (createVirtualTextureFrames(pTexture, setLayout) != SUCCESS))
+    {
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    pTexture->pLoaderThread = SDL_CreateThread(loadTilesThread, "tile loader", pTexture);
+    if (pTexture->pLoaderThread == NULL)
+    {
+        printError("Failed to create tile loader thread!");
+        destroyVirtualTexture(pTexture);
+        return FAIL;
+    }
+
+    const TileFileHeader* pHeader = &pTexture->tileFile.header;
+    printf("Virtual texture: %ux%u, %u levels, %u pages of %ux%u\n", pHeader->width, pHeader->height, pHeader->levelCount, pTexture->pageCount, TILE_SIZE, TILE_SIZE);
+    printf("%s cache of %u pages, %.3f MiB resident with staging\n\n", (pTexture->sparse == SDL_TRUE) ? "Sparse" : "Atlas", pTexture->slotCount,
+        getVirtualTextureMemory(pTexture) / 1048576.0);
+
+    return SUCCESS;
+}
+
+void destroyVirtualTexture(VirtualTexture* pTexture)
+{
+    if (pTexture->pLoaderThread != NULL)
+    {
+        SDL_LockMutex(pTexture->pMutex);
+        pTexture->quit = SDL_TRUE;
+        SDL_CondSignal(pTexture->pCondition);
+        SDL_UnlockMutex(pTexture->pMutex);
+
+        SDL_WaitThread(pTexture->pLoaderThread, NULL);
+        pTexture->pLoaderThread = NULL;
+    }
+
+    if (pTexture->pFrames != NULL)
+    {
+        for (uint32_t i = 0; i < pTexture->frameCount; ++i)
+        {
+            VirtualTextureFrame* pFrame = &pTexture->pFrames[i];
+            if (pFrame->pageTableBuffer != VK_NULL_HANDLE)
+            {
+                destroyBuffer(pTexture->pAllocator, pFrame->pageTableBuffer, &pFrame->pageTableAllocation);
+            }
+
+            if (pFrame->feedbackBuffer != VK_NULL_HANDLE)
+            {
+                destroyBuffer(pTexture->pAllocator, pFrame->feedbackBuffer, &pFrame->feedbackAllocation);
+            }
+
+            vkDestroySemaphore(pTexture->device, pFrame->bindSemaphore, NULL);
+        }
+    }
+
+    free(pTexture->pFrames);
+    pTexture->pFrames = NULL;
+
+    // Frees the descriptor sets with it
+    vkDestroyDescriptorPool(pTexture->device, pTexture->descriptorPool, NULL);
+    pTexture->descriptorPool = VK_NULL_HANDLE;
+
+    if (pTexture->stagingBuffer != VK_NULL_HANDLE)
+    {
+        destroyBuffer(pTexture->pAllocator, pTexture->stagingBuffer, &pTexture->stagingAllocation);
+        pTexture->stagingBuffer = VK_NULL_HANDLE;
+    }
+
+    destroyCache(pTexture);
+
+    vkDestroyFence(pTexture->device, pTexture->bindFence, NULL);
+    pTexture->bindFence = VK_NULL_HANDLE;
+
+    if (pTexture->pCondition != NULL)
+    {
+        SDL_DestroyCond(pTexture->pCondition);
+        pTexture->pCondition = NULL;
+    }
+
+    if (pTexture->pMutex != NULL)
+    {
+        SDL_DestroyMutex(pTexture->pMutex);
+        pTexture->pMutex = NULL;
+    }
+
+    free(pTexture->pSparseBinds);
+    free(pTexture->pCopies);
+    free(pTexture->pUploads);
+    free(pTexture->pReleaseFrames);
+    free(pTexture->pReleasedSlots);
+    free(pTexture->pFreeSlots);
+    free(pTexture->pSlotNext);
+    free(pTexture->pSlotPrevious);
+    free(pTexture->pSlotLastUsed);
+    free(pTexture->pSlotPages);
+    free(pTexture->pPageStates);
+    free(pTexture->pPageTable);
+
+    pTexture->pSparseBinds = NULL;
+    pTexture->pCopies = NULL;
+    pTexture->pUploads = NULL;
+    pTexture->pReleaseFrames = NULL;
+    pTexture->pReleasedSlots = NULL;
+    pTexture->pFreeSlots = NULL;
+    pTexture->pSlotNext = NULL;
+    pTexture->pSlotPrevious = NULL;
+    pTexture->pSlotLastUsed = NULL;
+    pTexture->pSlotPages = NULL;
+    pTexture->pPageStates = NULL;
+    pTexture->pPageTable = NULL;
+
+    closeTileFile(&pTexture->tileFile);
+}
+
+Result updateVirtualTexture(VirtualTexture* pTexture, VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber)
+{
+    VirtualTextureFrame* pFrame = &pTexture->pFrames[frameIndex];
+
+    // The last submission of the frame has waited on the bind semaphore, and the frame's fence on that submission
+    pFrame->bindPending = SDL_FALSE;
+
+    readFeedback(pTexture, pFrame, frameNumber);
+
+    // A slot is evicted from the page table of one frame, but older frames in flight may still sample it. Once those
+    // have finished it is reused, a sparse page that did not become resident again meanwhile is unbound then.
+    uint32_t bindCount = 0;
+    while ((pTexture->releasedCount > 0) && (pTexture->pReleaseFrames[pTexture->releasedFirst] + pTexture->frameCount <= frameNumber))
+    {
+        uint32_t slot = pTexture->pReleasedSlots[pTexture->releasedFirst];
+        uint32_t page = pTexture->pSlotPages[slot];
+
+        if ((pTexture->sparse == SDL_TRUE) && (pTexture->pPageStates[page] != PAGE_STATE_RESIDENT))
+        {
+            addSparseBind(pTexture, &bindCount, page, NO_SLOT);
+        }
+
+        pTexture->pSlotPages[slot] = NO_SLOT;
+        pTexture->pFreeSlots[pTexture->freeSlotCount++] = slot;
+
+        pTexture->releasedFirst = (pTexture->releasedFirst + 1) % pTexture->slotCount;
+        --pTexture->releasedCount;
+    }
+
+    uint32_t copyCount = 0;
+    SDL_bool uploadsFreed = SDL_FALSE;
+
+    SDL_LockMutex(pTexture->pMutex);
+
+    for (uint32_t i = 0; i < pTexture->uploadCount; ++i)
+    {
+        TileUpload* pUpload = &pTexture->pUploads[i];
+
+        if ((pUpload->state == TILE_UPLOAD_STATE_IN_FLIGHT) && (pUpload->frameNumber + pTexture->frameCount <= frameNumber))
+        {
+            pUpload->state = TILE_UPLOAD_STATE_FREE;
+            uploadsFreed = SDL_TRUE;
+            continue;
+        }
+
+        if (pUpload->state != TILE_UPLOAD_STATE_READY)
+        {
+            continue;
+        }
+
+        // Pinned pages are uploaded by the first frame all at once, however many there are
+        uint32_t level = getPageLevel(pTexture, pUpload->page, NULL, NULL);
+        if ((level < pTexture->pinnedFirstLevel) && (copyCount >= VIRTUAL_TEXTURE_UPLOADS_PER_FRAME))
+        {
+            continue;
+        }
+
+        // The tile waits in staging until an evicted slot has been released
+        uint32_t slot = NO_SLOT;
+        if (level < pTexture->mipTailFirstLevel)
+        {
+            if (pTexture->freeSlotCount == 0)
+            {
+                evictSlot(pTexture, frameNumber);
+                continue;
+            }
+
+            slot = pTexture->pFreeSlots[--pTexture->freeSlotCount];
+        }
+
+        makePageResident(pTexture, pUpload->page, slot, frameNumber);
+        getTileCopy(pTexture, i, pUpload->page, slot, &pTexture->pCopies[copyCount++]);
+
+        if ((pTexture->sparse == SDL_TRUE) && (slot != NO_SLOT))
+        {
+            addSparseBind(pTexture, &bindCount, pUpload->page, slot);
+        }
+
+        pUpload->state = TILE_UPLOAD_STATE_IN_FLIGHT;
+        pUpload->frameNumber = frameNumber;
+        ++pTexture->uploadedTileCount;
+    }
+
+    if (uploadsFreed == SDL_TRUE)
+    {
+        SDL_CondSignal(pTexture->pCondition);
+    }
+
+    SDL_UnlockMutex(pTexture->pMutex);
+
+    if ((bindCount > 0) && (bindSparsePages(pTexture, pFrame, bindCount) != SUCCESS))
+    {
+        printError("Failed to bind sparse pages!");
+        return FAIL;
+    }
+
+    recordCacheCopies(pTexture, commandBuffer, copyCount);
+
+    PageTableHeader* pHeader = pFrame->pageTableAllocation.pMapped;
+    pHeader->frameStamp = (uint32_t)(frameNumber + 1);
+
+    if (pFrame->pageTableVersion != pTexture->pageTableVersion)
+    {
+        memcpy(pHeader + 1, pTexture->pPageTable, pTexture->pageCount * sizeof(uint32_t));
+        pFrame->pageTableVersion = pTexture->pageTableVersion;
+    }
+
+    return SUCCESS;
+}
+
+VkSemaphore getVirtualTextureBindSemaphore(const VirtualTexture* pTexture, uint32_t frameIndex)
+{
+    const VirtualTextureFrame* pFrame = &pTexture->pFrames[frameIndex];
+    return (pFrame->bindPending == SDL_TRUE) ? pFrame->bindSemaphore : VK_NULL_HANDLE;
+}
+
+void finishVirtualTextureFrame(VkCommandBuffer commandBuffer)
+{
+    VkMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+VkDeviceSize getVirtualTextureMemory(const VirtualTexture* pTexture)
+{
+    return pTexture->cacheAllocation.size + pTexture->mipTailAllocation.size + pTexture->stagingAllocation.size;
+}
+
+Result openVirtualTextureFile(VirtualTexture* pTexture, const char* pPath)
+{
+    size_t length = strlen(pPath);
+    size_t extensionLength = strlen(TILE_FILE_EXTENSION);
+
+    if ((length > extensionLength) && (SDL_strcasecmp(pPath + length - extensionLength, TILE_FILE_EXTENSION) == 0))
+    {
+        if (openTileFile(pPath, NULL, &pTexture->tileFile) != SUCCESS)
+        {
+            printError("Failed to open tile file \"%s\"!", pPath);
+            return FAIL;
+        }
+
+        return SUCCESS;
+    }
+
+    char* pTilePath = getTileFilePath(pPath);
+    if (pTilePath == NULL)
+    {
+        return FAIL;
+    }
+
+    Result result = openTileFile(pTilePath, pPath, &pTexture->tileFile);
+    if (result != SUCCESS)
+    {
+        uint64_t startTicks = SDL_GetPerformanceCounter();
+
+        result = writeTileFile(pTilePath, pPath);
+        if (result == SUCCESS)
+        {
+            printf("Converted \"%s\" to \"%s\" in %.3f ms\n", pPath, pTilePath, (SDL_GetPerformanceCounter() - startTicks) * 1000.0 / SDL_GetPerformanceFrequency());
+            result = openTileFile(pTilePath, pPath, &pTexture->tileFile);
+        }
+    }
+
+    if (result != SUCCESS)
+    {
+        printError("Failed to open tiles of \"%s\"!", pPath);
+    }
+
+    free(pTilePath);
+
+    return result;
+}
+
+Result createAtlasCache(VirtualTexture* pTexture, VkPhysicalDevice physicalDevice, SamplerCache* pSamplerCache, VkDeviceSize budget)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // Square, no larger than the budget and the image size limit allow, and no larger than the texture
+    uint32_t slotsPerRow = (uint32_t)sqrt((double)(budget / TILE_SLOT_BYTES));
+    slotsPerRow = SDL_min(slotsPerRow, properties.limits.maxImageDimension2D / TILE_SLOT_SIZE);
+    while ((slotsPerRow > 2) && ((slotsPerRow - 1) * (slotsPerRow - 1) >= pTexture->pageCount))
+    {
+        --slotsPerRow;
+    }
+
+    if (slotsPerRow < 2)
+    {
+        printError("Virtual texture budget of %llu bytes does not even fit 4 tiles!", (unsigned long long)budget);
+        return FAIL;
+    }
+
+    pTexture->slotsPerRow = slotsPerRow;
+    pTexture->slotCount = SDL_min(slotsPerRow * slotsPerRow, pTexture->pageCount);
+    pTexture->pinnedFirstLevel = pTexture->tileFile.header.levelCount - 1;
+    pTexture->mipTailFirstLevel = pTexture->tileFile.header.levelCount;
+
+    VkImageCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+    createInfo.extent.width = slotsPerRow * TILE_SLOT_SIZE;
+    createInfo.extent.height = slotsPerRow * TILE_SLOT_SIZE;
+    createInfo.extent.depth = 1;
+    createInfo.mipLevels = 1;
+    createInfo.arrayLayers = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = NULL;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_TRUE;
+
+    if (createImage(pTexture->pAllocator, &createInfo, &allocationInfo, &pTexture->cacheImage, &pTexture->cacheAllocation) != SUCCESS)
+    {
+        pTexture->cacheImage = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    VkImageViewCreateInfo viewCreateInfo;
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = NULL;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = pTexture->cacheImage;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+    viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewCreateInfo.subresourceRange.baseMipLevel = 0;
+    viewCreateInfo.subresourceRange.levelCount = 1;
+    viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    viewCreateInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(pTexture->device, &viewCreateInfo, NULL, &pTexture->cacheImageView) != VK_SUCCESS)
+    {
+        printError("Failed to create atlas image view!");
+        destroyCache(pTexture);
+        return FAIL;
+    }
+
+    // Bilinear inside a tile reaches into its border at most, anisotropic filtering would reach past it
+    SamplerKey samplerKey;
+    samplerKey.filter = VK_FILTER_LINEAR;
+    samplerKey.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerKey.addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerKey.maxAnisotropy = 1.0f;
+
+    if (getSampler(pSamplerCache, &samplerKey, &pTexture->sampler) != SUCCESS)
+    {
+        printError("Failed to get atlas sampler!");
+        destroyCache(pTexture);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+Result createSparseCache(VirtualTexture* pTexture, VkPhysicalDevice physicalDevice, SamplerCache* pSamplerCache, uint32_t queueFamilyIndex, VkDeviceSize budget)
+{
+    const TileFileHeader* pHeader = &pTexture->tileFile.header;
+
+    // Every reason not to use the sparse image falls back to the atlas, so they are not errors
+    uint32_t queueFamilyCount;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, NULL);
+
+    VkQueueFamilyProperties* pQueueFamilies = malloc(queueFamilyCount * sizeof(VkQueueFamilyProperties));
+    if (pQueueFamilies == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for queue families!", queueFamilyCount * sizeof(VkQueueFamilyProperties));
+        return FAIL;
+    }
+
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, pQueueFamilies);
+    VkQueueFlags queueFlags = pQueueFamilies[queueFamilyIndex].queueFlags;
+    free(pQueueFamilies);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    if (((queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) == 0) || (SDL_max(pHeader->width, pHeader->height) > properties.limits.maxImageDimension2D))
+    {
+        printf("Virtual texture falls back to an atlas, the queue cannot bind sparse memory or the texture exceeds the image size limit\n");
+        return FAIL;
+    }
+
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    uint32_t formatPropertyCount = 0;
+    VkSparseImageFormatProperties pFormatProperties[4];
+    vkGetPhysicalDeviceSparseImageFormatProperties(physicalDevice, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, usage, VK_IMAGE_TILING_OPTIMAL,
+        &formatPropertyCount, NULL);
+    formatPropertyCount = SDL_min(formatPropertyCount, 4);
+    vkGetPhysicalDeviceSparseImageFormatProperties(physicalDevice, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, usage, VK_IMAGE_TILING_OPTIMAL,
+        &formatPropertyCount, pFormatProperties);
+
+    // Pages must be exactly the tiles of the tile file
+    SDL_bool granularityMatches = SDL_FALSE;
+    for (uint32_t i = 0; i < formatPropertyCount; ++i)
+    {
+        VkExtent3D granularity = pFormatProperties[i].imageGranularity;
+        if (((pFormatProperties[i].aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0) && (granularity.width == TILE_SIZE) && (granularity.height == TILE_SIZE))
+        {
+            granularityMatches = SDL_TRUE;
+        }
+    }
+
+    if (granularityMatches != SDL_TRUE)
+    {
+        printf("Virtual texture falls back to an atlas, sparse pages are not %ux%u texels\n", TILE_SIZE, TILE_SIZE);
+        return FAIL;
+    }
+
+    VkImageCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+    createInfo.extent.width = pHeader->width;
+    createInfo.extent.height = pHeader->height;
+    createInfo.extent.depth = 1;
+    createInfo.mipLevels = pHeader->levelCount;
+    createInfo.arrayLayers = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.usage = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = NULL;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(pTexture->device, &createInfo, NULL, &pTexture->cacheImage) != VK_SUCCESS)
+    {
+        printf("Virtual texture falls back to an atlas, the sparse image cannot be created\n");
+        return FAIL;
+    }
+
+    // Sparse images are never bound as a whole, so they do not go through createImage
+    pTexture->sparse = SDL_TRUE;
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(pTexture->device, pTexture->cacheImage, &requirements);
+
+    uint32_t sparseRequirementCount = 0;
+    VkSparseImageMemoryRequirements pSparseRequirements[4];
+    vkGetImageSparseMemoryRequirements(pTexture->device, pTexture->cacheImage, &sparseRequirementCount, NULL);
+    sparseRequirementCount = SDL_min(sparseRequirementCount, 4);
+    vkGetImageSparseMemoryRequirements(pTexture->device, pTexture->cacheImage, &sparseRequirementCount, pSparseRequirements);
+
+    const VkSparseImageMemoryRequirements* pColorRequirements = NULL;
+    for (uint32_t i = 0; i < sparseRequirementCount; ++i)
+    {
+        if ((pSparseRequirements[i].formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0)
+        {
+            pColorRequirements = &pSparseRequirements[i];
+        }
+    }
+
+    // The sparse block size in bytes is the alignment of the image memory
+    pTexture->sparsePageSize = requirements.alignment;
+    pTexture->slotCount = (uint32_t)SDL_min(budget / requirements.alignment, (VkDeviceSize)pTexture->pageCount);
+    pTexture->mipTailFirstLevel = (pColorRequirements != NULL) ? SDL_min(pColorRequirements->imageMipTailFirstLod, pHeader->levelCount) : pHeader->levelCount;
+    pTexture->pinnedFirstLevel = SDL_min(pTexture->mipTailFirstLevel, pHeader->levelCount - 1);
+
+    if ((pColorRequirements == NULL) || (pTexture->slotCount < 2))
+    {
+        printf("Virtual texture falls back to an atlas, the sparse image has no color aspect or the budget holds less than 2 pages\n");
+        destroyCache(pTexture);
+        return FAIL;
+    }
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_TRUE;
+
+    VkMemoryRequirements poolRequirements = requirements;
+    poolRequirements.size = (VkDeviceSize)pTexture->slotCount * requirements.alignment;
+
+    if (allocateMemory(pTexture->pAllocator, &poolRequirements, &allocationInfo, &pTexture->cacheAllocation) != SUCCESS)
+    {
+        printError("Failed to allocate sparse page pool!");
+        destroyCache(pTexture);
+        return FAIL;
+    }
+
+    VkSparseMemoryBind mipTailBind;
+    VkSparseImageOpaqueMemoryBindInfo mipTailBindInfo;
+
+    if (pColorRequirements->imageMipTailSize > 0)
+    {
+        VkMemoryRequirements mipTailRequirements = requirements;
+        mipTailRequirements.size = pColorRequirements->imageMipTailSize;
+
+        if (allocateMemory(pTexture->pAllocator, &mipTailRequirements, &allocationInfo, &pTexture->mipTailAllocation) != SUCCESS)
+        {
+            printError("Failed to allocate sparse mip tail!");
+            destroyCache(pTexture);
+            return FAIL;
+        }
+
+        mipTailBind.resourceOffset = pColorRequirements->imageMipTailOffset;
+        mipTailBind.size = pColorRequirements->imageMipTailSize;
+        mipTailBind.memory = pTexture->mipTailAllocation.memory;
+        mipTailBind.memoryOffset = pTexture->mipTailAllocation.offset;
+        mipTailBind.flags = 0;
+
+        mipTailBindInfo.image = pTexture->cacheImage;
+        mipTailBindInfo.bindCount = 1;
+        mipTailBindInfo.pBinds = &mipTailBind;
+
+        VkBindSparseInfo bindInfo;
+        bindInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+        bindInfo.pNext = NULL;
+        bindInfo.waitSemaphoreCount = 0;
+        bindInfo.pWaitSemaphores = NULL;
+        bindInfo.bufferBindCount = 0;
+        bindInfo.pBufferBinds = NULL;
+        bindInfo.imageOpaqueBindCount = 1;
+        bindInfo.pImageOpaqueBinds = &mipTailBindInfo;
+        bindInfo.imageBindCount = 0;
+        bindInfo.pImageBinds = NULL;
+        bindInfo.signalSemaphoreCount = 0;
+        bindInfo.pSignalSemaphores = NULL;
+
+        if (vkQueueBindSparse(pTexture->queue, 1, &bindInfo, pTexture->bindFence) != VK_SUCCESS)
+        {
+            printError("Failed to bind sparse mip tail!");
+            destroyCache(pTexture);
+            return FAIL;
+        }
+
+        vkWaitForFences(pTexture->device, 1, &pTexture->bindFence, VK_TRUE, UINT64_MAX);
+        vkResetFences(pTexture->device, 1, &pTexture->bindFence);
+    }
+
+    VkImageViewCreateInfo viewCreateInfo;
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = NULL;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = pTexture->cacheImage;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+    viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewCreateInfo.subresourceRange.baseMipLevel = 0;
+    viewCreateInfo.subresourceRange.levelCount = pHeader->levelCount;
+    viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    viewCreateInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(pTexture->device, &viewCreateInfo, NULL, &pTexture->cacheImageView) != VK_SUCCESS)
+    {
+        printError("Failed to create sparse image view!");
+        destroyCache(pTexture);
+        return FAIL;
+    }
+
+    // The shader picks the level, so there is nothing to blend between levels
+    SamplerKey samplerKey;
+    samplerKey.filter = VK_FILTER_LINEAR;
+    samplerKey.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerKey.addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerKey.maxAnisotropy = 1.0f;
+
+    if (getSampler(pSamplerCache, &samplerKey, &pTexture->sampler) != SUCCESS)
+    {
+        printError("Failed to get sparse image sampler!");
+        destroyCache(pTexture);
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void destroyCache(VirtualTexture* pTexture)
+{
+    // Samplers belong to the sampler cache
+    pTexture->sampler = VK_NULL_HANDLE;
+
+    vkDestroyImageView(pTexture->device, pTexture->cacheImageView, NULL);
+    pTexture->cacheImageView = VK_NULL_HANDLE;
+
+    if (pTexture->sparse == SDL_TRUE)
+    {
+        vkDestroyImage(pTexture->device, pTexture->cacheImage, NULL);
+
+        if (pTexture->mipTailAllocation.memory != VK_NULL_HANDLE)
+        {
+            freeMemory(pTexture->pAllocator, &pTexture->mipTailAllocation);
+        }
+
+        if (pTexture->cacheAllocation.memory != VK_NULL_HANDLE)
+        {
+            freeMemory(pTexture->pAllocator, &pTexture->cacheAllocation);
+        }
+    }
+    else if (pTexture->cacheImage != VK_NULL_HANDLE)
+    {
+        destroyImage(pTexture->pAllocator, pTexture->cacheImage, &pTexture->cacheAllocation);
+    }
+
+    memset(&pTexture->mipTailAllocation, 0, sizeof(pTexture->mipTailAllocation));
+    memset(&pTexture->cacheAllocation, 0, sizeof(pTexture->cacheAllocation));
+    pTexture->cacheImage = VK_NULL_HANDLE;
+    pTexture->sparse = SDL_FALSE;
+}
+
+Result createSlots(VirtualTexture* pTexture)
+{
+    uint32_t slotCount = pTexture->slotCount;
+
+    pTexture->pSlotPages = malloc(slotCount * sizeof(uint32_t));
+    pTexture->pSlotLastUsed = calloc(slotCount, sizeof(uint64_t));
+    pTexture->pSlotPrevious = malloc(slotCount * sizeof(uint32_t));
+    pTexture->pSlotNext = malloc(slotCount * sizeof(uint32_t));
+    pTexture->pFreeSlots = malloc(slotCount * sizeof(uint32_t));
+    pTexture->pReleasedSlots = malloc(slotCount * sizeof(uint32_t));
+    pTexture->pReleaseFrames = malloc(slotCount * sizeof(uint64_t));
+
+    if ((pTexture->pSlotPages == NULL) || (pTexture->pSlotLastUsed == NULL) || (pTexture->pSlotPrevious == NULL) || (pTexture->pSlotNext == NULL)
+        || (pTexture->pFreeSlots == NULL) || (pTexture->pReleasedSlots == NULL) || (pTexture->pReleaseFrames == NULL))
+    {
+        printError("Failed to allocate %lu bytes of memory for cache slots!", slotCount * (5 * sizeof(uint32_t) + 2 * sizeof(uint64_t)));
+        return FAIL;
+    }
+
+    // Popped from the back, so the first tiles go to the first slots
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        pTexture->pSlotPages[i] = NO_SLOT;
+        pTexture->pSlotPrevious[i] = NO_SLOT;
+        pTexture->pSlotNext[i] = NO_SLOT;
+        pTexture->pFreeSlots[i] = slotCount - 1 - i;
+    }
+
+    pTexture->freeSlotCount = slotCount;
+
+    return SUCCESS;
+}
+
+Result createUploads(VirtualTexture* pTexture)
+{
+    const TileLevel* pPinnedLevel = &pTexture->tileFile.pLevels[pTexture->pinnedFirstLevel];
+    uint32_t pinnedPageCount = pTexture->pageCount - pPinnedLevel->firstPage;
+
+    pTexture->uploadCount = SDL_max(pTexture->frameCount * VIRTUAL_TEXTURE_UPLOADS_PER_FRAME, pinnedPageCount);
+
+    pTexture->pUploads = calloc(pTexture->uploadCount, sizeof(TileUpload));
+    pTexture->pCopies = malloc(pTexture->uploadCount * sizeof(VkBufferImageCopy));
+    pTexture->pSparseBinds = malloc((pTexture->uploadCount + pTexture->slotCount) * sizeof(VkSparseImageMemoryBind));
+    if ((pTexture->pUploads == NULL) || (pTexture->pCopies == NULL) || (pTexture->pSparseBinds == NULL))
+    {
+        printError("Failed to allocate memory for %u tile uploads!", pTexture->uploadCount);
+        return FAIL;
+    }
+
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    if (createBuffer(pTexture->pAllocator, (VkDeviceSize)pTexture->uploadCount * TILE_SLOT_BYTES, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &allocationInfo,
+        &pTexture->stagingBuffer, &pTexture->stagingAllocation) != SUCCESS)
+    {
+        printError("Failed to create tile staging buffer!");
+        pTexture->stagingBuffer = VK_NULL_HANDLE;
+        return FAIL;
+    }
+
+    // Pinned pages are loaded right away, so the first frame already has a resident page everywhere
+    for (uint32_t i = 0; i < pinnedPageCount; ++i)
+    {
+        uint32_t page = pPinnedLevel->firstPage + i;
+        memcpy((char*)pTexture->stagingAllocation.pMapped + (size_t)i * TILE_SLOT_BYTES, getTile(&pTexture->tileFile, page), TILE_SLOT_BYTES);
+
+        pTexture->pUploads[i].state = TILE_UPLOAD_STATE_READY;
+        pTexture->pUploads[i].page = page;
+        pTexture->pPageStates[page] = PAGE_STATE_QUEUED;
+    }
+
+    return SUCCESS;
+}
+
+Result createVirtualTextureFrames(VirtualTexture* pTexture, VkDescriptorSetLayout setLayout)
+{
+    uint32_t frameCount = pTexture->frameCount;
+
+    VkDescriptorPoolSize pPoolSizes[2];
+    pPoolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pPoolSizes[0].descriptorCount = frameCount;
+    pPoolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pPoolSizes[1].descriptorCount = 2 * frameCount;
+
+    VkDescriptorPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = 0;
+    poolCreateInfo.maxSets = frameCount;
+    poolCreateInfo.poolSizeCount = 2;
+    poolCreateInfo.pPoolSizes = pPoolSizes;
+
+    if (vkCreateDescriptorPool(pTexture->device, &poolCreateInfo, NULL, &pTexture->descriptorPool) != VK_SUCCESS)
+    {
+        printError("Failed to create virtual texture descriptor pool!");
+        return FAIL;
+    }
+
+    pTexture->pFrames = calloc(frameCount, sizeof(VirtualTextureFrame));
+    if (pTexture->pFrames == NULL)
+    {
+        printError("Failed to allocate %lu bytes of memory for virtual texture frames!", frameCount * sizeof(VirtualTextureFrame));
+        return FAIL;
+    }
+
+    const TileFileHeader* pFileHeader = &pTexture->tileFile.header;
+
+    PageTableHeader header;
+    memset(&header, 0, sizeof(header));
+    header.width = pFileHeader->width;
+    header.height = pFileHeader->height;
+    header.levelCount = pFileHeader->levelCount;
+    header.cacheSize = pTexture->slotsPerRow * TILE_SLOT_SIZE;
+    header.slotsPerRow = pTexture->slotsPerRow;
+    header.sparse = (pTexture->sparse == SDL_TRUE) ? 1 : 0;
+    header.maxRequests = MAX_VIRTUAL_TEXTURE_REQUESTS;
+
+    for (uint32_t i = 0; i < pFileHeader->levelCount; ++i)
+    {
+        const TileLevel* pLevel = &pTexture->tileFile.pLevels[i];
+        header.pLevels[i][0] = pLevel->firstPage;
+        header.pLevels[i][1] = pLevel->pagesX;
+        header.pLevels[i][2] = pLevel->width;
+        header.pLevels[i][3] = pLevel->height;
+    }
+
+    // The feedback is read back on the CPU, the page table is written by it every frame
+    AllocationInfo allocationInfo;
+    allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocationInfo.preferredFlags = 0;
+    allocationInfo.strategy = ALLOCATION_STRATEGY_BUDDY;
+    allocationInfo.optimalImage = SDL_FALSE;
+
+    VkDeviceSize pageTableSize = sizeof(PageTableHeader) + (VkDeviceSize)pTexture->pageCount * sizeof(uint32_t);
+    VkDeviceSize feedbackSize = (1 + MAX_VIRTUAL_TEXTURE_REQUESTS + (VkDeviceSize)pTexture->pageCount) * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        VirtualTextureFrame* pFrame = &pTexture->pFrames[i];
+
+        allocationInfo.preferredFlags = 0;
+        if (createBuffer(pTexture->pAllocator, pageTableSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &allocationInfo, &pFrame->pageTableBuffer, &pFrame->pageTableAllocation) != SUCCESS)
+        {
+            printError("Failed to create page table buffer!");
+            pFrame->pageTableBuffer = VK_NULL_HANDLE;
+            return FAIL;
+        }
+
+        allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        if (createBuffer(pTexture->pAllocator, feedbackSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &allocationInfo, &pFrame->feedbackBuffer, &pFrame->feedbackAllocation) != SUCCESS)
+        {
+            printError("Failed to create feedback buffer!");
+            pFrame->feedbackBuffer = VK_NULL_HANDLE;
+            return FAIL;
+        }
+
+        // Frame stamps start at 1, so zeroed feedback requests nothing
+        memcpy(pFrame->pageTableAllocation.pMapped, &header, sizeof(header));
+        memset(pFrame->feedbackAllocation.pMapped, 0, feedbackSize);
+        pFrame->pageTableVersion = 0;
+
+        if (pTexture->sparse == SDL_TRUE)
+        {
+            VkSemaphoreCreateInfo semaphoreCreateInfo;
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreCreateInfo.pNext = NULL;
+            semaphoreCreateInfo.flags = 0;
+
+            if (vkCreateSemaphore(pTexture->device, &semaphoreCreateInfo, NULL, &pFrame->bindSemaphore) != VK_SUCCESS)
+            {
+                printError("Failed to create sparse binding semaphore!");
+                pFrame->bindSemaphore = VK_NULL_HANDLE;
+                return FAIL;
+            }
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo;
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.pNext = NULL;
+        allocateInfo.descriptorPool = pTexture->descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &setLayout;
+
+        if (vkAllocateDescriptorSets(pTexture->device, &allocateInfo, &pFrame->descriptorSet) != VK_SUCCESS)
+        {
+            printError("Failed to allocate virtual texture descriptor set!");
+            return FAIL;
+        }
+
+        VkDescriptorImageInfo imageInfo;
+        imageInfo.sampler = pTexture->sampler;
+        imageInfo.imageView = pTexture->cacheImageView;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorBufferInfo pBufferInfos[2];
+        pBufferInfos[0].buffer = pFrame->pageTableBuffer;
+        pBufferInfos[0].offset = 0;
+        pBufferInfos[0].range = VK_WHOLE_SIZE;
+        pBufferInfos[1].buffer = pFrame->feedbackBuffer;
+        pBufferInfos[1].offset = 0;
+        pBufferInfos[1].range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet pWrites[2];
+        pWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        pWrites[0].pNext = NULL;
+        pWrites[0].dstSet = pFrame->descriptorSet;
+        pWrites[0].dstBinding = 0;
+        pWrites[0].dstArrayElement = 0;
+        pWrites[0].descriptorCount = 1;
+        pWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pWrites[0].pImageInfo = &imageInfo;
+        pWrites[0].pBufferInfo = NULL;
+        pWrites[0].pTexelBufferView = NULL;
+
+        pWrites[1] = pWrites[0];
+        pWrites[1].dstBinding = 1;
+        pWrites[1].descriptorCount = 2;
+        pWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pWrites[1].pImageInfo = NULL;
+        pWrites[1].pBufferInfo = pBufferInfos;
+
+        vkUpdateDescriptorSets(pTexture->device, 2, pWrites, 0, NULL);
+    }
+
+    return SUCCESS;
+}
+
+int loadTilesThread(void* pData)
+{
+    VirtualTexture* pTexture = pData;
+    nameCpuTraceThread("tile loader");
+
+    SDL_LockMutex(pTexture->pMutex);
+
+    for (;;)
+    {
+        uint32_t upload = NO_SLOT;
+        while (pTexture->quit != SDL_TRUE)
+        {
+            for (uint32_t i = 0; (pTexture->requestCount > 0) && (i < pTexture->uploadCount); ++i)
+            {
+                if (pTexture->pUploads[i].state == TILE_UPLOAD_STATE_FREE)
+                {
+                    upload = i;
+                    break;
+                }
+            }
+
+            if (upload != NO_SLOT)
+            {
+                break;
+            }
+
+            SDL_CondWait(pTexture->pCondition, pTexture->pMutex);
+        }
+
+        if (pTexture->quit == SDL_TRUE)
+        {
+            break;
+        }
+
+        uint32_t page = pTexture->pRequests[pTexture->requestFirst];
+        pTexture->requestFirst = (pTexture->requestFirst + 1) % VIRTUAL_TEXTURE_QUEUE_SIZE;
+        --pTexture->requestCount;
+
+        TileUpload* pUpload = &pTexture->pUploads[upload];
+        pUpload->state = TILE_UPLOAD_STATE_LOADING;
+        pUpload->page = page;
+
+        // Reading the mapped tile is where the disk is touched, so it happens without the lock
+        SDL_UnlockMutex(pTexture->pMutex);
+
+        uint64_t traceStart = beginCpuTrace();
+        memcpy((char*)pTexture->stagingAllocation.pMapped + (size_t)upload * TILE_SLOT_BYTES, getTile(&pTexture->tileFile, page), TILE_SLOT_BYTES);
+        endCpuTrace("load tile", traceStart);
+
+        SDL_LockMutex(pTexture->pMutex);
+        pUpload->state = TILE_UPLOAD_STATE_READY;
+    }
+
+    SDL_UnlockMutex(pTexture->pMutex);
+
+    return 0;
+}
+
+uint32_t getPageLevel(const VirtualTexture* pTexture, uint32_t page, uint32_t* pPageX, uint32_t* pPageY)
+{
+    uint32_t level = pTexture->tileFile.header.levelCount - 1;
+    while ((level > 0) && (pTexture->tileFile.pLevels[level].firstPage > page))
+    {
+        --level;
+    }
+
+    const TileLevel* pLevel = &pTexture->tileFile.pLevels[level];
+    uint32_t index = page - pLevel->firstPage;
+
+    if (pPageX != NULL)
+    {
+        *pPageX = index % pLevel->pagesX;
+    }
+
+    if (pPageY != NULL)
+    {
+        *pPageY = index / pLevel->pagesX;
+    }
+
+    return level;
+}
+
+void readFeedback(VirtualTexture* pTexture, VirtualTextureFrame* pFrame, uint64_t frameNumber)
+{
+    uint32_t* pFeedback = pFrame->feedbackAllocation.pMapped;
+    uint32_t requestCount = SDL_min(pFeedback[0], MAX_VIRTUAL_TEXTURE_REQUESTS);
+    const uint32_t* pRequested = pFeedback + 1;
+
+    // The shader only counts up, the frame about to be recorded starts from an empty list again
+    pFeedback[0] = 0;
+
+    SDL_bool queued = SDL_FALSE;
+    SDL_LockMutex(pTexture->pMutex);
+
+    for (uint32_t i = 0; i < requestCount; ++i)
+    {
+        uint32_t page = pRequested[i];
+        if (page >= pTexture->pageCount)
+        {
+            continue;
+        }
+
+        if ((pTexture->pPageStates[page] == PAGE_STATE_NONE) && (pTexture->requestCount < VIRTUAL_TEXTURE_QUEUE_SIZE))
+        {
+            pTexture->pRequests[(pTexture->requestFirst + pTexture->requestCount) % VIRTUAL_TEXTURE_QUEUE_SIZE] = page;
+            ++pTexture->requestCount;
+            pTexture->pPageStates[page] = PAGE_STATE_QUEUED;
+            queued = SDL_TRUE;
+        }
+
+        // The shader samples the nearest resident ancestor until the page arrives, so those stay in use as well
+        uint32_t pageX;
+        uint32_t pageY;
+        uint32_t level = getPageLevel(pTexture, page, &pageX, &pageY);
+
+        for (uint32_t j = level; j < pTexture->tileFile.header.levelCount; ++j)
+        {
+            const TileLevel* pLevel = &pTexture->tileFile.pLevels[j];
+            uint32_t entry = pTexture->pPageTable[pLevel->firstPage + pageY * pLevel->pagesX + pageX];
+
+            if ((entry != 0) && (entry != MIP_TAIL_ENTRY))
+            {
+                touchSlot(pTexture, entry - 1, frameNumber);
+            }
+
+            pageX /= 2;
+            pageY /= 2;
+        }
+    }
+
+    if (queued == SDL_TRUE)
+    {
+        SDL_CondSignal(pTexture->pCondition);
+    }
+
+    SDL_UnlockMutex(pTexture->pMutex);
+}
+
+void touchSlot(VirtualTexture* pTexture, uint32_t slot, uint64_t frameNumber)
+{
+    if (pTexture->pSlotLastUsed[slot] == PINNED_SLOT)
+    {
+        return;
+    }
+
+    pTexture->pSlotLastUsed[slot] = frameNumber;
+
+    if (pTexture->lruHead == slot)
+    {
+        return;
+    }
+
+    unlinkSlot(pTexture, slot);
+
+    pTexture->pSlotPrevious[slot] = NO_SLOT;
+    pTexture->pSlotNext[slot] = pTexture->lruHead;
+
+    if (pTexture->lruHead != NO_SLOT)
+    {
+        pTexture->pSlotPrevious[pTexture->lruHead] = slot;
+    }
+
+    pTexture->lruHead = slot;
+
+    if (pTexture->lruTail == NO_SLOT)
+    {
+        pTexture->lruTail = slot;
+    }
+}
+
+void unlinkSlot(VirtualTexture* pTexture, uint32_t slot)
+{
+    uint32_t previous = pTexture->pSlotPrevious[slot];
+    uint32_t next = pTexture->pSlotNext[slot];
+
+    if (previous != NO_SLOT)
+    {
+        pTexture->pSlotNext[previous] = next;
+    }
+    else if (pTexture->lruHead == slot)
+    {
+        pTexture->lruHead = next;
+    }
+
+    if (next != NO_SLOT)
+    {
+        pTexture->pSlotPrevious[next] = previous;
+    }
+    else if (pTexture->lruTail == slot)
+    {
+        pTexture->lruTail = previous;
+    }
+
+    pTexture->pSlotPrevious[slot] = NO_SLOT;
+    pTexture->pSlotNext[slot] = NO_SLOT;
+}
+
+SDL_bool evictSlot(VirtualTexture* pTexture, uint64_t frameNumber)
+{
+    // A page requested by the frame being recorded is not evicted, the cache is too small for the view then
+    uint32_t slot = pTexture->lruTail;
+    if ((slot == NO_SLOT) || (pTexture->pSlotLastUsed[slot] >= frameNumber))
+    {
+        return SDL_FALSE;
+    }
+
+    unlinkSlot(pTexture, slot);
+
+    uint32_t page = pTexture->pSlotPages[slot];
+    pTexture->pPageTable[page] = 0;
+    pTexture->pPageStates[page] = PAGE_STATE_NONE;
+    --pTexture->residentPageCount;
+    ++pTexture->pageTableVersion;
+    ++pTexture->evictedTileCount;
+
+    uint32_t released = (pTexture->releasedFirst + pTexture->releasedCount) % pTexture->slotCount;
+    pTexture->pReleasedSlots[released] = slot;
+    pTexture->pReleaseFrames[released] = frameNumber;
+    ++pTexture->releasedCount;
+
+    return SDL_TRUE;
+}
+
+void makePageResident(VirtualTexture* pTexture, uint32_t page, uint32_t slot, uint64_t frameNumber)
+{
+    pTexture->pPageTable[page] = (slot != NO_SLOT) ? slot + 1 : MIP_TAIL_ENTRY;
+    pTexture->pPageStates[page] = PAGE_STATE_RESIDENT;
+    ++pTexture->residentPageCount;
+    ++pTexture->pageTableVersion;
+
+    if (slot == NO_SLOT)
+    {
+        return;
+    }
+
+    pTexture->pSlotPages[slot] = page;
+
+    if (getPageLevel(pTexture, page, NULL, NULL) >= pTexture->pinnedFirstLevel)
+    {
+        pTexture->pSlotLastUsed[slot] = PINNED_SLOT;
+    }
+    else
+    {
+        pTexture->pSlotLastUsed[slot] = 0;
+        touchSlot(pTexture, slot, frameNumber);
+    }
+}
+
+void getTileCopy(const VirtualTexture* pTexture, uint32_t upload, uint32_t page, uint32_t slot, VkBufferImageCopy* pCopy)
+{
+    pCopy->bufferOffset = (VkDeviceSize)upload * TILE_SLOT_BYTES;
+    pCopy->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    pCopy->imageSubresource.baseArrayLayer = 0;
+    pCopy->imageSubresource.layerCount = 1;
+    pCopy->imageOffset.z = 0;
+    pCopy->imageExtent.depth = 1;
+
+    if (pTexture->sparse == SDL_TRUE)
+    {
+        // Only the inside of the tile, the neighbours are pages of their own
+        uint32_t pageX;
+        uint32_t pageY;
+        uint32_t level = getPageLevel(pTexture, page, &pageX, &pageY);
+        const TileLevel* pLevel = &pTexture->tileFile.pLevels[level];
+
+        pCopy->bufferOffset += (TILE_BORDER * TILE_SLOT_SIZE + TILE_BORDER) * 4;
+        pCopy->bufferRowLength = TILE_SLOT_SIZE;
+        pCopy->bufferImageHeight = TILE_SLOT_SIZE;
+        pCopy->imageSubresource.mipLevel = level;
+        pCopy->imageOffset.x = (int32_t)(pageX * TILE_SIZE);
+        pCopy->imageOffset.y = (int32_t)(pageY * TILE_SIZE);
+        pCopy->imageExtent.width = SDL_min(TILE_SIZE, pLevel->width - pageX * TILE_SIZE);
+        pCopy->imageExtent.height = SDL_min(TILE_SIZE, pLevel->height - pageY * TILE_SIZE);
+    }
+    else
+    {
+        pCopy->bufferRowLength = 0;
+        pCopy->bufferImageHeight = 0;
+        pCopy->imageSubresource.mipLevel = 0;
+        pCopy->imageOffset.x = (int32_t)((slot % pTexture->slotsPerRow) * TILE_SLOT_SIZE);
+        pCopy->imageOffset.y = (int32_t)((slot / pTexture->slotsPerRow) * TILE_SLOT_SIZE);
+        pCopy->imageExtent.width = TILE_SLOT_SIZE;
+        pCopy->imageExtent.height = TILE_SLOT_SIZE;
+    }
+}
+
+void addSparseBind(VirtualTexture* pTexture, uint32_t* pBindCount, uint32_t page, uint32_t slot)
+{
+    uint32_t pageX;
+    uint32_t pageY;
+    uint32_t level = getPageLevel(pTexture, page, &pageX, &pageY);
+    const TileLevel* pLevel = &pTexture->tileFile.pLevels[level];
+
+    VkSparseImageMemoryBind* pBind = &pTexture->pSparseBinds[(*pBindCount)++];
+    pBind->subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    pBind->subresource.mipLevel = level;
+    pBind->subresource.arrayLayer = 0;
+    pBind->offset.x = (int32_t)(pageX * TILE_SIZE);
+    pBind->offset.y = (int32_t)(pageY * TILE_SIZE);
+    pBind->offset.z = 0;
+    pBind->extent.width = SDL_min(TILE_SIZE, pLevel->width - pageX * TILE_SIZE);
+    pBind->extent.height = SDL_min(TILE_SIZE, pLevel->height - pageY * TILE_SIZE);
+    pBind->extent.depth = 1;
+    pBind->memory = (slot != NO_SLOT) ? pTexture->cacheAllocation.memory : VK_NULL_HANDLE;
+    pBind->memoryOffset = (slot != NO_SLOT) ? pTexture->cacheAllocation.offset + slot * pTexture->sparsePageSize : 0;
+    pBind->flags = 0;
+}
+
+Result bindSparsePages(VirtualTexture* pTexture, VirtualTextureFrame* pFrame, uint32_t bindCount)
+{
+    VkSparseImageMemoryBindInfo imageBindInfo;
+    imageBindInfo.image = pTexture->cacheImage;
+    imageBindInfo.bindCount = bindCount;
+    imageBindInfo.pBinds = pTexture->pSparseBinds;
+
+    VkBindSparseInfo bindInfo;
+    bindInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+    bindInfo.pNext = NULL;
+    bindInfo.waitSemaphoreCount = 0;
+    bindInfo.pWaitSemaphores = NULL;
+    bindInfo.bufferBindCount = 0;
+    bindInfo.pBufferBinds = NULL;
+    bindInfo.imageOpaqueBindCount = 0;
+    bindInfo.pImageOpaqueBinds = NULL;
+    bindInfo.imageBindCount = 1;
+    bindInfo.pImageBinds = &imageBindInfo;
+    bindInfo.signalSemaphoreCount = 1;
+    bindInfo.pSignalSemaphores = &pFrame->bindSemaphore;
+
+    // Binding is not ordered with command buffers on the same queue, the frame's submission waits on the semaphore
+    // to keep it before the copies and the sampling instead of the CPU waiting here
+    uint64_t traceStart = beginCpuTrace();
+    if (vkQueueBindSparse(pTexture->queue, 1, &bindInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        return FAIL;
+    }
+    endCpuTrace("bind sparse", traceStart);
+
+    pFrame->bindPending = SDL_TRUE;
+
+    return SUCCESS;
+}
+
+void recordCacheCopies(VirtualTexture* pTexture, VkCommandBuffer commandBuffer, uint32_t copyCount)
+{
+    // The cache stays in the general layout, so copies into it need no transitions of the pages being sampled
+    if (pTexture->cacheInitialized != SDL_TRUE)
+    {
+        VkImageMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = pTexture->cacheImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+        pTexture->cacheInitialized = SDL_TRUE;
+    }
+
+    if (copyCount == 0)
+    {
+        return;
+    }
+
+    // Earlier frames may still sample the slots being overwritten
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 0, NULL);
+
+    vkCmdCopyBufferToImage(commandBuffer, pTexture->stagingBuffer, pTexture->cacheImage, VK_IMAGE_LAYOUT_GENERAL, copyCount, pTexture->pCopies);
+
+    VkMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
@@ -0,0 +1,243 @@
+#include "blockAllocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#define TEST_SIZE               (1024 * 1024)
+#define TEST_MIN_BLOCK_SIZE     256
+#define TEST_ITERATIONS         100000
+#define MAX_LIVE_ALLOCATIONS    512
+
+#define CHECK(condition)                                                                \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(condition))                                                               \
+        {                                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return FAIL;                                                                \
+        }                                                                               \
+    } while (0)
+
+typedef struct TestAllocation
+{
+    uint64_t    offset;
+    uint64_t    size;
+} TestAllocation;
+
+static uint64_t randomState = 0x9E3779B97F4A7C15ull;
+
+static uint64_t nextRandom(void);
+
+static Result markBytes(uint8_t* pUsed, uint64_t offset, uint64_t size, uint8_t value);
+
+static Result testLinear(void);
+
+static Result testBuddy(void);
+
+static Result testStress(AllocationStrategy strategy);
+
+int main(void)
+{
+    if ((testLinear() != SUCCESS) || (testBuddy() != SUCCESS)
+        || (testStress(ALLOCATION_STRATEGY_LINEAR) != SUCCESS) || (testStress(ALLOCATION_STRATEGY_BUDDY) != SUCCESS))
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("Block allocator tests passed\n");
+    return EXIT_SUCCESS;
+}
+
+uint64_t nextRandom(void)
+{
+    // xorshift64, the same sequence on every platform
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+Result markBytes(uint8_t* pUsed, uint64_t offset, uint64_t size, uint8_t value)
+{
+    CHECK(offset + size <= TEST_SIZE);
+
+    for (uint64_t i = offset; i < offset + size; ++i)
+    {
+        // Marking a byte twice means two live allocations overlap
+        CHECK(pUsed[i] != value);
+        pUsed[i] = value;
+    }
+
+    return SUCCESS;
+}
+
+Result testLinear(void)
+{
+    BlockAllocator allocator;
+    CHECK(createBlockAllocator(&allocator, ALLOCATION_STRATEGY_LINEAR, TEST_SIZE, 0) == SUCCESS);
+
+    uint64_t first, second;
+    CHECK(blockAllocate(&allocator, 100, 1, &first) == SUCCESS);
+    CHECK(first == 0);
+    CHECK(blockAllocate(&allocator, 100, 256, &second) == SUCCESS);
+    CHECK(second == 256);
+
+    // Exhaustion: nothing larger than what is left past the bump offset fits
+    uint64_t offset;
+    CHECK(blockAllocate(&allocator, TEST_SIZE, 1, &offset) == FAIL);
+    CHECK(blockAllocate(&allocator, TEST_SIZE - 356, 1, &offset) == SUCCESS);
+    CHECK(blockAllocate(&allocator, 1, 1, &offset) == FAIL);
+
+    BlockAllocatorStats stats;
+    getBlockAllocatorStats(&allocator, &stats);
+    CHECK(stats.usedSize == TEST_SIZE);
+    CHECK(stats.largestFreeRegion == 0);
+
+    // The range is only reclaimed once the last allocation is freed
+    blockFree(&allocator, second, 100);
+    blockFree(&allocator, offset, TEST_SIZE - 356);
+    CHECK(blockAllocate(&allocator, 1, 1, &offset) == FAIL);
+
+    blockFree(&allocator, first, 100);
+    getBlockAllocatorStats(&allocator, &stats);
+    CHECK(stats.usedSize == 0);
+    CHECK(stats.largestFreeRegion == TEST_SIZE);
+    CHECK(blockAllocate(&allocator, 1, 1, &offset) == SUCCESS);
+    CHECK(offset == 0);
+
+    destroyBlockAllocator(&allocator);
+    return SUCCESS;
+}
+
+Result testBuddy(void)
+{
+    // Prints an error, the range must be a power of two multiple of the minimum block size
+    BlockAllocator allocator;
+    CHECK(createBlockAllocator(&allocator, ALLOCATION_STRATEGY_BUDDY, 3 * TEST_MIN_BLOCK_SIZE, TEST_MIN_BLOCK_SIZE) == FAIL);
+    CHECK(createBlockAllocator(&allocator, ALLOCATION_STRATEGY_BUDDY, TEST_SIZE, TEST_MIN_BLOCK_SIZE) == SUCCESS);
+
+    // Blocks are aligned to their size, and at least to the requested alignment
+    uint64_t offset;
+    CHECK(blockAllocate(&allocator, 1, 1, &offset) == SUCCESS);
+    CHECK(offset % TEST_MIN_BLOCK_SIZE == 0);
+    uint64_t alignedOffset;
+    CHECK(blockAllocate(&allocator, 100, 64 * 1024, &alignedOffset) == SUCCESS);
+    CHECK(alignedOffset % (64 * 1024) == 0);
+    CHECK(alignedOffset != offset);
+
+    blockFree(&allocator, offset, 1);
+    blockFree(&allocator, alignedOffset, 100);
+
+    // Exhaustion with blocks of the minimum size, every one of them is handed out exactly once
+    uint32_t blockCount = TEST_SIZE / TEST_MIN_BLOCK_SIZE;
+    uint64_t* pOffsets = malloc(blockCount * sizeof(uint64_t));
+    CHECK(pOffsets != NULL);
+
+    for (uint32_t i = 0; i < blockCount; ++i)
+    {
+        CHECK(blockAllocate(&allocator, TEST_MIN_BLOCK_SIZE, 1, &pOffsets[i]) == SUCCESS);
+    }
+    CHECK(blockAllocate(&allocator, 1, 1, &offset) == FAIL);
+
+    BlockAllocatorStats stats;
+    getBlockAllocatorStats(&allocator, &stats);
+    CHECK(stats.usedSize == TEST_SIZE);
+    CHECK(stats.largestFreeRegion == 0);
+
+    // Coalescing: freeing every other block leaves only minimum size holes, freeing the rest merges them all
+    for (uint32_t i = 0; i < blockCount; i += 2)
+    {
+        blockFree(&allocator, pOffsets[i], TEST_MIN_BLOCK_SIZE);
+    }
+    getBlockAllocatorStats(&allocator, &stats);
+    CHECK(stats.largestFreeRegion == TEST_MIN_BLOCK_SIZE);
+    CHECK(blockAllocate(&allocator, 2 * TEST_MIN_BLOCK_SIZE, 1, &offset) == FAIL);
+
+    for (uint32_t i = 1; i < blockCount; i += 2)
+    {
+        blockFree(&allocator, pOffsets[i], TEST_MIN_BLOCK_SIZE);
+    }
+    getBlockAllocatorStats(&allocator, &stats);
+    CHECK(stats.usedSize == 0);
+    CHECK(stats.largestFreeRegion == TEST_SIZE);
+    CHECK(blockAllocate(&allocator, TEST_SIZE, 1, &offset) == SUCCESS);
+    CHECK(offset == 0);
+
+    free(pOffsets);
+    destroyBlockAllocator(&allocator);
+    return SUCCESS;
+}
+
+Result testStress(AllocationStrategy strategy)
+{
+    BlockAllocator allocator;
+    CHECK(createBlockAllocator(&allocator, strategy, TEST_SIZE, TEST_MIN_BLOCK_SIZE) == SUCCESS);
+
+    uint8_t* pUsed = calloc(TEST_SIZE, 1);
+    CHECK(pUsed != NULL);
+
+    TestAllocation pLive[MAX_LIVE_ALLOCATIONS];
+    uint32_t liveCount = 0;
+    uint64_t liveSize = 0;
+
+    for (uint32_t i = 0; i < TEST_ITERATIONS; ++i)
+    {
+        SDL_bool allocate = ((liveCount == 0) || ((liveCount < MAX_LIVE_ALLOCATIONS) && (nextRandom() % 2 == 0))) ? SDL_TRUE : SDL_FALSE;
+
+        if (allocate == SDL_TRUE)
+        {
+            uint64_t size = 1 + nextRandom() % (16 * 1024);
+            uint64_t alignment = 1ull << (nextRandom() % 13);
+
+            uint64_t offset;
+            if (blockAllocate(&allocator, size, alignment, &offset) != SUCCESS)
+            {
+                continue;
+            }
+
+            CHECK(offset % alignment == 0);
+            CHECK(markBytes(pUsed, offset, size, 1) == SUCCESS);
+
+            pLive[liveCount].offset = offset;
+            pLive[liveCount].size = size;
+            ++liveCount;
+            liveSize += size;
+        }
+        else
+        {
+            uint32_t index = (uint32_t)(nextRandom() % liveCount);
+            TestAllocation allocation = pLive[index];
+            pLive[index] = pLive[--liveCount];
+
+            CHECK(markBytes(pUsed, allocation.offset, allocation.size, 0) == SUCCESS);
+            blockFree(&allocator, allocation.offset, allocation.size);
+            liveSize -= allocation.size;
+        }
+
+        BlockAllocatorStats stats;
+        getBlockAllocatorStats(&allocator, &stats);
+        CHECK(stats.allocationCount == liveCount);
+        CHECK(stats.requestedSize == liveSize);
+        CHECK(stats.usedSize >= liveSize);
+        CHECK(stats.usedSize <= TEST_SIZE);
+    }
+
+    while (liveCount > 0)
+    {
+        --liveCount;
+        blockFree(&allocator, pLive[liveCount].offset, pLive[liveCount].size);
+    }
+
+    // Everything coalesced back into one free range
+    BlockAllocatorStats stats;
+    getBlockAllocatorStats(&allocator, &stats);
+    CHECK(stats.usedSize == 0);
+    CHECK(stats.largestFreeRegion == TEST_SIZE);
+
+    free(pUsed);
+    destroyBlockAllocator(&allocator);
+    return SUCCESS;
+}